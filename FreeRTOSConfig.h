@@ -78,8 +78,8 @@ extern uint32_t SystemCoreClock;
 /* Memory allocation related definitions. */
 #define configSUPPORT_STATIC_ALLOCATION         1
 #define configSUPPORT_DYNAMIC_ALLOCATION        1
-#define configTOTAL_HEAP_SIZE                   10240
-#define configAPPLICATION_ALLOCATED_HEAP        0
+#define configTOTAL_HEAP_SIZE                   (128 * 1024)    /* Also backs malloc, see mem_pool.c */
+#define configAPPLICATION_ALLOCATED_HEAP        1               /* ucHeap is defined in mem_pool.c */
 
 /* Hook function related definitions. */
 #define configUSE_IDLE_HOOK                     0
@@ -89,8 +89,14 @@ extern uint32_t SystemCoreClock;
 #define configUSE_DAEMON_TASK_STARTUP_HOOK      0
 
 /* Run time and task stats gathering related definitions. */
-#define configGENERATE_RUN_TIME_STATS           0
+#define configGENERATE_RUN_TIME_STATS           1
 #define configUSE_TRACE_FACILITY                1
+
+/* Run time stats are clocked by the DWT cycle counter, see metrics.c */
+extern void metrics_init_cycle_counter(void);
+extern uint32_t metrics_run_time(void);
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS() metrics_init_cycle_counter()
+#define portGET_RUN_TIME_COUNTER_VALUE()         metrics_run_time()
 #define configUSE_STATS_FORMATTING_FUNCTIONS    0
 
 /* Co-routine related definitions. */
@@ -190,7 +196,7 @@ standard names - or at least those used in the unmodified vector table. */
 #define HEAP_ALLOCATION_TYPE5                   (5)     /* heap_5.c*/
 #define NO_HEAP_ALLOCATION                      (0)
 
-#define configHEAP_ALLOCATION_SCHEME            (HEAP_ALLOCATION_TYPE3)
+#define configHEAP_ALLOCATION_SCHEME            (HEAP_ALLOCATION_TYPE4)
 
 /* Check if the ModusToolbox Device Configurator Power personality parameter
  * "System Idle Power Mode" is set to either "CPU Sleep" or "System Deep Sleep".
@@ -0,0 +1,174 @@
+/******************************************************************************
+* File Name:   alerts.c
+*
+* Description: This file contains the price alert engine. Every rule kind is
+* reduced at compile time to "value of field F against threshold T" plus two
+* flags, so evaluation is the same few operations for every rule.
+*
+*******************************************************************************/
+
+/* Standard C header file. */
+#include <stdio.h>
+#include <string.h>
+
+#include "alerts.h"
+#include "log_ring.h"
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+typedef enum {
+	ALERT_FIELD_PRICE,
+	ALERT_FIELD_MOVE_PERCENT,     // |price - previous close| in % of the previous close
+	ALERT_FIELD_DAY_HIGH,
+	ALERT_FIELD_DAY_LOW_NEG,      // Negated, so a new low is a rise like a new high
+	ALERT_FIELD_COUNT
+} alert_field_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+static int alerts_symbol_index(const alert_engine_t *engine, const char *symbol);
+
+/*******************************************************************************
+ * Function Name: alerts_compile
+ *******************************************************************************
+ * Summary:
+ *  Turns the rules into the evaluation table, grouped by symbol. Rules past
+ *  ALERT_MAX_RULES or for more than ALERT_MAX_SYMBOLS symbols are dropped.
+ *
+ * Return:
+ *  uint32_t : number of rules compiled
+ *
+ *******************************************************************************/
+uint32_t alerts_compile(alert_engine_t *engine, const alert_rule_t *rules, uint32_t num_rules) {
+	uint16_t counts[ALERT_MAX_SYMBOLS] = {0};
+	uint16_t fill[ALERT_MAX_SYMBOLS];
+	int symbolOf[ALERT_MAX_RULES];
+	uint32_t total = 0;
+
+	(void)memset(engine, 0, sizeof(*engine));
+	engine->rules = rules;
+
+	// Collect the symbols and how many rules each has
+	for(uint32_t i = 0; i < num_rules && i < ALERT_MAX_RULES; i++) {
+		int s = alerts_symbol_index(engine, rules[i].symbol);
+
+		if(s < 0 && engine->num_symbols < ALERT_MAX_SYMBOLS) {
+			s = (int)engine->num_symbols++;
+			(void)snprintf(engine->symbols[s], sizeof(engine->symbols[s]), "%s", rules[i].symbol);
+		}
+		symbolOf[i] = s;
+		if(s >= 0) {
+			counts[s]++;
+		}
+	}
+
+	// Each symbol's rules get a contiguous range
+	for(uint32_t s = 0; s < engine->num_symbols; s++) {
+		engine->first[s + 1] = engine->first[s] + counts[s];
+		fill[s] = engine->first[s];
+	}
+
+	for(uint32_t i = 0; i < num_rules && i < ALERT_MAX_RULES; i++) {
+		alert_compiled_t *c;
+
+		if(symbolOf[i] < 0) {
+			continue;
+		}
+		c = &engine->compiled[fill[symbolOf[i]]++];
+		c->rule = (uint16_t)i;
+		c->threshold = fixed_parse(rules[i].threshold, strlen(rules[i].threshold));
+
+		switch(rules[i].kind) {
+			case ALERT_KIND_CROSSES:
+				c->field = ALERT_FIELD_PRICE;
+				c->both_edges = 1;
+				break;
+			case ALERT_KIND_MOVE_PERCENT:
+				c->field = ALERT_FIELD_MOVE_PERCENT;
+				break;
+			case ALERT_KIND_NEW_DAY_HIGH:
+				c->field = ALERT_FIELD_DAY_HIGH;
+				c->track = 1;
+				break;
+			default:
+				c->field = ALERT_FIELD_DAY_LOW_NEG;
+				c->track = 1;
+				break;
+		}
+		total++;
+	}
+
+	return total;
+}
+
+/*******************************************************************************
+ * Function Name: alerts_evaluate
+ *******************************************************************************
+ * Summary:
+ *  Runs a quote's rules. Rules are edge triggered: a condition that stays
+ *  true fires once, when it becomes true. A tracked rule fires on every
+ *  rise past the value it last saw.
+ *
+ * Return:
+ *  uint32_t : number of rules that fired
+ *
+ *******************************************************************************/
+uint32_t alerts_evaluate(alert_engine_t *engine, const quote_t *quote) {
+	fixed_t values[ALERT_FIELD_COUNT];
+	fixed_t move;
+	uint32_t fired = 0;
+	int s = alerts_symbol_index(engine, quote->symbol);
+
+	if(s < 0) {
+		return 0;
+	}
+
+	// Every field a rule can look at, computed once per quote
+	move = quote->price - quote->previous_close;
+	values[ALERT_FIELD_PRICE] = quote->price;
+	values[ALERT_FIELD_MOVE_PERCENT] = (quote->previous_close > 0) ? ((move < 0) ? -move : move) * 100 * FIXED_SCALE / quote->previous_close : 0;
+	values[ALERT_FIELD_DAY_HIGH] = quote->day_high;
+	values[ALERT_FIELD_DAY_LOW_NEG] = -quote->day_low;
+
+	for(uint32_t i = engine->first[s]; i < engine->first[s + 1]; i++) {
+		alert_compiled_t *c = &engine->compiled[i];
+		fixed_t value = values[c->field];
+		uint8_t above = (value > c->threshold) ? 1 : 0;
+		uint8_t fire = c->primed & (above ^ c->above) & (c->both_edges | above);
+
+		// A tracked threshold moves with the value, so the next rise fires again
+		c->above = above & (uint8_t)!c->track;
+		c->threshold = c->track ? value : c->threshold;
+		c->primed = 1;
+
+		if(fire) {
+			const alert_rule_t *rule = &engine->rules[c->rule];
+			LOG_WARN("Alert: %s rule %u (%s) fired", rule->symbol, (unsigned)c->rule, rule->threshold);
+			fired++;
+		}
+	}
+
+	engine->evaluated += engine->first[s + 1] - engine->first[s];
+	engine->fired += fired;
+
+	return fired;
+}
+
+/*******************************************************************************
+ * Function Name: alerts_symbol_index
+ *******************************************************************************
+ * Summary:
+ *  Finds a symbol's group, -1 if it has no rules.
+ *
+ *******************************************************************************/
+static int alerts_symbol_index(const alert_engine_t *engine, const char *symbol) {
+	for(uint32_t s = 0; s < engine->num_symbols; s++) {
+		if(strncmp(engine->symbols[s], symbol, QUOTE_SYMBOL_LEN) == 0) {
+			return (int)s;
+		}
+	}
+
+	return -1;
+}
@@ -0,0 +1,77 @@
+/******************************************************************************
+* File Name:   alerts.h
+*
+* Description: This file contains declarations for the price alert engine.
+* Rules are written with the ALERT_* macros and compiled once into a flat
+* table grouped by symbol, so a quote only visits its own symbol's rules and
+* each rule is one comparison against a precomputed field value.
+*
+*******************************************************************************/
+
+#ifndef ALERTS_H_
+#define ALERTS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "fixed_point.h"
+#include "quote.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define ALERT_MAX_RULES   (64)
+#define ALERT_MAX_SYMBOLS (QUOTE_TABLE_CAPACITY)
+
+/* Rule constructors for ALERT_RULES, thresholds are written as plain numbers.
+ * A new day high or low fires on every quote that extends it; the pipeline
+ * limits how often those ask for another fetch.
+ */
+#define ALERT_CROSSES(symbol, price)        {(symbol), ALERT_KIND_CROSSES, #price}
+#define ALERT_MOVE_PERCENT(symbol, percent) {(symbol), ALERT_KIND_MOVE_PERCENT, #percent}
+#define ALERT_NEW_DAY_HIGH(symbol)          {(symbol), ALERT_KIND_NEW_DAY_HIGH, "0"}
+#define ALERT_NEW_DAY_LOW(symbol)           {(symbol), ALERT_KIND_NEW_DAY_LOW, "0"}
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+typedef enum {
+	ALERT_KIND_CROSSES,         // Price crosses the threshold, either way
+	ALERT_KIND_MOVE_PERCENT,    // Price moves more than threshold % away from the previous close
+	ALERT_KIND_NEW_DAY_HIGH,
+	ALERT_KIND_NEW_DAY_LOW
+} alert_kind_t;
+
+typedef struct {
+	const char *symbol;
+	alert_kind_t kind;
+	const char *threshold;    // Number text, parsed when the rules are compiled
+} alert_rule_t;
+
+typedef struct {
+	uint8_t field;         // Which precomputed value the rule compares
+	uint8_t both_edges;    // Fires on a crossing in either direction
+	uint8_t track;         // Threshold follows the value, fires when it grows
+	uint8_t above;         // Side of the threshold at the last quote
+	uint8_t primed;        // A quote has been seen, edges are meaningful
+	uint16_t rule;         // Index of the source rule
+	fixed_t threshold;
+} alert_compiled_t;
+
+typedef struct {
+	const alert_rule_t *rules;
+	alert_compiled_t compiled[ALERT_MAX_RULES];
+	char symbols[ALERT_MAX_SYMBOLS][QUOTE_SYMBOL_LEN];
+	uint16_t first[ALERT_MAX_SYMBOLS + 1];    // Rules of symbol i are compiled[first[i]] to compiled[first[i + 1] - 1]
+	uint32_t num_symbols;
+	uint32_t evaluated;
+	uint32_t fired;
+} alert_engine_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+uint32_t alerts_compile(alert_engine_t *engine, const alert_rule_t *rules, uint32_t num_rules);
+uint32_t alerts_evaluate(alert_engine_t *engine, const quote_t *quote);
+
+#endif /* ALERTS_H_ */
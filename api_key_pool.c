@@ -0,0 +1,309 @@
+/******************************************************************************
+* File Name:   api_key_pool.c
+*
+* Description: This file contains the API key pool. Keys are chosen before a
+* request is made, from what is known of each key's remaining budget, instead
+* of after the server has already rejected one. Daily counters are kept in
+* flash so a reboot does not forget what has been spent.
+*
+*******************************************************************************/
+
+/* Standard C header file. */
+#include <stdio.h>
+#include <string.h>
+
+#include "api_key_pool.h"
+#include "nv_store.h"
+#include "log_ring.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define MINUTE_BUCKET_CAPACITY_MILLI ((uint32_t)API_KEY_MINUTE_LIMIT * 1000u)
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+// Flash image of the daily counters
+typedef struct {
+	uint32_t keys_crc;
+	int32_t day;
+	uint16_t used_today[API_KEY_POOL_MAX_KEYS];
+	uint8_t exhausted[API_KEY_POOL_MAX_KEYS];
+} api_key_usage_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+static void api_key_pool_refill(api_key_pool_t *pool, uint32_t now_ms);
+static void api_key_pool_roll_day(api_key_pool_t *pool, time_t wall_time);
+static void api_key_pool_load(api_key_pool_t *pool);
+static void api_key_pool_save(api_key_pool_t *pool);
+
+/*******************************************************************************
+ * Function Name: api_key_pool_init
+ *******************************************************************************
+ * Summary:
+ *  Builds the pool from the key table and restores today's counters from
+ *  flash if they belong to the same keys.
+ *
+ * Parameters:
+ *  api_key_pool_t *pool : pool to initialize
+ *  const char *const *keys : key table
+ *  uint32_t num_keys : number of keys, at most API_KEY_POOL_MAX_KEYS are used
+ *
+ *******************************************************************************/
+void api_key_pool_init(api_key_pool_t *pool, const char *const *keys, uint32_t num_keys) {
+	(void)memset(pool, 0, sizeof(*pool));
+
+	if(num_keys > API_KEY_POOL_MAX_KEYS) {
+		num_keys = API_KEY_POOL_MAX_KEYS;
+	}
+
+	pool->num_keys = num_keys;
+	pool->day = -1;
+	for(uint32_t i = 0; i < num_keys; i++) {
+		pool->keys[i].key = keys[i];
+		pool->keys[i].minute_tokens_milli = MINUTE_BUCKET_CAPACITY_MILLI;
+		pool->keys_crc = nv_store_crc32(pool->keys_crc, keys[i], strlen(keys[i]) + 1);
+	}
+
+	api_key_pool_load(pool);
+}
+
+/*******************************************************************************
+ * Function Name: api_key_pool_acquire
+ *******************************************************************************
+ * Summary:
+ *  Picks the key for the next call and charges it one token. Among keys that
+ *  have a minute token available, the one with the most daily budget left
+ *  wins, so usage stays level across keys.
+ *
+ * Parameters:
+ *  api_key_pool_t *pool : pool to pick from
+ *  uint32_t now_ms : monotonic time in ms, drives the minute buckets
+ *  time_t wall_time : wall clock, drives the daily reset (0 if unknown)
+ *
+ * Return:
+ *  int : index of the key to use, -1 if every key is out of budget
+ *
+ *******************************************************************************/
+int api_key_pool_acquire(api_key_pool_t *pool, uint32_t now_ms, time_t wall_time) {
+	int best = -1;
+	uint32_t bestRemaining = 0;
+
+	api_key_pool_roll_day(pool, wall_time);
+	api_key_pool_refill(pool, now_ms);
+
+	for(uint32_t n = 0; n < pool->num_keys; n++) {
+		uint32_t i = (pool->next + n) % pool->num_keys;
+		api_key_t *key = &pool->keys[i];
+		uint32_t remaining;
+
+		if(key->throttled && (int32_t)(now_ms - key->throttled_until_ms) >= 0) {
+			key->throttled = false;
+		}
+		if(key->exhausted || key->throttled || key->used_today >= API_KEY_DAILY_LIMIT || key->minute_tokens_milli < 1000u) {
+			continue;
+		}
+
+		remaining = API_KEY_DAILY_LIMIT - key->used_today;
+		if(remaining > bestRemaining) {
+			best = (int)i;
+			bestRemaining = remaining;
+		}
+	}
+
+	if(best < 0) {
+		return -1;
+	}
+
+	pool->keys[best].minute_tokens_milli -= 1000u;
+	pool->keys[best].used_today++;
+	pool->next = ((uint32_t)best + 1) % pool->num_keys;
+
+	if(++pool->unsaved_calls >= API_KEY_PERSIST_EVERY) {
+		api_key_pool_save(pool);
+	}
+
+	return best;
+}
+
+/*******************************************************************************
+ * Function Name: api_key_pool_reject
+ *******************************************************************************
+ * Summary:
+ *  Marks a key the server refused as exhausted for the rest of the day, our
+ *  count drifted from the provider's. For an auth failure or a spent daily
+ *  quota; a rate limit goes to api_key_pool_throttle instead.
+ *
+ *******************************************************************************/
+void api_key_pool_reject(api_key_pool_t *pool, int index) {
+	if(index < 0 || (uint32_t)index >= pool->num_keys) {
+		return;
+	}
+
+	pool->keys[index].exhausted = true;
+	api_key_pool_save(pool);
+}
+
+/*******************************************************************************
+ * Function Name: api_key_pool_throttle
+ *******************************************************************************
+ * Summary:
+ *  Rests a key the server rate limited (429). The key keeps its daily
+ *  budget and comes back once the wait is over, with an empty minute bucket
+ *  since the provider counted more calls this minute than we did.
+ *
+ * Parameters:
+ *  api_key_pool_t *pool : pool the key is in
+ *  int index : key to rest
+ *  uint32_t now_ms : monotonic time in ms
+ *  uint32_t retry_ms : how long to rest it, from Retry-After
+ *
+ *******************************************************************************/
+void api_key_pool_throttle(api_key_pool_t *pool, int index, uint32_t now_ms, uint32_t retry_ms) {
+	if(index < 0 || (uint32_t)index >= pool->num_keys) {
+		return;
+	}
+
+	if(retry_ms > API_KEY_RATE_LIMIT_MAX_S * 1000u) {
+		retry_ms = API_KEY_RATE_LIMIT_MAX_S * 1000u;
+	}
+	pool->keys[index].throttled = true;
+	pool->keys[index].throttled_until_ms = now_ms + retry_ms;
+	pool->keys[index].minute_tokens_milli = 0;
+}
+
+/*******************************************************************************
+ * Function Name: api_key_pool_remaining_today
+ *******************************************************************************
+ * Summary:
+ *  Calls left today across all usable keys.
+ *
+ *******************************************************************************/
+uint32_t api_key_pool_remaining_today(const api_key_pool_t *pool) {
+	uint32_t remaining = 0;
+
+	for(uint32_t i = 0; i < pool->num_keys; i++) {
+		const api_key_t *key = &pool->keys[i];
+		if(!key->exhausted && key->used_today < API_KEY_DAILY_LIMIT) {
+			remaining += API_KEY_DAILY_LIMIT - key->used_today;
+		}
+	}
+
+	return remaining;
+}
+
+/*******************************************************************************
+ * Function Name: api_key_pool_print
+ *******************************************************************************
+ * Summary:
+ *  Prints per-key usage.
+ *
+ *******************************************************************************/
+void api_key_pool_print(const api_key_pool_t *pool) {
+	for(uint32_t i = 0; i < pool->num_keys; i++) {
+		LOG_INFO("Key %lu: %lu/%u today%s", (unsigned long)i, (unsigned long)pool->keys[i].used_today, API_KEY_DAILY_LIMIT,
+				 pool->keys[i].exhausted ? " (rejected)" : pool->keys[i].throttled ? " (rate limited)" : "");
+	}
+}
+
+/*******************************************************************************
+ * Function Name: api_key_pool_refill
+ *******************************************************************************
+ * Summary:
+ *  Tops up the minute buckets for the time elapsed since the last call.
+ *
+ *******************************************************************************/
+static void api_key_pool_refill(api_key_pool_t *pool, uint32_t now_ms) {
+	uint32_t elapsed = now_ms - pool->last_refill_ms;
+	// API_KEY_MINUTE_LIMIT tokens per 60000 ms, in milli-tokens
+	uint32_t add = (elapsed >= 60000u) ? MINUTE_BUCKET_CAPACITY_MILLI : (elapsed * API_KEY_MINUTE_LIMIT) / 60u;
+
+	pool->last_refill_ms = now_ms;
+	for(uint32_t i = 0; i < pool->num_keys; i++) {
+		api_key_t *key = &pool->keys[i];
+		key->minute_tokens_milli = (key->minute_tokens_milli + add > MINUTE_BUCKET_CAPACITY_MILLI) ? MINUTE_BUCKET_CAPACITY_MILLI
+																									: key->minute_tokens_milli + add;
+	}
+}
+
+/*******************************************************************************
+ * Function Name: api_key_pool_roll_day
+ *******************************************************************************
+ * Summary:
+ *  Resets the daily counters when the local day changes.
+ *
+ *******************************************************************************/
+static void api_key_pool_roll_day(api_key_pool_t *pool, time_t wall_time) {
+	struct tm local;
+	int32_t day;
+
+	if(wall_time == 0) {
+		return;
+	}
+
+	(void)localtime_r(&wall_time, &local);
+	day = (int32_t)(local.tm_year * 1000 + local.tm_yday);
+
+	if(day == pool->day) {
+		return;
+	}
+
+	// New day, the provider has reset every key's quota
+	for(uint32_t i = 0; i < pool->num_keys; i++) {
+		pool->keys[i].used_today = 0;
+		pool->keys[i].exhausted = false;
+	}
+	pool->day = day;
+	api_key_pool_save(pool);
+}
+
+/*******************************************************************************
+ * Function Name: api_key_pool_load
+ *******************************************************************************
+ * Summary:
+ *  Restores the daily counters saved before the last reboot.
+ *
+ *******************************************************************************/
+static void api_key_pool_load(api_key_pool_t *pool) {
+	api_key_usage_t usage;
+
+	if(nv_store_init() != CY_RSLT_SUCCESS) {
+		return;
+	}
+	if(nv_store_read(NV_STORE_SLOT_API_KEY_USAGE, &usage, sizeof(usage)) != sizeof(usage) || usage.keys_crc != pool->keys_crc) {
+		return;
+	}
+
+	pool->day = usage.day;
+	for(uint32_t i = 0; i < pool->num_keys; i++) {
+		pool->keys[i].used_today = usage.used_today[i];
+		pool->keys[i].exhausted = (usage.exhausted[i] != 0);
+	}
+}
+
+/*******************************************************************************
+ * Function Name: api_key_pool_save
+ *******************************************************************************
+ * Summary:
+ *  Writes the daily counters to flash.
+ *
+ *******************************************************************************/
+static void api_key_pool_save(api_key_pool_t *pool) {
+	api_key_usage_t usage;
+
+	(void)memset(&usage, 0, sizeof(usage));
+	usage.keys_crc = pool->keys_crc;
+	usage.day = pool->day;
+	for(uint32_t i = 0; i < pool->num_keys; i++) {
+		usage.used_today[i] = (uint16_t)pool->keys[i].used_today;
+		usage.exhausted[i] = pool->keys[i].exhausted ? 1u : 0u;
+	}
+
+	if(nv_store_write(NV_STORE_SLOT_API_KEY_USAGE, &usage, sizeof(usage)) != CY_RSLT_SUCCESS) {
+		LOG_WARN("API key usage not saved to flash");
+	}
+	pool->unsaved_calls = 0;
+}
@@ -0,0 +1,73 @@
+/******************************************************************************
+* File Name:   api_key_pool.h
+*
+* Description: This file contains declarations for the API key pool. Every key
+* has a per-minute token bucket and a daily budget; calls go to the key with
+* the most budget left so no key is exhausted early.
+*
+*******************************************************************************/
+
+#ifndef API_KEY_POOL_H_
+#define API_KEY_POOL_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define API_KEY_POOL_MAX_KEYS (8)
+
+/* Provider quota for a single key */
+#ifndef API_KEY_DAILY_LIMIT
+#define API_KEY_DAILY_LIMIT (250)
+#endif
+#ifndef API_KEY_MINUTE_LIMIT
+#define API_KEY_MINUTE_LIMIT (5)
+#endif
+
+/* Rest for a key the server rate limited without saying for how long */
+#ifndef API_KEY_RATE_LIMIT_BACKOFF_S
+#define API_KEY_RATE_LIMIT_BACKOFF_S (60)
+#endif
+
+/* Longest Retry-After honoured, so a bogus header cannot park a key for the day */
+#define API_KEY_RATE_LIMIT_MAX_S (15 * 60)
+
+/* Usage counters are written to flash every this many calls */
+#define API_KEY_PERSIST_EVERY (10)
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+typedef struct {
+	const char *key;
+	uint32_t minute_tokens_milli;    // Minute bucket in 1/1000 tokens so refill needs no division remainder
+	uint32_t used_today;
+	bool exhausted;                  // Server rejected the key, unusable until the day rolls over
+	bool throttled;                  // Server rate limited the key, unusable until throttled_until_ms
+	uint32_t throttled_until_ms;
+} api_key_t;
+
+typedef struct {
+	api_key_t keys[API_KEY_POOL_MAX_KEYS];
+	uint32_t num_keys;
+	uint32_t next;               // Round robin start among equally loaded keys
+	uint32_t last_refill_ms;
+	int32_t day;                 // Local day the daily counters belong to, -1 if unknown
+	uint32_t keys_crc;           // Identifies the key table the persisted counters belong to
+	uint32_t unsaved_calls;
+} api_key_pool_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+void api_key_pool_init(api_key_pool_t *pool, const char *const *keys, uint32_t num_keys);
+int api_key_pool_acquire(api_key_pool_t *pool, uint32_t now_ms, time_t wall_time);
+void api_key_pool_reject(api_key_pool_t *pool, int index);
+void api_key_pool_throttle(api_key_pool_t *pool, int index, uint32_t now_ms, uint32_t retry_ms);
+uint32_t api_key_pool_remaining_today(const api_key_pool_t *pool);
+void api_key_pool_print(const api_key_pool_t *pool);
+
+#endif /* API_KEY_POOL_H_ */
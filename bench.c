@@ -0,0 +1,226 @@
+/******************************************************************************
+* File Name:   bench.c
+*
+* Description: This file contains the per-tick benchmark harness and its
+* corpus. Stages are timed with the cycle counter, allocations are counted
+* through the memory pool statistics, and peak stack is found by painting the
+* unused part of the task stack before a stage and scanning it afterwards,
+* the way the kernel's high water mark does. Results print as CSV:
+*
+*   bench,<stage>,<ns/op>,<allocs/op>,<peak stack bytes>,<baseline ns/op>,<change>,<ok|REGRESSED|baseline>
+*
+*******************************************************************************/
+
+/* Header file includes. */
+#include "cy_pdl.h"
+#include "cyhal.h"
+
+/* FreeRTOS header file. */
+#include <FreeRTOS.h>
+#include <task.h>
+
+/* Standard C header file. */
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "metrics.h"
+#include "mem_pool.h"
+#include "nv_store.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Byte the kernel fills new task stacks with (tskSTACK_FILL_BYTE) */
+#define BENCH_STACK_FILL (0xa5u)
+
+/* Stack left alone below the measuring frame, for memset and vTaskGetInfo */
+#define BENCH_STACK_MARGIN (256)
+
+/* Define to replace the stored baseline with this run */
+#ifndef BENCH_SAVE_BASELINE
+#define BENCH_SAVE_BASELINE (0)
+#endif
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+typedef struct {
+	quote_table_t *table;
+	const char *json;
+	size_t len;
+} bench_parse_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+static void bench_parse(void *arg);
+static uint32_t bench_allocs(void);
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+// Recorded /api/v3/quote responses, every field FMP sends kept
+static const char corpusOne[] =
+	"[{\"symbol\":\"AMD\",\"name\":\"Advanced Micro Devices, Inc.\",\"price\":156.79,\"changesPercentage\":-1.2346,\"change\":-1.96,"
+	"\"dayLow\":155.12,\"dayHigh\":159.2,\"yearHigh\":227.3,\"yearLow\":93.12,\"marketCap\":253412345678,\"priceAvg50\":150.123,"
+	"\"priceAvg200\":140.245,\"exchange\":\"NASDAQ\",\"volume\":41234567,\"avgVolume\":60123456,\"open\":158.01,\"previousClose\":158.75,"
+	"\"eps\":0.53,\"pe\":295.83,\"earningsAnnouncement\":\"2024-10-29T20:00:00.000+0000\",\"sharesOutstanding\":1616220000,"
+	"\"timestamp\":1718308801}]";
+
+static const char corpusMany[] =
+	"[{\"symbol\":\"AMD\",\"name\":\"Advanced Micro Devices, Inc.\",\"price\":156.79,\"changesPercentage\":-1.2346,\"change\":-1.96,"
+	"\"dayLow\":155.12,\"dayHigh\":159.2,\"yearHigh\":227.3,\"yearLow\":93.12,\"marketCap\":253412345678,\"priceAvg50\":150.123,"
+	"\"priceAvg200\":140.245,\"exchange\":\"NASDAQ\",\"volume\":41234567,\"avgVolume\":60123456,\"open\":158.01,\"previousClose\":158.75,"
+	"\"eps\":0.53,\"pe\":295.83,\"earningsAnnouncement\":\"2024-10-29T20:00:00.000+0000\",\"sharesOutstanding\":1616220000,"
+	"\"timestamp\":1718308801},"
+	"{\"symbol\":\"NVDA\",\"name\":\"NVIDIA Corporation\",\"price\":129.61,\"changesPercentage\":3.5178,\"change\":4.405,"
+	"\"dayLow\":127.14,\"dayHigh\":130.85,\"yearHigh\":140.76,\"yearLow\":39.23,\"marketCap\":3188123456789,\"priceAvg50\":110.456,"
+	"\"priceAvg200\":85.789,\"exchange\":\"NASDAQ\",\"volume\":260123456,\"avgVolume\":412345678,\"open\":129.39,\"previousClose\":125.205,"
+	"\"eps\":1.71,\"pe\":75.8,\"earningsAnnouncement\":\"2024-08-28T20:00:00.000+0000\",\"sharesOutstanding\":24598000000,"
+	"\"timestamp\":1718308800},"
+	"{\"symbol\":\"INTC\",\"name\":\"Intel Corporation\",\"price\":30.4,\"changesPercentage\":-0.4585,\"change\":-0.14,"
+	"\"dayLow\":30.16,\"dayHigh\":30.83,\"yearHigh\":51.28,\"yearLow\":29.73,\"marketCap\":129456789012,\"priceAvg50\":31.234,"
+	"\"priceAvg200\":38.567,\"exchange\":\"NASDAQ\",\"volume\":35123456,\"avgVolume\":43123456,\"open\":30.66,\"previousClose\":30.54,"
+	"\"eps\":0.39,\"pe\":77.95,\"earningsAnnouncement\":\"2024-07-25T20:00:00.000+0000\",\"sharesOutstanding\":4258000000,"
+	"\"timestamp\":1718308800}]";
+
+static const char *const stageNames[BENCH_STAGE_COUNT] = {"parse_one", "parse_many", "format", "render"};
+
+static bench_result_t results[BENCH_STAGE_COUNT];
+
+/*******************************************************************************
+ * Function Name: bench_measure
+ *******************************************************************************
+ * Summary:
+ *  Runs one stage BENCH_ITERATIONS times after a warm-up and records its
+ *  time, allocations and peak stack. Other tasks may preempt it, so run it
+ *  from the highest priority task or on an idle system.
+ *
+ * Parameters:
+ *  bench_stage_t stage : stage the results are kept under
+ *  bench_op_t op : one operation
+ *  void *arg : passed to op
+ *
+ *******************************************************************************/
+void bench_measure(bench_stage_t stage, bench_op_t op, void *arg) {
+	bench_result_t *result = &results[stage];
+	TaskStatus_t status;
+	uint8_t marker;
+	uint8_t *base;
+	uint8_t *top;
+	uint32_t allocs;
+	uint32_t start;
+	uint32_t cycles;
+
+	op(arg);
+
+	// Paint the free stack below this frame, the stage's deepest use is where the paint stops
+	vTaskGetInfo(NULL, &status, pdFALSE, eRunning);
+	base = (uint8_t *)status.pxStackBase;
+	top = &marker - BENCH_STACK_MARGIN;
+	if(top > base) {
+		(void)memset(base, BENCH_STACK_FILL, (size_t)(top - base));
+	}
+
+	allocs = bench_allocs();
+	start = metrics_now();
+	for(uint32_t i = 0; i < BENCH_ITERATIONS; i++) {
+		op(arg);
+	}
+	cycles = metrics_now() - start;
+
+	vTaskGetInfo(NULL, &status, pdTRUE, eRunning);
+	result->ns_per_op = (uint32_t)((uint64_t)cycles * 1000u / (SystemCoreClock / 1000000u) / BENCH_ITERATIONS);
+	result->allocs = bench_allocs() - allocs;
+	result->peak_stack = (top > base) ? (uint32_t)(top - base) - status.usStackHighWaterMark * sizeof(StackType_t) : 0;
+}
+
+/*******************************************************************************
+ * Function Name: bench_run_parse
+ *******************************************************************************
+ * Summary:
+ *  Measures both parse stages over the corpus.
+ *
+ * Parameters:
+ *  quote_table_t *table : left holding the multi-symbol corpus, for the
+ *  format and render stages
+ *
+ *******************************************************************************/
+void bench_run_parse(quote_table_t *table) {
+	bench_parse_t parse = {table, corpusOne, sizeof(corpusOne) - 1};
+
+	bench_measure(BENCH_PARSE_ONE, bench_parse, &parse);
+
+	parse.json = corpusMany;
+	parse.len = sizeof(corpusMany) - 1;
+	bench_measure(BENCH_PARSE_MANY, bench_parse, &parse);
+}
+
+/*******************************************************************************
+ * Function Name: bench_report
+ *******************************************************************************
+ * Summary:
+ *  Prints the results against the baseline in flash. With no baseline
+ *  stored, or with BENCH_SAVE_BASELINE, this run becomes the baseline.
+ *
+ *******************************************************************************/
+void bench_report(void) {
+	bench_baseline_t baseline;
+	bool haveBaseline = (nv_store_read(NV_STORE_SLOT_BENCH_BASELINE, &baseline, sizeof(baseline)) == sizeof(baseline));
+
+	printf("bench,stage,ns/op,allocs/op,peak stack,baseline ns/op,change,verdict\n");
+	for(int i = 0; i < BENCH_STAGE_COUNT; i++) {
+		const bench_result_t *r = &results[i];
+		uint32_t allocsPerOp = r->allocs * 100u / BENCH_ITERATIONS;
+		uint32_t base = haveBaseline ? baseline.ns_per_op[i] : r->ns_per_op;
+		long permille = (base > 0) ? (long)(((int64_t)r->ns_per_op - base) * 1000 / base) : 0;
+		const char *verdict = !haveBaseline ? "baseline" : (permille > BENCH_REGRESSION_PERMILLE) ? "REGRESSED" : "ok";
+
+		printf("bench,%s,%lu,%lu.%02lu,%lu,%lu,%c%ld.%ld%%,%s\n", stageNames[i], (unsigned long)r->ns_per_op, (unsigned long)(allocsPerOp / 100),
+			   (unsigned long)(allocsPerOp % 100), (unsigned long)r->peak_stack, (unsigned long)base, (permille < 0) ? '-' : '+', labs(permille) / 10,
+			   labs(permille) % 10, verdict);
+	}
+	printf("end\n");
+
+	if(!haveBaseline || BENCH_SAVE_BASELINE) {
+		for(int i = 0; i < BENCH_STAGE_COUNT; i++) {
+			baseline.ns_per_op[i] = results[i].ns_per_op;
+		}
+		(void)nv_store_write(NV_STORE_SLOT_BENCH_BASELINE, &baseline, sizeof(baseline));
+	}
+}
+
+/*******************************************************************************
+ * Function Name: bench_parse
+ *******************************************************************************
+ * Summary:
+ *  One parse operation, the whole response into the table.
+ *
+ *******************************************************************************/
+static void bench_parse(void *arg) {
+	const bench_parse_t *parse = (const bench_parse_t *)arg;
+
+	(void)quote_table_parse(parse->table, parse->json, parse->len);
+}
+
+/*******************************************************************************
+ * Function Name: bench_allocs
+ *******************************************************************************
+ * Summary:
+ *  Allocations made so far, over all tags.
+ *
+ *******************************************************************************/
+static uint32_t bench_allocs(void) {
+	mem_tag_stats_t stats;
+	uint32_t allocs = 0;
+
+	for(int i = 0; i < MEM_TAG_COUNT; i++) {
+		mem_pool_get_stats((mem_tag_t)i, &stats);
+		allocs += stats.allocs;
+	}
+
+	return allocs;
+}
@@ -0,0 +1,60 @@
+/******************************************************************************
+* File Name:   bench.h
+*
+* Description: This file contains declarations for the per-tick benchmark.
+* Each stage of a tick (parse, format, render) is run on its own over a
+* built-in corpus of recorded responses; its cost per operation, heap
+* allocations per operation and peak stack are printed and compared against
+* a baseline kept in flash.
+*
+*******************************************************************************/
+
+#ifndef BENCH_H_
+#define BENCH_H_
+
+#include <stdint.h>
+
+#include "quote.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Timed operations per stage, after one untimed warm-up */
+#ifndef BENCH_ITERATIONS
+#define BENCH_ITERATIONS (200)
+#endif
+
+/* A stage this much slower than its baseline is flagged, in permille */
+#define BENCH_REGRESSION_PERMILLE (50)
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+typedef enum {
+	BENCH_PARSE_ONE,     // Single-symbol response
+	BENCH_PARSE_MANY,    // Multi-symbol response
+	BENCH_FORMAT,        // Every field text of one card
+	BENCH_RENDER,        // Every field of one card drawn off screen
+	BENCH_STAGE_COUNT
+} bench_stage_t;
+
+typedef void (*bench_op_t)(void *arg);
+
+typedef struct {
+	uint32_t ns_per_op;
+	uint32_t allocs;        // Over all timed operations
+	uint32_t peak_stack;    // Bytes below the caller's frame
+} bench_result_t;
+
+typedef struct {
+	uint32_t ns_per_op[BENCH_STAGE_COUNT];
+} bench_baseline_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+void bench_measure(bench_stage_t stage, bench_op_t op, void *arg);
+void bench_run_parse(quote_table_t *table);
+void bench_report(void);
+
+#endif /* BENCH_H_ */
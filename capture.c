@@ -0,0 +1,289 @@
+/******************************************************************************
+* File Name:   capture.c
+*
+* Description: This file contains the response capture log. Records are
+* packed back to back through a run of flash rows in main flash, which is
+* mapped, so a replayed body is parsed straight out of flash with no copy.
+* Each record is a header, then the raw response headers and body, padded to
+* a word:
+*
+*   magic, crc, session, seq, arrival ms, server time, status, header len, body len
+*
+* A recording starts over at the first row with a new session number, and
+* the log ends at the first record that is torn, from another session or out
+* of sequence, so whatever an older, longer recording left behind is never
+* replayed.
+*
+*******************************************************************************/
+
+/* Header file includes. */
+#include "cyhal.h"
+
+/* FreeRTOS header file. */
+#include <FreeRTOS.h>
+#include <task.h>
+
+/* Standard C header file. */
+#include <stddef.h>
+#include <string.h>
+
+#include "capture.h"
+#include "nv_store.h"
+#include "log_ring.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define CAPTURE_MAGIC    (0x43415031u)    // "CAP1"
+#define CAPTURE_ROW_SIZE (NV_STORE_ROW_SIZE)
+
+/* Only a build that records or replays pays for the flash */
+#if CAPTURE_MODE != CAPTURE_OFF
+#define CAPTURE_STORAGE_ROWS (CAPTURE_ROWS)
+#else
+#define CAPTURE_STORAGE_ROWS (1)
+#endif
+
+#define CAPTURE_STORAGE_SIZE (CAPTURE_STORAGE_ROWS * CAPTURE_ROW_SIZE)
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+typedef struct {
+	uint32_t magic;
+	uint32_t crc;    // CRC-32 of the rest of the header, the response headers and the body
+	uint32_t session;
+	uint32_t seq;    // From 0 in each session
+	uint32_t arrival_ms;
+	uint32_t server_time;
+	uint16_t status;
+	uint16_t header_len;
+	uint32_t body_len;
+} capture_header_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+static bool capture_append(const void *data, uint32_t len);
+static const capture_header_t *capture_header_at(uint32_t offset);
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+CY_SECTION(CAPTURE_SECTION) CY_ALIGN(CAPTURE_ROW_SIZE) static const volatile uint8_t captureStorage[CAPTURE_STORAGE_ROWS][CAPTURE_ROW_SIZE] = {{0}};
+
+// Record side, owned by the network task
+static uint32_t rowBuffer[CAPTURE_ROW_SIZE / sizeof(uint32_t)];    // Row being filled, zero past writeOffset
+static uint32_t writeOffset = 0;
+static uint32_t writeSession = 1;
+static uint32_t writeSeq = 0;
+static bool captureReady = false;
+
+// Replay side
+static uint32_t readOffset = 0;
+static uint32_t readSession = 0;
+static uint32_t readSeq = 0;
+
+/*******************************************************************************
+ * Function Name: capture_init
+ *******************************************************************************
+ * Summary:
+ *  Starts a new recording over the old one in record mode, or rewinds to the
+ *  first record in replay mode. Does nothing with capture off.
+ *
+ *******************************************************************************/
+void capture_init(void) {
+	const capture_header_t *first = capture_header_at(0);
+
+	if(CAPTURE_MODE == CAPTURE_OFF) {
+		return;
+	}
+
+	if(CAPTURE_MODE == CAPTURE_REPLAY) {
+		capture_rewind();
+		return;
+	}
+
+	if(nv_store_init() != CY_RSLT_SUCCESS) {
+		return;
+	}
+
+	// Newer than anything an older recording left in the rows
+	writeSession = (first->magic == CAPTURE_MAGIC) ? first->session + 1 : 1;
+	writeOffset = 0;
+	writeSeq = 0;
+	(void)memset(rowBuffer, 0, sizeof(rowBuffer));
+	captureReady = true;
+
+	LOG_INFO("Capture: recording session %lu, %lu B of flash", (unsigned long)writeSession, (unsigned long)CAPTURE_STORAGE_SIZE);
+}
+
+/*******************************************************************************
+ * Function Name: capture_write
+ *******************************************************************************
+ * Summary:
+ *  Appends a response to the log, arrival time taken now. The row it ends
+ *  in is written right away, so a reset loses at most the response being
+ *  written. Once the log is full further responses are not recorded.
+ *
+ * Parameters:
+ *  const cy_http_client_response_t *response : response as received
+ *  time_t server_time : its Date header, 0 if none
+ *
+ *******************************************************************************/
+void capture_write(const cy_http_client_response_t *response, time_t server_time) {
+	static const uint8_t padding[sizeof(uint32_t)] = {0};
+	capture_header_t header;
+	uint32_t headerLen = (response->header != NULL && response->headers_len <= UINT16_MAX) ? response->headers_len : 0;
+	uint32_t bodyLen = (response->body != NULL) ? response->body_len : 0;
+	uint32_t size = sizeof(header) + headerLen + bodyLen;
+	uint32_t pad = (sizeof(uint32_t) - size % sizeof(uint32_t)) % sizeof(uint32_t);
+
+	if(!captureReady) {
+		return;
+	}
+
+	if(writeOffset + size + pad > CAPTURE_STORAGE_SIZE) {
+		LOG_WARN("Capture: log full after %lu responses", (unsigned long)writeSeq);
+		captureReady = false;
+		return;
+	}
+
+	header.magic = CAPTURE_MAGIC;
+	header.session = writeSession;
+	header.seq = writeSeq;
+	header.arrival_ms = (uint32_t)pdTICKS_TO_MS(xTaskGetTickCount());
+	header.server_time = (uint32_t)server_time;
+	header.status = response->status_code;
+	header.header_len = (uint16_t)headerLen;
+	header.body_len = bodyLen;
+	header.crc = nv_store_crc32(0, &header.session, sizeof(header) - offsetof(capture_header_t, session));
+	header.crc = nv_store_crc32(header.crc, response->header, headerLen);
+	header.crc = nv_store_crc32(header.crc, response->body, bodyLen);
+
+	if(!capture_append(&header, sizeof(header)) || !capture_append(response->header, headerLen) || !capture_append(response->body, bodyLen) ||
+	   !capture_append(padding, pad)) {
+		LOG_ERROR("Capture: flash write failed, recording stopped");
+		captureReady = false;
+		return;
+	}
+
+	// The rest of the row, written again as the next response fills it
+	if(writeOffset % CAPTURE_ROW_SIZE != 0 &&
+	   nv_store_write_row((const void *)(uintptr_t)captureStorage[writeOffset / CAPTURE_ROW_SIZE], rowBuffer) != CY_RSLT_SUCCESS) {
+		LOG_ERROR("Capture: flash write failed, recording stopped");
+		captureReady = false;
+		return;
+	}
+
+	LOG_DEBUG("Capture: response %lu, %lu B", (unsigned long)writeSeq, (unsigned long)(size + pad));
+	writeSeq++;
+}
+
+/*******************************************************************************
+ * Function Name: capture_next
+ *******************************************************************************
+ * Summary:
+ *  Reads the next response of the recording.
+ *
+ * Return:
+ *  bool : false at the end of the recording
+ *
+ *******************************************************************************/
+bool capture_next(capture_entry_t *entry) {
+	const capture_header_t *header = capture_header_at(readOffset);
+	const uint8_t *data;
+	uint32_t size;
+	uint32_t crc;
+
+	if(header == NULL || header->magic != CAPTURE_MAGIC || header->session != readSession || header->seq != readSeq) {
+		return false;
+	}
+
+	size = sizeof(*header) + header->header_len;
+	if(header->body_len > CAPTURE_STORAGE_SIZE - readOffset - size) {
+		return false;
+	}
+	size += header->body_len;
+
+	data = (const uint8_t *)header;
+	crc = nv_store_crc32(0, &header->session, sizeof(*header) - offsetof(capture_header_t, session));
+	crc = nv_store_crc32(crc, data + sizeof(*header), header->header_len + header->body_len);
+	if(crc != header->crc) {
+		return false;
+	}
+
+	entry->seq = header->seq;
+	entry->arrival_ms = header->arrival_ms;
+	entry->server_time = (time_t)header->server_time;
+	entry->status = header->status;
+	entry->header = data + sizeof(*header);
+	entry->header_len = header->header_len;
+	entry->body = entry->header + header->header_len;
+	entry->body_len = header->body_len;
+
+	readOffset += (size + sizeof(uint32_t) - 1) & ~(sizeof(uint32_t) - 1);
+	readSeq++;
+	return true;
+}
+
+/*******************************************************************************
+ * Function Name: capture_rewind
+ *******************************************************************************
+ * Summary:
+ *  Goes back to the first response of the recording.
+ *
+ *******************************************************************************/
+void capture_rewind(void) {
+	readOffset = 0;
+	readSession = capture_header_at(0)->session;
+	readSeq = 0;
+}
+
+/*******************************************************************************
+ * Function Name: capture_append
+ *******************************************************************************
+ * Summary:
+ *  Copies bytes into the row buffer, writing each row out as it fills.
+ *
+ *******************************************************************************/
+static bool capture_append(const void *data, uint32_t len) {
+	const uint8_t *bytes = (const uint8_t *)data;
+
+	while(len > 0) {
+		uint32_t at = writeOffset % CAPTURE_ROW_SIZE;
+		uint32_t n = (len < CAPTURE_ROW_SIZE - at) ? len : CAPTURE_ROW_SIZE - at;
+
+		(void)memcpy((uint8_t *)rowBuffer + at, bytes, n);
+		writeOffset += n;
+		bytes += n;
+		len -= n;
+
+		if(at + n == CAPTURE_ROW_SIZE) {
+			if(nv_store_write_row((const void *)(uintptr_t)captureStorage[writeOffset / CAPTURE_ROW_SIZE - 1], rowBuffer) != CY_RSLT_SUCCESS) {
+				return false;
+			}
+			(void)memset(rowBuffer, 0, sizeof(rowBuffer));
+		}
+	}
+
+	return true;
+}
+
+/*******************************************************************************
+ * Function Name: capture_header_at
+ *******************************************************************************
+ * Summary:
+ *  Record header at a byte offset into the log.
+ *
+ * Return:
+ *  const capture_header_t * : NULL if a header does not fit there
+ *
+ *******************************************************************************/
+static const capture_header_t *capture_header_at(uint32_t offset) {
+	if(offset + sizeof(capture_header_t) > CAPTURE_STORAGE_SIZE) {
+		return NULL;
+	}
+
+	return (const capture_header_t *)((uintptr_t)captureStorage + offset);
+}
@@ -0,0 +1,72 @@
+/******************************************************************************
+* File Name:   capture.h
+*
+* Description: This file contains declarations for response capture and
+* replay. In record mode every response the network task receives, status,
+* raw headers, body and arrival time, is appended to a log in flash; in
+* replay mode the network task leaves Wi-Fi off and feeds the logged bodies
+* through the same parse, decode and display path instead, at their original
+* pacing or as fast as the pipeline takes them.
+*
+*******************************************************************************/
+
+#ifndef CAPTURE_H_
+#define CAPTURE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "cy_http_client_api.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define CAPTURE_OFF    (0)
+#define CAPTURE_RECORD (1)    // Log every response
+#define CAPTURE_REPLAY (2)    // Feed the log to the pipeline instead of fetching
+
+#ifndef CAPTURE_MODE
+#define CAPTURE_MODE (CAPTURE_OFF)
+#endif
+
+/* Flash rows for the log and where they live, main flash by default; a response of a few symbols takes about 6 */
+#ifndef CAPTURE_ROWS
+#define CAPTURE_ROWS (512)
+#endif
+#ifndef CAPTURE_SECTION
+#define CAPTURE_SECTION ".rodata.capture"
+#endif
+
+/* Replay keeps the recorded gaps between responses; 0 replays back to back */
+#ifndef CAPTURE_REPLAY_PACED
+#define CAPTURE_REPLAY_PACED (1)
+#endif
+
+/* Body bytes handed to the parser per call on replay, about one TCP segment */
+#define CAPTURE_REPLAY_CHUNK (1460)
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+// One logged response, pointing straight into flash
+typedef struct {
+	uint32_t seq;
+	uint32_t arrival_ms;    // Ticks since boot of the recording, in ms
+	time_t server_time;     // From the Date header, 0 if it had none
+	uint16_t status;
+	const uint8_t *header;
+	uint32_t header_len;
+	const uint8_t *body;
+	uint32_t body_len;
+} capture_entry_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+void capture_init(void);
+void capture_write(const cy_http_client_response_t *response, time_t server_time);
+bool capture_next(capture_entry_t *entry);
+void capture_rewind(void);
+
+#endif /* CAPTURE_H_ */
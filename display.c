@@ -0,0 +1,744 @@
+/******************************************************************************
+* File Name:   display.c
+*
+* Description: This file contains the display task. It owns the TFT and emWin
+* and updates one quote card per record it receives from the decode task, so
+* drawing never holds up the network. What is on screen is remembered per
+* field; only fields whose text changed are redrawn, within their own
+* rectangle, and the static labels are drawn once at boot. With
+* DISPLAY_COMPOSITE a changed card is instead rendered off screen into an
+* emWin memory device and flushed to the panel in one window write. Each card
+* keeps the day's ticks and charts them as a sparkline in its fourth row.
+* A card whose alert fired is framed for a while. At boot the cards are
+* filled from the quote log in flash, greyed out as stale, long before the
+* first fetch can complete.
+*
+*******************************************************************************/
+
+/* Header file includes. */
+#include "GUI.h"
+#include <time.h>
+
+/* FreeRTOS header file. */
+#include <FreeRTOS.h>
+#include <task.h>
+
+/* Standard C header file. */
+#include <stdio.h>
+#include <string.h>
+
+#include "display.h"
+#include "display_panel.h"
+#include "pipeline.h"
+#include "fixed_point.h"
+#include "glyph_cache.h"
+#include "tick_ring.h"
+#include "sparkline.h"
+#include "quote_log.h"
+#include "metrics.h"
+#include "log_ring.h"
+#include "bench.h"
+#include "freshness.h"
+#include "poll_scheduler.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+// Macros for GUI
+#define TFT_LEFT_ALIGNED (0)
+#define TFT_PRICE        (88)
+#define TFT_PERCENT      (210)
+#define TFT_ROW_ONE      (0)
+#define TFT_ROW_TWO      (30)
+#define TFT_ROW_THREE    (50)
+#define TFT_ROW_FOUR     (70)
+#define TFT_ROW_FIVE     (90)
+#define TFT_WIDTH        (320)
+#define TFT_HEIGHT       (240)
+#define TFT_CARD_HEIGHT  (120)    // One quote card, two fit on the 240 line panel
+#define TFT_CARD_COUNT   (TFT_HEIGHT / TFT_CARD_HEIGHT)
+#define TFT_SPARK_HEIGHT (TFT_ROW_FIVE - TFT_ROW_FOUR - 2)
+
+#define DISPLAY_FIELD_LEN (32)
+
+/* Render changed cards off screen and flush them in one blit */
+#ifndef DISPLAY_COMPOSITE
+#define DISPLAY_COMPOSITE (0)
+#endif
+
+/* emWin memory for compositing, a smaller budget flushes a card in several bands */
+#ifndef DISPLAY_COMPOSITE_RAM_BYTES
+#define DISPLAY_COMPOSITE_RAM_BYTES (TFT_WIDTH * TFT_CARD_HEIGHT * 2)
+#endif
+#define DISPLAY_COMPOSITE_BAND_LINES (DISPLAY_COMPOSITE_RAM_BYTES / (TFT_WIDTH * 2))
+
+#define DISPLAY_BYTES_PER_PIXEL (2)    // RGB565 over the 8-bit bus
+
+#define DISPLAY_STALE_COLOR (GUI_GRAY)    // Values restored from flash, not yet refreshed
+
+/* How long a card stays framed after one of its alerts fired */
+#ifndef DISPLAY_ALERT_HIGHLIGHT_MS
+#define DISPLAY_ALERT_HIGHLIGHT_MS (60 * 1000)
+#endif
+#define DISPLAY_ALERT_COLOR (GUI_YELLOW)
+
+/* Longest wait for a record, so highlights expire while no quotes arrive */
+#define DISPLAY_IDLE_MS (1000)
+
+/* Time parsing, formatting and rendering over the benchmark corpus at boot */
+#ifndef DISPLAY_BENCH
+#define DISPLAY_BENCH (0)
+#endif
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+typedef enum {
+	CARD_SYMBOL,
+	CARD_PRICE,
+	CARD_CHANGE,
+	CARD_OPEN_CLOSE,
+	CARD_LOW_HIGH,
+	CARD_TIME,
+	CARD_FIELD_COUNT
+} card_field_t;
+
+typedef struct {
+	int x;
+	int y;    // Relative to the top of the card
+	const GUI_FONT *font;
+} field_layout_t;
+
+// What a field currently shows on the panel
+typedef struct {
+	char text[DISPLAY_FIELD_LEN];
+	GUI_COLOR color;
+	int width;
+} field_state_t;
+
+// What every field of a card should show
+typedef struct {
+	char text[CARD_FIELD_COUNT][DISPLAY_FIELD_LEN];
+	GUI_COLOR color[CARD_FIELD_COUNT];
+} card_text_t;
+
+// Benchmark operand, the render stage draws the card the format stage made
+typedef struct {
+	const quote_t *quote;
+	card_text_t card;
+} card_bench_t;
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+// Indexed by card_field_t
+static const field_layout_t fieldLayout[CARD_FIELD_COUNT] = {
+	{TFT_LEFT_ALIGNED, TFT_ROW_ONE, &GUI_Font32B_ASCII}, {TFT_PRICE, TFT_ROW_ONE, &GUI_Font32B_ASCII},
+	{TFT_PERCENT, TFT_ROW_ONE, &GUI_Font32B_ASCII},      {TFT_PRICE, TFT_ROW_TWO, &GUI_Font24B_ASCII},
+	{TFT_PRICE, TFT_ROW_THREE, &GUI_Font24B_ASCII},      {TFT_LEFT_ALIGNED, TFT_ROW_FIVE, &GUI_Font20B_ASCII},
+};
+
+static field_state_t screen[TFT_CARD_COUNT][CARD_FIELD_COUNT];
+static bool cardDirty[TFT_CARD_COUNT];    // Compositing only, fields changed since the last flush
+
+static tick_ring_t cardTicks[TFT_CARD_COUNT];
+static sparkline_t cardSpark[TFT_CARD_COUNT];
+
+static bool cardHighlighted[TFT_CARD_COUNT];
+static TickType_t highlightUntil[TFT_CARD_COUNT];
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+static void display_chrome(void);
+static uint32_t display_warm_start(void);
+static uint32_t display_quote(uint32_t slot, const quote_t *quote, const indicator_values_t *indicators, bool stale);
+static void display_format_card(card_text_t *card, const quote_t *quote, const indicator_values_t *indicators, bool stale);
+static uint32_t display_tick(uint32_t slot, const quote_t *quote);
+static uint32_t display_blank(uint32_t slot);
+static uint32_t display_field(uint32_t slot, card_field_t field, const char *text, GUI_COLOR color);
+static uint32_t display_flush(uint32_t slot);
+static uint32_t display_flush_all(void);
+static uint32_t display_highlight(uint32_t slot, bool on);
+static uint32_t display_expire_highlights(void);
+static void display_draw_card(void *arg);
+static size_t display_format_money(char *buffer, size_t buffer_len, fixed_t value);
+static void display_format_pair(char *buffer, size_t buffer_len, fixed_t first, fixed_t second);
+static void display_bench(void);
+static void display_bench_format(void *arg);
+static void display_bench_render(void *arg);
+
+/*******************************************************************************
+ * Function Name: display_task
+ *******************************************************************************
+ * Summary:
+ *  Initializes the TFT, then draws quote records as they arrive.
+ *
+ * Parameters:
+ *  void *args : Task parameter defined during task creation (unused).
+ *
+ *******************************************************************************/
+void display_task(void *arg) {
+	quote_record_t record;
+
+	/* Initialize the display */
+	display_panel_init();
+	GUI_Init();
+	GUI_SetBkColor(GUI_BLACK);          // Background Color
+	GUI_SetColor(GUI_WHITE);            // Text Color
+	GUI_SetFont(&GUI_Font32B_ASCII);    // Font Size
+	GUI_Clear();
+	if(DISPLAY_BENCH) {
+		display_bench();
+	}
+	display_chrome();
+
+	for(int i = 0; i < TFT_CARD_COUNT; i++) {
+		tick_ring_reset(&cardTicks[i]);
+		sparkline_init(&cardSpark[i], TFT_LEFT_ALIGNED, i * TFT_CARD_HEIGHT + TFT_ROW_FOUR, TFT_WIDTH, TFT_SPARK_HEIGHT, GUI_YELLOW);
+	}
+	(void)display_warm_start();
+
+	while(1) {
+		uint32_t pixels = 0;
+		TickType_t start;
+		uint32_t startCycles;
+
+		if(!pipeline_receive_quote(&record, pdMS_TO_TICKS(DISPLAY_IDLE_MS))) {
+			(void)display_expire_highlights();
+			(void)display_flush_all();
+			continue;
+		}
+
+		// Only the cards that fit on screen are drawn
+		if(record.slot >= TFT_CARD_COUNT) {
+			continue;
+		}
+
+		start = xTaskGetTickCount();
+		startCycles = metrics_now();
+		pixels += display_expire_highlights();
+		if(record.alert) {
+			highlightUntil[record.slot] = start + pdMS_TO_TICKS(DISPLAY_ALERT_HIGHLIGHT_MS);
+			cardDirty[record.slot] |= !cardHighlighted[record.slot];
+			cardHighlighted[record.slot] = true;
+		}
+		pixels += display_tick(record.slot, &record.quote);
+		pixels += display_quote(record.slot, &record.quote, &record.indicators, false);
+		if(cardHighlighted[record.slot] && !DISPLAY_COMPOSITE) {
+			pixels += display_highlight(record.slot, true);
+		}
+
+		// Batch got shorter, blank the cards nothing was sent for
+		if(record.slot + 1 == record.count) {
+			for(uint32_t i = record.count; i < TFT_CARD_COUNT; i++) {
+				pixels += display_blank(i);
+			}
+		}
+
+		// Composited, a card is flushed once however many things changed on it
+		pixels += display_flush_all();
+
+		(void)metrics_record(METRICS_PHASE_RENDER, startCycles);
+		freshness_record(record.quote.timestamp, &record.stamps, xTaskGetTickCount());
+
+		LOG_DEBUG("Card %lu: %lu px, %lu bus bytes, %lu ms %s, %lu ticks in %lu B", (unsigned long)record.slot, (unsigned long)pixels,
+				  (unsigned long)(pixels * DISPLAY_BYTES_PER_PIXEL), (unsigned long)pdTICKS_TO_MS(xTaskGetTickCount() - start),
+				  DISPLAY_COMPOSITE ? "composited" : "direct", (unsigned long)cardTicks[record.slot].count,
+				  (unsigned long)(cardTicks[record.slot].count * sizeof(tick_delta_t)));
+		glyph_cache_print_stats();
+	}
+}
+
+/*******************************************************************************
+ * Function Name: display_chrome
+ *******************************************************************************
+ * Summary:
+ *  Draws the labels that never change, once for every card.
+ *
+ *******************************************************************************/
+static void display_chrome(void) {
+	GUI_SetFont(&GUI_Font24B_ASCII);    // Font Size
+	for(int i = 0; i < TFT_CARD_COUNT; i++) {
+		GUI_DispStringAt("PC/O", TFT_LEFT_ALIGNED, i * TFT_CARD_HEIGHT + TFT_ROW_TWO);
+		GUI_DispStringAt("DL/DH", TFT_LEFT_ALIGNED, i * TFT_CARD_HEIGHT + TFT_ROW_THREE);
+	}
+}
+
+/*******************************************************************************
+ * Function Name: display_warm_start
+ *******************************************************************************
+ * Summary:
+ *  Paints the last known quotes and charts from the quote log, marked stale.
+ *  The display task runs first, so this is on screen while Wi-Fi is still
+ *  joining.
+ *
+ * Return:
+ *  uint32_t : pixels pushed to the panel
+ *
+ *******************************************************************************/
+static uint32_t display_warm_start(void) {
+	static quote_t quotes[TFT_CARD_COUNT];
+	const indicator_values_t none = {0};
+	uint32_t count = quote_log_load(quotes, TFT_CARD_COUNT);
+	uint32_t pixels = 0;
+
+	for(uint32_t i = 0; i < count; i++) {
+		// The chart of the day of the last quote, nothing from the day before
+		time_t since = poll_scheduler_day_start(quotes[i].timestamp);
+
+		if(since < quotes[i].timestamp - QUOTE_LOG_HISTORY_S) {
+			since = quotes[i].timestamp - QUOTE_LOG_HISTORY_S;
+		}
+		(void)quote_log_replay_ticks(i, since, &cardTicks[i]);
+		pixels += display_quote(i, &quotes[i], &none, true);
+		if(DISPLAY_COMPOSITE) {
+			cardDirty[i] = true;
+		} else {
+			pixels += sparkline_redraw(&cardSpark[i], &cardTicks[i]);
+		}
+		pixels += display_flush(i);
+	}
+
+	if(count > 0) {
+		LOG_INFO("Warm start: %lu cards from flash, %lu px", (unsigned long)count, (unsigned long)pixels);
+	}
+
+	return pixels;
+}
+
+/*******************************************************************************
+ * Function Name: display_quote
+ *******************************************************************************
+ * Summary:
+ *  Brings one quote card up to date, touching only the fields that changed.
+ *
+ * Parameters:
+ *  uint32_t slot : card to update
+ *  const quote_t *quote : quote to show
+ *  const indicator_values_t *indicators : the symbol's indicators
+ *  bool stale : the quote was restored from flash, not fetched
+ *
+ * Return:
+ *  uint32_t : pixels pushed to the panel
+ *
+ *******************************************************************************/
+static uint32_t display_quote(uint32_t slot, const quote_t *quote, const indicator_values_t *indicators, bool stale) {
+	card_text_t card;
+	uint32_t pixels = 0;
+
+	display_format_card(&card, quote, indicators, stale);
+	for(int i = 0; i < CARD_FIELD_COUNT; i++) {
+		pixels += display_field(slot, (card_field_t)i, card.text[i], card.color[i]);
+	}
+
+	return pixels;
+}
+
+/*******************************************************************************
+ * Function Name: display_format_card
+ *******************************************************************************
+ * Summary:
+ *  Formats the text and picks the colour of every field of a quote's card.
+ *
+ *******************************************************************************/
+static void display_format_card(card_text_t *card, const quote_t *quote, const indicator_values_t *indicators, bool stale) {
+	GUI_COLOR color = stale ? DISPLAY_STALE_COLOR : GUI_WHITE;
+	char *text;
+	struct tm local;
+	size_t len;
+
+	for(int i = 0; i < CARD_FIELD_COUNT; i++) {
+		card->color[i] = color;
+	}
+
+	(void)snprintf(card->text[CARD_SYMBOL], DISPLAY_FIELD_LEN, "%s", quote->symbol);
+
+	(void)display_format_money(card->text[CARD_PRICE], DISPLAY_FIELD_LEN, quote->price);
+
+	text = card->text[CARD_CHANGE];
+	len = fixed_format(text, DISPLAY_FIELD_LEN - 1, quote->change_percent, 2, true);
+	text[len] = '%';
+	text[len + 1] = '\0';
+	card->color[CARD_CHANGE] = stale ? DISPLAY_STALE_COLOR : (quote->change_percent >= 0) ? GUI_GREEN : GUI_RED;
+
+	display_format_pair(card->text[CARD_OPEN_CLOSE], DISPLAY_FIELD_LEN, quote->previous_close, quote->open);
+
+	display_format_pair(card->text[CARD_LOW_HIGH], DISPLAY_FIELD_LEN, quote->day_low, quote->day_high);
+
+	// Quote time, then VWAP (when the feed has volume) and the move from the open
+	text = card->text[CARD_TIME];
+	(void)localtime_r(&quote->timestamp, &local);
+	len = strftime(text, DISPLAY_FIELD_LEN, stale ? "%H:%M stale" : "%H:%M ", &local);
+	if(stale) {
+		return;
+	}
+	if(indicators->has_vwap && len < DISPLAY_FIELD_LEN) {
+		(void)memcpy(text + len, "VW", 2);
+		len += 2 + display_format_money(text + len + 2, DISPLAY_FIELD_LEN - len - 2, indicators->vwap);
+	}
+	if(len + 4 < DISPLAY_FIELD_LEN) {
+		(void)memcpy(text + len, " O", 2);
+		len += 2 + fixed_format(text + len + 2, DISPLAY_FIELD_LEN - len - 3, indicators->from_open_percent, 2, true);
+		text[len] = '%';
+		text[len + 1] = '\0';
+	}
+}
+
+/*******************************************************************************
+ * Function Name: display_tick
+ *******************************************************************************
+ * Summary:
+ *  Records the quote in the card's tick ring and extends its sparkline. A
+ *  different symbol in the slot, or the first quote of a new trading day,
+ *  starts a new chart.
+ *
+ * Return:
+ *  uint32_t : pixels pushed to the panel
+ *
+ *******************************************************************************/
+static uint32_t display_tick(uint32_t slot, const quote_t *quote) {
+	tick_ring_t *ring = &cardTicks[slot];
+
+	if(strncmp(screen[slot][CARD_SYMBOL].text, quote->symbol, sizeof(quote->symbol)) != 0 ||
+	   (ring->count > 0 && poll_scheduler_day_start(quote->timestamp) != poll_scheduler_day_start(ring->last_time))) {
+		tick_ring_reset(ring);
+		cardSpark[slot].column = -1;
+	}
+
+	if(!tick_ring_push(ring, quote->timestamp, quote->price)) {
+		return 0;
+	}
+
+	if(DISPLAY_COMPOSITE) {
+		cardDirty[slot] = true;
+		return 0;
+	}
+
+	return sparkline_append(&cardSpark[slot], ring);
+}
+
+/*******************************************************************************
+ * Function Name: display_blank
+ *******************************************************************************
+ * Summary:
+ *  Empties every field of a card, the labels stay.
+ *
+ *******************************************************************************/
+static uint32_t display_blank(uint32_t slot) {
+	uint32_t pixels = 0;
+
+	if(cardTicks[slot].count > 0) {
+		tick_ring_reset(&cardTicks[slot]);
+		if(DISPLAY_COMPOSITE) {
+			cardDirty[slot] = true;
+		} else {
+			pixels += sparkline_redraw(&cardSpark[slot], &cardTicks[slot]);
+		}
+	}
+
+	for(int field = 0; field < CARD_FIELD_COUNT; field++) {
+		pixels += display_field(slot, (card_field_t)field, "", GUI_WHITE);
+	}
+
+	return pixels;
+}
+
+/*******************************************************************************
+ * Function Name: display_field
+ *******************************************************************************
+ * Summary:
+ *  Redraws a field if its text or color differ from what is on screen. The
+ *  new text is drawn with its background, so only the part of the old text
+ *  that sticks out past the new one needs clearing.
+ *
+ * Return:
+ *  uint32_t : pixels pushed to the panel, 0 if the field was unchanged
+ *
+ *******************************************************************************/
+static uint32_t display_field(uint32_t slot, card_field_t field, const char *text, GUI_COLOR color) {
+	field_state_t *state = &screen[slot][field];
+	const field_layout_t *layout = &fieldLayout[field];
+	int x = layout->x;
+	int y = (int)slot * TFT_CARD_HEIGHT + layout->y;
+	int width;
+	int height;
+	int pushed;
+
+	if(state->color == color && strncmp(state->text, text, sizeof(state->text)) == 0) {
+		return 0;
+	}
+
+	GUI_SetFont(layout->font);    // Font Size
+	height = GUI_GetFontSizeY();
+	width = GUI_GetStringDistX(text);
+
+	if(DISPLAY_COMPOSITE) {
+		// Only remember the text, display_flush renders the whole card
+		(void)snprintf(state->text, sizeof(state->text), "%s", text);
+		state->color = color;
+		state->width = width;
+		cardDirty[slot] = true;
+		return 0;
+	}
+
+	pushed = (state->width > width) ? state->width : width;
+
+	if(width > 0) {
+		GUI_SetColor(color);    // Text Color
+		(void)glyph_cache_draw_string(text, x, y);
+		GUI_SetColor(GUI_WHITE);    // Text Color
+	}
+	if(state->width > width) {
+		GUI_ClearRect(x + width, y, x + state->width - 1, y + height - 1);
+	}
+
+	(void)snprintf(state->text, sizeof(state->text), "%s", text);
+	state->color = color;
+	state->width = width;
+
+	return (uint32_t)(pushed * height);
+}
+
+/*******************************************************************************
+ * Function Name: display_flush
+ *******************************************************************************
+ * Summary:
+ *  In compositing mode, renders a changed card into a memory device and
+ *  writes it to the panel in one go. Does nothing when drawing directly.
+ *
+ * Return:
+ *  uint32_t : pixels pushed to the panel
+ *
+ *******************************************************************************/
+static uint32_t display_flush(uint32_t slot) {
+	GUI_RECT rect;
+
+	if(!DISPLAY_COMPOSITE || !cardDirty[slot]) {
+		return 0;
+	}
+
+	rect.x0 = 0;
+	rect.y0 = (int16_t)(slot * TFT_CARD_HEIGHT);
+	rect.x1 = TFT_WIDTH - 1;
+	rect.y1 = (int16_t)(rect.y0 + TFT_CARD_HEIGHT - 1);
+
+	// emWin bands the card if the budget does not cover all of it
+	(void)GUI_MEMDEV_Draw(&rect, display_draw_card, &slot, DISPLAY_COMPOSITE_BAND_LINES, 0);
+	cardDirty[slot] = false;
+
+	return TFT_WIDTH * TFT_CARD_HEIGHT;
+}
+
+/*******************************************************************************
+ * Function Name: display_flush_all
+ *******************************************************************************
+ * Summary:
+ *  Flushes every card that changed, in compositing mode.
+ *
+ * Return:
+ *  uint32_t : pixels pushed to the panel
+ *
+ *******************************************************************************/
+static uint32_t display_flush_all(void) {
+	uint32_t pixels = 0;
+
+	for(uint32_t i = 0; i < TFT_CARD_COUNT; i++) {
+		pixels += display_flush(i);
+	}
+
+	return pixels;
+}
+
+/*******************************************************************************
+ * Function Name: display_draw_card
+ *******************************************************************************
+ * Summary:
+ *  Draws a whole card from the remembered field texts, labels included.
+ *  Called by GUI_MEMDEV_Draw once per band.
+ *
+ *******************************************************************************/
+static void display_draw_card(void *arg) {
+	uint32_t slot = *(const uint32_t *)arg;
+	int top = (int)slot * TFT_CARD_HEIGHT;
+
+	GUI_Clear();
+
+	GUI_SetFont(&GUI_Font24B_ASCII);    // Font Size
+	GUI_DispStringAt("PC/O", TFT_LEFT_ALIGNED, top + TFT_ROW_TWO);
+	GUI_DispStringAt("DL/DH", TFT_LEFT_ALIGNED, top + TFT_ROW_THREE);
+
+	for(int field = 0; field < CARD_FIELD_COUNT; field++) {
+		const field_state_t *state = &screen[slot][field];
+
+		GUI_SetFont(fieldLayout[field].font);    // Font Size
+		GUI_SetColor(state->color);              // Text Color
+		(void)glyph_cache_draw_string(state->text, fieldLayout[field].x, top + fieldLayout[field].y);
+	}
+	GUI_SetColor(GUI_WHITE);    // Text Color
+
+	(void)sparkline_redraw(&cardSpark[slot], &cardTicks[slot]);
+
+	if(cardHighlighted[slot]) {
+		GUI_SetColor(DISPLAY_ALERT_COLOR);
+		GUI_DrawRect(0, top, TFT_WIDTH - 1, top + TFT_CARD_HEIGHT - 1);
+		GUI_SetColor(GUI_WHITE);    // Text Color
+	}
+}
+
+/*******************************************************************************
+ * Function Name: display_highlight
+ *******************************************************************************
+ * Summary:
+ *  Draws or erases the alert frame around a card. When drawing directly the
+ *  frame is redrawn after every update, since field backgrounds touch it.
+ *  Composited, the card is only marked for the next flush.
+ *
+ * Return:
+ *  uint32_t : pixels pushed to the panel
+ *
+ *******************************************************************************/
+static uint32_t display_highlight(uint32_t slot, bool on) {
+	int top = (int)slot * TFT_CARD_HEIGHT;
+
+	cardHighlighted[slot] = on;
+	if(DISPLAY_COMPOSITE) {
+		cardDirty[slot] = true;
+		return 0;
+	}
+
+	GUI_SetColor(on ? DISPLAY_ALERT_COLOR : GUI_BLACK);
+	GUI_DrawRect(0, top, TFT_WIDTH - 1, top + TFT_CARD_HEIGHT - 1);
+	GUI_SetColor(GUI_WHITE);    // Text Color
+
+	// Four sides, the corners drawn once
+	return 2 * (TFT_WIDTH + TFT_CARD_HEIGHT) - 4;
+}
+
+/*******************************************************************************
+ * Function Name: display_expire_highlights
+ *******************************************************************************
+ * Summary:
+ *  Takes the frame off cards whose alert is older than
+ *  DISPLAY_ALERT_HIGHLIGHT_MS.
+ *
+ * Return:
+ *  uint32_t : pixels pushed to the panel
+ *
+ *******************************************************************************/
+static uint32_t display_expire_highlights(void) {
+	TickType_t now = xTaskGetTickCount();
+	uint32_t pixels = 0;
+
+	for(uint32_t i = 0; i < TFT_CARD_COUNT; i++) {
+		if(cardHighlighted[i] && (int32_t)(now - highlightUntil[i]) >= 0) {
+			pixels += display_highlight(i, false);
+		}
+	}
+
+	return pixels;
+}
+
+/*******************************************************************************
+ * Function Name: display_format_money
+ *******************************************************************************
+ * Summary:
+ *  Formats a price as "$156.79" with the integer formatter, no float printf.
+ *
+ * Return:
+ *  size_t : length written
+ *
+ *******************************************************************************/
+static size_t display_format_money(char *buffer, size_t buffer_len, fixed_t value) {
+	if(buffer_len < 2) {
+		return 0;
+	}
+
+	buffer[0] = '$';
+	return 1 + fixed_format(buffer + 1, buffer_len - 1, value, 2, false);
+}
+
+/*******************************************************************************
+ * Function Name: display_format_pair
+ *******************************************************************************
+ * Summary:
+ *  Formats two prices as "$1.00 / $2.00".
+ *
+ *******************************************************************************/
+static void display_format_pair(char *buffer, size_t buffer_len, fixed_t first, fixed_t second) {
+	static const char separator[] = " / ";
+	size_t len = display_format_money(buffer, buffer_len, first);
+
+	if(len + sizeof(separator) > buffer_len) {
+		return;
+	}
+	(void)memcpy(buffer + len, separator, sizeof(separator));
+	len += sizeof(separator) - 1;
+	(void)display_format_money(buffer + len, buffer_len - len, second);
+}
+
+/*******************************************************************************
+ * Function Name: display_bench
+ *******************************************************************************
+ * Summary:
+ *  Runs the per-tick benchmark with the real parse, card formatting and
+ *  field drawing code. The card is drawn into a memory device that never
+ *  reaches the panel. Runs in the display task, the highest priority one,
+ *  before any quote arrives.
+ *
+ *******************************************************************************/
+static void display_bench(void) {
+	static quote_table_t table;
+	static card_bench_t bench;
+	GUI_MEMDEV_Handle memdev;
+
+	bench_run_parse(&table);
+
+	bench.quote = &table.quotes[0];
+	bench_measure(BENCH_FORMAT, display_bench_format, &bench);
+
+	memdev = GUI_MEMDEV_Create(0, 0, TFT_WIDTH, TFT_CARD_HEIGHT);
+	if(memdev != 0) {
+		(void)GUI_MEMDEV_Select(memdev);
+		bench_measure(BENCH_RENDER, display_bench_render, &bench);
+		(void)GUI_MEMDEV_Select(0);
+		GUI_MEMDEV_Delete(memdev);
+	}
+
+	bench_report();
+	GUI_SetColor(GUI_WHITE);            // Text Color
+	GUI_SetFont(&GUI_Font32B_ASCII);    // Font Size
+}
+
+/*******************************************************************************
+ * Function Name: display_bench_format
+ *******************************************************************************
+ * Summary:
+ *  One format operation, the text of a whole card with VWAP and the move
+ *  from the open shown, as on a tick with volume.
+ *
+ *******************************************************************************/
+static void display_bench_format(void *arg) {
+	card_bench_t *bench = (card_bench_t *)arg;
+	indicator_values_t indicators = {.vwap = bench->quote->price, .from_open_percent = bench->quote->change_percent, .has_vwap = true};
+
+	display_format_card(&bench->card, bench->quote, &indicators, false);
+}
+
+/*******************************************************************************
+ * Function Name: display_bench_render
+ *******************************************************************************
+ * Summary:
+ *  One render operation, every field of the formatted card drawn at its
+ *  place.
+ *
+ *******************************************************************************/
+static void display_bench_render(void *arg) {
+	const card_text_t *card = &((const card_bench_t *)arg)->card;
+
+	for(int i = 0; i < CARD_FIELD_COUNT; i++) {
+		GUI_SetFont(fieldLayout[i].font);    // Font Size
+		GUI_SetColor(card->color[i]);        // Text Color
+		(void)glyph_cache_draw_string(card->text[i], fieldLayout[i].x, fieldLayout[i].y);
+	}
+}
@@ -0,0 +1,17 @@
+/******************************************************************************
+* File Name:   display.h
+*
+* Description: This file contains declarations for the display task, the only
+* task that talks to emWin.
+*
+*******************************************************************************/
+
+#ifndef DISPLAY_H_
+#define DISPLAY_H_
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+void display_task(void *arg);
+
+#endif /* DISPLAY_H_ */
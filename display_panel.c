@@ -0,0 +1,42 @@
+/******************************************************************************
+* File Name:   display_panel.c
+*
+* Description: This file contains the bring-up of the CY8CKIT-028-TFT panel,
+* the only board-specific part of the display. emWin drives the panel
+* through the ST7789V driver from here on.
+*
+*******************************************************************************/
+
+/* Header file includes. */
+#include "cyhal.h"
+#include "cybsp.h"
+#include "mtb_st7789v.h"
+#include "cy8ckit_028_tft_pins.h"
+
+#include "display_panel.h"
+
+/*******************************************************************************
+ * Function Name: display_panel_init
+ *******************************************************************************
+ * Summary:
+ *  Resets the panel and sets up its 8 bit parallel bus. Must run before
+ *  GUI_Init.
+ *
+ *******************************************************************************/
+void display_panel_init(void) {
+	/* The pins below are defined by the CY8CKIT-028-TFT library. If the display is being used on different hardware the mappings will be different. */
+	const mtb_st7789v_pins_t tft_pins = {.db08 = CY8CKIT_028_TFT_PIN_DISPLAY_DB8,
+										 .db09 = CY8CKIT_028_TFT_PIN_DISPLAY_DB9,
+										 .db10 = CY8CKIT_028_TFT_PIN_DISPLAY_DB10,
+										 .db11 = CY8CKIT_028_TFT_PIN_DISPLAY_DB11,
+										 .db12 = CY8CKIT_028_TFT_PIN_DISPLAY_DB12,
+										 .db13 = CY8CKIT_028_TFT_PIN_DISPLAY_DB13,
+										 .db14 = CY8CKIT_028_TFT_PIN_DISPLAY_DB14,
+										 .db15 = CY8CKIT_028_TFT_PIN_DISPLAY_DB15,
+										 .nrd = CY8CKIT_028_TFT_PIN_DISPLAY_NRD,
+										 .nwr = CY8CKIT_028_TFT_PIN_DISPLAY_NWR,
+										 .dc = CY8CKIT_028_TFT_PIN_DISPLAY_DC,
+										 .rst = CY8CKIT_028_TFT_PIN_DISPLAY_RST};
+
+	mtb_st7789v_init8(&tft_pins);
+}
@@ -0,0 +1,16 @@
+/******************************************************************************
+* File Name:   display_panel.h
+*
+* Description: This file contains declarations for the TFT panel bring-up.
+*
+*******************************************************************************/
+
+#ifndef DISPLAY_PANEL_H_
+#define DISPLAY_PANEL_H_
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+void display_panel_init(void);
+
+#endif /* DISPLAY_PANEL_H_ */
@@ -0,0 +1,170 @@
+/******************************************************************************
+* File Name:   fixed_point.c
+*
+* Description: This file contains the decimal parser and formatter for fixed
+* point values.
+*
+*******************************************************************************/
+
+#include "fixed_point.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+// Significant digits kept by the parser, the rest only move the exponent
+#define PARSE_MAX_DIGITS (18)
+
+/*******************************************************************************
+ * Function Name: fixed_parse
+ *******************************************************************************
+ * Summary:
+ *  Converts a JSON number to 1e-4 units, rounding half away from zero.
+ *  Exponents are honoured (FMP sends e.g. 2.52131E11 for large caps), values
+ *  out of range saturate.
+ *
+ * Return:
+ *  fixed_t : value of the text, 0 if it is not a number (e.g. null)
+ *
+ *******************************************************************************/
+fixed_t fixed_parse(const char *text, size_t len) {
+	uint64_t mantissa = 0;
+	int digits = 0;
+	int exponent = FIXED_DECIMALS;
+	int explicitExponent = 0;
+	int exponentSign = 1;
+	bool negative = false;
+	bool fraction = false;
+	size_t i = 0;
+
+	if(i < len && (text[i] == '-' || text[i] == '+')) {
+		negative = (text[i] == '-');
+		i++;
+	}
+
+	for(; i < len; i++) {
+		char c = text[i];
+
+		if(c >= '0' && c <= '9') {
+			if(digits < PARSE_MAX_DIGITS) {
+				if(mantissa != 0 || c != '0') {
+					digits++;
+				}
+				mantissa = mantissa * 10u + (uint64_t)(c - '0');
+				exponent -= fraction ? 1 : 0;
+			} else {
+				exponent += fraction ? 0 : 1;
+			}
+		} else if(c == '.' && !fraction) {
+			fraction = true;
+		} else if(c == 'e' || c == 'E') {
+			i++;
+			if(i < len && (text[i] == '-' || text[i] == '+')) {
+				exponentSign = (text[i] == '-') ? -1 : 1;
+				i++;
+			}
+			for(; i < len && text[i] >= '0' && text[i] <= '9' && explicitExponent < 1000; i++) {
+				explicitExponent = explicitExponent * 10 + (text[i] - '0');
+			}
+			break;
+		} else {
+			return 0;
+		}
+	}
+
+	// mantissa * 10^exponent is now the value in 1e-4 units
+	exponent += exponentSign * explicitExponent;
+	for(; exponent > 0 && mantissa != 0; exponent--) {
+		if(mantissa > (uint64_t)INT64_MAX / 10u) {
+			mantissa = (uint64_t)INT64_MAX;
+			break;
+		}
+		mantissa *= 10u;
+	}
+	if(exponent < 0) {
+		if(exponent < -PARSE_MAX_DIGITS - 1) {
+			mantissa = 0;
+		} else {
+			for(; exponent < -1; exponent++) {
+				mantissa /= 10u;
+			}
+			mantissa = (mantissa + 5u) / 10u;
+		}
+	}
+	if(mantissa > (uint64_t)INT64_MAX) {
+		mantissa = (uint64_t)INT64_MAX;
+	}
+
+	return negative ? -(fixed_t)mantissa : (fixed_t)mantissa;
+}
+
+/*******************************************************************************
+ * Function Name: fixed_format
+ *******************************************************************************
+ * Summary:
+ *  Writes a value with the given number of decimals (at most FIXED_DECIMALS),
+ *  rounding half away from zero, e.g. 1567890 with 2 decimals is "156.79".
+ *
+ * Parameters:
+ *  char *buffer : destination, always terminated
+ *  size_t buffer_len : size of buffer
+ *  fixed_t value : value in 1e-4 units
+ *  uint32_t decimals : digits after the point
+ *  bool plus_sign : prefix positive values (and zero) with '+'
+ *
+ * Return:
+ *  size_t : length written, 0 if it did not fit
+ *
+ *******************************************************************************/
+size_t fixed_format(char *buffer, size_t buffer_len, fixed_t value, uint32_t decimals, bool plus_sign) {
+	char digitsOut[24];
+	size_t count = 0;
+	size_t len = 0;
+	uint64_t magnitude;
+	uint32_t drop;
+	bool negative;
+
+	if(decimals > FIXED_DECIMALS) {
+		decimals = FIXED_DECIMALS;
+	}
+
+	magnitude = (value < 0) ? (uint64_t)0 - (uint64_t)value : (uint64_t)value;
+
+	// Round away the decimals not shown
+	drop = FIXED_DECIMALS - decimals;
+	if(drop > 0) {
+		uint64_t divisor = 1;
+		for(uint32_t i = 0; i < drop; i++) {
+			divisor *= 10u;
+		}
+		magnitude = (magnitude + divisor / 2u) / divisor;
+	}
+	negative = (value < 0) && (magnitude != 0);    // No "-0.00"
+
+	// Digits come out least significant first, at least one before the point
+	do {
+		digitsOut[count++] = (char)('0' + magnitude % 10u);
+		magnitude /= 10u;
+	} while(magnitude != 0 || count <= decimals);
+
+	if(count + 3 > buffer_len) {
+		if(buffer_len > 0) {
+			buffer[0] = '\0';
+		}
+		return 0;
+	}
+
+	if(negative) {
+		buffer[len++] = '-';
+	} else if(plus_sign) {
+		buffer[len++] = '+';
+	}
+	while(count > 0) {
+		if(count == decimals && decimals > 0) {
+			buffer[len++] = '.';
+		}
+		buffer[len++] = digitsOut[--count];
+	}
+	buffer[len] = '\0';
+
+	return len;
+}
@@ -0,0 +1,37 @@
+/******************************************************************************
+* File Name:   fixed_point.h
+*
+* Description: This file contains the fixed-point decimal type prices and
+* percentages are kept in. Values are int64 counts of 1e-4, parsed straight
+* from JSON text and formatted with integer math only, so the fetch-to-pixel
+* path needs no double or float printf.
+*
+*******************************************************************************/
+
+#ifndef FIXED_POINT_H_
+#define FIXED_POINT_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define FIXED_DECIMALS (4)
+#define FIXED_SCALE    (10000)    // 10^FIXED_DECIMALS
+
+#define FIXED_FROM_INT(i) ((fixed_t)(i) * FIXED_SCALE)
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+typedef int64_t fixed_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+fixed_t fixed_parse(const char *text, size_t len);
+size_t fixed_format(char *buffer, size_t buffer_len, fixed_t value, uint32_t decimals, bool plus_sign);
+
+#endif /* FIXED_POINT_H_ */
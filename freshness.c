@@ -0,0 +1,172 @@
+/******************************************************************************
+* File Name:   freshness.c
+*
+* Description: This file contains the quote freshness trace. Stage times are
+* tick differences; the age at display is measured against the wall clock
+* synced from the server's Date header, so it is good to about a second,
+* the resolution of both that header and the quote timestamps. Entries are
+* only written by the display task. The dump, all times in ms, is:
+*
+*   freshness,<stage>,<count>,<p50>,<p90>,<p99>,<max>
+*
+*******************************************************************************/
+
+/* Header file includes. */
+#include "cyhal.h"
+
+/* FreeRTOS header file. */
+#include <FreeRTOS.h>
+#include <task.h>
+
+/* Standard C header file. */
+#include <stdio.h>
+
+#include "freshness.h"
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+// Wall clock at a tick, written by the network task
+static time_t clockTime = 0;
+static TickType_t clockTick = 0;
+
+// Fetch in progress, owned by the network task
+static freshness_stamps_t current;
+
+static freshness_entry_t ring[FRESHNESS_RING_LEN];
+static uint32_t recorded = 0;
+
+static const char *const stageNames[FRESHNESS_STAGE_COUNT] = {"server_to_fetch", "fetch_to_first_byte", "first_byte_to_parsed", "parsed_to_flush",
+															  "age_at_display"};
+
+/*******************************************************************************
+ * Function Name: freshness_sync_clock
+ *******************************************************************************
+ * Summary:
+ *  Sets the wall clock quote ages are measured with.
+ *
+ *******************************************************************************/
+void freshness_sync_clock(time_t wall_time, TickType_t tick) {
+	taskENTER_CRITICAL();
+	clockTime = wall_time;
+	clockTick = tick;
+	taskEXIT_CRITICAL();
+}
+
+/*******************************************************************************
+ * Function Name: freshness_fetch_start
+ *******************************************************************************
+ * Summary:
+ *  Marks the start of a fetch, before any connect. Network task only.
+ *
+ *******************************************************************************/
+void freshness_fetch_start(void) {
+	current.fetch_start = xTaskGetTickCount();
+	current.first_byte = current.fetch_start;
+}
+
+/*******************************************************************************
+ * Function Name: freshness_first_byte
+ *******************************************************************************
+ * Summary:
+ *  Marks the first response byte of the fetch. Network task only.
+ *
+ *******************************************************************************/
+void freshness_first_byte(void) {
+	current.first_byte = xTaskGetTickCount();
+}
+
+/*******************************************************************************
+ * Function Name: freshness_parsed
+ *******************************************************************************
+ * Summary:
+ *  Stamps a parsed body with the times of the fetch it came from. Network
+ *  task only.
+ *
+ *******************************************************************************/
+void freshness_parsed(freshness_stamps_t *stamps) {
+	*stamps = current;
+	stamps->parsed = xTaskGetTickCount();
+}
+
+/*******************************************************************************
+ * Function Name: freshness_record
+ *******************************************************************************
+ * Summary:
+ *  Adds a quote whose card just reached the panel. Nothing is recorded until
+ *  the clock has been synced.
+ *
+ * Parameters:
+ *  time_t server_time : the quote's own timestamp
+ *  const freshness_stamps_t *stamps : times of the fetch that brought it
+ *  TickType_t flushed : tick the card was on the panel
+ *
+ *******************************************************************************/
+void freshness_record(time_t server_time, const freshness_stamps_t *stamps, TickType_t flushed) {
+	freshness_entry_t *entry = &ring[recorded % FRESHNESS_RING_LEN];
+	time_t wallTime;
+	TickType_t wallTick;
+	int64_t age;
+
+	taskENTER_CRITICAL();
+	wallTime = clockTime;
+	wallTick = clockTick;
+	taskEXIT_CRITICAL();
+
+	if(wallTime == 0 || server_time == 0) {
+		return;
+	}
+
+	age = (int64_t)(wallTime - server_time) * 1000 + (int32_t)pdTICKS_TO_MS(flushed - wallTick);
+	age = (age > INT32_MAX) ? INT32_MAX : age;
+
+	entry->server_time = server_time;
+	entry->ms[FRESHNESS_FETCH_TO_FIRST_BYTE] = (int32_t)pdTICKS_TO_MS(stamps->first_byte - stamps->fetch_start);
+	entry->ms[FRESHNESS_FIRST_BYTE_TO_PARSED] = (int32_t)pdTICKS_TO_MS(stamps->parsed - stamps->first_byte);
+	entry->ms[FRESHNESS_PARSED_TO_FLUSH] = (int32_t)pdTICKS_TO_MS(flushed - stamps->parsed);
+	entry->ms[FRESHNESS_AGE_AT_DISPLAY] = (int32_t)age;
+	entry->ms[FRESHNESS_SERVER_TO_FETCH] = (int32_t)age - (int32_t)pdTICKS_TO_MS(flushed - stamps->fetch_start);
+	recorded++;
+}
+
+/*******************************************************************************
+ * Function Name: freshness_dump
+ *******************************************************************************
+ * Summary:
+ *  Prints the percentiles of every stage over the entries in the ring, in
+ *  the CSV format described at the top of this file.
+ *
+ *******************************************************************************/
+void freshness_dump(void) {
+	static freshness_entry_t copy[FRESHNESS_RING_LEN];
+	static int32_t values[FRESHNESS_RING_LEN];
+	uint32_t count;
+
+	// Consistent copy, the display task writes at a higher priority
+	vTaskSuspendAll();
+	count = (recorded < FRESHNESS_RING_LEN) ? recorded : FRESHNESS_RING_LEN;
+	for(uint32_t i = 0; i < count; i++) {
+		copy[i] = ring[i];
+	}
+	(void)xTaskResumeAll();
+
+	for(int stage = 0; stage < FRESHNESS_STAGE_COUNT; stage++) {
+		// Insertion sort, the ring is small
+		for(uint32_t i = 0; i < count; i++) {
+			int32_t value = copy[i].ms[stage];
+			uint32_t j = i;
+
+			for(; j > 0 && values[j - 1] > value; j--) {
+				values[j] = values[j - 1];
+			}
+			values[j] = value;
+		}
+
+		if(count == 0) {
+			printf("freshness,%s,0,0,0,0,0\n", stageNames[stage]);
+			continue;
+		}
+		printf("freshness,%s,%lu,%ld,%ld,%ld,%ld\n", stageNames[stage], (unsigned long)count, (long)values[(count - 1) * 50 / 100],
+			   (long)values[(count - 1) * 90 / 100], (long)values[(count - 1) * 99 / 100], (long)values[count - 1]);
+	}
+}
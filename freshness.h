@@ -0,0 +1,63 @@
+/******************************************************************************
+* File Name:   freshness.h
+*
+* Description: This file contains declarations for the quote freshness
+* trace. Each quote carries the tick it was fetched at, the tick its first
+* response byte arrived and the tick its body was parsed; when its card is on
+* the panel the display adds the flush tick and its age against the server
+* timestamp, and the lot goes into a fixed ring. Percentiles of the age and
+* of each stage are dumped as CSV with the metrics.
+*
+*******************************************************************************/
+
+#ifndef FRESHNESS_H_
+#define FRESHNESS_H_
+
+#include <stdint.h>
+#include <time.h>
+
+/* FreeRTOS header file. */
+#include <FreeRTOS.h>
+#include <task.h>
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Displayed quotes kept for the percentiles */
+#define FRESHNESS_RING_LEN (64)
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+// Ticks one fetch went through, carried with each of its quotes
+typedef struct {
+	TickType_t fetch_start;
+	TickType_t first_byte;
+	TickType_t parsed;
+} freshness_stamps_t;
+
+typedef enum {
+	FRESHNESS_SERVER_TO_FETCH,        // Quote time to the fetch that got it, mostly the poll period
+	FRESHNESS_FETCH_TO_FIRST_BYTE,    // Connect, request and server think time
+	FRESHNESS_FIRST_BYTE_TO_PARSED,   // Body transfer, parsed as it arrives
+	FRESHNESS_PARSED_TO_FLUSH,        // Indicators, alerts, queueing and drawing
+	FRESHNESS_AGE_AT_DISPLAY,         // Quote time to pixels, the sum of the above
+	FRESHNESS_STAGE_COUNT
+} freshness_stage_t;
+
+typedef struct {
+	time_t server_time;
+	int32_t ms[FRESHNESS_STAGE_COUNT];
+} freshness_entry_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+void freshness_sync_clock(time_t wall_time, TickType_t tick);
+void freshness_fetch_start(void);
+void freshness_first_byte(void);
+void freshness_parsed(freshness_stamps_t *stamps);
+void freshness_record(time_t server_time, const freshness_stamps_t *stamps, TickType_t flushed);
+void freshness_dump(void);
+
+#endif /* FRESHNESS_H_ */
@@ -0,0 +1,141 @@
+/******************************************************************************
+* File Name:   glyph_cache.c
+*
+* Description: This file contains the glyph cache. Glyphs are rendered on first
+* use with the current font, color and background into a memory device per
+* character, and blitted from then on. Fonts and colors other than the ones
+* the cards use, and glyphs emWin has no memory left for, fall back to normal
+* character drawing.
+*
+*******************************************************************************/
+
+/* Standard C header file. */
+#include <stdio.h>
+#include <string.h>
+
+#include "glyph_cache.h"
+#include "log_ring.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define CHARSET_LEN (sizeof(GLYPH_CACHE_CHARSET) - 1)
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+// Font and color combinations the quote cards draw numbers in
+static const GUI_FONT *const cachedFonts[] = {&GUI_Font32B_ASCII, &GUI_Font24B_ASCII};
+static const GUI_COLOR cachedColors[] = {GUI_WHITE, GUI_GREEN, GUI_RED};
+
+#define FONT_COUNT  (sizeof(cachedFonts) / sizeof(cachedFonts[0]))
+#define COLOR_COUNT (sizeof(cachedColors) / sizeof(cachedColors[0]))
+
+static GUI_MEMDEV_Handle glyphs[FONT_COUNT][COLOR_COUNT][CHARSET_LEN];
+static uint32_t glyphsRendered;
+static uint32_t glyphBlits;
+static uint32_t glyphFallbacks;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+static GUI_MEMDEV_Handle glyph_cache_get(char c);
+
+/*******************************************************************************
+ * Function Name: glyph_cache_draw_string
+ *******************************************************************************
+ * Summary:
+ *  Draws a string like GUI_DispStringAt, in the current font and color, with
+ *  cached glyphs where there are any.
+ *
+ * Return:
+ *  int : width drawn in pixels
+ *
+ *******************************************************************************/
+int glyph_cache_draw_string(const char *text, int x, int y) {
+	int start = x;
+
+	for(; *text != '\0'; text++) {
+		GUI_MEMDEV_Handle glyph = GLYPH_CACHE_ENABLE ? glyph_cache_get(*text) : 0;
+
+		if(glyph != 0) {
+			GUI_MEMDEV_WriteAt(glyph, x, y);
+			glyphBlits++;
+		} else {
+			GUI_DispCharAt((uint16_t)*text, x, y);
+			glyphFallbacks++;
+		}
+		x += GUI_GetCharDistX((uint16_t)*text);
+	}
+
+	return x - start;
+}
+
+/*******************************************************************************
+ * Function Name: glyph_cache_print_stats
+ *******************************************************************************
+ * Summary:
+ *  Prints how many glyphs were rendered, blitted and drawn uncached.
+ *
+ *******************************************************************************/
+void glyph_cache_print_stats(void) {
+	LOG_DEBUG("Glyph cache: %lu rendered, %lu blits, %lu uncached", (unsigned long)glyphsRendered, (unsigned long)glyphBlits,
+			  (unsigned long)glyphFallbacks);
+}
+
+/*******************************************************************************
+ * Function Name: glyph_cache_get
+ *******************************************************************************
+ * Summary:
+ *  Looks up the glyph for a character in the current font and color,
+ *  rendering it on first use.
+ *
+ * Return:
+ *  GUI_MEMDEV_Handle : the glyph, 0 if it is not cached
+ *
+ *******************************************************************************/
+static GUI_MEMDEV_Handle glyph_cache_get(char c) {
+	const GUI_FONT *font = GUI_GetFont();
+	GUI_COLOR color = GUI_GetColor();
+	const char *found = strchr(GLYPH_CACHE_CHARSET, c);
+	uint32_t f, k, i;
+	GUI_MEMDEV_Handle *glyph;
+	GUI_MEMDEV_Handle previous;
+
+	if(c == '\0' || found == NULL) {
+		return 0;
+	}
+	i = (uint32_t)(found - GLYPH_CACHE_CHARSET);
+
+	for(f = 0; f < FONT_COUNT; f++) {
+		if(cachedFonts[f] == font) {
+			break;
+		}
+	}
+	for(k = 0; k < COLOR_COUNT; k++) {
+		if(cachedColors[k] == color) {
+			break;
+		}
+	}
+	if(f == FONT_COUNT || k == COLOR_COUNT) {
+		return 0;
+	}
+
+	glyph = &glyphs[f][k][i];
+	if(*glyph != 0) {
+		return *glyph;
+	}
+
+	// Rasterize once, with the background so the blit fully covers the old glyph
+	*glyph = GUI_MEMDEV_Create(0, 0, GUI_GetCharDistX((uint16_t)c), GUI_GetFontSizeY());
+	if(*glyph == 0) {
+		return 0;
+	}
+	previous = GUI_MEMDEV_Select(*glyph);
+	GUI_Clear();
+	GUI_DispCharAt((uint16_t)c, 0, 0);
+	(void)GUI_MEMDEV_Select(previous);
+	glyphsRendered++;
+
+	return *glyph;
+}
@@ -0,0 +1,31 @@
+/******************************************************************************
+* File Name:   glyph_cache.h
+*
+* Description: This file contains declarations for the glyph cache. The
+* characters numeric fields are made of are rasterized once per font and color
+* into emWin memory devices and then drawn as plain blits.
+*
+*******************************************************************************/
+
+#ifndef GLYPH_CACHE_H_
+#define GLYPH_CACHE_H_
+
+#include "GUI.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#ifndef GLYPH_CACHE_ENABLE
+#define GLYPH_CACHE_ENABLE (1)
+#endif
+
+/* Characters that are cached, everything else is drawn by emWin as usual */
+#define GLYPH_CACHE_CHARSET "0123456789.$%+-/ "
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+int glyph_cache_draw_string(const char *text, int x, int y);
+void glyph_cache_print_stats(void);
+
+#endif /* GLYPH_CACHE_H_ */
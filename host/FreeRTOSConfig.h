@@ -0,0 +1,107 @@
+/******************************************************************************
+* File Name:   FreeRTOSConfig.h
+*
+* Description: Kernel configuration of the host build, for the FreeRTOS
+* POSIX port. It follows the target's FreeRTOSConfig.h in the repository
+* root, except where a host differs:
+*
+*  - Stacks are counted in 8 byte words and raised to a floor (board.c), so
+*    the heap is larger to hold them next to what the firmware allocates.
+*  - Task stacks are threads' stacks, overflow checking does not apply.
+*  - There is no newlib, no tickless idle and no interrupt priorities.
+*
+*******************************************************************************/
+
+#ifndef FREERTOS_CONFIG_H
+#define FREERTOS_CONFIG_H
+
+#include <stdint.h>
+
+#include "cyhal.h"
+
+#define configUSE_PREEMPTION                    1
+#define configUSE_PORT_OPTIMISED_TASK_SELECTION 0
+extern uint32_t SystemCoreClock;
+#define configCPU_CLOCK_HZ                      SystemCoreClock
+#define configTICK_RATE_HZ                      1000u
+#define configMAX_PRIORITIES                    7
+#define configMINIMAL_STACK_SIZE                4096    /* 32 KB, the floor board.c raises task stacks to */
+#define configMAX_TASK_NAME_LEN                 16
+#define configUSE_16_BIT_TICKS                  0
+#define configIDLE_SHOULD_YIELD                 1
+#define configUSE_TASK_NOTIFICATIONS            1
+#define configUSE_MUTEXES                       1
+#define configUSE_RECURSIVE_MUTEXES             1
+#define configUSE_COUNTING_SEMAPHORES           1
+#define configQUEUE_REGISTRY_SIZE               10
+#define configUSE_QUEUE_SETS                    0
+#define configUSE_TIME_SLICING                  1
+#define configENABLE_BACKWARD_COMPATIBILITY     0
+#define configNUM_THREAD_LOCAL_STORAGE_POINTERS 5
+
+/* Memory allocation related definitions. */
+#define configSUPPORT_STATIC_ALLOCATION         0
+#define configSUPPORT_DYNAMIC_ALLOCATION        1
+#define configTOTAL_HEAP_SIZE                   (1024 * 1024)    /* Also backs malloc, see mem_pool.c */
+#define configAPPLICATION_ALLOCATED_HEAP        1                /* ucHeap is defined in mem_pool.c */
+
+/* Hook function related definitions. */
+#define configUSE_IDLE_HOOK                     0
+#define configUSE_TICK_HOOK                     0
+#define configCHECK_FOR_STACK_OVERFLOW          0
+#define configUSE_MALLOC_FAILED_HOOK            1
+#define configUSE_DAEMON_TASK_STARTUP_HOOK      0
+
+/* Run time and task stats gathering related definitions. */
+#define configGENERATE_RUN_TIME_STATS           1
+#define configUSE_TRACE_FACILITY                1
+/* Run time stats are clocked by the DWT cycle counter, see metrics.c and host/board.c */
+extern void metrics_init_cycle_counter(void);
+extern uint32_t metrics_run_time(void);
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS() metrics_init_cycle_counter()
+#define portGET_RUN_TIME_COUNTER_VALUE()         metrics_run_time()
+#define configUSE_STATS_FORMATTING_FUNCTIONS    0
+
+/* Co-routine related definitions. */
+#define configUSE_CO_ROUTINES                   0
+#define configMAX_CO_ROUTINE_PRIORITIES         1
+
+/* Software timer related definitions. */
+#define configUSE_TIMERS                        1
+#define configTIMER_TASK_PRIORITY               3
+#define configTIMER_QUEUE_LENGTH                10
+#define configTIMER_TASK_STACK_DEPTH            ( configMINIMAL_STACK_SIZE * 2 )
+
+/* Set the following definitions to 1 to include the API function, or zero
+to exclude the API function. */
+#define INCLUDE_vTaskPrioritySet                1
+#define INCLUDE_uxTaskPriorityGet               1
+#define INCLUDE_vTaskDelete                     1
+#define INCLUDE_vTaskSuspend                    1
+#define INCLUDE_xResumeFromISR                  1
+#define INCLUDE_vTaskDelayUntil                 1
+#define INCLUDE_vTaskDelay                      1
+#define INCLUDE_xTaskGetSchedulerState          1
+#define INCLUDE_xTaskGetCurrentTaskHandle       1
+#define INCLUDE_uxTaskGetStackHighWaterMark     0
+#define INCLUDE_xTaskGetIdleTaskHandle          0
+#define INCLUDE_eTaskGetState                   0
+#define INCLUDE_xEventGroupSetBitFromISR        1
+#define INCLUDE_xTimerPendFunctionCall          1
+#define INCLUDE_xTaskAbortDelay                 0
+#define INCLUDE_xTaskGetHandle                  0
+#define INCLUDE_xTaskResumeFromISR              1
+
+/* Normal assert() semantics without relying on the provision of an assert.h
+header file. */
+#if defined(NDEBUG)
+#define configASSERT( x ) CY_UNUSED_PARAMETER( x )
+#else
+#define configASSERT( x ) if( ( x ) == 0 ) { taskDISABLE_INTERRUPTS(); CY_HALT(); }
+#endif
+
+#define configHEAP_ALLOCATION_SCHEME            (4)     /* heap_4.c, as on the target */
+#define configUSE_TICKLESS_IDLE                 0
+#define configUSE_NEWLIB_REENTRANT              0
+
+#endif /* FREERTOS_CONFIG_H */
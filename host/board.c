@@ -0,0 +1,187 @@
+/******************************************************************************
+* File Name:   board.c
+*
+* Description: This file contains the host side of the board: the cycle
+* counter, the debug UART on the terminal, the Wi-Fi and panel bring-up
+* (nothing to do on a host), the flash file and the task stack floor.
+*
+* Flash is kept in the file named by HOST_FLASH_FILE, flash.bin by default,
+* so API key usage, the quote log and a capture survive a restart like a
+* reset of the board.
+*
+*******************************************************************************/
+
+/* Standard C header file. */
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Header file includes. */
+#include "cy_pdl.h"
+#include "cyhal.h"
+#include "cybsp.h"
+#include "cy_retarget_io.h"
+#include "cy_wcm.h"
+#include "mtb_st7789v.h"
+#include "host_flash.h"
+
+/* FreeRTOS header file. */
+#include <FreeRTOS.h>
+#include <task.h>
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define HOST_FLASH_DEFAULT_FILE "flash.bin"
+
+// Smallest task stack in bytes. The C library's calls need far more stack on
+// a host than the target's tasks are given, and threads have a floor of their own
+#define HOST_TASK_STACK_MIN_BYTES (32 * 1024)
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+BaseType_t __real_xTaskCreate(TaskFunction_t code, const char *const name, const configSTACK_DEPTH_TYPE depth, void *const arg,
+							  UBaseType_t priority, TaskHandle_t *const handle);
+BaseType_t __wrap_xTaskCreate(TaskFunction_t code, const char *const name, const configSTACK_DEPTH_TYPE depth, void *const arg,
+							  UBaseType_t priority, TaskHandle_t *const handle);
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+uint32_t SystemCoreClock = HOST_CORE_CLOCK_HZ;
+host_core_debug_t hostCoreDebug;
+cyhal_uart_t cy_retarget_io_uart_obj = {.fd = STDIN_FILENO};
+
+static host_dwt_t dwt;
+static uint64_t dwtBase;        // Host ns the count is taken from
+static uint32_t dwtLastRead;    // What the count read last, a store to it differs
+
+/*******************************************************************************
+ * Function Name: host_board_attach_flash
+ *******************************************************************************
+ * Summary:
+ *  Maps the flash file before main runs, so the flash reads the first task
+ *  makes already see it.
+ *
+ *******************************************************************************/
+__attribute__((constructor)) static void host_board_attach_flash(void) {
+	const char *path = getenv("HOST_FLASH_FILE");
+
+	if(!host_flash_attach((path != NULL) ? path : HOST_FLASH_DEFAULT_FILE)) {
+		fprintf(stderr, "Flash file %s could not be opened, running on blank flash\n", (path != NULL) ? path : HOST_FLASH_DEFAULT_FILE);
+	}
+}
+
+/*******************************************************************************
+ * Function Name: host_dwt
+ *******************************************************************************
+ * Summary:
+ *  The DWT registers, with CYCCNT brought up to date: SystemCoreClock cycles
+ *  of the host's monotonic clock, counted from the last value stored to it.
+ *
+ *******************************************************************************/
+host_dwt_t *host_dwt(void) {
+	struct timespec now;
+	uint64_t ns;
+
+	(void)clock_gettime(CLOCK_MONOTONIC, &now);
+	ns = (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+
+	if(dwt.CYCCNT != dwtLastRead) {
+		dwtBase = ns - (uint64_t)dwt.CYCCNT * 1000000000u / SystemCoreClock;
+	}
+	dwt.CYCCNT = dwtLastRead = (uint32_t)((ns - dwtBase) * (SystemCoreClock / 1000000u) / 1000u);
+
+	return &dwt;
+}
+
+/*******************************************************************************
+ * Function Name: cybsp_init, cy_retarget_io_init
+ *******************************************************************************
+ * Summary:
+ *  Nothing to bring up; printf already reaches the terminal. Output is
+ *  unbuffered like the UART, so log lines from tasks are never held back.
+ *
+ *******************************************************************************/
+cy_rslt_t cybsp_init(void) {
+	return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_retarget_io_init(int tx, int rx, uint32_t baudrate) {
+	(void)setvbuf(stdout, NULL, _IONBF, 0);
+	return CY_RSLT_SUCCESS;
+}
+
+/*******************************************************************************
+ * Function Name: cyhal_uart_readable, cyhal_uart_getc
+ *******************************************************************************
+ * Summary:
+ *  Keys typed on the terminal, available once Enter is pressed.
+ *
+ *******************************************************************************/
+uint32_t cyhal_uart_readable(cyhal_uart_t *obj) {
+	struct pollfd fd = {.fd = obj->fd, .events = POLLIN};
+
+	return (poll(&fd, 1, 0) > 0 && (fd.revents & POLLIN) != 0) ? 1u : 0u;
+}
+
+cy_rslt_t cyhal_uart_getc(cyhal_uart_t *obj, uint8_t *value, uint32_t timeout) {
+	ssize_t n;
+
+	do {
+		n = read(obj->fd, value, 1);
+	} while(n < 0 && errno == EINTR);
+
+	// End of input reads as nothing to read, not as a stream of keys
+	if(n == 0) {
+		obj->fd = -1;
+	}
+	return (n == 1) ? CY_RSLT_SUCCESS : CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CY_RSLT_MODULE_MIDDLEWARE_BASE, 1);
+}
+
+/*******************************************************************************
+ * Function Name: cy_wcm_init, cy_wcm_connect_ap
+ *******************************************************************************
+ * Summary:
+ *  The host is on its network already. The address reported is loopback.
+ *
+ *******************************************************************************/
+cy_rslt_t cy_wcm_init(cy_wcm_config_t *config) {
+	return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_wcm_connect_ap(cy_wcm_connect_params_t *params, cy_wcm_ip_address_t *ip_address) {
+	ip_address->ip.v4 = 0x0100007Fu;    // 127.0.0.1, network byte order
+	return CY_RSLT_SUCCESS;
+}
+
+/*******************************************************************************
+ * Function Name: mtb_st7789v_init8
+ *******************************************************************************
+ * Summary:
+ *  The panel is the framebuffer of the emWin stand-in.
+ *
+ *******************************************************************************/
+cy_rslt_t mtb_st7789v_init8(const mtb_st7789v_pins_t *pins) {
+	return CY_RSLT_SUCCESS;
+}
+
+/*******************************************************************************
+ * Function Name: __wrap_xTaskCreate
+ *******************************************************************************
+ * Summary:
+ *  Link time wrapper around xTaskCreate. Raises the stack of a task to
+ *  HOST_TASK_STACK_MIN_BYTES, so the sizes main.c gives for the target can
+ *  stay as they are.
+ *
+ *******************************************************************************/
+BaseType_t __wrap_xTaskCreate(TaskFunction_t code, const char *const name, const configSTACK_DEPTH_TYPE depth, void *const arg,
+							  UBaseType_t priority, TaskHandle_t *const handle) {
+	configSTACK_DEPTH_TYPE floor = (configSTACK_DEPTH_TYPE)(HOST_TASK_STACK_MIN_BYTES / sizeof(StackType_t));
+
+	return __real_xTaskCreate(code, name, (depth < floor) ? floor : depth, arg, priority, handle);
+}
@@ -0,0 +1,538 @@
+/******************************************************************************
+* File Name:   GUI.c
+*
+* Description: This file contains the host stand-in for emWin. Drawing goes
+* to the selected memory device, or to the framebuffer standing in for the
+* panel when none is selected, and only writes to the framebuffer are
+* counted as bus traffic. Memory devices keep track of which pixels were
+* drawn, so copying one out leaves the rest of the destination alone like
+* emWin's transparent memory devices.
+*
+* Set HOST_FRAMEBUFFER to a file name to have the framebuffer saved there
+* as a PPM image, at most once a second while the panel is being drawn.
+*
+*******************************************************************************/
+
+/* Standard C header file. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "GUI.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+// Seconds between two saves of the framebuffer
+#define GUI_HOST_SAVE_INTERVAL (1)
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+typedef struct {
+	int x0;
+	int y0;
+	int xsize;
+	int ysize;
+	GUI_COLOR *pixels;
+	uint8_t *drawn;
+} host_memdev_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+static bool gui_plot(int x, int y, GUI_COLOR c);
+static void gui_window(uint32_t pixels);
+static void gui_fill(int x0, int y0, int x1, int y1, GUI_COLOR c);
+static void gui_write(const host_memdev_t *from, host_memdev_t *to, int x, int y);
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+// Cells of the real fonts' heights, advances about their average widths
+const GUI_FONT GUI_Font20B_ASCII = {10, 20};
+const GUI_FONT GUI_Font24B_ASCII = {12, 24};
+const GUI_FONT GUI_Font32B_ASCII = {16, 32};
+
+static GUI_COLOR frame[GUI_HOST_YSIZE][GUI_HOST_XSIZE];
+static host_memdev_t *selected = NULL;
+static GUI_COLOR fgColor = GUI_WHITE;
+static GUI_COLOR bkColor = GUI_BLACK;
+static const GUI_FONT *font = &GUI_Font20B_ASCII;
+static GUI_HOST_LCD_STATS lcdStats;
+static const char *framePath = NULL;
+static time_t lastSave = 0;
+
+/*******************************************************************************
+ * Function Name: GUI_Init
+ *******************************************************************************
+ * Summary:
+ *  Clears the panel to black.
+ *
+ *******************************************************************************/
+int GUI_Init(void) {
+	framePath = getenv("HOST_FRAMEBUFFER");
+	selected = NULL;
+	fgColor = GUI_WHITE;
+	bkColor = GUI_BLACK;
+	font = &GUI_Font20B_ASCII;
+	(void)memset(frame, 0, sizeof(frame));
+	return 0;
+}
+
+int LCD_GetXSize(void) {
+	return GUI_HOST_XSIZE;
+}
+
+int LCD_GetYSize(void) {
+	return GUI_HOST_YSIZE;
+}
+
+/*******************************************************************************
+ * Function Name: GUI_SetColor, GUI_GetColor, GUI_SetBkColor, GUI_GetBkColor,
+ *                GUI_SetFont, GUI_GetFont
+ *******************************************************************************
+ * Summary:
+ *  Drawing state. The setters return what was set before.
+ *
+ *******************************************************************************/
+GUI_COLOR GUI_SetColor(GUI_COLOR color) {
+	GUI_COLOR previous = fgColor;
+
+	fgColor = color;
+	return previous;
+}
+
+GUI_COLOR GUI_GetColor(void) {
+	return fgColor;
+}
+
+GUI_COLOR GUI_SetBkColor(GUI_COLOR color) {
+	GUI_COLOR previous = bkColor;
+
+	bkColor = color;
+	return previous;
+}
+
+GUI_COLOR GUI_GetBkColor(void) {
+	return bkColor;
+}
+
+const GUI_FONT *GUI_SetFont(const GUI_FONT *newFont) {
+	const GUI_FONT *previous = font;
+
+	font = newFont;
+	return previous;
+}
+
+const GUI_FONT *GUI_GetFont(void) {
+	return font;
+}
+
+/*******************************************************************************
+ * Function Name: GUI_GetFontSizeY, GUI_GetCharDistX, GUI_GetStringDistX
+ *******************************************************************************
+ * Summary:
+ *  Text metrics of the current font.
+ *
+ *******************************************************************************/
+int GUI_GetFontSizeY(void) {
+	return font->y_size;
+}
+
+int GUI_GetCharDistX(uint16_t c) {
+	return font->x_dist;
+}
+
+int GUI_GetStringDistX(const char *s) {
+	return (int)strlen(s) * font->x_dist;
+}
+
+/*******************************************************************************
+ * Function Name: GUI_Clear, GUI_ClearRect, GUI_FillRect
+ *******************************************************************************
+ * Summary:
+ *  Fill the whole drawing area, or a rectangle, in the background or
+ *  foreground color.
+ *
+ *******************************************************************************/
+void GUI_Clear(void) {
+	if(selected != NULL) {
+		gui_fill(selected->x0, selected->y0, selected->x0 + selected->xsize - 1, selected->y0 + selected->ysize - 1, bkColor);
+	} else {
+		gui_fill(0, 0, GUI_HOST_XSIZE - 1, GUI_HOST_YSIZE - 1, bkColor);
+	}
+}
+
+void GUI_ClearRect(int x0, int y0, int x1, int y1) {
+	gui_fill(x0, y0, x1, y1, bkColor);
+}
+
+void GUI_FillRect(int x0, int y0, int x1, int y1) {
+	gui_fill(x0, y0, x1, y1, fgColor);
+}
+
+/*******************************************************************************
+ * Function Name: GUI_DrawRect, GUI_DrawPixel, GUI_DrawLine
+ *******************************************************************************
+ * Summary:
+ *  Outlines, pixels and lines in the foreground color. Horizontal and
+ *  vertical lines take one window, like the driver's fills; others are set
+ *  pixel by pixel, a window each.
+ *
+ *******************************************************************************/
+void GUI_DrawRect(int x0, int y0, int x1, int y1) {
+	gui_fill(x0, y0, x1, y0, fgColor);
+	gui_fill(x0, y1, x1, y1, fgColor);
+	gui_fill(x0, y0 + 1, x0, y1 - 1, fgColor);
+	gui_fill(x1, y0 + 1, x1, y1 - 1, fgColor);
+}
+
+void GUI_DrawPixel(int x, int y) {
+	gui_fill(x, y, x, y, fgColor);
+}
+
+void GUI_DrawLine(int x0, int y0, int x1, int y1) {
+	int dx = abs(x1 - x0);
+	int dy = -abs(y1 - y0);
+	int sx = (x0 < x1) ? 1 : -1;
+	int sy = (y0 < y1) ? 1 : -1;
+	int err = dx + dy;
+
+	if(x0 == x1 || y0 == y1) {
+		gui_fill((x0 < x1) ? x0 : x1, (y0 < y1) ? y0 : y1, (x0 < x1) ? x1 : x0, (y0 < y1) ? y1 : y0, fgColor);
+		return;
+	}
+
+	// Bresenham
+	while(1) {
+		gui_fill(x0, y0, x0, y0, fgColor);
+		if(x0 == x1 && y0 == y1) {
+			break;
+		}
+		if(2 * err >= dy) {
+			err += dy;
+			x0 += sx;
+		}
+		if(2 * err <= dx) {
+			err += dx;
+			y0 += sy;
+		}
+	}
+}
+
+/*******************************************************************************
+ * Function Name: GUI_DispCharAt, GUI_DispStringAt
+ *******************************************************************************
+ * Summary:
+ *  Text in the foreground color over the background color, one window per
+ *  character cell. A printable character is a pattern of its code inside
+ *  the cell, so different text gives different pixels.
+ *
+ *******************************************************************************/
+void GUI_DispCharAt(uint16_t c, int x, int y) {
+	uint32_t plotted = 0;
+
+	for(int py = 0; py < font->y_size; py++) {
+		for(int px = 0; px < font->x_dist; px++) {
+			bool ink = c > ' ' && c < 0x7F && px > 0 && px < font->x_dist - 1 && py > 1 && py < font->y_size - 2 && ((px * 3 + py * 5 + c) % 4) != 0;
+
+			plotted += gui_plot(x + px, y + py, ink ? fgColor : bkColor);
+		}
+	}
+	gui_window(plotted);
+}
+
+void GUI_DispStringAt(const char *s, int x, int y) {
+	for(; *s != '\0'; s++) {
+		GUI_DispCharAt((uint8_t)*s, x, y);
+		x += font->x_dist;
+	}
+}
+
+/*******************************************************************************
+ * Function Name: GUI_MEMDEV_Create
+ *******************************************************************************
+ * Summary:
+ *  A memory device covering the given area of the panel, nothing drawn yet.
+ *
+ * Return:
+ *  GUI_MEMDEV_Handle : the device, 0 if out of memory
+ *
+ *******************************************************************************/
+GUI_MEMDEV_Handle GUI_MEMDEV_Create(int x0, int y0, int xSize, int ySize) {
+	host_memdev_t *memdev;
+
+	if(xSize <= 0 || ySize <= 0) {
+		return 0;
+	}
+	memdev = malloc(sizeof(*memdev));
+	if(memdev == NULL) {
+		return 0;
+	}
+	memdev->x0 = x0;
+	memdev->y0 = y0;
+	memdev->xsize = xSize;
+	memdev->ysize = ySize;
+	memdev->pixels = malloc((size_t)xSize * (size_t)ySize * sizeof(GUI_COLOR));
+	memdev->drawn = calloc((size_t)xSize * (size_t)ySize, 1);
+	if(memdev->pixels == NULL || memdev->drawn == NULL) {
+		free(memdev->pixels);
+		free(memdev->drawn);
+		free(memdev);
+		return 0;
+	}
+	return (GUI_MEMDEV_Handle)memdev;
+}
+
+/*******************************************************************************
+ * Function Name: GUI_MEMDEV_Select, GUI_MEMDEV_Delete
+ *******************************************************************************
+ * Summary:
+ *  Routes drawing to a memory device, or to the panel for 0, returning
+ *  where it went before; and frees a device, deselecting it if selected.
+ *
+ *******************************************************************************/
+GUI_MEMDEV_Handle GUI_MEMDEV_Select(GUI_MEMDEV_Handle memdev) {
+	GUI_MEMDEV_Handle previous = (GUI_MEMDEV_Handle)selected;
+
+	selected = (host_memdev_t *)memdev;
+	return previous;
+}
+
+void GUI_MEMDEV_Delete(GUI_MEMDEV_Handle memdev) {
+	host_memdev_t *device = (host_memdev_t *)memdev;
+
+	if(device == NULL) {
+		return;
+	}
+	if(device == selected) {
+		selected = NULL;
+	}
+	free(device->pixels);
+	free(device->drawn);
+	free(device);
+}
+
+/*******************************************************************************
+ * Function Name: GUI_MEMDEV_CopyToLCD, GUI_MEMDEV_WriteAt
+ *******************************************************************************
+ * Summary:
+ *  Copies the drawn pixels of a device to the panel where it was created,
+ *  or to wherever drawing goes now at the given place.
+ *
+ *******************************************************************************/
+void GUI_MEMDEV_CopyToLCD(GUI_MEMDEV_Handle memdev) {
+	const host_memdev_t *device = (const host_memdev_t *)memdev;
+
+	if(device != NULL) {
+		gui_write(device, NULL, device->x0, device->y0);
+	}
+}
+
+void GUI_MEMDEV_WriteAt(GUI_MEMDEV_Handle memdev, int x, int y) {
+	const host_memdev_t *device = (const host_memdev_t *)memdev;
+
+	if(device != NULL) {
+		gui_write(device, selected, x, y);
+	}
+}
+
+/*******************************************************************************
+ * Function Name: GUI_MEMDEV_Draw
+ *******************************************************************************
+ * Summary:
+ *  Draws the area through memory devices numLines high, or one device for
+ *  all of it with 0, calling draw once per band and copying each band to
+ *  the panel.
+ *
+ * Return:
+ *  int : 0, or 1 if a band could not be allocated
+ *
+ *******************************************************************************/
+int GUI_MEMDEV_Draw(GUI_RECT *rect, GUI_CALLBACK_VOID_P *draw, void *arg, int numLines, int flags) {
+	int height = rect->y1 - rect->y0 + 1;
+	int band = (numLines > 0 && numLines < height) ? numLines : height;
+
+	for(int y = rect->y0; y <= rect->y1; y += band) {
+		int lines = (rect->y1 - y + 1 < band) ? rect->y1 - y + 1 : band;
+		GUI_MEMDEV_Handle memdev = GUI_MEMDEV_Create(rect->x0, y, rect->x1 - rect->x0 + 1, lines);
+		GUI_MEMDEV_Handle previous;
+
+		if(memdev == 0) {
+			return 1;
+		}
+		previous = GUI_MEMDEV_Select(memdev);
+		draw(arg);
+		(void)GUI_MEMDEV_Select(previous);
+		GUI_MEMDEV_CopyToLCD(memdev);
+		GUI_MEMDEV_Delete(memdev);
+	}
+	return 0;
+}
+
+/*******************************************************************************
+ * Function Name: GUI_HOST_GetLCDStats, GUI_HOST_ResetLCDStats
+ *******************************************************************************
+ * Summary:
+ *  The panel traffic counted since the last reset.
+ *
+ *******************************************************************************/
+void GUI_HOST_GetLCDStats(GUI_HOST_LCD_STATS *stats) {
+	*stats = lcdStats;
+}
+
+void GUI_HOST_ResetLCDStats(void) {
+	(void)memset(&lcdStats, 0, sizeof(lcdStats));
+}
+
+/*******************************************************************************
+ * Function Name: GUI_HOST_GetPixel
+ *******************************************************************************
+ * Summary:
+ *  A pixel of the panel, black outside it.
+ *
+ *******************************************************************************/
+GUI_COLOR GUI_HOST_GetPixel(int x, int y) {
+	if(x < 0 || y < 0 || x >= GUI_HOST_XSIZE || y >= GUI_HOST_YSIZE) {
+		return GUI_BLACK;
+	}
+	return frame[y][x];
+}
+
+/*******************************************************************************
+ * Function Name: GUI_HOST_SaveFrame
+ *******************************************************************************
+ * Summary:
+ *  Writes the panel to a binary PPM image.
+ *
+ * Return:
+ *  bool : true if the whole image was written
+ *
+ *******************************************************************************/
+bool GUI_HOST_SaveFrame(const char *path) {
+	static uint8_t rgb[GUI_HOST_YSIZE][GUI_HOST_XSIZE][3];
+	FILE *file = fopen(path, "wb");
+	bool ok;
+
+	if(file == NULL) {
+		return false;
+	}
+	for(int y = 0; y < GUI_HOST_YSIZE; y++) {
+		for(int x = 0; x < GUI_HOST_XSIZE; x++) {
+			rgb[y][x][0] = (uint8_t)frame[y][x];
+			rgb[y][x][1] = (uint8_t)(frame[y][x] >> 8);
+			rgb[y][x][2] = (uint8_t)(frame[y][x] >> 16);
+		}
+	}
+	ok = fprintf(file, "P6\n%d %d\n255\n", GUI_HOST_XSIZE, GUI_HOST_YSIZE) > 0 && fwrite(rgb, sizeof(rgb), 1, file) == 1;
+	return (fclose(file) == 0) && ok;
+}
+
+/*******************************************************************************
+ * Function Name: gui_plot
+ *******************************************************************************
+ * Summary:
+ *  Sets a pixel where drawing goes, if it falls inside it.
+ *
+ * Return:
+ *  bool : true if the pixel was set
+ *
+ *******************************************************************************/
+static bool gui_plot(int x, int y, GUI_COLOR c) {
+	if(selected != NULL) {
+		int i;
+
+		if(x < selected->x0 || y < selected->y0 || x >= selected->x0 + selected->xsize || y >= selected->y0 + selected->ysize) {
+			return false;
+		}
+		i = (y - selected->y0) * selected->xsize + (x - selected->x0);
+		selected->pixels[i] = c;
+		selected->drawn[i] = 1;
+		return true;
+	}
+
+	if(x < 0 || y < 0 || x >= GUI_HOST_XSIZE || y >= GUI_HOST_YSIZE) {
+		return false;
+	}
+	frame[y][x] = c;
+	return true;
+}
+
+/*******************************************************************************
+ * Function Name: gui_window
+ *******************************************************************************
+ * Summary:
+ *  Counts one address window of pixels written to the panel, and saves the
+ *  framebuffer when it is time to.
+ *
+ *******************************************************************************/
+static void gui_window(uint32_t pixels) {
+	time_t now;
+
+	if(selected != NULL || pixels == 0) {
+		return;
+	}
+	lcdStats.pixels += pixels;
+	lcdStats.bus_bytes += GUI_HOST_WINDOW_BYTES + 2 * pixels;
+	lcdStats.windows++;
+
+	if(framePath != NULL && (now = time(NULL)) - lastSave >= GUI_HOST_SAVE_INTERVAL) {
+		lastSave = now;
+		(void)GUI_HOST_SaveFrame(framePath);
+	}
+}
+
+/*******************************************************************************
+ * Function Name: gui_fill
+ *******************************************************************************
+ * Summary:
+ *  Fills a rectangle, corners in any order, in one window.
+ *
+ *******************************************************************************/
+static void gui_fill(int x0, int y0, int x1, int y1, GUI_COLOR c) {
+	uint32_t plotted = 0;
+
+	if(x0 > x1 || y0 > y1) {
+		return;
+	}
+	for(int y = y0; y <= y1; y++) {
+		for(int x = x0; x <= x1; x++) {
+			plotted += gui_plot(x, y, c);
+		}
+	}
+	gui_window(plotted);
+}
+
+/*******************************************************************************
+ * Function Name: gui_write
+ *******************************************************************************
+ * Summary:
+ *  Copies the drawn pixels of one device into another, or to the panel for
+ *  NULL, with its top left corner at x, y. A fully drawn device goes to the
+ *  panel in one window, otherwise each run of drawn pixels takes its own.
+ *
+ *******************************************************************************/
+static void gui_write(const host_memdev_t *from, host_memdev_t *to, int x, int y) {
+	host_memdev_t *previous = selected;
+	bool opaque = (memchr(from->drawn, 0, (size_t)from->xsize * (size_t)from->ysize) == NULL);
+	uint32_t plotted = 0;
+
+	selected = to;
+	for(int j = 0; j < from->ysize; j++) {
+		for(int i = 0; i < from->xsize; i++) {
+			int k = j * from->xsize + i;
+
+			if(from->drawn[k]) {
+				plotted += gui_plot(x + i, y + j, from->pixels[k]);
+			}
+			if(!opaque && (i == from->xsize - 1 || !from->drawn[k + 1])) {
+				gui_window(plotted);
+				plotted = 0;
+			}
+		}
+	}
+	gui_window(plotted);
+	selected = previous;
+}
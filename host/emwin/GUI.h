@@ -0,0 +1,109 @@
+/******************************************************************************
+* File Name:   GUI.h
+*
+* Description: Host stand-in for the parts of emWin the display code uses,
+* drawing into a 320x240 framebuffer in place of the ST7789V panel. Fonts
+* are fixed-width blocks of the real fonts' heights, so layout and overdraw
+* match the target while the glyphs themselves are only placeholders.
+*
+* What would have crossed the panel's 8 bit bus is counted: every pixel
+* written to the panel, the bytes that carries (2 per pixel, plus the
+* address window command ahead of every run) and the number of windows.
+* The render tests compare drawing directly with compositing by these.
+*
+*******************************************************************************/
+
+#ifndef GUI_H_
+#define GUI_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define GUI_HOST_XSIZE (320)
+#define GUI_HOST_YSIZE (240)
+
+/* Colors are 0xBBGGRR, as in emWin */
+#define GUI_BLACK    (0x000000u)
+#define GUI_WHITE    (0xFFFFFFu)
+#define GUI_RED      (0x0000FFu)
+#define GUI_GREEN    (0x00FF00u)
+#define GUI_BLUE     (0xFF0000u)
+#define GUI_YELLOW   (0x00FFFFu)
+#define GUI_GRAY     (0x808080u)
+#define GUI_DARKGRAY (0x404040u)
+
+/* Bytes of the CASET, RASET and RAMWR commands that open an address window */
+#define GUI_HOST_WINDOW_BYTES (11u)
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+typedef uint32_t GUI_COLOR;
+typedef uintptr_t GUI_MEMDEV_Handle;    // 0 for none, the panel
+
+typedef struct {
+	uint8_t x_dist;    // Advance of every character
+	uint8_t y_size;
+} GUI_FONT;
+
+typedef struct {
+	int16_t x0, y0, x1, y1;
+} GUI_RECT;
+
+typedef void GUI_CALLBACK_VOID_P(void *p);
+
+typedef struct {
+	uint32_t pixels;       // Pixels written to the panel
+	uint32_t bus_bytes;    // Pixel data and window commands
+	uint32_t windows;      // Address windows opened
+} GUI_HOST_LCD_STATS;
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+extern const GUI_FONT GUI_Font20B_ASCII;
+extern const GUI_FONT GUI_Font24B_ASCII;
+extern const GUI_FONT GUI_Font32B_ASCII;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+int GUI_Init(void);
+int LCD_GetXSize(void);
+int LCD_GetYSize(void);
+
+GUI_COLOR GUI_SetColor(GUI_COLOR color);
+GUI_COLOR GUI_GetColor(void);
+GUI_COLOR GUI_SetBkColor(GUI_COLOR color);
+GUI_COLOR GUI_GetBkColor(void);
+const GUI_FONT *GUI_SetFont(const GUI_FONT *font);
+const GUI_FONT *GUI_GetFont(void);
+int GUI_GetFontSizeY(void);
+int GUI_GetCharDistX(uint16_t c);
+int GUI_GetStringDistX(const char *s);
+
+void GUI_Clear(void);
+void GUI_ClearRect(int x0, int y0, int x1, int y1);
+void GUI_FillRect(int x0, int y0, int x1, int y1);
+void GUI_DrawRect(int x0, int y0, int x1, int y1);
+void GUI_DrawPixel(int x, int y);
+void GUI_DrawLine(int x0, int y0, int x1, int y1);
+void GUI_DispCharAt(uint16_t c, int x, int y);
+void GUI_DispStringAt(const char *s, int x, int y);
+
+GUI_MEMDEV_Handle GUI_MEMDEV_Create(int x0, int y0, int xSize, int ySize);
+GUI_MEMDEV_Handle GUI_MEMDEV_Select(GUI_MEMDEV_Handle memdev);
+void GUI_MEMDEV_Delete(GUI_MEMDEV_Handle memdev);
+void GUI_MEMDEV_CopyToLCD(GUI_MEMDEV_Handle memdev);
+void GUI_MEMDEV_WriteAt(GUI_MEMDEV_Handle memdev, int x, int y);
+int GUI_MEMDEV_Draw(GUI_RECT *rect, GUI_CALLBACK_VOID_P *draw, void *arg, int numLines, int flags);
+
+void GUI_HOST_GetLCDStats(GUI_HOST_LCD_STATS *stats);
+void GUI_HOST_ResetLCDStats(void);
+GUI_COLOR GUI_HOST_GetPixel(int x, int y);
+bool GUI_HOST_SaveFrame(const char *path);
+
+#endif /* GUI_H_ */
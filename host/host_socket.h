@@ -0,0 +1,25 @@
+/******************************************************************************
+* File Name:   host_socket.h
+*
+* Description: This file contains declarations for the host's TLS sockets,
+* shared by the secure sockets stand-in, which implements them, and the
+* HTTP client stand-in, which opens and closes them. Sends and receives
+* only go through cy_socket_send and cy_socket_recv, so the link time
+* wrappers around those see all the traffic.
+*
+*******************************************************************************/
+
+#ifndef HOST_SOCKET_H_
+#define HOST_SOCKET_H_
+
+#include "cy_http_client_api.h"
+#include "cy_secure_sockets.h"
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+cy_rslt_t host_socket_open(cy_socket_t *handle, const cy_awsport_server_info_t *server, const cy_awsport_ssl_credentials_t *credentials,
+						   uint32_t send_timeout_ms, uint32_t receive_timeout_ms);
+void host_socket_close(cy_socket_t handle);
+
+#endif /* HOST_SOCKET_H_ */
@@ -0,0 +1,401 @@
+/******************************************************************************
+* File Name:   http_client_host.c
+*
+* Description: This file contains the host stand-in for the HTTP client
+* library. Like the library, cy_http_client_send writes the request and
+* reads the whole response into the request buffer before returning, the
+* body de-chunked and following the headers, and calls the disconnect
+* callback when it finds the server has closed the session.
+*
+* The response is framed with the firmware's own http_body framer, over
+* the bytes as cy_socket_recv left them, so the body the framer in
+* http_connection.c streams out and the one returned here always agree.
+*
+*******************************************************************************/
+
+/* Standard C header file, with memmem */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "http_body.h"
+#include "host_socket.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#ifndef HTTP_USER_AGENT_VALUE
+#define HTTP_USER_AGENT_VALUE "mtb-http-client"
+#endif
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+struct host_http_client {
+	cy_awsport_ssl_credentials_t credentials;
+	cy_awsport_server_info_t server;
+	cy_http_disconnect_callback_t disconnect_cb;
+	void *user_data;
+	cy_socket_t socket;    // NULL while disconnected
+	bool closed_seen;      // The disconnect callback ran for this session
+};
+
+/* Where a response is being read to */
+typedef struct {
+	uint8_t *buffer;
+	uint32_t received;
+	uint32_t header_end;      // Offset of the body, 0 until found
+	uint32_t fields_start;    // Offset of the first header field of the final response
+} host_response_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+static void host_http_closed(cy_http_client_t handle);
+static void host_http_body_sink(void *arg, const uint8_t *data, size_t len, size_t offset);
+static bool host_http_find_header_end(host_response_t *rx, uint32_t len);
+static int host_http_append(cy_http_client_request_header_t *request, const char *text, size_t len);
+
+/*******************************************************************************
+ * Function Name: cy_http_client_init
+ *******************************************************************************
+ * Summary:
+ *  Nothing to set up on a host.
+ *
+ *******************************************************************************/
+cy_rslt_t cy_http_client_init(void) {
+	return CY_RSLT_SUCCESS;
+}
+
+/*******************************************************************************
+ * Function Name: cy_http_client_create
+ *******************************************************************************
+ * Summary:
+ *  A client for the server, not connected yet. The credentials and server
+ *  info are copied, the strings they point to must outlive the client.
+ *
+ *******************************************************************************/
+cy_rslt_t cy_http_client_create(cy_awsport_ssl_credentials_t *security, cy_awsport_server_info_t *server_info,
+								cy_http_disconnect_callback_t disconn_cb, void *user_data, cy_http_client_t *handle) {
+	struct host_http_client *client;
+
+	if(security == NULL || server_info == NULL || handle == NULL) {
+		return CY_RSLT_HTTP_CLIENT_ERROR_BADARG;
+	}
+	client = calloc(1, sizeof(*client));
+	if(client == NULL) {
+		return CY_RSLT_HTTP_CLIENT_ERROR_NOMEM;
+	}
+	client->credentials = *security;
+	client->server = *server_info;
+	client->disconnect_cb = disconn_cb;
+	client->user_data = user_data;
+
+	*handle = client;
+	return CY_RSLT_SUCCESS;
+}
+
+/*******************************************************************************
+ * Function Name: cy_http_client_connect
+ *******************************************************************************
+ * Summary:
+ *  Opens the TLS session to the server.
+ *
+ *******************************************************************************/
+cy_rslt_t cy_http_client_connect(cy_http_client_t handle, uint32_t send_timeout_ms, uint32_t receive_timeout_ms) {
+	cy_rslt_t result;
+
+	if(handle->socket != NULL) {
+		return CY_RSLT_SUCCESS;
+	}
+	result = host_socket_open(&handle->socket, &handle->server, &handle->credentials, send_timeout_ms, receive_timeout_ms);
+	if(result != CY_RSLT_SUCCESS) {
+		handle->socket = NULL;
+		return result;
+	}
+	handle->closed_seen = false;
+	return CY_RSLT_SUCCESS;
+}
+
+/*******************************************************************************
+ * Function Name: cy_http_client_disconnect
+ *******************************************************************************
+ * Summary:
+ *  Closes the session, if there is one.
+ *
+ *******************************************************************************/
+cy_rslt_t cy_http_client_disconnect(cy_http_client_t handle) {
+	host_socket_close(handle->socket);
+	handle->socket = NULL;
+	return CY_RSLT_SUCCESS;
+}
+
+/*******************************************************************************
+ * Function Name: cy_http_client_delete
+ *******************************************************************************
+ * Summary:
+ *  Closes the session, if there is one, and frees the client.
+ *
+ *******************************************************************************/
+cy_rslt_t cy_http_client_delete(cy_http_client_t handle) {
+	if(handle == NULL) {
+		return CY_RSLT_HTTP_CLIENT_ERROR_BADARG;
+	}
+	(void)cy_http_client_disconnect(handle);
+	free(handle);
+	return CY_RSLT_SUCCESS;
+}
+
+/*******************************************************************************
+ * Function Name: cy_http_client_write_header
+ *******************************************************************************
+ * Summary:
+ *  Writes the request line, User-Agent, a Host header unless one is given,
+ *  the range if any and the given headers into request->buffer.
+ *
+ *******************************************************************************/
+cy_rslt_t cy_http_client_write_header(cy_http_client_t handle, cy_http_client_request_header_t *request, cy_http_client_header_t *header,
+									  uint32_t num_header) {
+	static const char *const methods[] = {"GET", "PUT", "POST", "HEAD"};
+	char line[96];
+	bool hasHost = false;
+	int ok;
+
+	request->headers_len = 0;
+	ok = host_http_append(request, methods[request->method], strlen(methods[request->method])) && host_http_append(request, " ", 1) &&
+		 host_http_append(request, request->resource_path, strlen(request->resource_path)) &&
+		 host_http_append(request, " HTTP/1.1\r\nUser-Agent: " HTTP_USER_AGENT_VALUE "\r\n", strlen(" HTTP/1.1\r\nUser-Agent: " HTTP_USER_AGENT_VALUE "\r\n"));
+
+	for(uint32_t i = 0; i < num_header; i++) {
+		hasHost = hasHost || (header[i].field_len == strlen("Host") && strncasecmp(header[i].field, "Host", header[i].field_len) == 0);
+	}
+	if(!hasHost) {
+		(void)snprintf(line, sizeof(line), "Host: %s\r\n", handle->server.host_name);
+		ok = ok && host_http_append(request, line, strlen(line));
+	}
+	if(request->range_start >= 0) {
+		if(request->range_end >= 0) {
+			(void)snprintf(line, sizeof(line), "Range: bytes=%ld-%ld\r\n", (long)request->range_start, (long)request->range_end);
+		} else {
+			(void)snprintf(line, sizeof(line), "Range: bytes=%ld-\r\n", (long)request->range_start);
+		}
+		ok = ok && host_http_append(request, line, strlen(line));
+	}
+	for(uint32_t i = 0; i < num_header; i++) {
+		ok = ok && host_http_append(request, header[i].field, header[i].field_len) && host_http_append(request, ": ", 2) &&
+			 host_http_append(request, header[i].value, header[i].value_len) && host_http_append(request, "\r\n", 2);
+	}
+	ok = ok && host_http_append(request, "\r\n", 2);
+
+	return ok ? CY_RSLT_SUCCESS : CY_RSLT_HTTP_CLIENT_ERROR_NOMEM;
+}
+
+/*******************************************************************************
+ * Function Name: cy_http_client_send
+ *******************************************************************************
+ * Summary:
+ *  Sends the request written by cy_http_client_write_header, and a payload
+ *  if any, then reads the response over it in request->buffer until the
+ *  framer has the whole message, or the server closes a body that ends
+ *  with the connection.
+ *
+ * Return:
+ *  cy_rslt_t : CY_RSLT_SUCCESS with response filled in; the socket error,
+ *  CY_RSLT_HTTP_CLIENT_ERROR_NOMEM if the response does not fit, or
+ *  CY_RSLT_HTTP_CLIENT_ERROR_PARSER if it cannot be framed
+ *
+ *******************************************************************************/
+cy_rslt_t cy_http_client_send(cy_http_client_t handle, cy_http_client_request_header_t *request, uint8_t *payload, uint32_t payload_len,
+							  cy_http_client_response_t *response) {
+	host_response_t rx = {.buffer = request->buffer};
+	http_body_t framer;
+	uint32_t count;
+	cy_rslt_t result;
+
+	if(handle->socket == NULL) {
+		return CY_RSLT_HTTP_CLIENT_ERROR_NOT_CONNECTED;
+	}
+
+	result = cy_socket_send(handle->socket, request->buffer, request->headers_len, 0, &count);
+	if(result == CY_RSLT_SUCCESS && payload_len > 0) {
+		result = cy_socket_send(handle->socket, payload, payload_len, 0, &count);
+	}
+	if(result != CY_RSLT_SUCCESS) {
+		if(result == CY_RSLT_MODULE_SECURE_SOCKETS_CLOSED) {
+			host_http_closed(handle);
+		}
+		return result;
+	}
+
+	http_body_init(&framer, host_http_body_sink, &rx);
+	while(framer.state != HTTP_BODY_DONE) {
+		if(rx.received == request->buffer_len) {
+			return CY_RSLT_HTTP_CLIENT_ERROR_NOMEM;
+		}
+		result = cy_socket_recv(handle->socket, &rx.buffer[rx.received], request->buffer_len - rx.received, 0, &count);
+		if(result == CY_RSLT_MODULE_SECURE_SOCKETS_CLOSED) {
+			host_http_closed(handle);
+			if(framer.state == HTTP_BODY_UNTIL_CLOSE) {
+				break;
+			}
+			return (rx.received == 0) ? CY_RSLT_HTTP_CLIENT_ERROR_NO_RESPONSE : result;
+		}
+		if(result != CY_RSLT_SUCCESS) {
+			return result;
+		}
+
+		http_body_feed(&framer, &rx.buffer[rx.received], count);
+		rx.received += count;
+		if(framer.state == HTTP_BODY_ERROR || framer.state == HTTP_BODY_UNSUPPORTED) {
+			return CY_RSLT_HTTP_CLIENT_ERROR_PARSER;
+		}
+	}
+
+	if(rx.header_end == 0 && !host_http_find_header_end(&rx, rx.received)) {
+		return CY_RSLT_HTTP_CLIENT_ERROR_PARSER;
+	}
+
+	response->status_code = framer.status;
+	response->header = &rx.buffer[rx.fields_start];
+	response->headers_len = rx.header_end - 2 - rx.fields_start;    // Up to the CRLF of the last field
+	response->header_count = 0;
+	for(uint32_t i = rx.fields_start; i < rx.header_end - 2; i++) {
+		response->header_count += (rx.buffer[i] == '\n');
+	}
+	response->body = &rx.buffer[rx.header_end];
+	response->body_len = (uint32_t)framer.offset;
+	response->content_len = (uint32_t)framer.offset;
+
+	return CY_RSLT_SUCCESS;
+}
+
+/*******************************************************************************
+ * Function Name: cy_http_client_read_header
+ *******************************************************************************
+ * Summary:
+ *  Looks up the value of each named header field in the response, without
+ *  regard to case. A field that is not there is left as it was.
+ *
+ * Return:
+ *  cy_rslt_t : CY_RSLT_SUCCESS if every field was found
+ *
+ *******************************************************************************/
+cy_rslt_t cy_http_client_read_header(cy_http_client_t handle, cy_http_client_response_t *response, cy_http_client_header_t *header,
+									 uint32_t num_header) {
+	cy_rslt_t result = CY_RSLT_SUCCESS;
+
+	for(uint32_t h = 0; h < num_header; h++) {
+		char *line = (char *)response->header;
+		char *end = line + response->headers_len;
+		bool found = false;
+
+		while(line < end && !found) {
+			char *next = memchr(line, '\n', (size_t)(end - line));
+			char *lineEnd = (next != NULL) ? next : end;
+
+			if((size_t)(lineEnd - line) > header[h].field_len && line[header[h].field_len] == ':' &&
+			   strncasecmp(line, header[h].field, header[h].field_len) == 0) {
+				char *value = line + header[h].field_len + 1;
+
+				while(value < lineEnd && (*value == ' ' || *value == '\t')) {
+					value++;
+				}
+				while(lineEnd > value && (lineEnd[-1] == '\r' || lineEnd[-1] == ' ' || lineEnd[-1] == '\t')) {
+					lineEnd--;
+				}
+				header[h].value = value;
+				header[h].value_len = (size_t)(lineEnd - value);
+				found = true;
+			}
+			line = (next != NULL) ? next + 1 : end;
+		}
+		if(!found) {
+			result = CY_RSLT_HTTP_CLIENT_ERROR_NOT_FOUND;
+		}
+	}
+
+	return result;
+}
+
+/*******************************************************************************
+ * Function Name: host_http_closed
+ *******************************************************************************
+ * Summary:
+ *  Tells the firmware the server closed the session, once per session. The
+ *  socket stays allocated until cy_http_client_disconnect, as on the target.
+ *
+ *******************************************************************************/
+static void host_http_closed(cy_http_client_t handle) {
+	if(!handle->closed_seen && handle->disconnect_cb != NULL) {
+		handle->closed_seen = true;
+		handle->disconnect_cb(handle->user_data);
+	}
+}
+
+/*******************************************************************************
+ * Function Name: host_http_body_sink
+ *******************************************************************************
+ * Summary:
+ *  Moves body bytes down to follow the headers, dropping the chunk framing
+ *  between them. Body bytes never sit before their place in the message,
+ *  so the move only writes over bytes already framed.
+ *
+ *******************************************************************************/
+static void host_http_body_sink(void *arg, const uint8_t *data, size_t len, size_t offset) {
+	host_response_t *rx = (host_response_t *)arg;
+
+	if(rx->header_end == 0 && !host_http_find_header_end(rx, (uint32_t)(data - rx->buffer))) {
+		return;
+	}
+	(void)memmove(&rx->buffer[rx->header_end + offset], data, len);
+}
+
+/*******************************************************************************
+ * Function Name: host_http_find_header_end
+ *******************************************************************************
+ * Summary:
+ *  Finds the blank line ending the headers of the final response in the
+ *  first len bytes, passing over interim 1xx responses.
+ *
+ *******************************************************************************/
+static bool host_http_find_header_end(host_response_t *rx, uint32_t len) {
+	uint32_t start = 0;
+
+	while(start < len) {
+		const uint8_t *blank = memmem(&rx->buffer[start], len - start, "\r\n\r\n", 4);
+		const uint8_t *statusEnd = memchr(&rx->buffer[start], '\n', len - start);
+
+		if(blank == NULL || statusEnd == NULL) {
+			return false;
+		}
+		if(len - start > sizeof("HTTP/1.1 1") - 1 && rx->buffer[start + sizeof("HTTP/1.1 ") - 1] == '1') {
+			start = (uint32_t)(blank - rx->buffer) + 4;
+			continue;
+		}
+		rx->fields_start = (uint32_t)(statusEnd - rx->buffer) + 1;
+		rx->header_end = (uint32_t)(blank - rx->buffer) + 4;
+		return true;
+	}
+	return false;
+}
+
+/*******************************************************************************
+ * Function Name: host_http_append
+ *******************************************************************************
+ * Summary:
+ *  Appends to the request headers in request->buffer.
+ *
+ * Return:
+ *  int : 0 if the buffer is full
+ *
+ *******************************************************************************/
+static int host_http_append(cy_http_client_request_header_t *request, const char *text, size_t len) {
+	if(request->headers_len + len > request->buffer_len) {
+		return 0;
+	}
+	(void)memcpy(&request->buffer[request->headers_len], text, len);
+	request->headers_len += (uint32_t)len;
+	return 1;
+}
@@ -0,0 +1,25 @@
+/******************************************************************************
+* File Name:   cy8ckit_028_tft_pins.h
+*
+* Description: Host stand-in for the CY8CKIT-028-TFT pin map. The pins only
+* need to exist.
+*
+*******************************************************************************/
+
+#ifndef CY8CKIT_028_TFT_PINS_H_
+#define CY8CKIT_028_TFT_PINS_H_
+
+#define CY8CKIT_028_TFT_PIN_DISPLAY_DB8  (8)
+#define CY8CKIT_028_TFT_PIN_DISPLAY_DB9  (9)
+#define CY8CKIT_028_TFT_PIN_DISPLAY_DB10 (10)
+#define CY8CKIT_028_TFT_PIN_DISPLAY_DB11 (11)
+#define CY8CKIT_028_TFT_PIN_DISPLAY_DB12 (12)
+#define CY8CKIT_028_TFT_PIN_DISPLAY_DB13 (13)
+#define CY8CKIT_028_TFT_PIN_DISPLAY_DB14 (14)
+#define CY8CKIT_028_TFT_PIN_DISPLAY_DB15 (15)
+#define CY8CKIT_028_TFT_PIN_DISPLAY_NRD  (16)
+#define CY8CKIT_028_TFT_PIN_DISPLAY_NWR  (17)
+#define CY8CKIT_028_TFT_PIN_DISPLAY_DC   (18)
+#define CY8CKIT_028_TFT_PIN_DISPLAY_RST  (19)
+
+#endif /* CY8CKIT_028_TFT_PINS_H_ */
@@ -0,0 +1,107 @@
+/******************************************************************************
+* File Name:   cy_http_client_api.h
+*
+* Description: Host stand-in for the HTTP client library, with the types and
+* calls of its API the firmware uses. host/http_client_host.c implements a
+* client over the host's secure sockets stand-in that, like the library,
+* reads a whole response into the request buffer before send returns.
+*
+*******************************************************************************/
+
+#ifndef CY_HTTP_CLIENT_API_H_
+#define CY_HTTP_CLIENT_API_H_
+
+#include "cyhal.h"
+#include "cy_secure_sockets.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define CY_RSLT_MODULE_HTTP_CLIENT (0x0A02u)
+
+#define CY_RSLT_HTTP_CLIENT_ERROR_BADARG        CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CY_RSLT_MODULE_HTTP_CLIENT, 1)
+#define CY_RSLT_HTTP_CLIENT_ERROR_NOMEM         CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CY_RSLT_MODULE_HTTP_CLIENT, 2)
+#define CY_RSLT_HTTP_CLIENT_ERROR_NOT_CONNECTED CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CY_RSLT_MODULE_HTTP_CLIENT, 3)
+#define CY_RSLT_HTTP_CLIENT_ERROR_PARSER        CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CY_RSLT_MODULE_HTTP_CLIENT, 4)
+#define CY_RSLT_HTTP_CLIENT_ERROR_NO_RESPONSE   CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CY_RSLT_MODULE_HTTP_CLIENT, 5)
+#define CY_RSLT_HTTP_CLIENT_ERROR_NOT_FOUND     CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CY_RSLT_MODULE_HTTP_CLIENT, 6)
+
+#define CY_AWS_ROOTCA_VERIFY_NONE     (0)
+#define CY_AWS_ROOTCA_VERIFY_OPTIONAL (1)
+#define CY_AWS_ROOTCA_VERIFY_REQUIRED (2)
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+typedef struct host_http_client *cy_http_client_t;
+
+typedef void (*cy_http_disconnect_callback_t)(void *user_data);
+
+typedef struct {
+	const char *host_name;
+	uint16_t port;
+} cy_awsport_server_info_t;
+
+typedef struct {
+	const char *root_ca;
+	uint32_t root_ca_size;           // Including the terminating NUL of a PEM
+	int root_ca_verify_mode;
+	const char *client_cert;
+	uint32_t client_cert_size;
+	const char *private_key;
+	uint32_t private_key_size;
+	const char *sni_host_name;
+	uint16_t sni_host_name_size;
+} cy_awsport_ssl_credentials_t;
+
+typedef enum {
+	CY_HTTP_CLIENT_METHOD_GET,
+	CY_HTTP_CLIENT_METHOD_PUT,
+	CY_HTTP_CLIENT_METHOD_POST,
+	CY_HTTP_CLIENT_METHOD_HEAD
+} cy_http_client_method_t;
+
+typedef struct {
+	cy_http_client_method_t method;
+	const char *resource_path;
+	uint8_t *buffer;                 // Holds the request headers, then the response
+	uint32_t buffer_len;
+	uint32_t headers_len;
+	int32_t range_start;
+	int32_t range_end;
+} cy_http_client_request_header_t;
+
+typedef struct {
+	char *field;
+	size_t field_len;
+	char *value;
+	size_t value_len;
+} cy_http_client_header_t;
+
+typedef struct {
+	uint16_t status_code;
+	uint8_t *header;
+	uint32_t headers_len;
+	uint32_t header_count;
+	uint8_t *body;
+	uint32_t body_len;
+	uint32_t content_len;
+} cy_http_client_response_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+cy_rslt_t cy_http_client_init(void);
+cy_rslt_t cy_http_client_create(cy_awsport_ssl_credentials_t *security, cy_awsport_server_info_t *server_info,
+								cy_http_disconnect_callback_t disconn_cb, void *user_data, cy_http_client_t *handle);
+cy_rslt_t cy_http_client_connect(cy_http_client_t handle, uint32_t send_timeout_ms, uint32_t receive_timeout_ms);
+cy_rslt_t cy_http_client_write_header(cy_http_client_t handle, cy_http_client_request_header_t *request,
+									  cy_http_client_header_t *header, uint32_t num_header);
+cy_rslt_t cy_http_client_send(cy_http_client_t handle, cy_http_client_request_header_t *request, uint8_t *payload,
+							  uint32_t payload_len, cy_http_client_response_t *response);
+cy_rslt_t cy_http_client_read_header(cy_http_client_t handle, cy_http_client_response_t *response,
+									 cy_http_client_header_t *header, uint32_t num_header);
+cy_rslt_t cy_http_client_disconnect(cy_http_client_t handle);
+cy_rslt_t cy_http_client_delete(cy_http_client_t handle);
+
+#endif /* CY_HTTP_CLIENT_API_H_ */
@@ -0,0 +1,54 @@
+/******************************************************************************
+* File Name:   cy_pdl.h
+*
+* Description: Host stand-in for the Cortex-M core registers the firmware
+* touches. The DWT cycle counter counts SystemCoreClock cycles of the host's
+* monotonic clock, so the metrics histograms and benchmarks read in the same
+* units as on the board.
+*
+*******************************************************************************/
+
+#ifndef CY_PDL_H_
+#define CY_PDL_H_
+
+#include <stdint.h>
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* The CM4 core clock of the board, the rate the cycle counter ticks at */
+#define HOST_CORE_CLOCK_HZ (100000000u)
+
+#define CoreDebug_DEMCR_TRCENA_Msk (1u << 24)
+#define DWT_CTRL_CYCCNTENA_Msk     (1u << 0)
+
+#define DWT       host_dwt()
+#define CoreDebug (&hostCoreDebug)
+
+#define __enable_irq()  ((void)0)
+#define __disable_irq() ((void)0)
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+typedef struct {
+	volatile uint32_t CTRL;
+	volatile uint32_t CYCCNT;    // Refreshed from the host clock on every DWT access
+} host_dwt_t;
+
+typedef struct {
+	volatile uint32_t DEMCR;
+} host_core_debug_t;
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+extern uint32_t SystemCoreClock;
+extern host_core_debug_t hostCoreDebug;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+host_dwt_t *host_dwt(void);
+
+#endif /* CY_PDL_H_ */
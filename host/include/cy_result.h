@@ -0,0 +1,13 @@
+/******************************************************************************
+* File Name:   cy_result.h
+*
+* Description: Host stand-in for the result type, which cyhal.h declares.
+*
+*******************************************************************************/
+
+#ifndef CY_RESULT_H_
+#define CY_RESULT_H_
+
+#include "cyhal.h"
+
+#endif /* CY_RESULT_H_ */
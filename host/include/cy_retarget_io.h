@@ -0,0 +1,34 @@
+/******************************************************************************
+* File Name:   cy_retarget_io.h
+*
+* Description: Host stand-in for retarget-io. printf already goes to the
+* terminal; the debug UART object reads keys from standard input.
+*
+*******************************************************************************/
+
+#ifndef CY_RETARGET_IO_H_
+#define CY_RETARGET_IO_H_
+
+#include <stdio.h>
+
+#include "cyhal.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define CY_RETARGET_IO_BAUDRATE (115200u)
+
+#define CYBSP_DEBUG_UART_TX (0)
+#define CYBSP_DEBUG_UART_RX (0)
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+extern cyhal_uart_t cy_retarget_io_uart_obj;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+cy_rslt_t cy_retarget_io_init(int tx, int rx, uint32_t baudrate);
+
+#endif /* CY_RETARGET_IO_H_ */
@@ -0,0 +1,51 @@
+/******************************************************************************
+* File Name:   cy_secure_sockets.h
+*
+* Description: Host stand-in for the secure sockets calls the firmware makes.
+* host/http_client_host.c implements them over a POSIX socket and an mbedTLS
+* context, so cy_socket_send and cy_socket_recv are TLS writes and reads the
+* link time wrappers in http_connection.c see as on the target.
+*
+*******************************************************************************/
+
+#ifndef CY_SECURE_SOCKETS_H_
+#define CY_SECURE_SOCKETS_H_
+
+#include "cyhal.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define CY_RSLT_MODULE_SECURE_SOCKETS (0x0A00u)
+
+#define CY_RSLT_MODULE_SECURE_SOCKETS_TIMEOUT        CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CY_RSLT_MODULE_SECURE_SOCKETS, 5)
+#define CY_RSLT_MODULE_SECURE_SOCKETS_CLOSED         CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CY_RSLT_MODULE_SECURE_SOCKETS, 7)
+#define CY_RSLT_MODULE_SECURE_SOCKETS_TLS_ERROR      CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CY_RSLT_MODULE_SECURE_SOCKETS, 10)
+#define CY_RSLT_MODULE_SECURE_SOCKETS_HOST_NOT_FOUND CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CY_RSLT_MODULE_SECURE_SOCKETS, 23)
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+typedef struct host_socket *cy_socket_t;
+
+typedef enum {
+	CY_SOCKET_IP_VER_V4 = 4,
+	CY_SOCKET_IP_VER_V6 = 6
+} cy_socket_ip_version_t;
+
+typedef struct {
+	cy_socket_ip_version_t version;
+	union {
+		uint32_t v4;    // Network byte order
+		uint32_t v6[4];
+	} ip;
+} cy_socket_ip_address_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+cy_rslt_t cy_socket_gethostbyname(const char *hostname, cy_socket_ip_version_t ip_ver, cy_socket_ip_address_t *addr);
+cy_rslt_t cy_socket_send(cy_socket_t handle, const void *data, uint32_t size, int flags, uint32_t *bytes_sent);
+cy_rslt_t cy_socket_recv(cy_socket_t handle, void *buffer, uint32_t size, int flags, uint32_t *bytes_received);
+
+#endif /* CY_SECURE_SOCKETS_H_ */
@@ -0,0 +1,59 @@
+/******************************************************************************
+* File Name:   cy_wcm.h
+*
+* Description: Host stand-in for the Wi-Fi connection manager. The host is
+* already on a network, so joining the access point only reports the
+* loopback address.
+*
+*******************************************************************************/
+
+#ifndef CY_WCM_H_
+#define CY_WCM_H_
+
+#include "cyhal.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define CY_WCM_MAX_SSID_LEN       (32)
+#define CY_WCM_MAX_PASSPHRASE_LEN (63)
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+typedef uint8_t uint8;
+
+typedef enum {
+	CY_WCM_INTERFACE_TYPE_STA
+} cy_wcm_interface_t;
+
+typedef enum {
+	CY_WCM_SECURITY_OPEN,
+	CY_WCM_SECURITY_WPA2_AES_PSK
+} cy_wcm_security_t;
+
+typedef struct {
+	cy_wcm_interface_t interface;
+} cy_wcm_config_t;
+
+typedef struct {
+	struct {
+		uint8_t SSID[CY_WCM_MAX_SSID_LEN + 1];
+		uint8_t password[CY_WCM_MAX_PASSPHRASE_LEN + 1];
+		cy_wcm_security_t security;
+	} ap_credentials;
+} cy_wcm_connect_params_t;
+
+typedef struct {
+	struct {
+		uint32_t v4;
+	} ip;
+} cy_wcm_ip_address_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+cy_rslt_t cy_wcm_init(cy_wcm_config_t *config);
+cy_rslt_t cy_wcm_connect_ap(cy_wcm_connect_params_t *params, cy_wcm_ip_address_t *ip_address);
+
+#endif /* CY_WCM_H_ */
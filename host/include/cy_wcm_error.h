@@ -0,0 +1,14 @@
+/******************************************************************************
+* File Name:   cy_wcm_error.h
+*
+* Description: Host stand-in for the Wi-Fi connection manager's error codes,
+* none of which the host reports.
+*
+*******************************************************************************/
+
+#ifndef CY_WCM_ERROR_H_
+#define CY_WCM_ERROR_H_
+
+#include "cyhal.h"
+
+#endif /* CY_WCM_ERROR_H_ */
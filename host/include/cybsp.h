@@ -0,0 +1,19 @@
+/******************************************************************************
+* File Name:   cybsp.h
+*
+* Description: Host stand-in for the board support package. There is no
+* board to bring up.
+*
+*******************************************************************************/
+
+#ifndef CYBSP_H_
+#define CYBSP_H_
+
+#include "cyhal.h"
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+cy_rslt_t cybsp_init(void);
+
+#endif /* CYBSP_H_ */
@@ -0,0 +1,36 @@
+/******************************************************************************
+* File Name:   cyhal.h
+*
+* Description: Host stand-in for the PSoC6 HAL. The flash driver is the
+* file-backed emulator of the host tests, test/stubs/host_flash.c; the debug
+* UART reads keys from the terminal.
+*
+*******************************************************************************/
+
+#ifndef HOST_CYHAL_H_
+#define HOST_CYHAL_H_
+
+#include <stdlib.h>
+
+#include "../../test/stubs/cyhal.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define CY_HALT()              abort()
+#define CY_UNUSED_PARAMETER(x) ((void)(x))
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+typedef struct {
+	int fd;    // Where the debug UART reads from, standard input
+} cyhal_uart_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+uint32_t cyhal_uart_readable(cyhal_uart_t *obj);
+cy_rslt_t cyhal_uart_getc(cyhal_uart_t *obj, uint8_t *value, uint32_t timeout);
+
+#endif /* HOST_CYHAL_H_ */
@@ -0,0 +1,29 @@
+/******************************************************************************
+* File Name:   mtb_st7789v.h
+*
+* Description: Host stand-in for the ST7789V panel driver. The panel is the
+* framebuffer in host/emwin, which needs no bring-up.
+*
+*******************************************************************************/
+
+#ifndef MTB_ST7789V_H_
+#define MTB_ST7789V_H_
+
+#include "cyhal.h"
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+typedef int cyhal_gpio_t;
+
+typedef struct {
+	cyhal_gpio_t db08, db09, db10, db11, db12, db13, db14, db15;
+	cyhal_gpio_t nrd, nwr, dc, rst;
+} mtb_st7789v_pins_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+cy_rslt_t mtb_st7789v_init8(const mtb_st7789v_pins_t *pins);
+
+#endif /* MTB_ST7789V_H_ */
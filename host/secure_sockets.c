@@ -0,0 +1,426 @@
+/******************************************************************************
+* File Name:   secure_sockets.c
+*
+* Description: This file contains the host stand-in for secure sockets: a
+* POSIX TCP socket with an mbedTLS client session on top, set up from the
+* same credentials the firmware passes to the HTTP client. The host name
+* is set on the session with mbedtls_ssl_set_hostname and the handshake run
+* with mbedtls_ssl_handshake, the calls the TLS session cache wraps.
+*
+* Sockets never block the calling thread. A task waiting for the network is
+* delayed a tick at a time, like one blocked in lwIP, so lower priority
+* tasks still run and the kernel's tick keeps its thread in control.
+*
+*******************************************************************************/
+
+/* Standard C header file. */
+#include <errno.h>
+#include <netdb.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+/* FreeRTOS header file. */
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include "mbedtls/ctr_drbg.h"
+#include "mbedtls/entropy.h"
+#include "mbedtls/net_sockets.h"
+#include "mbedtls/pk.h"
+#include "mbedtls/ssl.h"
+#include "mbedtls/x509_crt.h"
+
+#include "host_socket.h"
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+struct host_socket {
+	int fd;
+	uint32_t send_timeout_ms;
+	uint32_t receive_timeout_ms;
+	mbedtls_ssl_context ssl;
+	mbedtls_ssl_config conf;
+	mbedtls_x509_crt ca;
+	mbedtls_x509_crt cert;
+	mbedtls_pk_context key;
+	mbedtls_entropy_context entropy;
+	mbedtls_ctr_drbg_context drbg;
+};
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+static cy_rslt_t host_socket_connect_tcp(struct host_socket *sock, const cy_awsport_server_info_t *server);
+static cy_rslt_t host_socket_setup_tls(struct host_socket *sock, const cy_awsport_ssl_credentials_t *credentials);
+static bool host_socket_wait(TickType_t start, uint32_t timeout_ms);
+static int host_socket_bio_send(void *ctx, const unsigned char *buf, size_t len);
+static int host_socket_bio_recv(void *ctx, unsigned char *buf, size_t len);
+static cy_rslt_t host_socket_result(int ret);
+
+/*******************************************************************************
+ * Function Name: cy_socket_gethostbyname
+ *******************************************************************************
+ * Summary:
+ *  Resolves a host name to an IPv4 address with the host's resolver, which
+ *  blocks the scheduler until it answers.
+ *
+ *******************************************************************************/
+cy_rslt_t cy_socket_gethostbyname(const char *hostname, cy_socket_ip_version_t ip_ver, cy_socket_ip_address_t *addr) {
+	struct addrinfo hints = {.ai_family = AF_INET, .ai_socktype = SOCK_STREAM};
+	struct addrinfo *found = NULL;
+
+	if(ip_ver != CY_SOCKET_IP_VER_V4 || getaddrinfo(hostname, NULL, &hints, &found) != 0 || found == NULL) {
+		return CY_RSLT_MODULE_SECURE_SOCKETS_HOST_NOT_FOUND;
+	}
+	addr->version = CY_SOCKET_IP_VER_V4;
+	addr->ip.v4 = ((const struct sockaddr_in *)found->ai_addr)->sin_addr.s_addr;
+	freeaddrinfo(found);
+
+	return CY_RSLT_SUCCESS;
+}
+
+/*******************************************************************************
+ * Function Name: cy_socket_send
+ *******************************************************************************
+ * Summary:
+ *  Writes all of data over the TLS session.
+ *
+ *******************************************************************************/
+cy_rslt_t cy_socket_send(cy_socket_t handle, const void *data, uint32_t size, int flags, uint32_t *bytes_sent) {
+	uint32_t sent = 0;
+	int ret;
+
+	while(sent < size) {
+		ret = mbedtls_ssl_write(&handle->ssl, (const unsigned char *)data + sent, size - sent);
+		if(ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
+			continue;
+		}
+		if(ret < 0) {
+			*bytes_sent = sent;
+			return host_socket_result(ret);
+		}
+		sent += (uint32_t)ret;
+	}
+
+	*bytes_sent = sent;
+	return CY_RSLT_SUCCESS;
+}
+
+/*******************************************************************************
+ * Function Name: cy_socket_recv
+ *******************************************************************************
+ * Summary:
+ *  Reads what has arrived of the TLS session, up to size bytes, waiting up
+ *  to the receive timeout for the first of it.
+ *
+ * Return:
+ *  cy_rslt_t : CY_RSLT_SUCCESS with at least one byte, or the timeout, the
+ *  close by the server, or a TLS error
+ *
+ *******************************************************************************/
+cy_rslt_t cy_socket_recv(cy_socket_t handle, void *buffer, uint32_t size, int flags, uint32_t *bytes_received) {
+	int ret;
+
+	*bytes_received = 0;
+	do {
+		ret = mbedtls_ssl_read(&handle->ssl, buffer, size);
+	} while(ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE);
+
+	if(ret <= 0) {
+		return host_socket_result(ret);
+	}
+	*bytes_received = (uint32_t)ret;
+	return CY_RSLT_SUCCESS;
+}
+
+/*******************************************************************************
+ * Function Name: host_socket_open
+ *******************************************************************************
+ * Summary:
+ *  Connects to the server and completes the TLS handshake.
+ *
+ * Return:
+ *  cy_rslt_t : CY_RSLT_SUCCESS with *handle set, the TCP or TLS failure
+ *  otherwise
+ *
+ *******************************************************************************/
+cy_rslt_t host_socket_open(cy_socket_t *handle, const cy_awsport_server_info_t *server, const cy_awsport_ssl_credentials_t *credentials,
+						   uint32_t send_timeout_ms, uint32_t receive_timeout_ms) {
+	struct host_socket *sock = calloc(1, sizeof(*sock));
+	cy_rslt_t result;
+
+	if(sock == NULL) {
+		return CY_RSLT_MODULE_SECURE_SOCKETS_TLS_ERROR;
+	}
+	sock->fd = -1;
+	sock->send_timeout_ms = send_timeout_ms;
+	sock->receive_timeout_ms = receive_timeout_ms;
+	mbedtls_ssl_init(&sock->ssl);
+	mbedtls_ssl_config_init(&sock->conf);
+	mbedtls_x509_crt_init(&sock->ca);
+	mbedtls_x509_crt_init(&sock->cert);
+	mbedtls_pk_init(&sock->key);
+	mbedtls_entropy_init(&sock->entropy);
+	mbedtls_ctr_drbg_init(&sock->drbg);
+
+	result = host_socket_connect_tcp(sock, server);
+	if(result == CY_RSLT_SUCCESS) {
+		result = host_socket_setup_tls(sock, credentials);
+	}
+	if(result != CY_RSLT_SUCCESS) {
+		host_socket_close(sock);
+		return result;
+	}
+
+	*handle = sock;
+	return CY_RSLT_SUCCESS;
+}
+
+/*******************************************************************************
+ * Function Name: host_socket_close
+ *******************************************************************************
+ * Summary:
+ *  Ends the session, telling the server if it is still listening, and
+ *  frees the socket.
+ *
+ *******************************************************************************/
+void host_socket_close(cy_socket_t handle) {
+	if(handle == NULL) {
+		return;
+	}
+	if(handle->fd >= 0) {
+		handle->send_timeout_ms = 0;    // Never wait on a server that stopped reading
+		(void)mbedtls_ssl_close_notify(&handle->ssl);
+		(void)close(handle->fd);
+	}
+	mbedtls_ssl_free(&handle->ssl);
+	mbedtls_ssl_config_free(&handle->conf);
+	mbedtls_x509_crt_free(&handle->ca);
+	mbedtls_x509_crt_free(&handle->cert);
+	mbedtls_pk_free(&handle->key);
+	mbedtls_ctr_drbg_free(&handle->drbg);
+	mbedtls_entropy_free(&handle->entropy);
+	free(handle);
+}
+
+/*******************************************************************************
+ * Function Name: host_socket_connect_tcp
+ *******************************************************************************
+ * Summary:
+ *  Opens a non-blocking TCP connection to the server, waiting up to the
+ *  send timeout for it to be accepted.
+ *
+ *******************************************************************************/
+static cy_rslt_t host_socket_connect_tcp(struct host_socket *sock, const cy_awsport_server_info_t *server) {
+	struct sockaddr_in address = {.sin_family = AF_INET, .sin_port = htons(server->port)};
+	cy_socket_ip_address_t ip;
+	TickType_t start = xTaskGetTickCount();
+	int error = 0;
+	socklen_t errorLen = sizeof(error);
+
+	if(cy_socket_gethostbyname(server->host_name, CY_SOCKET_IP_VER_V4, &ip) != CY_RSLT_SUCCESS) {
+		return CY_RSLT_MODULE_SECURE_SOCKETS_HOST_NOT_FOUND;
+	}
+	address.sin_addr.s_addr = ip.ip.v4;
+
+	sock->fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if(sock->fd < 0) {
+		return CY_RSLT_MODULE_SECURE_SOCKETS_CLOSED;
+	}
+	if(connect(sock->fd, (const struct sockaddr *)&address, sizeof(address)) == 0) {
+		return CY_RSLT_SUCCESS;
+	}
+	if(errno != EINPROGRESS && errno != EINTR) {
+		return CY_RSLT_MODULE_SECURE_SOCKETS_CLOSED;
+	}
+
+	while(1) {
+		struct pollfd fd = {.fd = sock->fd, .events = POLLOUT};
+
+		if(poll(&fd, 1, 0) > 0) {
+			break;
+		}
+		if(!host_socket_wait(start, sock->send_timeout_ms)) {
+			return CY_RSLT_MODULE_SECURE_SOCKETS_TIMEOUT;
+		}
+	}
+	if(getsockopt(sock->fd, SOL_SOCKET, SO_ERROR, &error, &errorLen) != 0 || error != 0) {
+		return CY_RSLT_MODULE_SECURE_SOCKETS_CLOSED;
+	}
+	return CY_RSLT_SUCCESS;
+}
+
+/*******************************************************************************
+ * Function Name: host_socket_setup_tls
+ *******************************************************************************
+ * Summary:
+ *  Sets up the client session from the credentials, as the secure sockets
+ *  TLS port does, and runs the handshake. The root CA verify mode maps
+ *  onto mbedTLS's, and a client certificate is only presented when there
+ *  is one with its key.
+ *
+ *******************************************************************************/
+static cy_rslt_t host_socket_setup_tls(struct host_socket *sock, const cy_awsport_ssl_credentials_t *credentials) {
+	static const char personalization[] = "host_socket";
+	char sni[256];
+	int authMode;
+	int ret;
+
+	switch(credentials->root_ca_verify_mode) {
+		case CY_AWS_ROOTCA_VERIFY_NONE:
+			authMode = MBEDTLS_SSL_VERIFY_NONE;
+			break;
+		case CY_AWS_ROOTCA_VERIFY_OPTIONAL:
+			authMode = MBEDTLS_SSL_VERIFY_OPTIONAL;
+			break;
+		default:
+			authMode = MBEDTLS_SSL_VERIFY_REQUIRED;
+			break;
+	}
+
+	if(mbedtls_ctr_drbg_seed(&sock->drbg, mbedtls_entropy_func, &sock->entropy, (const unsigned char *)personalization, sizeof(personalization) - 1) != 0 ||
+	   mbedtls_ssl_config_defaults(&sock->conf, MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT) != 0) {
+		return CY_RSLT_MODULE_SECURE_SOCKETS_TLS_ERROR;
+	}
+	mbedtls_ssl_conf_rng(&sock->conf, mbedtls_ctr_drbg_random, &sock->drbg);
+	mbedtls_ssl_conf_authmode(&sock->conf, authMode);
+
+	if(credentials->root_ca != NULL && credentials->root_ca_size > 1) {
+		if(mbedtls_x509_crt_parse(&sock->ca, (const unsigned char *)credentials->root_ca, credentials->root_ca_size) != 0) {
+			printf("Root CA could not be parsed\n");
+			return CY_RSLT_MODULE_SECURE_SOCKETS_TLS_ERROR;
+		}
+		mbedtls_ssl_conf_ca_chain(&sock->conf, &sock->ca, NULL);
+	}
+
+	if(credentials->client_cert != NULL && credentials->client_cert_size > 1 && credentials->private_key != NULL && credentials->private_key_size > 1) {
+		if(mbedtls_x509_crt_parse(&sock->cert, (const unsigned char *)credentials->client_cert, credentials->client_cert_size) != 0 ||
+		   mbedtls_pk_parse_key(&sock->key, (const unsigned char *)credentials->private_key, credentials->private_key_size, NULL, 0) != 0 ||
+		   mbedtls_ssl_conf_own_cert(&sock->conf, &sock->cert, &sock->key) != 0) {
+			printf("Client certificate could not be loaded\n");
+			return CY_RSLT_MODULE_SECURE_SOCKETS_TLS_ERROR;
+		}
+	}
+
+	if(mbedtls_ssl_setup(&sock->ssl, &sock->conf) != 0) {
+		return CY_RSLT_MODULE_SECURE_SOCKETS_TLS_ERROR;
+	}
+	if(credentials->sni_host_name != NULL && credentials->sni_host_name_size > 0 && credentials->sni_host_name_size < sizeof(sni)) {
+		(void)memcpy(sni, credentials->sni_host_name, credentials->sni_host_name_size);
+		sni[credentials->sni_host_name_size] = '\0';
+		if(mbedtls_ssl_set_hostname(&sock->ssl, sni) != 0) {
+			return CY_RSLT_MODULE_SECURE_SOCKETS_TLS_ERROR;
+		}
+	}
+	mbedtls_ssl_set_bio(&sock->ssl, sock, host_socket_bio_send, host_socket_bio_recv, NULL);
+
+	do {
+		ret = mbedtls_ssl_handshake(&sock->ssl);
+	} while(ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE);
+
+	if(ret != 0) {
+		printf("TLS handshake failed: -0x%04x\n", (unsigned)-ret);
+		return CY_RSLT_MODULE_SECURE_SOCKETS_TLS_ERROR;
+	}
+	return CY_RSLT_SUCCESS;
+}
+
+/*******************************************************************************
+ * Function Name: host_socket_wait
+ *******************************************************************************
+ * Summary:
+ *  Gives up the processor for a tick while waiting on the socket.
+ *
+ * Return:
+ *  bool : false once timeout_ms have passed since start
+ *
+ *******************************************************************************/
+static bool host_socket_wait(TickType_t start, uint32_t timeout_ms) {
+	if(pdTICKS_TO_MS(xTaskGetTickCount() - start) >= timeout_ms) {
+		return false;
+	}
+	vTaskDelay(1);
+	return true;
+}
+
+/*******************************************************************************
+ * Function Name: host_socket_bio_send, host_socket_bio_recv
+ *******************************************************************************
+ * Summary:
+ *  The transport under the TLS session. A signal from the kernel's tick
+ *  interrupting a call only retries it.
+ *
+ *******************************************************************************/
+static int host_socket_bio_send(void *ctx, const unsigned char *buf, size_t len) {
+	struct host_socket *sock = (struct host_socket *)ctx;
+	TickType_t start = xTaskGetTickCount();
+
+	while(1) {
+		ssize_t n = send(sock->fd, buf, len, MSG_DONTWAIT | MSG_NOSIGNAL);
+
+		if(n >= 0) {
+			return (int)n;
+		}
+		if(errno == EPIPE || errno == ECONNRESET) {
+			return MBEDTLS_ERR_NET_CONN_RESET;
+		}
+		if(errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK) {
+			return MBEDTLS_ERR_NET_SEND_FAILED;
+		}
+		if(errno != EINTR && !host_socket_wait(start, sock->send_timeout_ms)) {
+			return MBEDTLS_ERR_SSL_TIMEOUT;
+		}
+	}
+}
+
+static int host_socket_bio_recv(void *ctx, unsigned char *buf, size_t len) {
+	struct host_socket *sock = (struct host_socket *)ctx;
+	TickType_t start = xTaskGetTickCount();
+
+	while(1) {
+		ssize_t n = recv(sock->fd, buf, len, MSG_DONTWAIT);
+
+		if(n >= 0) {
+			return (int)n;
+		}
+		if(errno == ECONNRESET) {
+			return MBEDTLS_ERR_NET_CONN_RESET;
+		}
+		if(errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK) {
+			return MBEDTLS_ERR_NET_RECV_FAILED;
+		}
+		if(errno != EINTR && !host_socket_wait(start, sock->receive_timeout_ms)) {
+			return MBEDTLS_ERR_SSL_TIMEOUT;
+		}
+	}
+}
+
+/*******************************************************************************
+ * Function Name: host_socket_result
+ *******************************************************************************
+ * Summary:
+ *  The secure sockets result for an mbedTLS return value.
+ *
+ *******************************************************************************/
+static cy_rslt_t host_socket_result(int ret) {
+	switch(ret) {
+		case 0:
+		case MBEDTLS_ERR_SSL_CONN_EOF:
+		case MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY:
+		case MBEDTLS_ERR_NET_CONN_RESET:
+			return CY_RSLT_MODULE_SECURE_SOCKETS_CLOSED;
+
+		case MBEDTLS_ERR_SSL_TIMEOUT:
+			return CY_RSLT_MODULE_SECURE_SOCKETS_TIMEOUT;
+
+		default:
+			return CY_RSLT_MODULE_SECURE_SOCKETS_TLS_ERROR;
+	}
+}
@@ -0,0 +1,507 @@
+#!/usr/bin/env python3
+################################################################################
+# \file standin_server.py
+# \version 1.0
+#
+# \brief
+# Local HTTPS stand-in for financialmodelingprep.com, for load and fault
+# testing the client without spending API keys. It serves
+# /api/v3/quote/<symbols>?apikey=<key> with FMP's quote objects, the prices
+# walking at random, over HTTP/1.1 keep-alive. Scripted profiles inject the
+# faults the client has to survive:
+#
+#   latency      responses held back 0.2 to 1.5 s
+#   stall        the body sent in small records with pauses between them
+#   chunked      chunked transfer coding, odd chunk sizes, extensions
+#   until-close  no length, the body ends with the connection
+#   429          rate limited, Retry-After in seconds or as an HTTP date
+#   quota        200 carrying FMP's "Error Message" object
+#   401          key refused
+#   503          server error
+#   malformed    the JSON cut short or garbled
+#   disconnect   the connection dropped in the middle of the body
+#   close        "Connection: close" after the response
+#   drop-idle    the kept-alive connection closed without notice
+#   reset        the TCP connection reset before the handshake
+#
+# 429, quota and 401 exercise the key pool (api_key_pool.c); reset, 503,
+# malformed, disconnect, close and drop-idle the connection's failure classes
+# and backoff (http_connection.c); stall, chunked, until-close and disconnect
+# the framing of the streamed body (http_body.c).
+#
+# Which fault a request gets is drawn from a seeded random sequence, so a run
+# can be repeated. Every handshake (TLS version, cipher, session resumed) and
+# every request (key, status, fault, bytes, time) is logged, and a summary is
+# printed on exit.
+#
+#   ./standin_server.py --make-certs                 writes the certificates
+#                                                    and build/server_config.h
+#   ./standin_server.py --profile chaos --seed 7     serves on port 8443
+#   make FREERTOS_KERNEL_PATH=<...> SERVER_CONFIG=build/server_config.h run
+#
+# The certificates are a root, an intermediate and a leaf for "localhost",
+# the shape of the Amazon chain the firmware trusts; the header sets
+# SSL_ROOTCA_PEM to the root, so the client verifies the chain as it does in
+# production. The leaf names localhost by DNS name, mbedTLS 2.x does not
+# match IP addresses.
+#
+################################################################################
+
+import argparse
+import email.utils
+import json
+import os
+import random
+import signal
+import socket
+import ssl
+import struct
+import subprocess
+import sys
+import threading
+import time
+
+################################################################################
+# Profiles
+################################################################################
+
+# Probability of each fault per request; the first one drawn applies
+PROFILES = {
+    "clean": {},
+    "latency": {"latency": 1.0},
+    "stall": {"stall": 0.5},
+    "framing": {"chunked": 0.4, "until-close": 0.2},
+    "ratelimit": {"429": 0.3, "quota": 0.05},
+    "malformed": {"malformed": 0.3},
+    "disconnect": {"disconnect": 0.3},
+    "keepalive": {"close": 0.2, "drop-idle": 0.2},
+    "outage": {"503": 0.3, "reset": 0.2},
+    "chaos": {
+        "latency": 0.15, "stall": 0.1, "chunked": 0.1, "until-close": 0.05, "429": 0.05, "quota": 0.02,
+        "401": 0.02, "503": 0.05, "malformed": 0.05, "disconnect": 0.05, "close": 0.05, "drop-idle": 0.05,
+        "reset": 0.03,
+    },
+}
+
+# Faults applied at connection time, the rest per request
+CONNECTION_FAULTS = ("reset",)
+
+LATENCY_S = (0.2, 1.5)
+STALL_PIECE_BYTES = (16, 200)
+STALL_S = (0.05, 0.8)
+RETRY_AFTER_S = (1, 30)
+IDLE_TIMEOUT_S = 60
+
+# Symbols and starting prices; anything else starts at 100
+START_PRICES = {"AMD": 156.79, "NVDA": 121.7, "INTC": 31.2, "AAPL": 214.29, "MSFT": 442.57}
+
+################################################################################
+# Quotes
+################################################################################
+
+
+class Market:
+    """Prices walking at random, one walk per symbol, shared by all clients."""
+
+    def __init__(self, rng):
+        self.rng = rng
+        self.lock = threading.Lock()
+        self.symbols = {}
+
+    def quote(self, symbol):
+        with self.lock:
+            state = self.symbols.get(symbol)
+            if state is None:
+                start = START_PRICES.get(symbol, 100.0)
+                state = {"previousClose": start, "open": round(start * (1 + self.rng.gauss(0, 0.005)), 2),
+                         "volume": 0}
+                state["price"] = state["dayLow"] = state["dayHigh"] = state["open"]
+                self.symbols[symbol] = state
+            price = max(0.01, round(state["price"] * (1 + self.rng.gauss(0, 0.002)), 2))
+            state["price"] = price
+            state["dayLow"] = min(state["dayLow"], price)
+            state["dayHigh"] = max(state["dayHigh"], price)
+            state["volume"] += self.rng.randint(1000, 200000)
+            close = state["previousClose"]
+            return {
+                "symbol": symbol, "name": symbol + " Inc.", "price": price,
+                "changesPercentage": round((price - close) * 100 / close, 4), "change": round(price - close, 2),
+                "dayLow": state["dayLow"], "dayHigh": state["dayHigh"], "yearHigh": round(close * 1.45, 2),
+                "yearLow": round(close * 0.6, 2), "marketCap": int(price * 1616220000), "priceAvg50": round(close, 3),
+                "priceAvg200": round(close * 0.95, 3), "exchange": "NASDAQ", "volume": state["volume"],
+                "avgVolume": 60123456, "open": state["open"], "previousClose": close, "eps": 0.53,
+                "pe": round(price / 0.53, 2), "earningsAnnouncement": "2024-10-29T20:00:00.000+0000",
+                "sharesOutstanding": 1616220000, "timestamp": int(time.time()),
+            }
+
+
+################################################################################
+# Log
+################################################################################
+
+
+class Log:
+    """Timestamped lines to stderr and optionally a file, and the run's totals."""
+
+    def __init__(self, path):
+        self.lock = threading.Lock()
+        self.file = open(path, "a") if path else None
+        self.start = time.monotonic()
+        self.totals = {"connections": 0, "handshakes": 0, "resumed": 0, "handshake_failures": 0, "requests": 0,
+                       "bytes": 0}
+        self.faults = {}
+        self.statuses = {}
+
+    def line(self, text):
+        text = "%9.3f %s" % (time.monotonic() - self.start, text)
+        with self.lock:
+            print(text, file=sys.stderr, flush=True)
+            if self.file:
+                self.file.write(text + "\n")
+                self.file.flush()
+
+    def count(self, key, n=1):
+        with self.lock:
+            self.totals[key] += n
+
+    def fault(self, fault):
+        with self.lock:
+            self.faults[fault] = self.faults.get(fault, 0) + 1
+
+    def request(self, status, fault, sent):
+        self.fault(fault)
+        with self.lock:
+            self.totals["requests"] += 1
+            self.totals["bytes"] += sent
+            self.statuses[status] = self.statuses.get(status, 0) + 1
+
+    def summary(self):
+        elapsed = time.monotonic() - self.start
+        with self.lock:
+            t = self.totals
+        self.line("summary: %.1f s, %d connections, %d handshakes (%d resumed, %d failed), %d requests (%.2f/s), %d B sent"
+                  % (elapsed, t["connections"], t["handshakes"], t["resumed"], t["handshake_failures"], t["requests"],
+                     t["requests"] / elapsed if elapsed > 0 else 0, t["bytes"]))
+        self.line("summary: statuses " + ", ".join("%s %d" % kv for kv in sorted(self.statuses.items(), key=str)))
+        self.line("summary: faults " + ", ".join("%s %d" % kv for kv in sorted(self.faults.items())))
+
+
+################################################################################
+# Connection
+################################################################################
+
+
+class Connection(threading.Thread):
+    """One client connection: the handshake, then requests until either side closes."""
+
+    def __init__(self, server, sock, peer, number):
+        super().__init__(daemon=True)
+        self.server = server
+        self.sock = sock
+        self.peer = peer
+        self.number = number
+        self.rng = random.Random(server.seed * 1000003 + number)
+
+    def log(self, text):
+        self.server.log.line("conn %d %s" % (self.number, text))
+
+    def draw_fault(self, faults):
+        for name, probability in self.server.faults.items():
+            if name in faults and self.rng.random() < probability:
+                return name
+        return None
+
+    def run(self):
+        log = self.server.log
+        log.count("connections")
+        self.log("accepted from %s:%d" % self.peer)
+
+        if self.draw_fault(CONNECTION_FAULTS) == "reset":
+            # Linger 0 turns the close into a RST
+            self.sock.setsockopt(socket.SOL_SOCKET, socket.SO_LINGER, struct.pack("ii", 1, 0))
+            self.sock.close()
+            self.log("reset before handshake (fault reset)")
+            log.fault("reset")
+            return
+
+        start = time.monotonic()
+        try:
+            self.sock.settimeout(IDLE_TIMEOUT_S)
+            tls = self.server.context.wrap_socket(self.sock, server_side=True)
+        except (ssl.SSLError, OSError) as error:
+            log.count("handshake_failures")
+            self.log("handshake failed: %s" % error)
+            self.sock.close()
+            return
+        log.count("handshakes")
+        if tls.session_reused:
+            log.count("resumed")
+        self.log("handshake %s %s, %s, %.0f ms" % (tls.version(), tls.cipher()[0],
+                                                  "resumed" if tls.session_reused else "full",
+                                                  (time.monotonic() - start) * 1000))
+
+        try:
+            self.serve(tls)
+        except (ssl.SSLError, OSError) as error:
+            self.log("connection error: %s" % error)
+        finally:
+            try:
+                tls.close()
+            except OSError:
+                pass
+
+    def read_request(self, tls, pending):
+        while b"\r\n\r\n" not in pending:
+            try:
+                data = tls.recv(4096)
+            except socket.timeout:
+                self.log("idle for %d s, closing" % IDLE_TIMEOUT_S)
+                return None, b""
+            if not data:
+                return None, b""
+            pending += data
+        head, _, rest = pending.partition(b"\r\n\r\n")
+        return head.decode("latin-1"), rest
+
+    def serve(self, tls):
+        pending = b""
+        served = 0
+        while True:
+            head, pending = self.read_request(tls, pending)
+            if head is None:
+                self.log("closed by client after %d requests" % served)
+                return
+            served += 1
+            lines = head.split("\r\n")
+            parts = lines[0].split(" ")
+            method, target = (parts[0], parts[1]) if len(parts) >= 2 else ("?", "?")
+            headers = {}
+            for line in lines[1:]:
+                name, _, value = line.partition(":")
+                headers[name.strip().lower()] = value.strip()
+            start = time.monotonic()
+            keep = self.respond(tls, served, method, target, headers, start)
+            if not keep:
+                return
+
+    def respond(self, tls, served, method, target, headers, start):
+        path, _, query = target.partition("?")
+        params = dict(p.partition("=")[::2] for p in query.split("&") if p)
+        key = params.get("apikey", "-")
+        fault = self.draw_fault([f for f in self.server.faults if f not in CONNECTION_FAULTS])
+        close = headers.get("connection", "").lower() == "close"
+
+        if fault == "latency":
+            time.sleep(self.rng.uniform(*LATENCY_S))
+
+        date = email.utils.formatdate(usegmt=True)
+        extra = []
+        if method != "GET" or not path.startswith("/api/v3/quote/"):
+            status, body = 404, b'{"Error Message": "Invalid API endpoint"}'
+        elif fault == "429":
+            retry = self.rng.randint(*RETRY_AFTER_S)
+            if self.rng.random() < 0.5:
+                extra.append("Retry-After: %d" % retry)
+            else:
+                extra.append("Retry-After: " + email.utils.formatdate(time.time() + retry, usegmt=True))
+            status, body = 429, b'{"Error Message": "Limit Reach . Please upgrade your plan"}'
+        elif fault == "quota":
+            status, body = 200, b'{\n  "Error Message": "Limit Reach . Please upgrade your plan or visit our documentation for more details at https://site.financialmodelingprep.com/"\n}'
+        elif fault == "401":
+            status, body = 401, b'{"Error Message": "Invalid API KEY. Please retry or visit our documentation."}'
+        elif fault == "503":
+            status, body = 503, b"<html><body>503 Service Temporarily Unavailable</body></html>"
+        else:
+            symbols = [s for s in path[len("/api/v3/quote/"):].split(",") if s]
+            status = 200
+            body = json.dumps([self.server.market.quote(s) for s in symbols], separators=(",", ":")).encode()
+            if fault == "malformed":
+                if self.rng.random() < 0.5:
+                    body = body[:self.rng.randint(1, max(1, len(body) - 1))]
+                else:
+                    at = self.rng.randrange(len(body))
+                    body = body[:at] + b"}{\x00" + body[at + 1:]
+
+        framing = "length"
+        if fault == "chunked":
+            framing = "chunked"
+        elif fault == "until-close":
+            framing = "close"
+        ending = close or fault in ("close", "until-close")
+
+        head = ["HTTP/1.1 %d %s" % (status, STATUS_TEXT.get(status, "Status")), "Date: " + date,
+                "Content-Type: application/json;charset=UTF-8", "Server: standin"]
+        head += extra
+        if framing == "length":
+            head.append("Content-Length: %d" % len(body))
+        elif framing == "chunked":
+            head.append("Transfer-Encoding: chunked")
+        head.append("Connection: " + ("close" if ending else "keep-alive"))
+        data = ("\r\n".join(head) + "\r\n\r\n").encode()
+
+        if framing == "chunked":
+            wire = b""
+            at = 0
+            while at < len(body):
+                size = min(len(body) - at, self.rng.randint(1, 700))
+                wire += b"%x%s\r\n" % (size, b";ext=1" if self.rng.random() < 0.2 else b"") + body[at:at + size] + b"\r\n"
+                at += size
+            body = wire + b"0\r\n\r\n"
+
+        sent = len(data)
+        tls.sendall(data)
+        if fault == "disconnect":
+            cut = self.rng.randint(0, max(0, len(body) - 1))
+            tls.sendall(body[:cut])
+            sent += cut
+            self.log("req %d %s %s key=%s -> %d, dropped after %d of %d body bytes (fault disconnect), %.0f ms"
+                     % (served, method, path, key, status, cut, len(body), (time.monotonic() - start) * 1000))
+            self.server.log.request(status, fault, sent)
+            self.drop(tls)
+            return False
+        if fault == "stall":
+            at = 0
+            while at < len(body):
+                piece = self.rng.randint(*STALL_PIECE_BYTES)
+                tls.sendall(body[at:at + piece])
+                at += piece
+                if at < len(body):
+                    time.sleep(self.rng.uniform(*STALL_S))
+        else:
+            tls.sendall(body)
+        sent += len(body)
+
+        self.log("req %d %s %s key=%s -> %d %s, %d B%s, %.0f ms"
+                 % (served, method, path, key, status, framing, len(body), (" (fault %s)" % fault) if fault else "",
+                    (time.monotonic() - start) * 1000))
+        self.server.log.request(status, fault or "none", sent)
+
+        if fault == "drop-idle":
+            self.log("dropping the kept-alive connection (fault drop-idle)")
+            self.drop(tls)
+            return False
+        return not ending
+
+    def drop(self, tls):
+        """Closes the connection without close_notify, as when the link goes away. The FIN follows what was sent."""
+        tls.shutdown(socket.SHUT_RDWR)
+
+
+STATUS_TEXT = {200: "OK", 401: "Unauthorized", 404: "Not Found", 429: "Too Many Requests",
+               503: "Service Unavailable"}
+
+################################################################################
+# Server
+################################################################################
+
+
+class Server:
+    def __init__(self, args):
+        self.seed = args.seed
+        self.faults = dict(PROFILES[args.profile])
+        for override in args.fault or []:
+            name, _, probability = override.partition("=")
+            if name not in PROFILES["chaos"]:
+                sys.exit("unknown fault %s, one of: %s" % (name, ", ".join(PROFILES["chaos"])))
+            self.faults[name] = float(probability or 1)
+        self.market = Market(random.Random(args.seed))
+        self.log = Log(args.log)
+        self.context = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+        self.context.minimum_version = ssl.TLSVersion.TLSv1_2
+        self.context.load_cert_chain(os.path.join(args.certs, "server_chain.pem"),
+                                     os.path.join(args.certs, "server_key.pem"))
+        self.listener = socket.create_server((args.bind, args.port), reuse_port=False)
+        self.log.line("serving https://localhost:%d, profile %s, faults %s, seed %d"
+                      % (args.port, args.profile, self.faults or "none", args.seed))
+
+    def run(self):
+        number = 0
+        while True:
+            sock, peer = self.listener.accept()
+            number += 1
+            Connection(self, sock, peer[:2], number).start()
+
+
+################################################################################
+# Certificates
+################################################################################
+
+
+def openssl(*args):
+    subprocess.run(["openssl"] + list(args), check=True, stdout=subprocess.DEVNULL, stderr=subprocess.PIPE)
+
+
+def make_certs(directory, port):
+    """Root, intermediate and localhost leaf, and the client's server_config.h."""
+    os.makedirs(directory, exist_ok=True)
+    path = lambda name: os.path.join(directory, name)
+
+    with open(path("ca.ext"), "w") as ext:
+        ext.write("basicConstraints=critical,CA:TRUE\nkeyUsage=critical,keyCertSign,cRLSign\n"
+                  "subjectKeyIdentifier=hash\nauthorityKeyIdentifier=keyid\n")
+    with open(path("leaf.ext"), "w") as ext:
+        ext.write("basicConstraints=critical,CA:FALSE\nkeyUsage=critical,digitalSignature,keyEncipherment\n"
+                  "extendedKeyUsage=serverAuth\nsubjectAltName=DNS:localhost\n"
+                  "subjectKeyIdentifier=hash\nauthorityKeyIdentifier=keyid\n")
+
+    openssl("req", "-x509", "-newkey", "rsa:2048", "-nodes", "-sha256", "-days", "3650", "-subj",
+            "/C=US/O=Standin/CN=Standin Root CA 1", "-keyout", path("root_key.pem"), "-out", path("root.pem"),
+            "-addext", "basicConstraints=critical,CA:TRUE", "-addext", "keyUsage=critical,keyCertSign,cRLSign")
+    openssl("req", "-newkey", "rsa:2048", "-nodes", "-sha256", "-subj", "/C=US/O=Standin/CN=Standin RSA 2048 M01",
+            "-keyout", path("intermediate_key.pem"), "-out", path("intermediate.csr"))
+    openssl("x509", "-req", "-sha256", "-days", "3650", "-in", path("intermediate.csr"), "-CA", path("root.pem"),
+            "-CAkey", path("root_key.pem"), "-CAcreateserial", "-extfile", path("ca.ext"), "-out",
+            path("intermediate.pem"))
+    openssl("req", "-newkey", "rsa:2048", "-nodes", "-sha256", "-subj", "/CN=localhost", "-keyout",
+            path("server_key.pem"), "-out", path("server.csr"))
+    openssl("x509", "-req", "-sha256", "-days", "825", "-in", path("server.csr"), "-CA", path("intermediate.pem"),
+            "-CAkey", path("intermediate_key.pem"), "-CAcreateserial", "-extfile", path("leaf.ext"), "-out",
+            path("server.pem"))
+
+    with open(path("server_chain.pem"), "w") as chain:
+        for name in ("server.pem", "intermediate.pem"):
+            with open(path(name)) as pem:
+                chain.write(pem.read())
+
+    with open(path("root.pem")) as pem:
+        root = [line.rstrip("\n") for line in pem if line.strip()]
+    width = max(len(line) for line in root) + 6
+    rows = ['\t"%s\\n"' % line for line in root]
+    rows = [row.ljust(width) + " \\" for row in rows[:-1]] + [rows[-1]]
+    with open(path("server_config.h"), "w") as header:
+        header.write("/* Generated by standin_server.py --make-certs, points the client at the stand-in */\n\n")
+        header.write('#define SERVERHOSTNAME "localhost"\n#define SERVERPORT     (%d)\n\n' % port)
+        header.write("#define SSL_ROOTCA_PEM".ljust(width) + " \\\n" + "\n".join(rows) + "\n")
+
+    print("certificates and server_config.h written to %s" % directory, file=sys.stderr)
+
+
+def main():
+    here = os.path.dirname(os.path.abspath(__file__))
+    parser = argparse.ArgumentParser(description="Local HTTPS stand-in for financialmodelingprep.com")
+    parser.add_argument("--port", type=int, default=8443)
+    parser.add_argument("--bind", default="127.0.0.1")
+    parser.add_argument("--certs", default=os.path.join(here, "build"), help="certificate directory")
+    parser.add_argument("--make-certs", action="store_true", help="write the certificates and server_config.h, then exit")
+    parser.add_argument("--profile", default="clean", choices=sorted(PROFILES))
+    parser.add_argument("--fault", action="append", metavar="NAME[=P]", help="add or override a fault's probability")
+    parser.add_argument("--seed", type=int, default=1)
+    parser.add_argument("--log", help="also append the log to this file")
+    args = parser.parse_args()
+
+    if args.make_certs:
+        make_certs(args.certs, args.port)
+        return
+
+    server = Server(args)
+    signal.signal(signal.SIGTERM, lambda *_: sys.exit(0))
+    try:
+        server.run()
+    except (KeyboardInterrupt, SystemExit):
+        pass
+    finally:
+        server.log.summary()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,341 @@
+/******************************************************************************
+* File Name:   http_body.c
+*
+* Description: This file contains the HTTP/1.1 response framer. Lines (the
+* status line, headers, chunk sizes and trailers) are collected one byte at a
+* time into a short buffer, so a response can be fed in whatever pieces it
+* is received in. Body bytes are passed on in place, never copied.
+*
+*******************************************************************************/
+
+/* Standard C header file. */
+#include <string.h>
+#include <strings.h>
+
+#include "http_body.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+// Largest chunk or body accepted, keeps the size arithmetic from overflowing
+#define HTTP_BODY_MAX_LENGTH (UINT64_C(1) << 48)
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+static void http_body_line(http_body_t *body);
+static void http_body_status_line(http_body_t *body);
+static void http_body_header_line(http_body_t *body);
+static void http_body_headers_done(http_body_t *body);
+static void http_body_chunk_size_line(http_body_t *body);
+static void http_body_pass(http_body_t *body, const uint8_t *data, size_t len);
+static const char *http_body_header_value(const http_body_t *body, const char *name);
+
+/*******************************************************************************
+ * Function Name: http_body_init
+ *******************************************************************************
+ * Summary:
+ *  Prepares the framer for a new response, whose body goes to sink.
+ *
+ *******************************************************************************/
+void http_body_init(http_body_t *body, http_body_sink_t sink, void *arg) {
+	(void)memset(body, 0, sizeof(*body));
+	body->state = HTTP_BODY_STATUS;
+	body->sink = sink;
+	body->sink_arg = arg;
+}
+
+/*******************************************************************************
+ * Function Name: http_body_feed
+ *******************************************************************************
+ * Summary:
+ *  Consumes the next piece of the response. Pieces may split lines anywhere.
+ *
+ *******************************************************************************/
+void http_body_feed(http_body_t *body, const uint8_t *data, size_t len) {
+	size_t i = 0;
+
+	while(i < len) {
+		switch(body->state) {
+			case HTTP_BODY_LENGTH:
+			case HTTP_BODY_CHUNK_DATA: {
+				size_t n = ((uint64_t)(len - i) < body->remaining) ? len - i : (size_t)body->remaining;
+
+				http_body_pass(body, &data[i], n);
+				i += n;
+				body->remaining -= n;
+				if(body->remaining == 0) {
+					body->state = (body->state == HTTP_BODY_LENGTH) ? HTTP_BODY_DONE : HTTP_BODY_CHUNK_END;
+				}
+				break;
+			}
+
+			case HTTP_BODY_UNTIL_CLOSE:
+				http_body_pass(body, &data[i], len - i);
+				i = len;
+				break;
+
+			case HTTP_BODY_DONE:
+			case HTTP_BODY_UNSUPPORTED:
+			case HTTP_BODY_ERROR:
+				return;
+
+			default:
+				if(data[i] == '\n') {
+					http_body_line(body);
+					body->line_len = 0;
+					body->line_overflow = false;
+				} else if(body->line_len < HTTP_BODY_LINE_LEN - 1) {
+					body->line[body->line_len++] = (char)data[i];
+				} else {
+					body->line_overflow = true;
+				}
+				i++;
+				break;
+		}
+	}
+}
+
+/*******************************************************************************
+ * Function Name: http_body_done
+ *******************************************************************************
+ * Summary:
+ *  Whether the sink has been given the whole body. A body that ends with the
+ *  connection counts as whole once the caller has seen the close.
+ *
+ *******************************************************************************/
+bool http_body_done(const http_body_t *body) {
+	return body->state == HTTP_BODY_DONE || body->state == HTTP_BODY_UNTIL_CLOSE;
+}
+
+/*******************************************************************************
+ * Function Name: http_body_line
+ *******************************************************************************
+ * Summary:
+ *  Handles a complete line, without its CRLF.
+ *
+ *******************************************************************************/
+static void http_body_line(http_body_t *body) {
+	if(body->line_len > 0 && body->line[body->line_len - 1] == '\r') {
+		body->line_len--;
+	}
+	body->line[body->line_len] = '\0';
+
+	switch(body->state) {
+		case HTTP_BODY_STATUS:
+			http_body_status_line(body);
+			break;
+
+		case HTTP_BODY_HEADERS:
+			if(body->line_len == 0 && !body->line_overflow) {
+				http_body_headers_done(body);
+			} else {
+				http_body_header_line(body);
+			}
+			break;
+
+		case HTTP_BODY_CHUNK_SIZE:
+			http_body_chunk_size_line(body);
+			break;
+
+		case HTTP_BODY_CHUNK_END:
+			body->state = (body->line_len == 0) ? HTTP_BODY_CHUNK_SIZE : HTTP_BODY_ERROR;
+			break;
+
+		case HTTP_BODY_TRAILERS:
+			// Trailer fields are not needed, only the blank line ending them
+			if(body->line_len == 0 && !body->line_overflow) {
+				body->state = HTTP_BODY_DONE;
+			}
+			break;
+
+		default:
+			break;
+	}
+}
+
+/*******************************************************************************
+ * Function Name: http_body_status_line
+ *******************************************************************************
+ * Summary:
+ *  Reads the status code and starts on the headers.
+ *
+ *******************************************************************************/
+static void http_body_status_line(http_body_t *body) {
+	const char *code = &body->line[sizeof("HTTP/1.1 ") - 1];
+
+	if(strncmp(body->line, "HTTP/1.", sizeof("HTTP/1.") - 1) != 0 || body->line_len < sizeof("HTTP/1.1 200") - 1) {
+		body->state = HTTP_BODY_ERROR;
+		return;
+	}
+
+	body->status = 0;
+	for(int i = 0; i < 3; i++) {
+		if(code[i] < '0' || code[i] > '9') {
+			body->state = HTTP_BODY_ERROR;
+			return;
+		}
+		body->status = (uint16_t)(body->status * 10 + (code[i] - '0'));
+	}
+
+	body->chunked = false;
+	body->other_coding = false;
+	body->has_length = false;
+	body->state = HTTP_BODY_HEADERS;
+}
+
+/*******************************************************************************
+ * Function Name: http_body_header_line
+ *******************************************************************************
+ * Summary:
+ *  Picks the body length or transfer coding out of a header line. A
+ *  Transfer-Encoding line too long to read in full is taken as a coding the
+ *  framer does not undo.
+ *
+ *******************************************************************************/
+static void http_body_header_line(http_body_t *body) {
+	const char *value;
+
+	value = http_body_header_value(body, "Content-Length");
+	if(value != NULL) {
+		uint64_t length = 0;
+
+		if(*value == '\0' || body->line_overflow) {
+			body->state = HTTP_BODY_ERROR;
+			return;
+		}
+		for(; *value >= '0' && *value <= '9' && length < HTTP_BODY_MAX_LENGTH; value++) {
+			length = length * 10 + (uint64_t)(*value - '0');
+		}
+		while(*value == ' ' || *value == '\t') {
+			value++;
+		}
+		if(*value != '\0' || length >= HTTP_BODY_MAX_LENGTH || (body->has_length && length != body->remaining)) {
+			body->state = HTTP_BODY_ERROR;
+			return;
+		}
+		body->has_length = true;
+		body->remaining = length;
+		return;
+	}
+
+	value = http_body_header_value(body, "Transfer-Encoding");
+	if(value != NULL) {
+		if(body->line_overflow) {
+			body->other_coding = true;
+			return;
+		}
+
+		// A list of codings applied in order, only "chunked" alone is undone here
+		while(*value != '\0') {
+			size_t len = strcspn(value, ", \t");
+
+			if(len > 0) {
+				if(len == sizeof("chunked") - 1 && strncasecmp(value, "chunked", len) == 0) {
+					body->chunked = true;
+				} else {
+					body->other_coding = true;
+				}
+			}
+			value += len;
+			value += strspn(value, ", \t");
+		}
+	}
+}
+
+/*******************************************************************************
+ * Function Name: http_body_headers_done
+ *******************************************************************************
+ * Summary:
+ *  Works out how the body is framed from the headers just read. An interim
+ *  1xx response is followed by the real one.
+ *
+ *******************************************************************************/
+static void http_body_headers_done(http_body_t *body) {
+	if(body->status >= 100 && body->status < 200) {
+		body->state = HTTP_BODY_STATUS;
+	} else if(body->status == 204 || body->status == 304) {
+		body->state = HTTP_BODY_DONE;
+	} else if(body->other_coding) {
+		body->state = HTTP_BODY_UNSUPPORTED;
+	} else if(body->chunked) {
+		body->state = HTTP_BODY_CHUNK_SIZE;
+	} else if(body->has_length) {
+		body->state = (body->remaining > 0) ? HTTP_BODY_LENGTH : HTTP_BODY_DONE;
+	} else {
+		body->state = HTTP_BODY_UNTIL_CLOSE;
+	}
+}
+
+/*******************************************************************************
+ * Function Name: http_body_chunk_size_line
+ *******************************************************************************
+ * Summary:
+ *  Reads the hex size of the next chunk, ignoring any chunk extensions. The
+ *  last chunk, of size 0, is followed by the trailers.
+ *
+ *******************************************************************************/
+static void http_body_chunk_size_line(http_body_t *body) {
+	uint64_t size = 0;
+	uint8_t i = 0;
+
+	for(; i < body->line_len && size < HTTP_BODY_MAX_LENGTH; i++) {
+		char c = body->line[i];
+
+		if(c >= '0' && c <= '9') {
+			size = size * 16 + (uint64_t)(c - '0');
+		} else if((c | 0x20) >= 'a' && (c | 0x20) <= 'f') {
+			size = size * 16 + (uint64_t)((c | 0x20) - 'a' + 10);
+		} else {
+			break;
+		}
+	}
+
+	if(i == 0 || size >= HTTP_BODY_MAX_LENGTH || (i < body->line_len && body->line[i] != ';' && body->line[i] != ' ' && body->line[i] != '\t')) {
+		body->state = HTTP_BODY_ERROR;
+		return;
+	}
+
+	body->remaining = size;
+	body->state = (size > 0) ? HTTP_BODY_CHUNK_DATA : HTTP_BODY_TRAILERS;
+}
+
+/*******************************************************************************
+ * Function Name: http_body_pass
+ *******************************************************************************
+ * Summary:
+ *  Hands body bytes to the sink.
+ *
+ *******************************************************************************/
+static void http_body_pass(http_body_t *body, const uint8_t *data, size_t len) {
+	if(len > 0 && body->sink != NULL) {
+		body->sink(body->sink_arg, data, len, body->offset);
+	}
+	body->offset += len;
+}
+
+/*******************************************************************************
+ * Function Name: http_body_header_value
+ *******************************************************************************
+ * Summary:
+ *  The value of the header line if it is the named field, which is matched
+ *  without regard to case, with the whitespace before it skipped.
+ *
+ * Return:
+ *  const char * : the value, NULL if the line is another field
+ *
+ *******************************************************************************/
+static const char *http_body_header_value(const http_body_t *body, const char *name) {
+	size_t len = strlen(name);
+	const char *value;
+
+	if(body->line_len <= len || body->line[len] != ':' || strncasecmp(body->line, name, len) != 0) {
+		return NULL;
+	}
+
+	value = &body->line[len + 1];
+	while(*value == ' ' || *value == '\t') {
+		value++;
+	}
+	return value;
+}
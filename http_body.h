@@ -0,0 +1,73 @@
+/******************************************************************************
+* File Name:   http_body.h
+*
+* Description: This file contains declarations for the HTTP/1.1 response
+* framer. It reads the status line and headers of a response as they are
+* received, then hands only the body bytes on to a sink: up to
+* Content-Length, de-chunked for Transfer-Encoding: chunked, or up to the
+* close when there is neither. Bytes after the end of the message never
+* reach the sink.
+*
+*******************************************************************************/
+
+#ifndef HTTP_BODY_H_
+#define HTTP_BODY_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Longest header or chunk size line kept, the framer only reads short ones */
+#define HTTP_BODY_LINE_LEN (48)
+
+/* Room for the status line and headers of a response in the receive buffer */
+#define HTTP_BODY_HEADER_BYTES (1024)
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+typedef enum {
+	HTTP_BODY_STATUS,          // Reading the status line
+	HTTP_BODY_HEADERS,
+	HTTP_BODY_LENGTH,          // Content-Length bytes left
+	HTTP_BODY_UNTIL_CLOSE,     // Neither length nor chunked, the body ends with the connection
+	HTTP_BODY_CHUNK_SIZE,
+	HTTP_BODY_CHUNK_DATA,
+	HTTP_BODY_CHUNK_END,       // CRLF after a chunk's data
+	HTTP_BODY_TRAILERS,
+	HTTP_BODY_DONE,
+	HTTP_BODY_UNSUPPORTED,     // A transfer coding other than chunked, the body is not passed on
+	HTTP_BODY_ERROR            // Framing the response failed, the body is not passed on
+} http_body_state_t;
+
+/* Takes the response body in the pieces it is received in. offset is where
+ * data sits in the body, 0 on the first piece of a new body.
+ */
+typedef void (*http_body_sink_t)(void *arg, const uint8_t *data, size_t len, size_t offset);
+
+typedef struct {
+	http_body_state_t state;
+	http_body_sink_t sink;
+	void *sink_arg;
+	uint16_t status;
+	bool chunked;
+	bool other_coding;         // Transfer-Encoding names a coding the framer does not undo
+	bool has_length;
+	uint64_t remaining;        // Bytes left of the body or the current chunk
+	size_t offset;             // Body bytes passed to the sink so far
+	char line[HTTP_BODY_LINE_LEN];
+	uint8_t line_len;
+	bool line_overflow;
+} http_body_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+void http_body_init(http_body_t *body, http_body_sink_t sink, void *arg);
+void http_body_feed(http_body_t *body, const uint8_t *data, size_t len);
+bool http_body_done(const http_body_t *body);
+
+#endif /* HTTP_BODY_H_ */
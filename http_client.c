@@ -40,10 +40,6 @@
 #include "cyhal.h"
 #include "cybsp.h"
 #include "cy_retarget_io.h"
-#include "cJSON.h"
-#include "GUI.h"
-#include "mtb_st7789v.h"
-#include "cy8ckit_028_tft_pins.h"
 #include <time.h>
 
 /* FreeRTOS header file. */
@@ -57,9 +53,8 @@
 /* Cypress secure socket header file. */
 #include "cy_secure_sockets.h"
 
-/* Wi-Fi connection manager header files. */
-#include "cy_wcm.h"
-#include "cy_wcm_error.h"
+/* Wi-Fi station bring-up. */
+#include "wifi.h"
 
 /* TCP client task header file. */
 #include "http_client.h"
@@ -67,40 +62,89 @@
 /* HTTP Client Library*/
 #include "cy_http_client_api.h"
 
+/* Keep-alive connection manager */
+#include "http_connection.h"
+
+/* TLS session resumption */
+#include "tls_session_cache.h"
+
+/* Quote request builder */
+#include "quote.h"
+
+/* Hand-off to the decode and display tasks */
+#include "pipeline.h"
+
+/* Market-hours-aware poll scheduling */
+#include "poll_scheduler.h"
+
+/* Quota-aware API key selection */
+#include "api_key_pool.h"
+
+/* Heap and pool telemetry */
+#include "mem_pool.h"
+
+/* Leveled logging */
+#include "log_ring.h"
+
+/* Quote age tracing */
+#include "freshness.h"
+
+/* Response capture and replay */
+#include "capture.h"
+
 /*******************************************************************************
 * Macros
 ********************************************************************************/
-#define BUFFERSIZE         (2048 * 2)
-#define SENDRECEIVETIMEOUT (10000)
-
-// Macros for GUI
-#define TFT_LEFT_ALIGNED (0)
-#define TFT_PRICE        (88)
-#define TFT_PERCENT      (210)
-#define TFT_ROW_ONE      (0)
-#define TFT_ROW_TWO      (30)
-#define TFT_ROW_THREE    (50)
-#define TFT_ROW_FOUR     (70)
-#define TFT_ROW_FIVE     (90)
+#define RESOURCEPATHSIZE (256)
+
+/* The HTTP client assembles the whole response in the request buffer even
+ * though the body is parsed as it arrives, so the buffer holds the headers and
+ * a quote object per watched symbol: 3328 B for three, instead of a flat 4 KB
+ * that could not take a full table of eight. */
+#define BUFFERSIZE (HTTP_BODY_HEADER_BYTES + WATCHLIST_LEN * QUOTE_JSON_BYTES)
+
+/* Pause between passes over a replayed recording */
+#define REPLAY_PASS_PAUSE_MS (5000)
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+typedef enum {
+	KEY_STATUS_OK,
+	KEY_STATUS_RATE_LIMITED,    // 429, too many calls this minute
+	KEY_STATUS_REJECTED         // Auth failure or the daily quota is spent
+} key_status_t;
 
 /*******************************************************************************
 * Function Prototypes
 ********************************************************************************/
-cy_rslt_t connect_to_wifi_ap(void);
-void disconnect_callback(void *arg);
+static time_t update_clock(http_connection_t *conn, cy_http_client_response_t *response);
+static void set_clock(time_t wall_time);
+static uint32_t wait_for_next_fetch(TickType_t *lastWake, uint32_t retry_ms);
+static key_status_t key_status(uint16_t status, const uint8_t *body, uint32_t body_len);
+static uint32_t retry_after_ms(http_connection_t *conn, cy_http_client_response_t *response, time_t server_time);
+static void replay_capture(void);
 
 /*******************************************************************************
 * Global Variables
 ********************************************************************************/
-volatile bool connected = false;
-uint32_t apiKeySelect = 0;
+static const char *const apiKeys[] = {API_KEYS};
+static api_key_pool_t apiKeyPool;
+
+static const char *const watchlist[] = {WATCHLIST_SYMBOLS};
+#define WATCHLIST_LEN (sizeof(watchlist) / sizeof(watchlist[0]))
+_Static_assert(WATCHLIST_LEN <= QUOTE_TABLE_CAPACITY, "WATCHLIST_SYMBOLS lists more symbols than a quote table holds");
+
+// Wall clock, taken from the server's Date header (the board has no time source of its own)
+static time_t clockTime = 0;
+static TickType_t clockTick = 0;
 
 /*******************************************************************************
  * Function Name: http_client_task
  *******************************************************************************
  * Summary:
  *  Task used to establish a secure connection to a remote TCP server, request
- *  data from the server, then print the data to the tft dispaly.
+ *  data from the server, then pass the response on to the decode task.
  *
  * Parameters:
  *  void *args : Task parameter defined during task creation (unused).
@@ -112,29 +156,14 @@ uint32_t apiKeySelect = 0;
 void http_client_task(void *arg) {
 	cy_rslt_t result;
 
-	/* The pins above are defined by the CY8CKIT-028-TFT library. If the display is being used on different hardware the mappings will be different. */
-	const mtb_st7789v_pins_t tft_pins = {.db08 = CY8CKIT_028_TFT_PIN_DISPLAY_DB8,
-										 .db09 = CY8CKIT_028_TFT_PIN_DISPLAY_DB9,
-										 .db10 = CY8CKIT_028_TFT_PIN_DISPLAY_DB10,
-										 .db11 = CY8CKIT_028_TFT_PIN_DISPLAY_DB11,
-										 .db12 = CY8CKIT_028_TFT_PIN_DISPLAY_DB12,
-										 .db13 = CY8CKIT_028_TFT_PIN_DISPLAY_DB13,
-										 .db14 = CY8CKIT_028_TFT_PIN_DISPLAY_DB14,
-										 .db15 = CY8CKIT_028_TFT_PIN_DISPLAY_DB15,
-										 .nrd = CY8CKIT_028_TFT_PIN_DISPLAY_NRD,
-										 .nwr = CY8CKIT_028_TFT_PIN_DISPLAY_NWR,
-										 .dc = CY8CKIT_028_TFT_PIN_DISPLAY_DC,
-										 .rst = CY8CKIT_028_TFT_PIN_DISPLAY_RST};
-
-	/* Initialize the display */
-	mtb_st7789v_init8(&tft_pins);
-	GUI_Init();
-	GUI_SetBkColor(GUI_BLACK);          // Background Color
-	GUI_SetColor(GUI_WHITE);            // Text Color
-	GUI_SetFont(&GUI_Font32B_ASCII);    // Font Size
+	// Record every response, or feed a recording to the pipeline without touching the network
+	capture_init();
+	if(CAPTURE_MODE == CAPTURE_REPLAY) {
+		replay_capture();
+	}
 
 	// Connect to wifi - configuration settings are in http_client.h
-	result = connect_to_wifi_ap();
+	result = wifi_connect();
 	CY_ASSERT(result == CY_RSLT_SUCCESS);
 
 	// Initialize http client lib
@@ -162,249 +191,370 @@ void http_client_task(void *arg) {
 	credentials.client_cert_size = sizeof(SSL_CLIENTCERT_PEM);
 	credentials.private_key = SSL_CLIENTKEY_PEM;
 	credentials.private_key_size = sizeof(SSL_CLIENTKEY_PEM);
+	credentials.sni_host_name = SERVERHOSTNAME;    // Also keys the TLS session cache
+	credentials.sni_host_name_size = strlen(SERVERHOSTNAME);
 
-	// Disconnection Callback
-	cy_http_disconnect_callback_t disconnectCallback = (void *)disconnect_callback;
+	// Resume the last TLS session with the server instead of a full handshake on every reconnect
+	tls_session_cache_init(SERVERHOSTNAME);
 
-	// Client Handle
-	cy_http_client_t clientHandle;
+	// Keep-alive connection to the server, connects lazily on the first request
+	static http_connection_t connection;
 
 	// Create the HTTP Client
-	result = cy_http_client_create(&credentials, &serverInfo, disconnectCallback, NULL, &clientHandle);
+	result = http_connection_init(&connection, &credentials, &serverInfo);
 	if(result != CY_RSLT_SUCCESS) {
 		printf("HTTP Client Creation Failed!\n");
 		CY_ASSERT(0);
 	}
 
+	// Quotes are parsed while the body arrives, straight out of the receive buffer
+	http_connection_set_body_sink(&connection, pipeline_body_sink, NULL);
+
 	// For time.h
 	setenv("TZ", "EST5EDT", 1);
 
+	// Key table with per-key budgets, restores today's usage from flash
+	api_key_pool_init(&apiKeyPool, apiKeys, sizeof(apiKeys) / sizeof(apiKeys[0]));
+
+	// Fetch deadlines are absolute, so the time spent fetching and drawing does not add up as drift
+	TickType_t lastWake = xTaskGetTickCount();
+
 	// Main program loop
 	while(1) {
-		if(!connected) {
-			// Connect to the HTTP Server
-			result = cy_http_client_connect(clientHandle, SENDRECEIVETIMEOUT, SENDRECEIVETIMEOUT);
-			if(result != CY_RSLT_SUCCESS) {
-				printf("HTTP Client Connection Failed!\nResult: %lx\n", result);
-			} else {
-				printf("\nConnected to HTTP Server Successfully\n\n");
-				connected = true;
-			}
+		// Backing off after a failure, do not spend a key on a request that would not be sent
+		uint32_t retryMs = http_connection_retry_delay_ms(&connection);
+		if(retryMs > 0) {
+			LOG_WARN("Connection %s, retrying in %lu ms", http_connection_state_name(connection.state), (unsigned long)retryMs);
+			vTaskDelay(pdMS_TO_TICKS(retryMs));
+			lastWake = xTaskGetTickCount();
+			continue;
 		}
 
-		// Create and send get request, parse and display data
-		if(connected) {
-			printf("Creating request. Connection state: %d\n", connected);
-
-			// Create Request
-			uint8_t buffer[BUFFERSIZE];
-			cy_http_client_request_header_t request;
-			request.buffer = buffer;
-			request.buffer_len = BUFFERSIZE;
-			request.method = CY_HTTP_CLIENT_METHOD_GET;
-			request.range_start = -1;
-			request.range_end = -1;
-			switch(apiKeySelect) {
-				case 0:
-					request.resource_path = AMDSTOCKQUOTERESOURCE_0;
-					printf("Key 0\n");
-					break;
-				case 1:
-					request.resource_path = AMDSTOCKQUOTERESOURCE_1;
-					printf("Key 1\n");
-					break;
-				case 2:
-					request.resource_path = AMDSTOCKQUOTERESOURCE_2;
-					printf("Key 2\n");
-					break;
-				default:
-					apiKeySelect = 0;
-					request.resource_path = AMDSTOCKQUOTERESOURCE_0;
-					printf("DEFAULT\n");
-					break;
-			}
-
-			// Create Header
-			cy_http_client_header_t header;
-			header.field = "Host";
-			header.field_len = strlen("Host");
-			header.value = SERVERHOSTNAME;
-			header.value_len = strlen(SERVERHOSTNAME);
-			uint32_t num_header = 1;
-
-			result = cy_http_client_write_header(clientHandle, &request, &header, num_header);
-			if(result != CY_RSLT_SUCCESS) {
-				printf("HTTP Client Header Write Failed!\n");
-				CY_ASSERT(0);
-			}
-
-			// Var to hold the servers responses
-			cy_http_client_response_t response;
+		// Create and send get request
+		LOG_DEBUG("Creating request. Connection state: %s", http_connection_state_name(connection.state));
+
+		// Create Request
+		uint8_t buffer[BUFFERSIZE];
+		cy_http_client_request_header_t request;
+		request.buffer = buffer;
+		request.buffer_len = BUFFERSIZE;
+		request.method = CY_HTTP_CLIENT_METHOD_GET;
+		request.range_start = -1;
+		request.range_end = -1;
+		// Pick the key with the most budget left before spending a round trip on it
+		time_t wallNow = (clockTime == 0) ? 0 : clockTime + (time_t)((xTaskGetTickCount() - clockTick) / configTICK_RATE_HZ);
+		int apiKey = api_key_pool_acquire(&apiKeyPool, pdTICKS_TO_MS(xTaskGetTickCount()), wallNow);
+		if(apiKey < 0) {
+			LOG_WARN("All API keys are out of budget");
+			(void)wait_for_next_fetch(&lastWake, 0);
+			continue;
+		}
 
-			printf("Sending HTTP Request\n");
-			result = cy_http_client_send(clientHandle, &request, NULL, 0, &response);
-			if(result != CY_RSLT_SUCCESS) {
-				printf("HTTP Client Send Failed!\n");
+		// One comma-joined request refreshes the whole watchlist
+		static char resourcePath[RESOURCEPATHSIZE];
+		if(quote_build_resource(resourcePath, sizeof(resourcePath), watchlist, WATCHLIST_LEN, apiKeyPool.keys[apiKey].key) == 0) {
+			printf("Watchlist too long for the resource path!\n");
+			CY_ASSERT(0);
+		}
+		request.resource_path = resourcePath;
+
+		// Create Header
+		cy_http_client_header_t header;
+		header.field = "Host";
+		header.field_len = strlen("Host");
+		header.value = SERVERHOSTNAME;
+		header.value_len = strlen(SERVERHOSTNAME);
+		uint32_t num_header = 1;
+
+		// Var to hold the servers responses
+		cy_http_client_response_t response;
+
+		// Send over the kept-alive session, reconnecting only if the server closed it
+		LOG_DEBUG("Sending HTTP Request");
+		freshness_fetch_start();
+		result = http_connection_get(&connection, &request, &header, num_header, &response);
+		http_connection_print_stats(&connection);
+		tls_session_cache_print_histogram();
+		mem_pool_print_stats();
+		if(result != CY_RSLT_SUCCESS) {
+			LOG_ERROR("HTTP Request Failed!");
+			pipeline_discard_body();
+		} else {
+			time_t serverTime = update_clock(&connection, &response);
+			if(CAPTURE_MODE == CAPTURE_RECORD) {
+				capture_write(&response, serverTime);
 			}
 
 			// Print response message
-			printf("Response received:\n");
-			for(int i = 1; i < response.body_len - 2; i++) {
-				printf("%c", response.body[i]);
-			}
-			printf("\n\n");
-
-			// Parse the JSON received
-			cJSON *root = cJSON_ParseWithLength((const char *)response.body + 1, response.body_len - 2);    // Read the JSON
-			cJSON *symbol = cJSON_GetObjectItem(root, "symbol");                                            // Ticker
-			cJSON *price = cJSON_GetObjectItem(root, "price");                                              // Current Price
-			cJSON *change = cJSON_GetObjectItem(root, "changesPercentage");                                 // % change over the day
-			cJSON *dayLow = cJSON_GetObjectItem(root, "dayLow");                                            // Todays low
-			cJSON *dayHigh = cJSON_GetObjectItem(root, "dayHigh");                                          // Todays high
-			cJSON *open = cJSON_GetObjectItem(root, "open");                                                // Todays open price
-			cJSON *previousClose = cJSON_GetObjectItem(root, "previousClose");                              // Previous closing price
-			cJSON *timestamp = cJSON_GetObjectItem(root, "timestamp");                                      // Unix time stamp
-
-			// Disconnect from server
-			result = cy_http_client_disconnect(clientHandle);
-			if(result != CY_RSLT_SUCCESS) {
-				printf("HTTP Client Disconnect Failed!\n");
-			} else {
-				printf("Disconnected from HTTP Server\n");
-				connected = false;
+			LOG_DEBUG("Response received: status %u, %lu B", response.status_code, (unsigned long)response.body_len);
+
+			// Quota and auth errors are the key's fault, move on to the next key right away
+			key_status_t keyStatus = key_status(response.status_code, response.body, response.body_len);
+			if(keyStatus == KEY_STATUS_RATE_LIMITED) {
+				// A per-minute limit, the key is rested rather than written off for the day
+				uint32_t restMs = retry_after_ms(&connection, &response, serverTime);
+				pipeline_discard_body();
+				api_key_pool_throttle(&apiKeyPool, apiKey, pdTICKS_TO_MS(xTaskGetTickCount()), restMs);
+				LOG_WARN("Key %d rate limited, resting it %lu s", apiKey, (unsigned long)(restMs / 1000));
+				continue;    // Jump to next iteration of loop
 			}
-
-			// Check if website actually gave us data
-			if((int)cJSON_IsString(symbol) == 0) {
-				apiKeySelect = (apiKeySelect + 1) % NUM_API_KEYS;
-				printf("Request failed. New key select: %ld\n", apiKeySelect);
+			if(keyStatus == KEY_STATUS_REJECTED) {
+				pipeline_discard_body();
+				api_key_pool_reject(&apiKeyPool, apiKey);
+				api_key_pool_print(&apiKeyPool);
+				LOG_WARN("Request failed with key %d, %lu calls left today", apiKey, (unsigned long)api_key_pool_remaining_today(&apiKeyPool));
 				continue;    // Jump to next iteration of loop
 			}
 
-			printf("Drawing Info.\n");
-			// Display the stock info
-			GUI_Clear();    // Clear the display
-			char symbol_s[25];
-			GUI_SetFont(&GUI_Font32B_ASCII);    // Font Size
-			sprintf(symbol_s, "%s", symbol->valuestring);
-			GUI_DispStringAt(symbol_s, TFT_LEFT_ALIGNED, TFT_ROW_ONE);
-
-			char price_s[25];
-			sprintf(price_s, "$%.2f", price->valuedouble);
-			GUI_DispStringAt(price_s, TFT_PRICE, TFT_ROW_ONE);
-
-			char change_s[25];
-			if(change->valuedouble >= 0) {
-				GUI_SetColor(GUI_GREEN);    // Text Color
-				sprintf(change_s, "+%.2f%%\n", change->valuedouble);
-			} else {
-				GUI_SetColor(GUI_RED);    // Text Color
-				sprintf(change_s, "%.2f%%\n", change->valuedouble);
+			// The body was parsed while it arrived, indicators and drawing happen in their own tasks
+			switch(pipeline_submit_body()) {
+				case PIPELINE_BODY_EMPTY:
+					http_connection_report_failure(&connection, HTTP_FAILURE_PAYLOAD);
+					break;
+				case PIPELINE_BODY_BUSY:
+					LOG_WARN("Decoder busy, response dropped");
+					break;
+				default:
+					break;
 			}
-			GUI_DispStringAt(change_s, TFT_PERCENT, TFT_ROW_ONE);
-			GUI_SetColor(GUI_WHITE);    // Text Color
-
-			char open_close[25];
-			GUI_SetFont(&GUI_Font24B_ASCII);    // Font Size
-			sprintf(open_close, "$%.2f / $%.2f", previousClose->valuedouble, open->valuedouble);
-			GUI_DispStringAt("PC/O", TFT_LEFT_ALIGNED, TFT_ROW_TWO);
-			GUI_DispStringAt(open_close, TFT_PRICE, TFT_ROW_TWO);
+		}    // if(result == CY_RSLT_SUCCESS)
 
-			char day_low_high[25];
-			sprintf(day_low_high, "$%.2f / $%.2f", dayLow->valuedouble, dayHigh->valuedouble);
-			GUI_DispStringAt("DL/DH", TFT_LEFT_ALIGNED, TFT_ROW_THREE);
-			GUI_DispStringAt(day_low_high, TFT_PRICE, TFT_ROW_THREE);
-
-			time_t updateTime = (time_t)timestamp->valueint;
-			GUI_SetFont(&GUI_Font20B_ASCII);    // Font Size
-			GUI_DispStringAt(ctime(&updateTime), TFT_LEFT_ALIGNED, TFT_ROW_FIVE);
-
-			printf("Deleting stuff.\n");
-			// Delete CJSON objects
-			cJSON_Delete(root);
-
-			printf("Deleted stuff.\n");
-		}    // if(connected)
+		// Wait until the next fetch the trading calendar calls for, or the retry after a failure
+		// The decode task cuts the wait short with an alert refresh
+		(void)wait_for_next_fetch(&lastWake, http_connection_retry_delay_ms(&connection));
+	}
+}
 
-		printf("Waiting 2 mins.\n");
-		// Wait 2 mins before re-connecting and querying again
-		vTaskDelay(pdMS_TO_TICKS(120000));
+/*******************************************************************************
+ * Function Name: update_clock
+ *******************************************************************************
+ * Summary:
+ *  Syncs the wall clock to the Date header of a response.
+ *
+ * Return:
+ *  time_t : the server's time, 0 if the response had no usable Date header
+ *
+ *******************************************************************************/
+static time_t update_clock(http_connection_t *conn, cy_http_client_response_t *response) {
+	cy_http_client_header_t header;
+	time_t serverTime;
+
+	header.field = "Date";
+	header.field_len = strlen("Date");
+	header.value = NULL;
+	header.value_len = 0;
+	if(cy_http_client_read_header(conn->handle, response, &header, 1) != CY_RSLT_SUCCESS || header.value == NULL) {
+		return 0;
+	}
 
-		printf("Waited 2 mins.\n");
+	serverTime = poll_scheduler_parse_http_date(header.value, header.value_len);
+	if(serverTime != 0) {
+		set_clock(serverTime);
 	}
+	return serverTime;
 }
 
 /*******************************************************************************
- * Function Name: connect_to_wifi_ap()
+ * Function Name: set_clock
  *******************************************************************************
  * Summary:
- *  Connects to Wi-Fi AP using the user-configured credentials, retries up to a
- *  configured number of times until the connection succeeds.
+ *  Sets the wall clock to a server time taken now.
  *
  *******************************************************************************/
-cy_rslt_t connect_to_wifi_ap(void) {
-	cy_rslt_t result;
+static void set_clock(time_t wall_time) {
+	clockTime = wall_time;
+	clockTick = xTaskGetTickCount();
+	freshness_sync_clock(clockTime, clockTick);
+}
 
-	/* Variables used by Wi-Fi connection manager.*/
-	cy_wcm_connect_params_t wifi_conn_param;
+/*******************************************************************************
+ * Function Name: wait_for_next_fetch
+ *******************************************************************************
+ * Summary:
+ *  Sleeps until the next fetch deadline from the poll scheduler. Until the
+ *  clock has been synced the old fixed period is used. A pending retry after
+ *  a failure wakes the task earlier than the schedule would, and so does a
+ *  notification from the decode task.
+ *
+ * Parameters:
+ *  TickType_t *lastWake : tick of the previous deadline, advanced to the next
+ *  uint32_t retry_ms : retry delay from the connection state machine, 0 if none
+ *
+ * Return:
+ *  uint32_t : PIPELINE_NOTIFY_* bits received while waiting, 0 on timeout
+ *
+ *******************************************************************************/
+static uint32_t wait_for_next_fetch(TickType_t *lastWake, uint32_t retry_ms) {
+	TickType_t now = xTaskGetTickCount();
+	TickType_t period;
+	TickType_t wake;
+	uint32_t bits = 0;
+
+	if(clockTime == 0) {
+		period = pdMS_TO_TICKS(POLL_PERIOD_UNSYNCED_S * 1000);
+		LOG_INFO("Clock not synced, waiting %d s", POLL_PERIOD_UNSYNCED_S);
+	} else {
+		market_session_t session;
+		time_t wallNow = clockTime + (time_t)((now - clockTick) / configTICK_RATE_HZ);
+		time_t next = poll_scheduler_next_fetch(wallNow, &session);
+		TickType_t deadline = clockTick + (TickType_t)(next - clockTime) * configTICK_RATE_HZ;
+
+		period = deadline - *lastWake;
+		LOG_INFO("Market %s, next fetch in %ld s", poll_scheduler_session_name(session), (long)(next - wallNow));
+	}
 
-	cy_wcm_config_t wifi_config = {.interface = CY_WCM_INTERFACE_TYPE_STA};
+	// Transient failure, retry in seconds instead of waiting out the whole period
+	if(retry_ms > 0 && (int32_t)(*lastWake + period - now) > (int32_t)pdMS_TO_TICKS(retry_ms)) {
+		LOG_INFO("Retrying in %lu ms", (unsigned long)retry_ms);
+		wake = now + pdMS_TO_TICKS(retry_ms);
+	} else if((int32_t)(*lastWake + period - now) <= 0) {
+		// Already past the deadline (slow fetch or clock step), fetch right away and restart the period from here
+		*lastWake = now;
+		return 0;
+	} else {
+		wake = *lastWake + period;
+	}
 
-	cy_wcm_ip_address_t ip_address;
+	// Sleep on the notification word rather than vTaskDelayUntil so other tasks can wake us
+	while(bits == 0) {
+		int32_t left = (int32_t)(wake - xTaskGetTickCount());
+		if(left <= 0) {
+			break;
+		}
+		(void)xTaskNotifyWait(0, UINT32_MAX, &bits, (TickType_t)left);
+	}
 
-	/* Initialize Wi-Fi connection manager. */
-	result = cy_wcm_init(&wifi_config);
+	*lastWake = (bits == 0) ? wake : xTaskGetTickCount();
+	return bits;
+}
 
-	if(result != CY_RSLT_SUCCESS) {
-		printf("Wi-Fi Connection Manager initialization failed!\n");
-		return result;
+/*******************************************************************************
+ * Function Name: key_status
+ *******************************************************************************
+ * Summary:
+ *  Checks whether the server refused the API key: a 429 rate limit, an auth
+ *  status, or a 200 carrying FMP's {"Error Message": ...} object instead of
+ *  quotes, which is how it reports a spent daily quota.
+ *
+ *******************************************************************************/
+static key_status_t key_status(uint16_t status, const uint8_t *body, uint32_t body_len) {
+	static const char errorTag[] = "\"Error Message\"";
+
+	if(status == 429) {
+		return KEY_STATUS_RATE_LIMITED;
+	}
+	if(status == 401 || status == 403) {
+		return KEY_STATUS_REJECTED;
 	}
-	printf("Wi-Fi Connection Manager initialized.\r\n");
-
-	/* Set the Wi-Fi SSID, password and security type. */
-	memset(&wifi_conn_param, 0, sizeof(cy_wcm_connect_params_t));
-	memcpy(wifi_conn_param.ap_credentials.SSID, WIFI_SSID, sizeof(WIFI_SSID));
-	memcpy(wifi_conn_param.ap_credentials.password, WIFI_PASSWORD, sizeof(WIFI_PASSWORD));
-	wifi_conn_param.ap_credentials.security = WIFI_SECURITY_TYPE;
-
-	/* Join the Wi-Fi AP. */
-	for(uint32_t conn_retries = 0; conn_retries < MAX_WIFI_CONN_RETRIES; conn_retries++) {
-		result = cy_wcm_connect_ap(&wifi_conn_param, &ip_address);
-
-		if(result == CY_RSLT_SUCCESS) {
-			printf("Successfully connected to Wi-Fi network '%s'.\n", wifi_conn_param.ap_credentials.SSID);
-			printf("IP Address Assigned: %d.%d.%d.%d\n", (uint8)ip_address.ip.v4, (uint8)(ip_address.ip.v4 >> 8), (uint8)(ip_address.ip.v4 >> 16),
-				   (uint8)(ip_address.ip.v4 >> 24));
-			return result;
+
+	for(uint32_t i = 0; i + sizeof(errorTag) - 1 <= body_len; i++) {
+		if(memcmp(&body[i], errorTag, sizeof(errorTag) - 1) == 0) {
+			return KEY_STATUS_REJECTED;
 		}
+	}
 
-		printf("Connection to Wi-Fi network failed with error code %d."
-			   "Retrying in %d ms...\n",
-			   (int)result, WIFI_CONN_RETRY_INTERVAL_MSEC);
+	return KEY_STATUS_OK;
+}
 
-		vTaskDelay(pdMS_TO_TICKS(WIFI_CONN_RETRY_INTERVAL_MSEC));
+/*******************************************************************************
+ * Function Name: retry_after_ms
+ *******************************************************************************
+ * Summary:
+ *  Reads how long a rate limited key should rest from the Retry-After
+ *  header, in seconds or as an HTTP date. Without one the key rests
+ *  API_KEY_RATE_LIMIT_BACKOFF_S.
+ *
+ *******************************************************************************/
+static uint32_t retry_after_ms(http_connection_t *conn, cy_http_client_response_t *response, time_t server_time) {
+	cy_http_client_header_t header;
+	uint32_t seconds = 0;
+	time_t until;
+
+	header.field = "Retry-After";
+	header.field_len = strlen("Retry-After");
+	header.value = NULL;
+	header.value_len = 0;
+	if(cy_http_client_read_header(conn->handle, response, &header, 1) != CY_RSLT_SUCCESS || header.value == NULL || header.value_len == 0) {
+		return API_KEY_RATE_LIMIT_BACKOFF_S * 1000u;
 	}
 
-	/* Stop retrying after maximum retry attempts. */
-	printf("Exceeded maximum Wi-Fi connection attempts\n");
+	if(header.value[0] >= '0' && header.value[0] <= '9') {
+		for(size_t i = 0; i < header.value_len && header.value[i] >= '0' && header.value[i] <= '9' && seconds < API_KEY_RATE_LIMIT_MAX_S; i++) {
+			seconds = seconds * 10 + (uint32_t)(header.value[i] - '0');
+		}
+	} else {
+		until = poll_scheduler_parse_http_date(header.value, header.value_len);
+		if(until == 0 || server_time == 0) {
+			return API_KEY_RATE_LIMIT_BACKOFF_S * 1000u;
+		}
+		seconds = (until > server_time) ? (uint32_t)(until - server_time) : 0;
+	}
 
-	return result;
+	// At least a second, so a "0" does not spin on the same key
+	return ((seconds > 0) ? seconds : 1) * 1000u;
 }
 
 /*******************************************************************************
- * Function Name: disconnect_callback
+ * Function Name: replay_capture
  *******************************************************************************
  * Summary:
- *  Invoked when the server disconnects
- *
- * Parameters:
- *  void *arg : unused
- *
- * Return:
- *  void
+ *  Feeds the recorded responses through the parse, decode and display path
+ *  in place of fetching, over and over. The clock follows the recorded Date
+ *  headers, so quote ages and market hours come out as they did on the day.
+ *  With CAPTURE_REPLAY_PACED the recorded gaps between responses are kept;
+ *  without it a body goes in as soon as the decode task frees a table, and
+ *  each pass reports its throughput. Bodies are never dropped for a busy
+ *  decoder on replay, so every pass draws the same quotes. Does not return.
  *
  *******************************************************************************/
-void disconnect_callback(void *arg) {
-	printf("Disconnected from HTTP Server\n");
-	connected = false;
+static void replay_capture(void) {
+	capture_entry_t entry;
+
+	while(1) {
+		TickType_t start = xTaskGetTickCount();
+		TickType_t lastWake = start;
+		uint32_t previousMs = 0;
+		uint32_t responses = 0;
+		uint32_t bytes = 0;
+
+		capture_rewind();
+		while(capture_next(&entry)) {
+			if(CAPTURE_REPLAY_PACED && responses > 0) {
+				vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(entry.arrival_ms - previousMs));
+			}
+			previousMs = entry.arrival_ms;
+			responses++;
+			bytes += entry.body_len;
+
+			if(entry.server_time != 0) {
+				set_clock(entry.server_time);
+			}
+			if(key_status(entry.status, entry.body, entry.body_len) != KEY_STATUS_OK) {
+				LOG_INFO("Replay: response %lu is a rejected key, skipped", (unsigned long)entry.seq);
+				continue;
+			}
+
+			(void)pipeline_wait_for_table(portMAX_DELAY);
+			freshness_fetch_start();
+			freshness_first_byte();
+
+			// Piece by piece, the way the receive path hands a body to the parser
+			for(uint32_t offset = 0; offset < entry.body_len; offset += CAPTURE_REPLAY_CHUNK) {
+				uint32_t len = entry.body_len - offset;
+				pipeline_body_sink(NULL, &entry.body[offset], (len < CAPTURE_REPLAY_CHUNK) ? len : CAPTURE_REPLAY_CHUNK, offset);
+			}
+			if(pipeline_submit_body() != PIPELINE_BODY_QUEUED) {
+				LOG_WARN("Replay: response %lu has no quotes", (unsigned long)entry.seq);
+			}
+		}
+
+		if(responses == 0) {
+			LOG_WARN("Replay: no recording in flash");
+		} else {
+			uint32_t ms = (uint32_t)pdTICKS_TO_MS(xTaskGetTickCount() - start);
+			LOG_INFO("Replay: %lu responses, %lu B in %lu ms, %lu responses/s", (unsigned long)responses, (unsigned long)bytes, (unsigned long)ms,
+					 (unsigned long)((ms > 0) ? responses * 1000u / ms : 0));
+		}
+		vTaskDelay(pdMS_TO_TICKS(REPLAY_PASS_PAUSE_MS));
+	}
 }
@@ -42,6 +42,15 @@
 /*******************************************************************************
 * Macros
 ********************************************************************************/
+/* A build can point the client at another server, e.g. a local stand-in for
+ * load and fault testing, by defining SERVER_CONFIG_FILE as a header that sets
+ * SERVERHOSTNAME, SERVERPORT and SSL_ROOTCA_PEM. Whatever it leaves out keeps
+ * the defaults below. The host name is also sent as SNI and in the Host header.
+ */
+#ifdef SERVER_CONFIG_FILE
+#include SERVER_CONFIG_FILE
+#endif
+
 /* Wi-Fi Credentials: Modify WIFI_SSID, WIFI_PASSWORD and WIFI_SECURITY_TYPE
  * to match your Wi-Fi network credentials.
  * Note: Maximum length of the Wi-Fi SSID and password is set to
@@ -51,13 +60,30 @@
 #define WIFI_SSID     "SSID"
 #define WIFI_PASSWORD "PSWD"
 
+#ifndef SERVERHOSTNAME
 #define SERVERHOSTNAME "financialmodelingprep.com"
-#define SERVERPORT     (443)
+#endif
+#ifndef SERVERPORT
+#define SERVERPORT (443)
+#endif
+
+/* API keys, any number up to API_KEY_POOL_MAX_KEYS (api_key_pool.h). Calls
+ * are spread over them by remaining daily budget.
+ */
+#define API_KEYS "<mykey>", "<mykey>", "<mykey>"
 
-#define NUM_API_KEYS            (3)
-#define AMDSTOCKQUOTERESOURCE_0 "/api/v3/quote/AMD?apikey=<mykey>"
-#define AMDSTOCKQUOTERESOURCE_1 "/api/v3/quote/AMD?apikey=<mykey>"
-#define AMDSTOCKQUOTERESOURCE_2 "/api/v3/quote/AMD?apikey=<mykey>"
+/* Tickers to watch. All of them are fetched with one request, at most
+ * QUOTE_TABLE_CAPACITY (quote.h) are kept.
+ */
+#define WATCHLIST_SYMBOLS "AMD", "NVDA", "INTC"
+
+/* Price alerts, see the ALERT_* rule macros in alerts.h. A rule that fires
+ * highlights the card and fetches again right away, at most once every
+ * PIPELINE_REFRESH_MIN_INTERVAL_MS (pipeline.h).
+ */
+#define ALERT_RULES                                                     \
+	ALERT_MOVE_PERCENT("AMD", 3), ALERT_MOVE_PERCENT("NVDA", 3),        \
+		ALERT_MOVE_PERCENT("INTC", 3), ALERT_NEW_DAY_HIGH("AMD"), ALERT_NEW_DAY_LOW("AMD")
 
 /* Security type of the Wi-Fi access point. See 'cy_wcm_security_t' structure
  * in "cy_wcm.h" for more details.
@@ -126,6 +152,7 @@
 	"mNQ/k3fRffW4DdHiYzgoIfmF\n"                                         \
 	"-----END PRIVATE KEY-----\n"
 
+#ifndef SSL_ROOTCA_PEM
 #define SSL_ROOTCA_PEM                                                   \
 	"-----BEGIN CERTIFICATE-----\n"                                      \
 	"MIIDQTCCAimgAwIBAgITBmyfz5m/jAo54vB4ikPmljZbyjANBgkqhkiG9w0BAQsF\n" \
@@ -147,6 +174,7 @@
 	"5MsI+yMRQ+hDKXJioaldXgjUkK642M4UwtBV8ob2xJNDd2ZhwLnoQdeXeGADbkpy\n" \
 	"rqXRfboQnoZsG4q5WTP468SQvvG5\n"                                     \
 	"-----END CERTIFICATE-----\n"
+#endif
 
 /*******************************************************************************
 * Function Prototypes
@@ -0,0 +1,612 @@
+/******************************************************************************
+* File Name:   http_connection.c
+*
+* Description: This file contains the persistent HTTP/1.1 keep-alive
+* connection manager. One TLS session is kept open across polls and is only
+* re-established after the server (or a failed request) closes it.
+*
+* Failures are classified (DNS, TCP, TLS, HTTP status, payload) and drive a
+* small state machine:
+*
+*   IDLE -> CONNECTING -> CONNECTED
+*     ^         |             |
+*     |         v             v
+*     +----- BACKOFF <--------+    bounded exponential backoff with jitter
+*               |
+*               v
+*          CIRCUIT_OPEN            after HTTP_CONNECTION_CIRCUIT_THRESHOLD
+*                                  failures in a row, one trial request is
+*                                  let through when the open period ends
+*
+*******************************************************************************/
+
+/* Header file includes. */
+#include "cyhal.h"
+#include "cybsp.h"
+
+/* FreeRTOS header file. */
+#include <FreeRTOS.h>
+#include <task.h>
+
+/* Standard C header file. */
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+
+/* Cypress secure socket header file. */
+#include "cy_secure_sockets.h"
+
+#include "http_connection.h"
+#include "tls_session_cache.h"
+#include "metrics.h"
+#include "freshness.h"
+#include "log_ring.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define HTTP_CONNECTION_MAX_HEADERS (4)
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+static void http_connection_disconnect_callback(void *arg);
+static cy_rslt_t http_connection_connect(http_connection_t *conn);
+static cy_rslt_t http_connection_send(http_connection_t *conn, cy_http_client_request_header_t *request, cy_http_client_header_t *headers,
+									  uint32_t num_headers, cy_http_client_response_t *response);
+static bool http_connection_server_wants_close(http_connection_t *conn, cy_http_client_response_t *response);
+static void http_connection_succeeded(http_connection_t *conn);
+static uint32_t http_connection_now_ms(void);
+
+cy_rslt_t __real_cy_socket_send(cy_socket_t handle, const void *data, uint32_t size, int flags, uint32_t *bytes_sent);
+cy_rslt_t __real_cy_socket_recv(cy_socket_t handle, void *buffer, uint32_t size, int flags, uint32_t *bytes_received);
+cy_rslt_t __wrap_cy_socket_send(cy_socket_t handle, const void *data, uint32_t size, int flags, uint32_t *bytes_sent);
+cy_rslt_t __wrap_cy_socket_recv(cy_socket_t handle, void *buffer, uint32_t size, int flags, uint32_t *bytes_received);
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+// Request timing, kept by the socket wrappers while cy_http_client_send runs
+static bool requestTimed = false;
+static bool firstByteSeen;
+static uint32_t requestStart;
+static uint32_t requestSent;
+static uint32_t firstByteAt;
+
+// Body framing for the body sink, kept by the receive wrapper the same way
+static bool sinkActive = false;
+static http_body_t sinkBody;
+
+/*******************************************************************************
+ * Function Name: http_connection_init
+ *******************************************************************************
+ * Summary:
+ *  Creates the HTTP client used for every request. No connection is made here,
+ *  the first request connects lazily.
+ *
+ * Parameters:
+ *  http_connection_t *conn : connection to initialize
+ *  cy_awsport_ssl_credentials_t *credentials : TLS credentials
+ *  cy_awsport_server_info_t *serverInfo : host name and port of the server
+ *
+ * Return:
+ *  cy_rslt_t : CY_RSLT_SUCCESS if the client was created
+ *
+ *******************************************************************************/
+cy_rslt_t http_connection_init(http_connection_t *conn, cy_awsport_ssl_credentials_t *credentials, cy_awsport_server_info_t *serverInfo) {
+	(void)memset(conn, 0, sizeof(*conn));
+	conn->host_name = serverInfo->host_name;
+	conn->state = HTTP_CONNECTION_IDLE;
+	conn->jitter_seed = xTaskGetTickCount() | 1u;
+
+	return cy_http_client_create(credentials, serverInfo, http_connection_disconnect_callback, conn, &conn->handle);
+}
+
+/*******************************************************************************
+ * Function Name: http_connection_get
+ *******************************************************************************
+ * Summary:
+ *  Sends a request over the kept-alive session, connecting first if the
+ *  session is down. A request that fails on a reused session is retried once
+ *  on a fresh one, since the server may have dropped an idle connection
+ *  without the disconnect callback having fired yet.
+ *
+ *  While backing off or with the circuit open no network traffic is made and
+ *  HTTP_CONNECTION_RSLT_BACKOFF is returned.
+ *
+ * Parameters:
+ *  http_connection_t *conn : connection to use
+ *  cy_http_client_request_header_t *request : request to send, response is read into request->buffer
+ *  cy_http_client_header_t *headers : extra request headers (Host etc.)
+ *  uint32_t num_headers : number of entries in headers
+ *  cy_http_client_response_t *response : filled with the server's response
+ *
+ * Return:
+ *  cy_rslt_t : CY_RSLT_SUCCESS if a response was received. Server errors
+ *  (5xx) count as failures, client errors (4xx) are returned for the caller
+ *  to handle.
+ *
+ *******************************************************************************/
+cy_rslt_t http_connection_get(http_connection_t *conn, cy_http_client_request_header_t *request, cy_http_client_header_t *headers, uint32_t num_headers,
+							  cy_http_client_response_t *response) {
+	cy_rslt_t result;
+	bool reused;
+
+	if(http_connection_retry_delay_ms(conn) > 0) {
+		return HTTP_CONNECTION_RSLT_BACKOFF;
+	}
+
+	reused = (conn->state == HTTP_CONNECTION_CONNECTED) && !conn->server_closed;
+
+	result = http_connection_connect(conn);
+	if(result != CY_RSLT_SUCCESS) {
+		return result;
+	}
+
+	result = http_connection_send(conn, request, headers, num_headers, response);
+	if(result != CY_RSLT_SUCCESS && reused) {
+		LOG_WARN("Request on reused session failed, reconnecting");
+		if(!conn->server_closed) {
+			conn->server_closes++;    // Unless the disconnect callback counted it already
+		}
+		http_connection_close(conn);
+
+		result = http_connection_connect(conn);
+		if(result != CY_RSLT_SUCCESS) {
+			return result;
+		}
+		result = http_connection_send(conn, request, headers, num_headers, response);
+	}
+
+	if(result != CY_RSLT_SUCCESS) {
+		http_connection_close(conn);
+		http_connection_report_failure(conn, HTTP_FAILURE_TCP);
+		return result;
+	}
+
+	// Server asked to close after this response, drop our side now instead of failing the next poll
+	if(http_connection_server_wants_close(conn, response)) {
+		if(!conn->server_closed) {
+			conn->server_closes++;
+		}
+		http_connection_close(conn);
+	}
+
+	if(response->status_code >= 500) {
+		LOG_WARN("Server error %u", response->status_code);
+		http_connection_report_failure(conn, HTTP_FAILURE_HTTP_STATUS);
+		return HTTP_CONNECTION_RSLT_BACKOFF;
+	}
+
+	http_connection_succeeded(conn);
+	return CY_RSLT_SUCCESS;
+}
+
+/*******************************************************************************
+ * Function Name: http_connection_set_body_sink
+ *******************************************************************************
+ * Summary:
+ *  Streams the body of every later response to sink as it is received, so
+ *  the caller can parse it without waiting for, or copying, the whole body.
+ *  Content-Length and chunked bodies are framed as they arrive; a body sent
+ *  with any other transfer coding is handed over from response->body once
+ *  the response is complete. response->body is still filled in as before.
+ *
+ * Parameters:
+ *  http_connection_t *conn : connection to stream from
+ *  http_connection_body_sink_t sink : called from the task sending the request, NULL to stop
+ *  void *arg : passed to sink
+ *
+ *******************************************************************************/
+void http_connection_set_body_sink(http_connection_t *conn, http_connection_body_sink_t sink, void *arg) {
+	conn->body_sink = sink;
+	conn->body_sink_arg = arg;
+}
+
+/*******************************************************************************
+ * Function Name: http_connection_close
+ *******************************************************************************
+ * Summary:
+ *  Closes the session if it is open. The next request reconnects.
+ *
+ *******************************************************************************/
+void http_connection_close(http_connection_t *conn) {
+	cy_rslt_t result;
+
+	if(conn->state != HTTP_CONNECTION_CONNECTED) {
+		return;
+	}
+
+	result = cy_http_client_disconnect(conn->handle);
+	if(result != CY_RSLT_SUCCESS) {
+		LOG_ERROR("HTTP Client Disconnect Failed!");
+	}
+	conn->state = HTTP_CONNECTION_IDLE;
+}
+
+/*******************************************************************************
+ * Function Name: http_connection_deinit
+ *******************************************************************************
+ * Summary:
+ *  Closes the session and deletes the HTTP client. The connection has to be
+ *  initialized again before it is used.
+ *
+ *******************************************************************************/
+void http_connection_deinit(http_connection_t *conn) {
+	http_connection_close(conn);
+	if(conn->handle != NULL && cy_http_client_delete(conn->handle) != CY_RSLT_SUCCESS) {
+		LOG_ERROR("HTTP Client Delete Failed!");
+	}
+	conn->handle = NULL;
+}
+
+/*******************************************************************************
+ * Function Name: http_connection_report_failure
+ *******************************************************************************
+ * Summary:
+ *  Records a failed attempt and schedules the next one. Also used by the
+ *  caller for failures only it can see, such as an unparsable body. The
+ *  response such a failure is about reset the streak when it arrived, so a
+ *  payload failure goes on from the streak before it: a server that keeps
+ *  answering with bodies that cannot be used backs off and opens the
+ *  circuit like one that does not answer.
+ *
+ *******************************************************************************/
+void http_connection_report_failure(http_connection_t *conn, http_failure_t failure) {
+	uint32_t delay;
+
+	if(failure == HTTP_FAILURE_PAYLOAD && conn->consecutive_failures == 0) {
+		conn->consecutive_failures = conn->failures_before_response;
+	}
+	conn->last_failure = failure;
+	conn->failures[failure]++;
+	conn->consecutive_failures++;
+
+	if(conn->consecutive_failures >= HTTP_CONNECTION_CIRCUIT_THRESHOLD) {
+		// Drop the session too, a half-open trial should start clean
+		http_connection_close(conn);
+		conn->state = HTTP_CONNECTION_CIRCUIT_OPEN;
+		delay = HTTP_CONNECTION_CIRCUIT_OPEN_MS;
+	} else {
+		uint32_t shift = conn->consecutive_failures - 1;
+		uint32_t cap = (shift >= 16 || (HTTP_CONNECTION_BACKOFF_BASE_MS << shift) > HTTP_CONNECTION_BACKOFF_MAX_MS)
+						   ? HTTP_CONNECTION_BACKOFF_MAX_MS
+						   : (HTTP_CONNECTION_BACKOFF_BASE_MS << shift);
+
+		// xorshift32, only spreads retries from many devices apart
+		conn->jitter_seed ^= conn->jitter_seed << 13;
+		conn->jitter_seed ^= conn->jitter_seed >> 17;
+		conn->jitter_seed ^= conn->jitter_seed << 5;
+		delay = cap / 2 + conn->jitter_seed % (cap / 2 + 1);
+
+		if(conn->state != HTTP_CONNECTION_CONNECTED) {
+			conn->state = HTTP_CONNECTION_BACKOFF;
+		}
+	}
+
+	conn->retry_at_ms = http_connection_now_ms() + delay;
+	LOG_WARN("%s failure #%lu, next attempt in %lu ms (%s)", http_connection_failure_name(failure), (unsigned long)conn->consecutive_failures,
+			 (unsigned long)delay, http_connection_state_name(conn->state));
+}
+
+/*******************************************************************************
+ * Function Name: http_connection_retry_delay_ms
+ *******************************************************************************
+ * Summary:
+ *  Time left before another attempt is allowed, 0 if one can be made now.
+ *
+ *******************************************************************************/
+uint32_t http_connection_retry_delay_ms(const http_connection_t *conn) {
+	int32_t left;
+
+	if(conn->consecutive_failures == 0) {
+		return 0;
+	}
+
+	left = (int32_t)(conn->retry_at_ms - http_connection_now_ms());
+	return (left > 0) ? (uint32_t)left : 0;
+}
+
+/*******************************************************************************
+ * Function Name: http_connection_state_name
+ *******************************************************************************
+ * Summary:
+ *  Short name of a connection state for logs.
+ *
+ *******************************************************************************/
+const char *http_connection_state_name(http_connection_state_t state) {
+	switch(state) {
+		case HTTP_CONNECTION_CONNECTING:
+			return "connecting";
+		case HTTP_CONNECTION_CONNECTED:
+			return "connected";
+		case HTTP_CONNECTION_BACKOFF:
+			return "backoff";
+		case HTTP_CONNECTION_CIRCUIT_OPEN:
+			return "circuit open";
+		default:
+			return "idle";
+	}
+}
+
+/*******************************************************************************
+ * Function Name: http_connection_failure_name
+ *******************************************************************************
+ * Summary:
+ *  Short name of a failure class for logs.
+ *
+ *******************************************************************************/
+const char *http_connection_failure_name(http_failure_t failure) {
+	switch(failure) {
+		case HTTP_FAILURE_DNS:
+			return "DNS";
+		case HTTP_FAILURE_TCP:
+			return "TCP";
+		case HTTP_FAILURE_TLS:
+			return "TLS";
+		case HTTP_FAILURE_HTTP_STATUS:
+			return "HTTP status";
+		case HTTP_FAILURE_PAYLOAD:
+			return "payload";
+		default:
+			return "none";
+	}
+}
+
+/*******************************************************************************
+ * Function Name: http_connection_print_stats
+ *******************************************************************************
+ * Summary:
+ *  Prints the handshake to request ratio so connection reuse can be verified,
+ *  and the failure counts per class.
+ *
+ *******************************************************************************/
+void http_connection_print_stats(const http_connection_t *conn) {
+	LOG_DEBUG("Connection stats: %lu requests, %lu handshakes (%lu resumed), %lu server closes, state %s", (unsigned long)conn->requests,
+			  (unsigned long)conn->handshakes, (unsigned long)conn->resumed_handshakes, (unsigned long)conn->server_closes,
+			  http_connection_state_name(conn->state));
+	LOG_DEBUG("Failures: DNS %lu, TCP %lu, TLS %lu, HTTP %lu, payload %lu", (unsigned long)conn->failures[HTTP_FAILURE_DNS],
+			  (unsigned long)conn->failures[HTTP_FAILURE_TCP], (unsigned long)conn->failures[HTTP_FAILURE_TLS],
+			  (unsigned long)conn->failures[HTTP_FAILURE_HTTP_STATUS], (unsigned long)conn->failures[HTTP_FAILURE_PAYLOAD]);
+}
+
+/*******************************************************************************
+ * Function Name: http_connection_connect
+ *******************************************************************************
+ * Summary:
+ *  Connects to the server if the session is not already up. The host name is
+ *  resolved first so DNS failures can be told apart, lwIP caches the answer
+ *  for the connect that follows. A failed connect is TLS if a handshake with
+ *  the server was attempted and failed, TCP otherwise; after a TLS failure
+ *  the cached session is dropped so the next handshake is a full one.
+ *
+ *******************************************************************************/
+static cy_rslt_t http_connection_connect(http_connection_t *conn) {
+	cy_rslt_t result;
+	cy_socket_ip_address_t address;
+	uint32_t tlsFailures;
+	uint32_t start;
+	uint32_t elapsed;
+
+	// The library still holds the dead socket after a server side close, release it before reconnecting
+	if(conn->server_closed) {
+		conn->server_closed = false;
+		http_connection_close(conn);
+	}
+
+	if(conn->state == HTTP_CONNECTION_CONNECTED) {
+		return CY_RSLT_SUCCESS;
+	}
+
+	conn->state = HTTP_CONNECTION_CONNECTING;
+
+	start = metrics_now();
+	result = cy_socket_gethostbyname(conn->host_name, CY_SOCKET_IP_VER_V4, &address);
+	(void)metrics_record(METRICS_PHASE_DNS, start);
+	if(result != CY_RSLT_SUCCESS) {
+		LOG_ERROR("DNS lookup of %s failed! Result: %lx", conn->host_name, (unsigned long)result);
+		http_connection_report_failure(conn, HTTP_FAILURE_DNS);
+		return result;
+	}
+
+	tlsFailures = tls_session_cache_failed_handshakes();
+	start = metrics_now();
+	result = cy_http_client_connect(conn->handle, HTTP_CONNECTION_TIMEOUT_MS, HTTP_CONNECTION_TIMEOUT_MS);
+	if(result != CY_RSLT_SUCCESS) {
+		bool tls = (tls_session_cache_failed_handshakes() != tlsFailures);
+
+		LOG_ERROR("HTTP Client Connection Failed! Result: %lx", (unsigned long)result);
+		if(tls) {
+			// The server may have dropped the session that was offered, do not offer it again
+			tls_session_cache_invalidate();
+		}
+		http_connection_report_failure(conn, tls ? HTTP_FAILURE_TLS : HTTP_FAILURE_TCP);
+		return result;
+	}
+
+	// The handshake inside the connect was just timed by the TLS wrapper, the rest is TCP
+	elapsed = metrics_now() - start;
+	metrics_record_cycles(METRICS_PHASE_TCP, elapsed - ((metrics_last(METRICS_PHASE_TLS) < elapsed) ? metrics_last(METRICS_PHASE_TLS) : elapsed));
+
+	conn->handshakes++;
+	conn->resumed_handshakes += tls_session_cache_last_resumed() ? 1u : 0u;
+	conn->state = HTTP_CONNECTION_CONNECTED;
+	LOG_INFO("Connected to HTTP Server Successfully (%s handshake)", tls_session_cache_last_resumed() ? "resumed" : "full");
+
+	return CY_RSLT_SUCCESS;
+}
+
+/*******************************************************************************
+ * Function Name: http_connection_send
+ *******************************************************************************
+ * Summary:
+ *  Writes the request header, asking the server to keep the session open, and
+ *  sends the request.
+ *
+ *******************************************************************************/
+static cy_rslt_t http_connection_send(http_connection_t *conn, cy_http_client_request_header_t *request, cy_http_client_header_t *headers,
+									  uint32_t num_headers, cy_http_client_response_t *response) {
+	cy_rslt_t result;
+	cy_http_client_header_t allHeaders[HTTP_CONNECTION_MAX_HEADERS];
+
+	if(num_headers >= HTTP_CONNECTION_MAX_HEADERS) {
+		num_headers = HTTP_CONNECTION_MAX_HEADERS - 1;
+	}
+	(void)memcpy(allHeaders, headers, num_headers * sizeof(cy_http_client_header_t));
+
+	// HTTP/1.1 defaults to keep-alive, but ask explicitly so proxies do not close on us
+	allHeaders[num_headers].field = "Connection";
+	allHeaders[num_headers].field_len = strlen("Connection");
+	allHeaders[num_headers].value = "keep-alive";
+	allHeaders[num_headers].value_len = strlen("keep-alive");
+
+	result = cy_http_client_write_header(conn->handle, request, allHeaders, num_headers + 1);
+	if(result != CY_RSLT_SUCCESS) {
+		LOG_ERROR("HTTP Client Header Write Failed!");
+		return result;
+	}
+
+	conn->requests++;
+	requestStart = requestSent = metrics_now();
+	firstByteSeen = false;
+	requestTimed = true;
+	http_body_init(&sinkBody, conn->body_sink, conn->body_sink_arg);
+	sinkActive = (conn->body_sink != NULL);
+	result = cy_http_client_send(conn->handle, request, NULL, 0, response);
+	sinkActive = false;
+	requestTimed = false;
+	if(result != CY_RSLT_SUCCESS) {
+		LOG_ERROR("HTTP Client Send Failed! Result: %lx", (unsigned long)result);
+		return result;
+	}
+	if(firstByteSeen) {
+		(void)metrics_record(METRICS_PHASE_BODY, firstByteAt);
+	}
+
+	// Not framed on the way in, the library's own copy of the body goes to the sink instead
+	if(conn->body_sink != NULL && !http_body_done(&sinkBody)) {
+		LOG_DEBUG("Body not streamed (framing state %d), passing it on whole", (int)sinkBody.state);
+		conn->body_sink(conn->body_sink_arg, response->body, response->body_len, 0);
+	}
+
+	return result;
+}
+
+/*******************************************************************************
+ * Function Name: http_connection_server_wants_close
+ *******************************************************************************
+ * Summary:
+ *  Checks the response for a "Connection: close" header.
+ *
+ *******************************************************************************/
+static bool http_connection_server_wants_close(http_connection_t *conn, cy_http_client_response_t *response) {
+	cy_http_client_header_t header;
+
+	header.field = "Connection";
+	header.field_len = strlen("Connection");
+	header.value = NULL;
+	header.value_len = 0;
+
+	if(cy_http_client_read_header(conn->handle, response, &header, 1) != CY_RSLT_SUCCESS || header.value == NULL) {
+		return false;
+	}
+
+	return (header.value_len == strlen("close")) && (strncasecmp(header.value, "close", header.value_len) == 0);
+}
+
+/*******************************************************************************
+ * Function Name: http_connection_succeeded
+ *******************************************************************************
+ * Summary:
+ *  Resets the backoff and closes the circuit after a good response.
+ *
+ *******************************************************************************/
+static void http_connection_succeeded(http_connection_t *conn) {
+	if(conn->consecutive_failures >= HTTP_CONNECTION_CIRCUIT_THRESHOLD) {
+		LOG_INFO("Circuit closed, upstream is back");
+	}
+
+	conn->failures_before_response = conn->consecutive_failures;
+	conn->consecutive_failures = 0;
+	conn->last_failure = HTTP_FAILURE_NONE;
+	if(conn->state != HTTP_CONNECTION_CONNECTED) {
+		conn->state = HTTP_CONNECTION_IDLE;
+	}
+}
+
+/*******************************************************************************
+ * Function Name: http_connection_now_ms
+ *******************************************************************************
+ * Summary:
+ *  Monotonic time in ms for retry deadlines.
+ *
+ *******************************************************************************/
+static uint32_t http_connection_now_ms(void) {
+	return (uint32_t)pdTICKS_TO_MS(xTaskGetTickCount());
+}
+
+/*******************************************************************************
+ * Function Name: http_connection_disconnect_callback
+ *******************************************************************************
+ * Summary:
+ *  Invoked by the HTTP client library when the server closes the session.
+ *
+ * Parameters:
+ *  void *arg : the http_connection_t passed at creation
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void http_connection_disconnect_callback(void *arg) {
+	http_connection_t *conn = (http_connection_t *)arg;
+
+	LOG_INFO("Disconnected from HTTP Server");
+	conn->server_closed = true;
+	conn->server_closes++;
+}
+
+/*******************************************************************************
+ * Function Name: __wrap_cy_socket_send
+ *******************************************************************************
+ * Summary:
+ *  Link time wrapper around cy_socket_send. While a request is being timed,
+ *  notes when the last of it went out.
+ *
+ *******************************************************************************/
+cy_rslt_t __wrap_cy_socket_send(cy_socket_t handle, const void *data, uint32_t size, int flags, uint32_t *bytes_sent) {
+	cy_rslt_t result = __real_cy_socket_send(handle, data, size, flags, bytes_sent);
+
+	if(requestTimed && !firstByteSeen) {
+		requestSent = metrics_now();
+	}
+
+	return result;
+}
+
+/*******************************************************************************
+ * Function Name: __wrap_cy_socket_recv
+ *******************************************************************************
+ * Summary:
+ *  Link time wrapper around cy_socket_recv. The first bytes of a timed
+ *  response close the send and first byte phases. The response goes on to
+ *  the framer, which passes the body bytes to the body sink, decrypted and in
+ *  place.
+ *
+ *******************************************************************************/
+cy_rslt_t __wrap_cy_socket_recv(cy_socket_t handle, void *buffer, uint32_t size, int flags, uint32_t *bytes_received) {
+	cy_rslt_t result = __real_cy_socket_recv(handle, buffer, size, flags, bytes_received);
+
+	if(requestTimed && !firstByteSeen && result == CY_RSLT_SUCCESS && bytes_received != NULL && *bytes_received > 0) {
+		firstByteSeen = true;
+		firstByteAt = metrics_now();
+		metrics_record_cycles(METRICS_PHASE_SEND, requestSent - requestStart);
+		metrics_record_cycles(METRICS_PHASE_FIRST_BYTE, firstByteAt - requestSent);
+		freshness_first_byte();
+	}
+	if(sinkActive && result == CY_RSLT_SUCCESS && bytes_received != NULL) {
+		http_body_feed(&sinkBody, (const uint8_t *)buffer, *bytes_received);
+	}
+
+	return result;
+}
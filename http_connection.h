@@ -0,0 +1,111 @@
+/******************************************************************************
+* File Name:   http_connection.h
+*
+* Description: This file contains declarations for the persistent HTTP/1.1
+* keep-alive connection manager used by the HTTP client task, and for the
+* reconnect state machine (backoff with jitter and a circuit breaker) that
+* guards it.
+*
+*******************************************************************************/
+
+#ifndef HTTP_CONNECTION_H_
+#define HTTP_CONNECTION_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* HTTP Client Library*/
+#include "cy_http_client_api.h"
+
+/* Response body framing */
+#include "http_body.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Send and receive timeout used for connect and for every request */
+#define HTTP_CONNECTION_TIMEOUT_MS (10000)
+
+/* Retry delay after the n-th consecutive failure is drawn from
+ * [d/2, d] with d = min(BASE << (n - 1), MAX).
+ */
+#define HTTP_CONNECTION_BACKOFF_BASE_MS (2000)
+#define HTTP_CONNECTION_BACKOFF_MAX_MS  (60000)
+
+/* Consecutive failures that open the circuit, and how long it stays open
+ * before a single trial request is let through.
+ */
+#define HTTP_CONNECTION_CIRCUIT_THRESHOLD (6)
+#define HTTP_CONNECTION_CIRCUIT_OPEN_MS   (10 * 60 * 1000)
+
+/* Returned by http_connection_get while backing off or with the circuit open */
+#define HTTP_CONNECTION_RSLT_BACKOFF (CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CY_RSLT_MODULE_MIDDLEWARE_BASE, 0x48))
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+typedef enum {
+	HTTP_CONNECTION_IDLE = 0,        // No session, next request connects
+	HTTP_CONNECTION_CONNECTING,
+	HTTP_CONNECTION_CONNECTED,
+	HTTP_CONNECTION_BACKOFF,         // Last attempt failed, waiting before the next one
+	HTTP_CONNECTION_CIRCUIT_OPEN     // Upstream looks dead, requests are refused until the open period ends
+} http_connection_state_t;
+
+typedef enum {
+	HTTP_FAILURE_NONE = 0,
+	HTTP_FAILURE_DNS,
+	HTTP_FAILURE_TCP,
+	HTTP_FAILURE_TLS,
+	HTTP_FAILURE_HTTP_STATUS,
+	HTTP_FAILURE_PAYLOAD,
+	HTTP_FAILURE_COUNT
+} http_failure_t;
+
+/* Takes the response body in the pieces it is received in, straight from the
+ * HTTP client's receive buffer, de-chunked and without the bytes after it.
+ */
+typedef http_body_sink_t http_connection_body_sink_t;
+
+typedef struct {
+	cy_http_client_t handle;
+	const char *host_name;
+	http_connection_state_t state;
+	volatile bool server_closed;  // Set by the disconnect callback, the session is torn down on the next request
+
+	// Reconnect state machine
+	uint32_t consecutive_failures;
+	uint32_t failures_before_response;    // Streak the last response ended, a payload failure carries it on
+	uint32_t retry_at_ms;                 // Tick time (ms) the next attempt is allowed at
+	http_failure_t last_failure;
+	uint32_t failures[HTTP_FAILURE_COUNT];
+	uint32_t jitter_seed;
+
+	// Reuse statistics
+	uint32_t handshakes;            // Successful TCP + TLS connects
+	uint32_t resumed_handshakes;    // Of those, handshakes that resumed the cached TLS session
+	uint32_t requests;              // Requests that were sent
+	uint32_t server_closes;         // Sessions closed by the server between or after requests
+
+	// Response body streaming, NULL sink if the caller only wants response->body
+	http_connection_body_sink_t body_sink;
+	void *body_sink_arg;
+} http_connection_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+cy_rslt_t http_connection_init(http_connection_t *conn, cy_awsport_ssl_credentials_t *credentials, cy_awsport_server_info_t *serverInfo);
+cy_rslt_t http_connection_get(http_connection_t *conn, cy_http_client_request_header_t *request, cy_http_client_header_t *headers, uint32_t num_headers,
+							  cy_http_client_response_t *response);
+void http_connection_set_body_sink(http_connection_t *conn, http_connection_body_sink_t sink, void *arg);
+void http_connection_close(http_connection_t *conn);
+void http_connection_deinit(http_connection_t *conn);
+void http_connection_report_failure(http_connection_t *conn, http_failure_t failure);
+uint32_t http_connection_retry_delay_ms(const http_connection_t *conn);
+const char *http_connection_state_name(http_connection_state_t state);
+const char *http_connection_failure_name(http_failure_t failure);
+void http_connection_print_stats(const http_connection_t *conn);
+
+#endif /* HTTP_CONNECTION_H_ */
@@ -0,0 +1,145 @@
+/******************************************************************************
+* File Name:   indicators.c
+*
+* Description: This file contains the indicator engine. The SMA keeps a running
+* sum over a ring of the window's prices, rolling min and max use monotonic
+* deques (each price is pushed and popped at most once), the EMA is a single
+* multiply-add and VWAP accumulates the volume traded since the last tick.
+*
+*******************************************************************************/
+
+/* Standard C header file. */
+#include <stdio.h>
+#include <string.h>
+
+#include "indicators.h"
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+static void indicators_deque_push(indicator_deque_t *deque, uint32_t seq, fixed_t price, bool keep_min);
+static fixed_t indicators_deque_front(const indicator_deque_t *deque);
+
+/*******************************************************************************
+ * Function Name: indicators_reset
+ *******************************************************************************
+ * Summary:
+ *  Starts over for a (new) symbol.
+ *
+ *******************************************************************************/
+void indicators_reset(indicator_state_t *state, const char *symbol) {
+	(void)memset(state, 0, sizeof(*state));
+	(void)snprintf(state->symbol, sizeof(state->symbol), "%s", symbol);
+}
+
+/*******************************************************************************
+ * Function Name: indicators_update
+ *******************************************************************************
+ * Summary:
+ *  Folds a quote into the statistics. A quote that is not newer than the
+ *  last one (the market is closed, or the poll beat the feed) is not a tick
+ *  and changes nothing.
+ *
+ * Parameters:
+ *  indicator_state_t *state : statistics of the quote's symbol
+ *  const quote_t *quote : the new quote
+ *  int volume_extra : index of the cumulative volume in quote->extra, -1 if none
+ *
+ * Return:
+ *  bool : true if the quote was a new tick
+ *
+ *******************************************************************************/
+bool indicators_update(indicator_state_t *state, const quote_t *quote, int volume_extra) {
+	indicator_values_t *values = &state->values;
+	fixed_t price = quote->price;
+	uint32_t seq;
+	uint32_t filled;
+
+	if(state->seq > 0 && quote->timestamp <= state->last_time) {
+		return false;
+	}
+	state->last_time = quote->timestamp;
+	seq = state->seq++;
+
+	// EMA, seeded with the first price
+	if(seq == 0) {
+		values->ema = price;
+	} else {
+		values->ema += (price - values->ema) * 2 / (INDICATOR_EMA_PERIOD + 1);
+	}
+
+	// SMA, the price leaving the window is the one being overwritten
+	if(seq >= INDICATOR_WINDOW) {
+		state->window_sum -= state->window[seq % INDICATOR_WINDOW];
+	}
+	state->window[seq % INDICATOR_WINDOW] = price;
+	state->window_sum += price;
+	filled = (state->seq < INDICATOR_WINDOW) ? state->seq : INDICATOR_WINDOW;
+	values->sma = (fixed_t)(state->window_sum / (int64_t)filled);
+
+	// Rolling extremes
+	indicators_deque_push(&state->min_deque, seq, price, true);
+	indicators_deque_push(&state->max_deque, seq, price, false);
+	values->min = indicators_deque_front(&state->min_deque);
+	values->max = indicators_deque_front(&state->max_deque);
+
+	// VWAP from the shares traded since the last tick; cumulative volume going down is a new day
+	if(volume_extra >= 0 && volume_extra < QUOTE_EXTRA_MAX) {
+		int64_t volume = quote->extra[volume_extra] / FIXED_SCALE;
+
+		if(volume < state->volume_last) {
+			state->price_volume_sum = 0;
+			state->volume_sum = 0;
+			state->volume_last = 0;
+		}
+		state->price_volume_sum += price * (volume - state->volume_last);
+		state->volume_sum += volume - state->volume_last;
+		state->volume_last = volume;
+
+		values->has_vwap = (state->volume_sum > 0);
+		values->vwap = values->has_vwap ? (fixed_t)(state->price_volume_sum / state->volume_sum) : 0;
+	}
+
+	values->from_open_percent = (quote->open > 0) ? (price - quote->open) * 100 * FIXED_SCALE / quote->open : 0;
+
+	return true;
+}
+
+/*******************************************************************************
+ * Function Name: indicators_deque_push
+ *******************************************************************************
+ * Summary:
+ *  Adds a price to a monotonic deque. Samples that can never be the extreme
+ *  again are dropped from the back, the sample leaving the window from the
+ *  front. Amortized O(1).
+ *
+ *******************************************************************************/
+static void indicators_deque_push(indicator_deque_t *deque, uint32_t seq, fixed_t price, bool keep_min) {
+	while(deque->count > 0) {
+		const indicator_sample_t *back = &deque->samples[(deque->head + deque->count - 1) % INDICATOR_WINDOW];
+		if(keep_min ? (back->price < price) : (back->price > price)) {
+			break;
+		}
+		deque->count--;
+	}
+
+	if(deque->count > 0 && seq - deque->samples[deque->head].seq >= INDICATOR_WINDOW) {
+		deque->head = (deque->head + 1) % INDICATOR_WINDOW;
+		deque->count--;
+	}
+
+	deque->samples[(deque->head + deque->count) % INDICATOR_WINDOW].seq = seq;
+	deque->samples[(deque->head + deque->count) % INDICATOR_WINDOW].price = price;
+	deque->count++;
+}
+
+/*******************************************************************************
+ * Function Name: indicators_deque_front
+ *******************************************************************************
+ * Summary:
+ *  Current extreme of the window.
+ *
+ *******************************************************************************/
+static fixed_t indicators_deque_front(const indicator_deque_t *deque) {
+	return deque->samples[deque->head].price;
+}
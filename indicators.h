@@ -0,0 +1,78 @@
+/******************************************************************************
+* File Name:   indicators.h
+*
+* Description: This file contains declarations for the per-symbol indicator
+* engine. Every statistic is updated from the new tick alone in O(1), nothing
+* is recomputed over the history.
+*
+*******************************************************************************/
+
+#ifndef INDICATORS_H_
+#define INDICATORS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "fixed_point.h"
+#include "quote.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Ticks in the SMA and rolling min/max window */
+#ifndef INDICATOR_WINDOW
+#define INDICATOR_WINDOW (20)
+#endif
+
+/* EMA period, smoothing factor 2 / (period + 1) */
+#ifndef INDICATOR_EMA_PERIOD
+#define INDICATOR_EMA_PERIOD (12)
+#endif
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+typedef struct {
+	fixed_t ema;
+	fixed_t sma;                  // Over the last INDICATOR_WINDOW ticks (fewer at the start)
+	fixed_t min;                  // Rolling, same window
+	fixed_t max;
+	fixed_t vwap;                 // Today's volume weighted average price, if has_vwap
+	fixed_t from_open_percent;    // Price against today's open
+	bool has_vwap;
+} indicator_values_t;
+
+typedef struct {
+	uint32_t seq;    // Tick number the sample was taken at
+	fixed_t price;
+} indicator_sample_t;
+
+// Monotonic deque over the window, front is the current extreme
+typedef struct {
+	indicator_sample_t samples[INDICATOR_WINDOW];
+	uint32_t head;
+	uint32_t count;
+} indicator_deque_t;
+
+typedef struct {
+	char symbol[QUOTE_SYMBOL_LEN];
+	time_t last_time;
+	uint32_t seq;                          // Ticks seen
+	fixed_t window[INDICATOR_WINDOW];      // Last prices for the SMA
+	int64_t window_sum;
+	indicator_deque_t min_deque;
+	indicator_deque_t max_deque;
+	int64_t volume_last;                   // Cumulative day volume at the last tick, in shares
+	int64_t price_volume_sum;              // Sum of price * traded shares, in fixed_t * shares
+	int64_t volume_sum;
+	indicator_values_t values;
+} indicator_state_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+void indicators_reset(indicator_state_t *state, const char *symbol);
+bool indicators_update(indicator_state_t *state, const quote_t *quote, int volume_extra);
+
+#endif /* INDICATORS_H_ */
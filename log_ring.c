@@ -0,0 +1,141 @@
+/******************************************************************************
+* File Name:   log_ring.c
+*
+* Description: This file contains the log ring and its drain task. Writers
+* claim a slot by advancing the write index with a compare-and-swap, fill it
+* and publish it by storing its sequence number last; the drain task, the
+* only reader, prints slots in order as they are published. A full ring drops
+* the new message and counts it rather than block the writer.
+*
+*******************************************************************************/
+
+/* Header file includes. */
+#include "cy_pdl.h"
+#include "cyhal.h"
+
+/* FreeRTOS header file. */
+#include <FreeRTOS.h>
+#include <task.h>
+
+/* Standard C header file. */
+#include <stdarg.h>
+#include <stdio.h>
+
+#include "log_ring.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* How often the drain task empties the ring */
+#define LOG_DRAIN_MS (20)
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+static log_record_t records[LOG_RING_RECORDS];
+static uint32_t writeIndex = 0;
+static uint32_t readIndex = 0;
+static uint32_t dropped = 0;
+
+static const char levelNames[] = "-EWID";
+
+/*******************************************************************************
+ * Function Name: log_ring_write
+ *******************************************************************************
+ * Summary:
+ *  Queues one message, called through the LOG_* macros. Safe from any task;
+ *  never blocks.
+ *
+ * Parameters:
+ *  uint32_t level : LOG_LEVEL_* of the message
+ *  const char *format : printf format, must outlive the message
+ *  uint32_t count : number of word sized arguments that follow
+ *
+ *******************************************************************************/
+void log_ring_write(uint32_t level, const char *format, uint32_t count, ...) {
+	uint32_t index = __atomic_load_n(&writeIndex, __ATOMIC_RELAXED);
+	log_record_t *record;
+	va_list args;
+
+	do {
+		if(index - __atomic_load_n(&readIndex, __ATOMIC_ACQUIRE) >= LOG_RING_RECORDS) {
+			__atomic_fetch_add(&dropped, 1, __ATOMIC_RELAXED);
+			return;
+		}
+	} while(!__atomic_compare_exchange_n(&writeIndex, &index, index + 1, true, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+
+	record = &records[index % LOG_RING_RECORDS];
+	record->tick = xTaskGetTickCount();
+	record->format = format;
+	record->level = (uint8_t)level;
+	record->count = (uint8_t)((count < LOG_ARGS_MAX) ? count : LOG_ARGS_MAX);
+
+	va_start(args, count);
+	for(uint32_t i = 0; i < record->count; i++) {
+		record->args[i] = va_arg(args, uintptr_t);
+	}
+	va_end(args);
+
+	__atomic_store_n(&record->seq, index + 1, __ATOMIC_RELEASE);
+}
+
+/*******************************************************************************
+ * Function Name: log_ring_read
+ *******************************************************************************
+ * Summary:
+ *  Takes the oldest message off the ring. Only the drain task reads.
+ *
+ * Return:
+ *  bool : false if the next message is not published yet
+ *
+ *******************************************************************************/
+bool log_ring_read(log_record_t *record) {
+	log_record_t *slot = &records[readIndex % LOG_RING_RECORDS];
+
+	if(__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != readIndex + 1) {
+		return false;
+	}
+
+	*record = *slot;
+	__atomic_store_n(&readIndex, readIndex + 1, __ATOMIC_RELEASE);
+	return true;
+}
+
+/*******************************************************************************
+ * Function Name: log_ring_task
+ *******************************************************************************
+ * Summary:
+ *  Formats and prints queued messages, one line each prefixed with the level
+ *  and the tick they were logged at, and reports messages dropped on a full
+ *  ring.
+ *
+ * Parameters:
+ *  void *args : Task parameter defined during task creation (unused).
+ *
+ *******************************************************************************/
+void log_ring_task(void *arg) {
+	log_record_t record;
+	uint32_t reported = 0;
+
+	(void)arg;
+
+	while(1) {
+		uint32_t lost;
+
+		while(log_ring_read(&record)) {
+			uintptr_t *a = record.args;
+
+			printf("%c %lu ", levelNames[(record.level <= LOG_LEVEL_DEBUG) ? record.level : 0], (unsigned long)record.tick);
+			printf(record.format, a[0], a[1], a[2], a[3], a[4], a[5], a[6], a[7]);
+			printf("\n");
+		}
+
+		lost = __atomic_load_n(&dropped, __ATOMIC_RELAXED);
+		if(lost != reported) {
+			printf("W log: %lu messages dropped\n", (unsigned long)(lost - reported));
+			reported = lost;
+		}
+
+		vTaskDelay(pdMS_TO_TICKS(LOG_DRAIN_MS));
+	}
+}
@@ -0,0 +1,99 @@
+/******************************************************************************
+* File Name:   log_ring.h
+*
+* Description: This file contains the leveled logging macros. Levels above
+* LOG_LEVEL compile to nothing, arguments included. An enabled message is
+* not formatted where it is logged: its format pointer and raw argument words
+* are put in a lock-free ring, and a task at idle priority formats and
+* prints them later, so the UART never stalls the caller.
+*
+* Because formatting is deferred, arguments must be 32 bit integers or
+* pointers to strings that outlive the message (literals, static tables).
+* No 64 bit integers, doubles or stack buffers. Each is kept in a word the
+* size of a pointer, so a string survives the host build's 64 bit pointers.
+*
+*******************************************************************************/
+
+#ifndef LOG_RING_H_
+#define LOG_RING_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define LOG_LEVEL_NONE  (0)
+#define LOG_LEVEL_ERROR (1)
+#define LOG_LEVEL_WARN  (2)
+#define LOG_LEVEL_INFO  (3)
+#define LOG_LEVEL_DEBUG (4)
+
+/* Most verbose level compiled in, release builds keep warnings and errors only */
+#ifndef LOG_LEVEL
+#ifdef NDEBUG
+#define LOG_LEVEL LOG_LEVEL_WARN
+#else
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+#endif
+
+/* Messages buffered between the callers and the drain task, a power of two */
+#define LOG_RING_RECORDS (64)
+
+/* Arguments a message can carry */
+#define LOG_ARGS_MAX (8)
+
+/* Number of arguments, 0 to LOG_ARGS_MAX */
+#define LOG_COUNT(...)                                       LOG_COUNT_(0, ##__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define LOG_COUNT_(_0, _1, _2, _3, _4, _5, _6, _7, _8, n, ...) (n)
+
+/* A level that is compiled out still sees its arguments, so variables only
+ * logged do not warn as unused, but never evaluates them or emits any code.
+ */
+#define LOG_DISABLED(format, ...) ((void)(0 ? log_ring_write(0, (format), 0, ##__VA_ARGS__) : (void)0))
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(format, ...) log_ring_write(LOG_LEVEL_ERROR, (format), LOG_COUNT(__VA_ARGS__), ##__VA_ARGS__)
+#else
+#define LOG_ERROR(format, ...) LOG_DISABLED(format, ##__VA_ARGS__)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(format, ...) log_ring_write(LOG_LEVEL_WARN, (format), LOG_COUNT(__VA_ARGS__), ##__VA_ARGS__)
+#else
+#define LOG_WARN(format, ...) LOG_DISABLED(format, ##__VA_ARGS__)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(format, ...) log_ring_write(LOG_LEVEL_INFO, (format), LOG_COUNT(__VA_ARGS__), ##__VA_ARGS__)
+#else
+#define LOG_INFO(format, ...) LOG_DISABLED(format, ##__VA_ARGS__)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(format, ...) log_ring_write(LOG_LEVEL_DEBUG, (format), LOG_COUNT(__VA_ARGS__), ##__VA_ARGS__)
+#else
+#define LOG_DEBUG(format, ...) LOG_DISABLED(format, ##__VA_ARGS__)
+#endif
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+typedef struct {
+	uint32_t seq;       // Ring index + 1 once the record is complete
+	uint32_t tick;
+	const char *format;
+	uint8_t level;
+	uint8_t count;
+	uintptr_t args[LOG_ARGS_MAX];    // Integers and string pointers, one word each
+} log_record_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+void log_ring_write(uint32_t level, const char *format, uint32_t count, ...);
+bool log_ring_read(log_record_t *record);
+void log_ring_task(void *arg);
+
+#endif /* LOG_RING_H_ */
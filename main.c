@@ -52,12 +52,33 @@
 /* TCP client task header file. */
 #include "http_client.h"
 
+/* Decode and display tasks, and the channels between them. */
+#include "pipeline.h"
+#include "display.h"
+
+/* Pools and per-task tags behind malloc. */
+#include "mem_pool.h"
+
+/* Phase latency histograms and per-task CPU, dumped over the debug UART. */
+#include "metrics.h"
+
+/* Leveled logging, printed by a task of its own. */
+#include "log_ring.h"
+
 /*******************************************************************************
 * Macros
 ********************************************************************************/
 /* RTOS related macros. */
 #define HTTP_CLIENT_TASK_STACK_SIZE (5 * 1024)
 #define HTTP_CLIENT_TASK_PRIORITY   (1)
+#define DECODE_TASK_STACK_SIZE      (2 * 1024)
+#define DECODE_TASK_PRIORITY        (2)
+#define DISPLAY_TASK_STACK_SIZE     (2 * 1024)
+#define DISPLAY_TASK_PRIORITY       (3)    // Highest, so a redraw is never queued behind a fetch or a parse
+#define METRICS_TASK_STACK_SIZE     (1024)
+#define METRICS_TASK_PRIORITY       (0)    // Idle priority, a dump never delays real work
+#define LOG_TASK_STACK_SIZE         (1024)
+#define LOG_TASK_PRIORITY           (0)    // Idle priority, the UART never holds up a logging task
 
 /*******************************************************************************
 * Global Variables
@@ -65,9 +86,22 @@
 /* This enables RTOS aware debugging. */
 volatile int uxTopUsedPriority;
 
+/* Price alert rules, compiled once when the pipeline is created. */
+static const alert_rule_t alertRules[] = {ALERT_RULES};
+
 /* HTTP Client task handle. */
 TaskHandle_t client_task_handle;
 
+/* Decode and display task handles. */
+TaskHandle_t decode_task_handle;
+TaskHandle_t display_task_handle;
+
+/* Metrics dump task handle. */
+TaskHandle_t metrics_task_handle;
+
+/* Log drain task handle. */
+TaskHandle_t log_task_handle;
+
 /*******************************************************************************
 * Function Name: main
 ********************************************************************************
@@ -104,9 +138,29 @@ int main(void) {
 	/* \x1b[2J\x1b[;H - ANSI ESC sequence to clear screen. */
 	printf("\x1b[2J\x1b[;H");
 
+	/* Create the queues between the tasks before any of them runs. */
+	pipeline_init(alertRules, sizeof(alertRules) / sizeof(alertRules[0]));
+
 	/* Create the client task. */
 	xTaskCreate(http_client_task, "Network task", HTTP_CLIENT_TASK_STACK_SIZE, NULL, HTTP_CLIENT_TASK_PRIORITY, &client_task_handle);
 
+	/* Create the decode task, it wakes the client task for an early fetch when an alert fires. */
+	xTaskCreate(quote_decode_task, "Decode task", DECODE_TASK_STACK_SIZE, client_task_handle, DECODE_TASK_PRIORITY, &decode_task_handle);
+
+	/* Create the display task. */
+	xTaskCreate(display_task, "Display task", DISPLAY_TASK_STACK_SIZE, NULL, DISPLAY_TASK_PRIORITY, &display_task_handle);
+
+	/* Create the metrics task, any key on the debug UART dumps the metrics. */
+	xTaskCreate(metrics_task, "Metrics task", METRICS_TASK_STACK_SIZE, NULL, METRICS_TASK_PRIORITY, &metrics_task_handle);
+
+	/* Create the log drain task. */
+	xTaskCreate(log_ring_task, "Log task", LOG_TASK_STACK_SIZE, NULL, LOG_TASK_PRIORITY, &log_task_handle);
+
+	/* Charge each task's allocations to its own tag. */
+	mem_pool_register_task(client_task_handle, MEM_TAG_NETWORK);
+	mem_pool_register_task(decode_task_handle, MEM_TAG_DECODE);
+	mem_pool_register_task(display_task_handle, MEM_TAG_DISPLAY);
+
 	/* Start the FreeRTOS scheduler. */
 	vTaskStartScheduler();
 
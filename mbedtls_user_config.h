@@ -378,7 +378,7 @@
  *
  * Comment this macro to disable support for SSL session tickets
  */
-#undef MBEDTLS_SSL_SESSION_TICKETS
+//#undef MBEDTLS_SSL_SESSION_TICKETS
 
 /**
  * \def MBEDTLS_SSL_EXPORT_KEYS
@@ -0,0 +1,396 @@
+/******************************************************************************
+* File Name:   mem_pool.c
+*
+* Description: This file contains the memory subsystem. Each block starts with
+* a small header naming its pool and tag, so free needs no lookup. Pools are
+* singly linked free lists, O(1) both ways and immune to fragmentation; a
+* request no pool can take goes to heap_4, whose region is defined here so
+* blocks from the C library's own heap can be told apart and passed through.
+*
+*******************************************************************************/
+
+/* Header file includes. */
+#include "cyhal.h"
+
+/* Standard C header file. */
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "mem_pool.h"
+#include "log_ring.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Pool blocks including their headers, must cover MEM_POOL_SIZES x MEM_POOL_BLOCKS */
+#define MEM_POOL_STORAGE_BYTES (25 * 1024)
+
+#define MEM_POOL_HEAP (MEM_POOL_COUNT)    // Header pool index of a heap_4 block
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+typedef struct {
+	uint32_t size;    // Requested bytes
+	uint8_t tag;
+	uint8_t pool;
+	uint16_t reserved;
+} mem_header_t;    // 8 bytes, keeps the payload 8 byte aligned
+
+typedef struct mem_free_block {
+	struct mem_free_block *next;
+} mem_free_block_t;
+
+typedef struct {
+	uint32_t size;
+	uint32_t blocks;
+	mem_free_block_t *free_list;
+	uint32_t used;
+	uint32_t peak;
+	uint32_t misses;    // Requests that fell through to the heap because the pool was empty
+} mem_pool_t;
+
+typedef struct {
+	TaskHandle_t task;
+	mem_tag_t tag;
+} mem_task_tag_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+void *__real_malloc(size_t size);
+void __real_free(void *ptr);
+void *__real_realloc(void *ptr, size_t size);
+void *__wrap_malloc(size_t size);
+void __wrap_free(void *ptr);
+void *__wrap_calloc(size_t count, size_t size);
+void *__wrap_realloc(void *ptr, size_t size);
+void vApplicationMallocFailedHook(void);
+
+static void mem_pool_init(void);
+static bool mem_pool_owns(const void *ptr);
+static mem_tag_t mem_pool_current_tag(void);
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+/* heap_4 region, configAPPLICATION_ALLOCATED_HEAP is set so it can be range checked */
+uint8_t ucHeap[configTOTAL_HEAP_SIZE];
+
+static uint64_t poolStorage[MEM_POOL_STORAGE_BYTES / sizeof(uint64_t)];
+static mem_pool_t pools[MEM_POOL_COUNT];
+static bool poolsReady = false;
+
+static mem_task_tag_t taskTags[MEM_POOL_MAX_TASKS];
+static mem_tag_stats_t tagStats[MEM_TAG_COUNT];
+static mem_tag_t heapTag = MEM_TAG_SYSTEM;    // Charged by the malloc failed hook
+
+static const char *const tagNames[MEM_TAG_COUNT] = {"system", "network", "tls", "decode", "display"};
+
+/*******************************************************************************
+ * Function Name: mem_pool_register_task
+ *******************************************************************************
+ * Summary:
+ *  Charges a task's allocations to a tag. Tasks never registered are charged
+ *  to MEM_TAG_SYSTEM.
+ *
+ *******************************************************************************/
+void mem_pool_register_task(TaskHandle_t task, mem_tag_t tag) {
+	for(uint32_t i = 0; i < MEM_POOL_MAX_TASKS; i++) {
+		if(taskTags[i].task == NULL || taskTags[i].task == task) {
+			taskTags[i].task = task;
+			taskTags[i].tag = tag;
+			return;
+		}
+	}
+}
+
+/*******************************************************************************
+ * Function Name: mem_pool_set_tag
+ *******************************************************************************
+ * Summary:
+ *  Changes the tag of the calling task, to charge one piece of work (a TLS
+ *  handshake) separately. The calling task must be registered.
+ *
+ * Return:
+ *  mem_tag_t : the previous tag, to restore afterwards
+ *
+ *******************************************************************************/
+mem_tag_t mem_pool_set_tag(mem_tag_t tag) {
+	TaskHandle_t self = xTaskGetCurrentTaskHandle();
+
+	for(uint32_t i = 0; i < MEM_POOL_MAX_TASKS; i++) {
+		if(taskTags[i].task == self && self != NULL) {
+			mem_tag_t previous = taskTags[i].tag;
+			taskTags[i].tag = tag;
+			return previous;
+		}
+	}
+
+	return MEM_TAG_SYSTEM;
+}
+
+/*******************************************************************************
+ * Function Name: mem_pool_alloc
+ *******************************************************************************
+ * Summary:
+ *  Takes a block from the smallest pool that fits, or from heap_4 when the
+ *  request is too big or that pool is empty.
+ *
+ *******************************************************************************/
+void *mem_pool_alloc(size_t size) {
+	mem_tag_t tag = mem_pool_current_tag();
+	mem_header_t *header = NULL;
+	uint32_t pool = 0;
+
+	vTaskSuspendAll();
+
+	if(!poolsReady) {
+		mem_pool_init();
+	}
+
+	while(pool < MEM_POOL_COUNT && pools[pool].size < size) {
+		pool++;
+	}
+	if(pool < MEM_POOL_COUNT && pools[pool].free_list == NULL) {
+		pools[pool].misses++;
+		pool = MEM_POOL_HEAP;
+	}
+
+	if(pool < MEM_POOL_COUNT) {
+		header = (mem_header_t *)pools[pool].free_list;
+		pools[pool].free_list = pools[pool].free_list->next;
+		pools[pool].used++;
+		pools[pool].peak = (pools[pool].used > pools[pool].peak) ? pools[pool].used : pools[pool].peak;
+	} else {
+		heapTag = tag;
+		header = (mem_header_t *)pvPortMalloc(sizeof(mem_header_t) + size);
+	}
+
+	if(header != NULL) {
+		header->size = (uint32_t)size;
+		header->tag = (uint8_t)tag;
+		header->pool = (uint8_t)pool;
+
+		tagStats[tag].current += (uint32_t)size;
+		tagStats[tag].peak = (tagStats[tag].current > tagStats[tag].peak) ? tagStats[tag].current : tagStats[tag].peak;
+		tagStats[tag].allocs++;
+	}
+
+	(void)xTaskResumeAll();
+
+	return (header != NULL) ? (void *)(header + 1) : NULL;
+}
+
+/*******************************************************************************
+ * Function Name: mem_pool_free
+ *******************************************************************************
+ * Summary:
+ *  Returns a block from mem_pool_alloc to where it came from.
+ *
+ *******************************************************************************/
+void mem_pool_free(void *ptr) {
+	mem_header_t *header = (mem_header_t *)ptr - 1;
+	uint32_t pool = header->pool;
+
+	vTaskSuspendAll();
+
+	tagStats[header->tag].current -= header->size;
+	tagStats[header->tag].frees++;
+
+	if(pool < MEM_POOL_COUNT) {
+		mem_free_block_t *block = (mem_free_block_t *)header;
+		block->next = pools[pool].free_list;
+		pools[pool].free_list = block;
+		pools[pool].used--;
+	} else {
+		vPortFree(header);
+	}
+
+	(void)xTaskResumeAll();
+}
+
+/*******************************************************************************
+ * Function Name: mem_pool_get_stats
+ *******************************************************************************
+ * Summary:
+ *  Copies the counters of one tag.
+ *
+ *******************************************************************************/
+void mem_pool_get_stats(mem_tag_t tag, mem_tag_stats_t *stats) {
+	vTaskSuspendAll();
+	*stats = tagStats[tag];
+	(void)xTaskResumeAll();
+}
+
+/*******************************************************************************
+ * Function Name: mem_pool_print_stats
+ *******************************************************************************
+ * Summary:
+ *  Prints every tag and pool, and the heap_4 watermark. A steady state shows
+ *  the same live block count after every fetch.
+ *
+ *******************************************************************************/
+void mem_pool_print_stats(void) {
+	for(uint32_t i = 0; i < MEM_TAG_COUNT; i++) {
+		mem_tag_stats_t stats;
+
+		mem_pool_get_stats((mem_tag_t)i, &stats);
+		LOG_DEBUG("Mem %-7s: %6lu B now, %6lu B peak, %4lu live, %lu failed", tagNames[i], (unsigned long)stats.current,
+				  (unsigned long)stats.peak, (unsigned long)(stats.allocs - stats.frees), (unsigned long)stats.failed);
+	}
+	for(uint32_t i = 0; i < MEM_POOL_COUNT; i++) {
+		LOG_DEBUG("Pool %4lu B: %2lu/%2lu used, %2lu peak, %lu misses", (unsigned long)pools[i].size, (unsigned long)pools[i].used,
+				  (unsigned long)pools[i].blocks, (unsigned long)pools[i].peak, (unsigned long)pools[i].misses);
+	}
+	LOG_DEBUG("Heap: %lu B free, %lu B lowest", (unsigned long)xPortGetFreeHeapSize(), (unsigned long)xPortGetMinimumEverFreeHeapSize());
+}
+
+/*******************************************************************************
+ * Function Name: __wrap_malloc, __wrap_free, __wrap_calloc, __wrap_realloc
+ *******************************************************************************
+ * Summary:
+ *  Link time wrappers routing the C allocator to the pools. Blocks the C
+ *  library allocated itself (printf buffers, strdup) still go back to it.
+ *
+ *******************************************************************************/
+void *__wrap_malloc(size_t size) {
+	return mem_pool_alloc(size);
+}
+
+void __wrap_free(void *ptr) {
+	if(ptr == NULL) {
+		return;
+	}
+	if(!mem_pool_owns(ptr)) {
+		__real_free(ptr);
+		return;
+	}
+
+	mem_pool_free(ptr);
+}
+
+void *__wrap_calloc(size_t count, size_t size) {
+	void *ptr;
+
+	if(size != 0 && count > SIZE_MAX / size) {
+		return NULL;
+	}
+
+	ptr = mem_pool_alloc(count * size);
+	if(ptr != NULL) {
+		(void)memset(ptr, 0, count * size);
+	}
+
+	return ptr;
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+	void *grown;
+	uint32_t old;
+
+	if(ptr != NULL && !mem_pool_owns(ptr)) {
+		return __real_realloc(ptr, size);
+	}
+	if(ptr == NULL) {
+		return mem_pool_alloc(size);
+	}
+	if(size == 0) {
+		mem_pool_free(ptr);
+		return NULL;
+	}
+
+	old = ((mem_header_t *)ptr - 1)->size;
+	grown = mem_pool_alloc(size);
+	if(grown != NULL) {
+		(void)memcpy(grown, ptr, (old < size) ? old : size);
+		mem_pool_free(ptr);
+	}
+
+	return grown;
+}
+
+/*******************************************************************************
+ * Function Name: vApplicationMallocFailedHook
+ *******************************************************************************
+ * Summary:
+ *  Called by heap_4 when it runs out. The failure is charged to the tag of
+ *  the request that fell through to it.
+ *
+ *******************************************************************************/
+void vApplicationMallocFailedHook(void) {
+	// Runs inside an allocation with the scheduler suspended, so no printf here
+	tagStats[heapTag].failed++;
+}
+
+/*******************************************************************************
+ * Function Name: mem_pool_init
+ *******************************************************************************
+ * Summary:
+ *  Carves the pool storage into blocks and threads the free lists. Runs on
+ *  the first allocation, with the scheduler suspended.
+ *
+ *******************************************************************************/
+static void mem_pool_init(void) {
+	static const uint32_t sizes[MEM_POOL_COUNT] = MEM_POOL_SIZES;
+	static const uint32_t blocks[MEM_POOL_COUNT] = MEM_POOL_BLOCKS;
+	uint8_t *next = (uint8_t *)poolStorage;
+
+	for(uint32_t i = 0; i < MEM_POOL_COUNT; i++) {
+		uint32_t stride = sizeof(mem_header_t) + sizes[i];
+
+		pools[i].size = sizes[i];
+		pools[i].blocks = blocks[i];
+		pools[i].free_list = NULL;
+
+		CY_ASSERT(next + blocks[i] * stride <= (uint8_t *)poolStorage + sizeof(poolStorage));
+		for(uint32_t b = blocks[i]; b > 0; b--) {
+			mem_free_block_t *block = (mem_free_block_t *)(next + (b - 1) * stride);
+			block->next = pools[i].free_list;
+			pools[i].free_list = block;
+		}
+		next += blocks[i] * stride;
+	}
+
+	poolsReady = true;
+}
+
+/*******************************************************************************
+ * Function Name: mem_pool_owns
+ *******************************************************************************
+ * Summary:
+ *  True if a pointer lies in the pools or the heap_4 region.
+ *
+ *******************************************************************************/
+static bool mem_pool_owns(const void *ptr) {
+	const uint8_t *p = (const uint8_t *)ptr;
+
+	return (p >= (const uint8_t *)poolStorage && p < (const uint8_t *)poolStorage + sizeof(poolStorage)) ||
+		   (p >= ucHeap && p < ucHeap + sizeof(ucHeap));
+}
+
+/*******************************************************************************
+ * Function Name: mem_pool_current_tag
+ *******************************************************************************
+ * Summary:
+ *  Tag of the calling task, MEM_TAG_SYSTEM before the scheduler starts.
+ *
+ *******************************************************************************/
+static mem_tag_t mem_pool_current_tag(void) {
+	TaskHandle_t self;
+
+	// Before the start the current task is just the highest priority one created
+	if(xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED) {
+		return MEM_TAG_SYSTEM;
+	}
+	self = xTaskGetCurrentTaskHandle();
+
+	for(uint32_t i = 0; i < MEM_POOL_MAX_TASKS; i++) {
+		if(taskTags[i].task == self) {
+			return taskTags[i].tag;
+		}
+	}
+
+	return MEM_TAG_SYSTEM;
+}
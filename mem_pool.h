@@ -0,0 +1,63 @@
+/******************************************************************************
+* File Name:   mem_pool.h
+*
+* Description: This file contains declarations for the memory subsystem.
+* malloc, calloc, realloc and free are wrapped at link time so every library
+* (mbedTLS, lwIP, the HTTP client) allocates from fixed-block pools for the
+* small hot sizes and from the FreeRTOS heap_4 region for the rest. Every
+* allocation is charged to a tag, by default the tag of the calling task.
+*
+*******************************************************************************/
+
+#ifndef MEM_POOL_H_
+#define MEM_POOL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* FreeRTOS header file. */
+#include <FreeRTOS.h>
+#include <task.h>
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Payload size and block count of each pool, smallest first */
+#define MEM_POOL_SIZES  {32, 64, 128, 256, 512}
+#define MEM_POOL_BLOCKS {64, 48, 32, 24, 16}
+#define MEM_POOL_COUNT  (5)
+
+/* Tasks that get their own tag */
+#define MEM_POOL_MAX_TASKS (4)
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+typedef enum {
+	MEM_TAG_SYSTEM,     // lwIP, Wi-Fi and anything else not registered
+	MEM_TAG_NETWORK,    // Network task: HTTP client and TLS record layer
+	MEM_TAG_TLS,        // TLS handshakes
+	MEM_TAG_DECODE,
+	MEM_TAG_DISPLAY,
+	MEM_TAG_COUNT
+} mem_tag_t;
+
+typedef struct {
+	uint32_t current;    // Bytes held now
+	uint32_t peak;
+	uint32_t allocs;
+	uint32_t frees;
+	uint32_t failed;     // Requests neither a pool nor the heap could serve
+} mem_tag_stats_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+void mem_pool_register_task(TaskHandle_t task, mem_tag_t tag);
+mem_tag_t mem_pool_set_tag(mem_tag_t tag);
+void *mem_pool_alloc(size_t size);
+void mem_pool_free(void *ptr);
+void mem_pool_get_stats(mem_tag_t tag, mem_tag_stats_t *stats);
+void mem_pool_print_stats(void);
+
+#endif /* MEM_POOL_H_ */
@@ -0,0 +1,239 @@
+/******************************************************************************
+* File Name:   metrics.c
+*
+* Description: This file contains the latency and CPU metrics. Timestamps are
+* raw reads of the DWT cycle counter, a single load, so the timed code pays
+* nothing measurable; each phase has one writer task and keeps its own
+* histogram. The dump, one CSV record per line, is:
+*
+*   metrics,<uptime ms>,<core MHz>
+*   phase,<name>,<count>,<mean us>,<max us>,<bucket 0>,...,<bucket 15>
+*   task,<name>,<CPU permille since the last dump>,<stack never used, bytes>
+*   freshness,...    (see freshness.c)
+*   end
+*
+*******************************************************************************/
+
+/* Header file includes. */
+#include "cy_pdl.h"
+#include "cyhal.h"
+#include "cy_retarget_io.h"
+
+/* FreeRTOS header file. */
+#include <FreeRTOS.h>
+#include <task.h>
+
+/* Standard C header file. */
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "metrics.h"
+#include "freshness.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* How often the metrics task looks for a key press. It also keeps the
+ * extended run time counter sampled well within one cycle counter wrap.
+ */
+#define METRICS_POLL_MS (100)
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+static metrics_histogram_t histograms[METRICS_PHASE_COUNT];
+
+static const char *const phaseNames[METRICS_PHASE_COUNT] = {"dns", "tcp", "tls", "send", "first_byte", "body", "parse", "render"};
+
+/*******************************************************************************
+ * Function Name: metrics_init_cycle_counter
+ *******************************************************************************
+ * Summary:
+ *  Starts the DWT cycle counter. Called by the kernel as
+ *  portCONFIGURE_TIMER_FOR_RUN_TIME_STATS when the scheduler starts.
+ *
+ *******************************************************************************/
+void metrics_init_cycle_counter(void) {
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+/*******************************************************************************
+ * Function Name: metrics_now
+ *******************************************************************************
+ * Summary:
+ *  Current cycle count, the start of a phase passed to metrics_record. It
+ *  wraps every 2^32 cycles, about half a minute, so phases must be shorter.
+ *
+ *******************************************************************************/
+uint32_t metrics_now(void) {
+	return DWT->CYCCNT;
+}
+
+/*******************************************************************************
+ * Function Name: metrics_record
+ *******************************************************************************
+ * Summary:
+ *  Ends a phase started at start.
+ *
+ * Return:
+ *  uint32_t : cycles the phase took
+ *
+ *******************************************************************************/
+uint32_t metrics_record(metrics_phase_t phase, uint32_t start) {
+	uint32_t cycles = metrics_now() - start;
+
+	metrics_record_cycles(phase, cycles);
+	return cycles;
+}
+
+/*******************************************************************************
+ * Function Name: metrics_record_cycles
+ *******************************************************************************
+ * Summary:
+ *  Adds one phase duration to its histogram.
+ *
+ *******************************************************************************/
+void metrics_record_cycles(metrics_phase_t phase, uint32_t cycles) {
+	metrics_histogram_t *histogram = &histograms[phase];
+	uint32_t us = cycles / (SystemCoreClock / 1000000u);
+	int bucket = 0;
+
+	while(bucket < METRICS_BUCKET_COUNT - 1 && us >= ((uint32_t)METRICS_BUCKET_US << bucket)) {
+		bucket++;
+	}
+
+	histogram->count++;
+	histogram->total_cycles += cycles;
+	histogram->max_cycles = (cycles > histogram->max_cycles) ? cycles : histogram->max_cycles;
+	histogram->last_cycles = cycles;
+	histogram->buckets[bucket]++;
+}
+
+/*******************************************************************************
+ * Function Name: metrics_last
+ *******************************************************************************
+ * Summary:
+ *  Duration of the latest sample of a phase, in cycles.
+ *
+ *******************************************************************************/
+uint32_t metrics_last(metrics_phase_t phase) {
+	return histograms[phase].last_cycles;
+}
+
+/*******************************************************************************
+ * Function Name: metrics_run_time
+ *******************************************************************************
+ * Summary:
+ *  The run time stats clock, portGET_RUN_TIME_COUNTER_VALUE. The cycle
+ *  counter is extended to 64 bits on every call; the kernel only calls this
+ *  at context switches and with the scheduler suspended, so calls never
+ *  overlap.
+ *
+ *******************************************************************************/
+uint32_t metrics_run_time(void) {
+	static uint32_t lastCycles = 0;
+	static uint64_t totalCycles = 0;
+	uint32_t now = metrics_now();
+
+	totalCycles += now - lastCycles;
+	lastCycles = now;
+
+	return (uint32_t)(totalCycles >> METRICS_RUN_TIME_SHIFT);
+}
+
+/*******************************************************************************
+ * Function Name: metrics_dump
+ *******************************************************************************
+ * Summary:
+ *  Prints the phase histograms, per task CPU share and stack headroom and
+ *  the quote freshness percentiles in the CSV format described at the top
+ *  of this file.
+ *
+ *******************************************************************************/
+void metrics_dump(void) {
+	static metrics_histogram_t copy[METRICS_PHASE_COUNT];
+	static TaskStatus_t tasks[METRICS_MAX_TASKS];
+	static TaskHandle_t lastHandles[METRICS_MAX_TASKS];
+	static uint32_t lastRunTimes[METRICS_MAX_TASKS];
+	static uint32_t lastTotal = 0;
+	uint32_t cyclesPerUs = SystemCoreClock / 1000000u;
+	uint32_t total;
+	UBaseType_t count;
+
+	// Consistent copy, the writers run at higher priorities
+	vTaskSuspendAll();
+	for(int i = 0; i < METRICS_PHASE_COUNT; i++) {
+		copy[i] = histograms[i];
+	}
+	(void)xTaskResumeAll();
+
+	printf("metrics,%lu,%lu\n", (unsigned long)pdTICKS_TO_MS(xTaskGetTickCount()), (unsigned long)cyclesPerUs);
+
+	for(int i = 0; i < METRICS_PHASE_COUNT; i++) {
+		const metrics_histogram_t *h = &copy[i];
+		uint32_t mean = (h->count > 0) ? (uint32_t)(h->total_cycles / h->count / cyclesPerUs) : 0;
+
+		printf("phase,%s,%lu,%lu,%lu", phaseNames[i], (unsigned long)h->count, (unsigned long)mean, (unsigned long)(h->max_cycles / cyclesPerUs));
+		for(int b = 0; b < METRICS_BUCKET_COUNT; b++) {
+			printf(",%lu", (unsigned long)h->buckets[b]);
+		}
+		printf("\n");
+	}
+
+	count = uxTaskGetSystemState(tasks, METRICS_MAX_TASKS, &total);
+	for(UBaseType_t i = 0; i < count; i++) {
+		uint32_t previous = 0;
+		uint32_t permille;
+
+		for(int j = 0; j < METRICS_MAX_TASKS; j++) {
+			if(lastHandles[j] == tasks[i].xHandle) {
+				previous = lastRunTimes[j];
+				break;
+			}
+		}
+		permille = (total != lastTotal) ? (uint32_t)((uint64_t)(tasks[i].ulRunTimeCounter - previous) * 1000 / (total - lastTotal)) : 0;
+
+		printf("task,%s,%lu,%lu\n", tasks[i].pcTaskName, (unsigned long)permille,
+			   (unsigned long)(tasks[i].usStackHighWaterMark * sizeof(StackType_t)));
+	}
+	freshness_dump();
+	printf("end\n");
+
+	// The next dump reports the CPU share since this one
+	for(int j = 0; j < METRICS_MAX_TASKS; j++) {
+		lastHandles[j] = ((UBaseType_t)j < count) ? tasks[j].xHandle : NULL;
+		lastRunTimes[j] = ((UBaseType_t)j < count) ? tasks[j].ulRunTimeCounter : 0;
+	}
+	lastTotal = total;
+}
+
+/*******************************************************************************
+ * Function Name: metrics_task
+ *******************************************************************************
+ * Summary:
+ *  Dumps the metrics whenever a key arrives on the debug UART.
+ *
+ * Parameters:
+ *  void *args : Task parameter defined during task creation (unused).
+ *
+ *******************************************************************************/
+void metrics_task(void *arg) {
+	uint8_t key;
+	bool pressed;
+
+	(void)arg;
+
+	while(1) {
+		vTaskDelay(pdMS_TO_TICKS(METRICS_POLL_MS));
+
+		pressed = false;
+		while(cyhal_uart_readable(&cy_retarget_io_uart_obj) > 0 && cyhal_uart_getc(&cy_retarget_io_uart_obj, &key, 1) == CY_RSLT_SUCCESS) {
+			pressed = true;
+		}
+		if(pressed) {
+			metrics_dump();
+		}
+	}
+}
@@ -0,0 +1,67 @@
+/******************************************************************************
+* File Name:   metrics.h
+*
+* Description: This file contains declarations for the latency and CPU
+* metrics. Every phase of a fetch, from the DNS lookup to the redraw, is
+* timed with the core cycle counter into a fixed-bucket histogram; per task
+* CPU time comes from the FreeRTOS run time stats on the same counter. All of
+* it is dumped as CSV on the debug UART when any key is pressed.
+*
+*******************************************************************************/
+
+#ifndef METRICS_H_
+#define METRICS_H_
+
+#include <stdint.h>
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Phase histogram, bucket i counts samples below (METRICS_BUCKET_US << i) */
+#define METRICS_BUCKET_US    (100)
+#define METRICS_BUCKET_COUNT (16)    // Last bucket also takes everything slower, from 3.3 s
+
+/* Run time stats count in units of 2^METRICS_RUN_TIME_SHIFT cycles so the
+ * 32 bit task counters last hours instead of seconds.
+ */
+#define METRICS_RUN_TIME_SHIFT (10)
+
+/* Tasks listed in a dump */
+#define METRICS_MAX_TASKS (16)
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+typedef enum {
+	METRICS_PHASE_DNS,
+	METRICS_PHASE_TCP,           // TCP connect, the connect minus its TLS handshake
+	METRICS_PHASE_TLS,
+	METRICS_PHASE_SEND,          // Writing the request to the socket
+	METRICS_PHASE_FIRST_BYTE,    // Request sent to first response byte
+	METRICS_PHASE_BODY,          // First response byte to full response
+	METRICS_PHASE_PARSE,
+	METRICS_PHASE_RENDER,        // One card
+	METRICS_PHASE_COUNT
+} metrics_phase_t;
+
+typedef struct {
+	uint32_t count;
+	uint64_t total_cycles;
+	uint32_t max_cycles;
+	uint32_t last_cycles;
+	uint32_t buckets[METRICS_BUCKET_COUNT];
+} metrics_histogram_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+void metrics_init_cycle_counter(void);
+uint32_t metrics_now(void);
+uint32_t metrics_record(metrics_phase_t phase, uint32_t start);
+void metrics_record_cycles(metrics_phase_t phase, uint32_t cycles);
+uint32_t metrics_last(metrics_phase_t phase);
+uint32_t metrics_run_time(void);
+void metrics_dump(void);
+void metrics_task(void *arg);
+
+#endif /* METRICS_H_ */
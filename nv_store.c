@@ -0,0 +1,192 @@
+/******************************************************************************
+* File Name:   nv_store.c
+*
+* Description: This file contains the non-volatile record store. Slots live in
+* the .cy_em_eeprom section (auxiliary flash) so application flashing does not
+* wipe them. Reads go straight through the memory mapped flash, writes
+* rewrite the whole row.
+*
+*******************************************************************************/
+
+/* Header file includes. */
+#include "cyhal.h"
+#include "cybsp.h"
+
+/* Standard C header file. */
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "nv_store.h"
+#include "log_ring.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define NV_STORE_MAGIC (0x4E565331u)    // "NVS1"
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+typedef struct {
+	uint32_t magic;
+	uint16_t len;
+	uint16_t crc;    // Low half of the CRC-32 over the payload
+	uint8_t data[NV_STORE_RECORD_MAX_SIZE];
+} nv_store_record_t;
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+// Volatile: the flash driver writes it, reads must not be folded to the zero initializer
+CY_SECTION(".cy_em_eeprom") CY_ALIGN(NV_STORE_ROW_SIZE) static const volatile uint8_t nvStorage[NV_STORE_SLOT_COUNT][NV_STORE_ROW_SIZE] = {{0}};
+
+static cyhal_flash_t flashObj;
+static bool flashReady = false;
+
+/*******************************************************************************
+ * Function Name: nv_store_init
+ *******************************************************************************
+ * Summary:
+ *  Initializes the flash driver used for writes.
+ *
+ *******************************************************************************/
+cy_rslt_t nv_store_init(void) {
+	cy_rslt_t result;
+
+	if(flashReady) {
+		return CY_RSLT_SUCCESS;
+	}
+
+	result = cyhal_flash_init(&flashObj);
+	if(result != CY_RSLT_SUCCESS) {
+		LOG_ERROR("NV store flash init failed!");
+		return result;
+	}
+	flashReady = true;
+
+	return CY_RSLT_SUCCESS;
+}
+
+/*******************************************************************************
+ * Function Name: nv_store_read
+ *******************************************************************************
+ * Summary:
+ *  Copies the record held in a slot.
+ *
+ * Parameters:
+ *  nv_store_slot_t slot : slot to read
+ *  void *data : destination
+ *  size_t max_len : size of the destination
+ *
+ * Return:
+ *  size_t : length of the record, 0 if the slot is empty, corrupt or the
+ *  record does not fit
+ *
+ *******************************************************************************/
+size_t nv_store_read(nv_store_slot_t slot, void *data, size_t max_len) {
+	const nv_store_record_t *record = (const nv_store_record_t *)(uintptr_t)nvStorage[slot];
+
+	if(record->magic != NV_STORE_MAGIC || record->len > NV_STORE_RECORD_MAX_SIZE || record->len > max_len) {
+		return 0;
+	}
+	if((uint16_t)nv_store_crc32(0, record->data, record->len) != record->crc) {
+		return 0;
+	}
+
+	(void)memcpy(data, record->data, record->len);
+	return record->len;
+}
+
+/*******************************************************************************
+ * Function Name: nv_store_write
+ *******************************************************************************
+ * Summary:
+ *  Replaces the record held in a slot. Rows are only rewritten when the
+ *  content changes, to spare flash endurance.
+ *
+ *******************************************************************************/
+cy_rslt_t nv_store_write(nv_store_slot_t slot, const void *data, size_t len) {
+	static nv_store_record_t row;    // Row sized, kept off the caller's stack
+	const nv_store_record_t *current = (const nv_store_record_t *)(uintptr_t)nvStorage[slot];
+
+	if(len > NV_STORE_RECORD_MAX_SIZE || !flashReady) {
+		return NV_STORE_RSLT_ERR;
+	}
+
+	if(current->magic == NV_STORE_MAGIC && current->len == len && memcmp(current->data, data, len) == 0) {
+		return CY_RSLT_SUCCESS;
+	}
+
+	(void)memset(&row, 0, sizeof(row));
+	row.magic = NV_STORE_MAGIC;
+	row.len = (uint16_t)len;
+	row.crc = (uint16_t)nv_store_crc32(0, data, len);
+	(void)memcpy(row.data, data, len);
+
+	return cyhal_flash_write(&flashObj, (uint32_t)(uintptr_t)nvStorage[slot], (const uint32_t *)&row);
+}
+
+/*******************************************************************************
+ * Function Name: nv_store_erase
+ *******************************************************************************
+ * Summary:
+ *  Invalidates the record held in a slot.
+ *
+ *******************************************************************************/
+cy_rslt_t nv_store_erase(nv_store_slot_t slot) {
+	const nv_store_record_t *current = (const nv_store_record_t *)(uintptr_t)nvStorage[slot];
+
+	if(!flashReady) {
+		return NV_STORE_RSLT_ERR;
+	}
+	if(current->magic != NV_STORE_MAGIC) {
+		return CY_RSLT_SUCCESS;
+	}
+
+	return cyhal_flash_erase(&flashObj, (uint32_t)(uintptr_t)nvStorage[slot]);
+}
+
+/*******************************************************************************
+ * Function Name: nv_store_write_row
+ *******************************************************************************
+ * Summary:
+ *  Rewrites one whole flash row outside the slots, for stores that manage
+ *  their own rows (the quote log).
+ *
+ * Parameters:
+ *  const void *row_address : row aligned flash address
+ *  const void *row : NV_STORE_ROW_SIZE bytes, word aligned
+ *
+ *******************************************************************************/
+cy_rslt_t nv_store_write_row(const void *row_address, const void *row) {
+	if(!flashReady || ((uintptr_t)row_address % NV_STORE_ROW_SIZE) != 0) {
+		return NV_STORE_RSLT_ERR;
+	}
+
+	return cyhal_flash_write(&flashObj, (uint32_t)(uintptr_t)row_address, (const uint32_t *)row);
+}
+
+/*******************************************************************************
+ * Function Name: nv_store_crc32
+ *******************************************************************************
+ * Summary:
+ *  Bitwise CRC-32 (IEEE 802.3). Records are small, so no table is kept.
+ *
+ * Parameters:
+ *  uint32_t crc : 0 to start, or the result of a previous call to continue
+ *
+ *******************************************************************************/
+uint32_t nv_store_crc32(uint32_t crc, const void *data, size_t len) {
+	const uint8_t *bytes = (const uint8_t *)data;
+
+	crc = ~crc;
+	for(size_t i = 0; i < len; i++) {
+		crc ^= bytes[i];
+		for(int bit = 0; bit < 8; bit++) {
+			crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+		}
+	}
+
+	return ~crc;
+}
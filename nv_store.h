@@ -0,0 +1,46 @@
+/******************************************************************************
+* File Name:   nv_store.h
+*
+* Description: This file contains declarations for the small non-volatile
+* record store kept in the emulated EEPROM flash region. Every slot is one
+* flash row holding a single CRC-checked record.
+*
+*******************************************************************************/
+
+#ifndef NV_STORE_H_
+#define NV_STORE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cyhal.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define NV_STORE_ROW_SIZE        (CY_FLASH_SIZEOF_ROW)
+#define NV_STORE_RECORD_MAX_SIZE (NV_STORE_ROW_SIZE - 8)    // Row minus the record header
+
+#define NV_STORE_RSLT_ERR (CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CY_RSLT_MODULE_MIDDLEWARE_BASE, 0x4E))
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+typedef enum {
+	NV_STORE_SLOT_TLS_SESSION = 0,
+	NV_STORE_SLOT_API_KEY_USAGE,
+	NV_STORE_SLOT_BENCH_BASELINE,
+	NV_STORE_SLOT_COUNT
+} nv_store_slot_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+cy_rslt_t nv_store_init(void);
+size_t nv_store_read(nv_store_slot_t slot, void *data, size_t max_len);
+cy_rslt_t nv_store_write(nv_store_slot_t slot, const void *data, size_t len);
+cy_rslt_t nv_store_erase(nv_store_slot_t slot);
+cy_rslt_t nv_store_write_row(const void *row_address, const void *row);
+uint32_t nv_store_crc32(uint32_t crc, const void *data, size_t len);
+
+#endif /* NV_STORE_H_ */
@@ -0,0 +1,257 @@
+/******************************************************************************
+* File Name:   pipeline.c
+*
+* Description: This file contains the channels between the network, decode and
+* display tasks, and the decode task itself. Response bodies are never
+* copied: the network task feeds each piece to the streaming extractor
+* straight from the receive buffer, and only the finished quote table,
+* by index, crosses to the decode task. Free tables go back the other way.
+*
+*******************************************************************************/
+
+/* Header file includes. */
+#include "cyhal.h"
+
+/* FreeRTOS header file. */
+#include <FreeRTOS.h>
+#include <task.h>
+#include <queue.h>
+
+/* Standard C header file. */
+#include <stdio.h>
+#include <string.h>
+
+#include "pipeline.h"
+#include "capture.h"
+#include "quote_stream.h"
+#include "quote_log.h"
+#include "metrics.h"
+#include "log_ring.h"
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+static quote_table_t tables[PIPELINE_TABLES];
+static freshness_stamps_t tableStamps[PIPELINE_TABLES];
+static QueueHandle_t freeTables;    // Indexes into tables, network task takes, decode task returns
+static QueueHandle_t fullTables;    // Indexes into tables, parsed and waiting for the decode task
+static QueueHandle_t quoteQueue;
+
+// Body being parsed, owned by the network task
+static quote_stream_t stream;
+static int streamTable = -1;     // Table the body is parsed into, -1 if none
+static bool streamDropped;       // The body started while no table was free
+static uint32_t streamCycles;    // Time spent parsing the body so far
+
+// Per watchlist position, reset when a different symbol shows up there
+static indicator_state_t indicators[QUOTE_TABLE_CAPACITY];
+
+static alert_engine_t alertEngine;
+
+/*******************************************************************************
+ * Function Name: pipeline_init
+ *******************************************************************************
+ * Summary:
+ *  Creates the channels, compiles the alert rules and opens the quote log.
+ *  Must run before any of the pipeline tasks start.
+ *
+ *******************************************************************************/
+void pipeline_init(const alert_rule_t *rules, uint32_t num_rules) {
+	freeTables = xQueueCreate(PIPELINE_TABLES, sizeof(uint8_t));
+	fullTables = xQueueCreate(PIPELINE_TABLES, sizeof(uint8_t));
+	quoteQueue = xQueueCreate(PIPELINE_QUOTE_QUEUE_LEN, sizeof(quote_record_t));
+	CY_ASSERT(freeTables != NULL && fullTables != NULL && quoteQueue != NULL);
+
+	for(uint8_t i = 0; i < PIPELINE_TABLES; i++) {
+		(void)xQueueSend(freeTables, &i, 0);
+	}
+
+	LOG_INFO("%lu alert rules compiled", (unsigned long)alerts_compile(&alertEngine, rules, num_rules));
+
+	quote_log_init();
+}
+
+/*******************************************************************************
+ * Function Name: pipeline_body_sink
+ *******************************************************************************
+ * Summary:
+ *  Body sink of the network task's connection. Parses each piece of the body
+ *  into a free table as it arrives, taking the table on the first piece. If
+ *  the decoder still holds both tables the body is dropped, the next fetch
+ *  brings newer data anyway.
+ *
+ *******************************************************************************/
+void pipeline_body_sink(void *arg, const uint8_t *data, size_t len, size_t offset) {
+	uint32_t start = metrics_now();
+	uint8_t index;
+
+	(void)arg;
+
+	// A request retried on a fresh session starts its body over
+	if(offset == 0) {
+		if(streamTable < 0 && xQueueReceive(freeTables, &index, 0) == pdPASS) {
+			streamTable = index;
+		}
+		streamDropped = (streamTable < 0);
+		streamCycles = 0;
+		if(streamTable >= 0) {
+			quote_stream_init(&stream, &tables[streamTable]);
+		}
+	}
+
+	if(streamTable >= 0) {
+		quote_stream_feed(&stream, (const char *)data, len);
+		streamCycles += metrics_now() - start;
+	}
+}
+
+/*******************************************************************************
+ * Function Name: pipeline_submit_body
+ *******************************************************************************
+ * Summary:
+ *  Finishes the body parsed by pipeline_body_sink and hands its table to the
+ *  decode task without blocking.
+ *
+ *******************************************************************************/
+pipeline_body_result_t pipeline_submit_body(void) {
+	bool dropped = streamDropped;
+	uint8_t index;
+
+	streamDropped = false;
+	if(streamTable < 0) {
+		return dropped ? PIPELINE_BODY_BUSY : PIPELINE_BODY_EMPTY;
+	}
+
+	index = (uint8_t)streamTable;
+	streamTable = -1;
+	if(quote_stream_finish(&stream) == 0) {
+		(void)xQueueSend(freeTables, &index, 0);
+		return PIPELINE_BODY_EMPTY;
+	}
+
+	metrics_record_cycles(METRICS_PHASE_PARSE, streamCycles);
+	freshness_parsed(&tableStamps[index]);
+	(void)xQueueSend(fullTables, &index, 0);
+	return PIPELINE_BODY_QUEUED;
+}
+
+/*******************************************************************************
+ * Function Name: pipeline_wait_for_table
+ *******************************************************************************
+ * Summary:
+ *  Waits until the decode task has a table free for the next body, for a
+ *  sender that would rather wait than have its body dropped.
+ *
+ * Return:
+ *  bool : false if none came free in time
+ *
+ *******************************************************************************/
+bool pipeline_wait_for_table(TickType_t wait) {
+	uint8_t index;
+
+	return streamTable >= 0 || xQueuePeek(freeTables, &index, wait) == pdPASS;
+}
+
+/*******************************************************************************
+ * Function Name: pipeline_discard_body
+ *******************************************************************************
+ * Summary:
+ *  Drops the body parsed by pipeline_body_sink, for a failed request or an
+ *  error reply, and frees its table.
+ *
+ *******************************************************************************/
+void pipeline_discard_body(void) {
+	uint8_t index;
+
+	if(streamTable >= 0) {
+		index = (uint8_t)streamTable;
+		streamTable = -1;
+		(void)xQueueSend(freeTables, &index, 0);
+	}
+	streamDropped = false;
+}
+
+/*******************************************************************************
+ * Function Name: pipeline_receive_quote
+ *******************************************************************************
+ * Summary:
+ *  Takes the next quote record for the display task.
+ *
+ *******************************************************************************/
+bool pipeline_receive_quote(quote_record_t *record, TickType_t wait) {
+	return xQueueReceive(quoteQueue, record, wait) == pdPASS;
+}
+
+/*******************************************************************************
+ * Function Name: quote_decode_task
+ *******************************************************************************
+ * Summary:
+ *  Turns parsed quote tables into quote records, updates each symbol's
+ *  indicators, runs its alert rules, queues the records for display and
+ *  logs the batch to flash. A fired alert is reported back to the network
+ *  task, since it calls for a fetch ahead of schedule, at most once every
+ *  PIPELINE_REFRESH_MIN_INTERVAL_MS.
+ *
+ * Parameters:
+ *  void *arg : handle of the network task to notify
+ *
+ *******************************************************************************/
+void quote_decode_task(void *arg) {
+	TaskHandle_t networkTask = (TaskHandle_t)arg;
+	quote_record_t record;
+	uint8_t index;
+	int volumeExtra = quote_stream_extra_index("volume");
+	TickType_t lastRefresh = 0;
+	bool refreshed = false;
+
+	while(1) {
+		if(xQueueReceive(fullTables, &index, portMAX_DELAY) != pdPASS) {
+			continue;
+		}
+
+		const quote_table_t *table = &tables[index];
+		uint32_t fired = 0;
+
+		for(uint32_t i = 0; i < table->count; i++) {
+			const quote_t *quote = &table->quotes[i];
+
+			if(strncmp(indicators[i].symbol, quote->symbol, sizeof(quote->symbol)) != 0) {
+				indicators_reset(&indicators[i], quote->symbol);
+			}
+			if(indicators_update(&indicators[i], quote, volumeExtra)) {
+				const indicator_values_t *v = &indicators[i].values;
+				LOG_DEBUG("%s ema %ld sma %ld min %ld max %ld vwap %ld open %+ld (1e-4)", indicators[i].symbol, (long)v->ema, (long)v->sma,
+						  (long)v->min, (long)v->max, (long)v->vwap, (long)v->from_open_percent);
+			}
+
+			record.slot = i;
+			record.count = table->count;
+			record.quote = *quote;
+			record.indicators = indicators[i].values;
+			record.alert = (alerts_evaluate(&alertEngine, quote) > 0);
+			record.stamps = tableStamps[index];
+			fired += record.alert ? 1u : 0u;
+			(void)xQueueSend(quoteQueue, &record, portMAX_DELAY);
+		}
+
+		// A replay keeps its own pace, an alert does not fetch early
+		if(fired > 0 && CAPTURE_MODE != CAPTURE_REPLAY) {
+			TickType_t now = xTaskGetTickCount();
+
+			if(!refreshed || now - lastRefresh >= pdMS_TO_TICKS(PIPELINE_REFRESH_MIN_INTERVAL_MS)) {
+				(void)xTaskNotify(networkTask, PIPELINE_NOTIFY_REFRESH, eSetBits);
+				lastRefresh = now;
+				refreshed = true;
+			} else {
+				LOG_DEBUG("Alert refresh skipped, last one %lu ms ago", (unsigned long)pdTICKS_TO_MS(now - lastRefresh));
+			}
+		}
+
+		// Flash writes happen here, off the network and display tasks. Replayed
+		// quotes are not logged over the live ones the next boot restores
+		if(CAPTURE_MODE != CAPTURE_REPLAY) {
+			quote_log_append(table);
+		}
+		(void)xQueueSend(freeTables, &index, 0);
+	}
+}
@@ -0,0 +1,76 @@
+/******************************************************************************
+* File Name:   pipeline.h
+*
+* Description: This file contains declarations for the fetch / decode / render
+* pipeline. The network task parses each response body as it is received
+* into one of a pair of quote tables and hands the finished table to the
+* decode task, and the decode task hands fixed-size quote records to the
+* display task through a queue, so no stage waits on another.
+*
+*******************************************************************************/
+
+#ifndef PIPELINE_H_
+#define PIPELINE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* FreeRTOS header file. */
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include "quote.h"
+#include "indicators.h"
+#include "alerts.h"
+#include "freshness.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Quote tables, one being parsed into while the decode task works on the other */
+#define PIPELINE_TABLES (2)
+
+/* Quote records in flight between the decode and display tasks */
+#define PIPELINE_QUOTE_QUEUE_LEN (QUOTE_TABLE_CAPACITY)
+
+/* Notification bits the decode task sets on the network task */
+#define PIPELINE_NOTIFY_REFRESH (1u << 1)    // An alert fired, fetch again now
+
+/* Least time between two fetches asked for by alerts, so a rule that keeps
+ * firing cannot spend the API key budget on back-to-back requests
+ */
+#ifndef PIPELINE_REFRESH_MIN_INTERVAL_MS
+#define PIPELINE_REFRESH_MIN_INTERVAL_MS (5 * 60 * 1000)
+#endif
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+typedef enum {
+	PIPELINE_BODY_QUEUED,    // Handed to the decode task
+	PIPELINE_BODY_EMPTY,     // Parsed to no quotes, e.g. an error reply
+	PIPELINE_BODY_BUSY       // Both tables were in use, the body was dropped
+} pipeline_body_result_t;
+
+typedef struct {
+	uint32_t slot;     // Position in the watchlist
+	uint32_t count;    // Quotes in the batch this record came from
+	quote_t quote;
+	indicator_values_t indicators;
+	bool alert;        // An alert rule for the symbol fired on this quote
+	freshness_stamps_t stamps;
+} quote_record_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+void pipeline_init(const alert_rule_t *rules, uint32_t num_rules);
+void pipeline_body_sink(void *arg, const uint8_t *data, size_t len, size_t offset);
+pipeline_body_result_t pipeline_submit_body(void);
+bool pipeline_wait_for_table(TickType_t wait);
+void pipeline_discard_body(void);
+bool pipeline_receive_quote(quote_record_t *record, TickType_t wait);
+void quote_decode_task(void *arg);
+
+#endif /* PIPELINE_H_ */
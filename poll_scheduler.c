@@ -0,0 +1,329 @@
+/******************************************************************************
+* File Name:   poll_scheduler.c
+*
+* Description: This file contains the poll scheduler. It maps wall clock time
+* to the exchange's trading sessions (in the local time zone set through TZ)
+* and computes the next fetch deadline. Deadlines are aligned to the session's
+* period so waiting for them does not accumulate drift.
+*
+*******************************************************************************/
+
+/* Standard C header file. */
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "poll_scheduler.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+// Session boundaries, minutes after local midnight
+#define PRE_MARKET_OPEN_MIN  (4 * 60)
+#define REGULAR_OPEN_MIN     (9 * 60 + 30)
+#define REGULAR_CLOSE_MIN    (16 * 60)
+#define EARLY_CLOSE_MIN      (13 * 60)
+#define AFTER_HOURS_END_MIN  (20 * 60)
+#define EARLY_AFTER_END_MIN  (17 * 60)
+
+#define MAX_DAYS_TO_NEXT_SESSION (10)
+
+#define YMD(y, m, d) ((y) * 10000L + (m) * 100L + (d))
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+// NYSE full day closures
+static const long marketHolidays[] = {
+	YMD(2024, 1, 1),  YMD(2024, 1, 15), YMD(2024, 2, 19), YMD(2024, 3, 29), YMD(2024, 5, 27), YMD(2024, 6, 19), YMD(2024, 7, 4),
+	YMD(2024, 9, 2),  YMD(2024, 11, 28), YMD(2024, 12, 25),
+	YMD(2025, 1, 1),  YMD(2025, 1, 9),  YMD(2025, 1, 20), YMD(2025, 2, 17), YMD(2025, 4, 18), YMD(2025, 5, 26), YMD(2025, 6, 19),
+	YMD(2025, 7, 4),  YMD(2025, 9, 1),  YMD(2025, 11, 27), YMD(2025, 12, 25),
+	YMD(2026, 1, 1),  YMD(2026, 1, 19), YMD(2026, 2, 16), YMD(2026, 4, 3),  YMD(2026, 5, 25), YMD(2026, 6, 19), YMD(2026, 7, 3),
+	YMD(2026, 9, 7),  YMD(2026, 11, 26), YMD(2026, 12, 25),
+	YMD(2027, 1, 1),  YMD(2027, 1, 18), YMD(2027, 2, 15), YMD(2027, 3, 26), YMD(2027, 5, 31), YMD(2027, 6, 18), YMD(2027, 7, 5),
+	YMD(2027, 9, 6),  YMD(2027, 11, 25), YMD(2027, 12, 24),
+};
+
+// NYSE 1 pm early closes
+static const long marketEarlyCloses[] = {
+	YMD(2024, 7, 3), YMD(2024, 11, 29), YMD(2024, 12, 24), YMD(2025, 7, 3), YMD(2025, 11, 28), YMD(2025, 12, 24),
+	YMD(2026, 11, 27), YMD(2026, 12, 24), YMD(2027, 11, 26),
+};
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+static bool poll_scheduler_in_table(const long *table, size_t len, const struct tm *local);
+static bool poll_scheduler_is_trading_day(const struct tm *local);
+static time_t poll_scheduler_local_time(const struct tm *day, int minutes);
+static time_t poll_scheduler_next_boundary(time_t now);
+static long poll_scheduler_days_from_civil(long y, unsigned m, unsigned d);
+
+/*******************************************************************************
+ * Function Name: poll_scheduler_session
+ *******************************************************************************
+ * Summary:
+ *  Returns the trading session in effect at a given time.
+ *
+ *******************************************************************************/
+market_session_t poll_scheduler_session(time_t now) {
+	struct tm local;
+	int minute;
+	bool early;
+
+	(void)localtime_r(&now, &local);
+	if(!poll_scheduler_is_trading_day(&local)) {
+		return MARKET_CLOSED;
+	}
+
+	minute = local.tm_hour * 60 + local.tm_min;
+	early = poll_scheduler_in_table(marketEarlyCloses, sizeof(marketEarlyCloses) / sizeof(marketEarlyCloses[0]), &local);
+
+	if(minute < PRE_MARKET_OPEN_MIN) {
+		return MARKET_CLOSED;
+	}
+	if(minute < REGULAR_OPEN_MIN) {
+		return MARKET_PRE;
+	}
+	if(minute < (early ? EARLY_CLOSE_MIN : REGULAR_CLOSE_MIN)) {
+		return MARKET_REGULAR;
+	}
+	if(minute < (early ? EARLY_AFTER_END_MIN : AFTER_HOURS_END_MIN)) {
+		return MARKET_AFTER;
+	}
+
+	return MARKET_CLOSED;
+}
+
+/*******************************************************************************
+ * Function Name: poll_scheduler_next_fetch
+ *******************************************************************************
+ * Summary:
+ *  Computes when the next fetch is due. The deadline is the next multiple of
+ *  the current session's period, pulled in to the next session boundary so
+ *  the opening and closing prints are always fetched.
+ *
+ * Parameters:
+ *  time_t now : current wall clock time
+ *  market_session_t *session : set to the session in effect now (may be NULL)
+ *
+ * Return:
+ *  time_t : wall clock time of the next fetch, always after now
+ *
+ *******************************************************************************/
+time_t poll_scheduler_next_fetch(time_t now, market_session_t *session) {
+	market_session_t current = poll_scheduler_session(now);
+	time_t period;
+	time_t next;
+	time_t boundary;
+
+	switch(current) {
+		case MARKET_REGULAR:
+			period = POLL_PERIOD_REGULAR_S;
+			break;
+		case MARKET_PRE:
+		case MARKET_AFTER:
+			period = POLL_PERIOD_EXTENDED_S;
+			break;
+		default:
+			period = POLL_PERIOD_CLOSED_S;
+			break;
+	}
+
+	next = (now / period + 1) * period;
+	boundary = poll_scheduler_next_boundary(now);
+	if(boundary > now && boundary < next) {
+		next = boundary;
+	}
+
+	if(session != NULL) {
+		*session = current;
+	}
+
+	return next;
+}
+
+/*******************************************************************************
+ * Function Name: poll_scheduler_session_name
+ *******************************************************************************
+ * Summary:
+ *  Short name of a session for logs.
+ *
+ *******************************************************************************/
+const char *poll_scheduler_session_name(market_session_t session) {
+	switch(session) {
+		case MARKET_PRE:
+			return "pre-market";
+		case MARKET_REGULAR:
+			return "regular";
+		case MARKET_AFTER:
+			return "after-hours";
+		default:
+			return "closed";
+	}
+}
+
+/*******************************************************************************
+ * Function Name: poll_scheduler_day_start
+ *******************************************************************************
+ * Summary:
+ *  Local midnight of the market day a time falls in. Two times on the same
+ *  trading date give the same value, so it tells where a new day starts.
+ *
+ *******************************************************************************/
+time_t poll_scheduler_day_start(time_t now) {
+	struct tm day;
+
+	(void)localtime_r(&now, &day);
+	return poll_scheduler_local_time(&day, 0);
+}
+
+/*******************************************************************************
+ * Function Name: poll_scheduler_parse_http_date
+ *******************************************************************************
+ * Summary:
+ *  Parses an HTTP Date header ("Sun, 18 Oct 2026 14:03:07 GMT"). The device
+ *  has no RTC source, so the server's Date is what the scheduler runs on.
+ *
+ * Return:
+ *  time_t : Unix time, 0 if the value could not be parsed
+ *
+ *******************************************************************************/
+time_t poll_scheduler_parse_http_date(const char *value, size_t value_len) {
+	static const char months[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+	char copy[40];
+	char month[4];
+	int day, year, hour, minute, second;
+	const char *found;
+
+	if(value_len >= sizeof(copy)) {
+		return 0;
+	}
+	(void)memcpy(copy, value, value_len);
+	copy[value_len] = '\0';
+
+	if(sscanf(copy, "%*3s, %d %3s %d %d:%d:%d", &day, month, &year, &hour, &minute, &second) != 6) {
+		return 0;
+	}
+	found = strstr(months, month);
+	if(found == NULL || ((found - months) % 3) != 0) {
+		return 0;
+	}
+
+	return (time_t)(poll_scheduler_days_from_civil(year, (unsigned)((found - months) / 3 + 1), (unsigned)day) * 86400L + hour * 3600L + minute * 60L + second);
+}
+
+/*******************************************************************************
+ * Function Name: poll_scheduler_in_table
+ *******************************************************************************
+ * Summary:
+ *  Looks up a local date in a YMD table.
+ *
+ *******************************************************************************/
+static bool poll_scheduler_in_table(const long *table, size_t len, const struct tm *local) {
+	long ymd = YMD(local->tm_year + 1900L, local->tm_mon + 1L, (long)local->tm_mday);
+
+	for(size_t i = 0; i < len; i++) {
+		if(table[i] == ymd) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/*******************************************************************************
+ * Function Name: poll_scheduler_is_trading_day
+ *******************************************************************************
+ * Summary:
+ *  Weekdays that are not exchange holidays.
+ *
+ *******************************************************************************/
+static bool poll_scheduler_is_trading_day(const struct tm *local) {
+	if(local->tm_wday == 0 || local->tm_wday == 6) {
+		return false;
+	}
+
+	return !poll_scheduler_in_table(marketHolidays, sizeof(marketHolidays) / sizeof(marketHolidays[0]), local);
+}
+
+/*******************************************************************************
+ * Function Name: poll_scheduler_local_time
+ *******************************************************************************
+ * Summary:
+ *  Wall clock time of a given minute of a local day, DST aware.
+ *
+ *******************************************************************************/
+static time_t poll_scheduler_local_time(const struct tm *day, int minutes) {
+	struct tm local = *day;
+
+	local.tm_hour = minutes / 60;
+	local.tm_min = minutes % 60;
+	local.tm_sec = 0;
+	local.tm_isdst = -1;
+
+	return mktime(&local);
+}
+
+/*******************************************************************************
+ * Function Name: poll_scheduler_next_boundary
+ *******************************************************************************
+ * Summary:
+ *  Finds the next session change after now: the next open/close of today,
+ *  or the pre-market open of the next trading day.
+ *
+ *******************************************************************************/
+static time_t poll_scheduler_next_boundary(time_t now) {
+	struct tm day;
+
+	(void)localtime_r(&now, &day);
+
+	if(poll_scheduler_is_trading_day(&day)) {
+		bool early = poll_scheduler_in_table(marketEarlyCloses, sizeof(marketEarlyCloses) / sizeof(marketEarlyCloses[0]), &day);
+		const int boundaries[] = {PRE_MARKET_OPEN_MIN, REGULAR_OPEN_MIN, early ? EARLY_CLOSE_MIN : REGULAR_CLOSE_MIN,
+								  early ? EARLY_AFTER_END_MIN : AFTER_HOURS_END_MIN};
+
+		for(size_t i = 0; i < sizeof(boundaries) / sizeof(boundaries[0]); i++) {
+			time_t boundary = poll_scheduler_local_time(&day, boundaries[i]);
+			if(boundary > now) {
+				return boundary;
+			}
+		}
+	}
+
+	for(int i = 0; i < MAX_DAYS_TO_NEXT_SESSION; i++) {
+		// Noon keeps the day arithmetic clear of DST transitions
+		day.tm_mday++;
+		day.tm_hour = 12;
+		day.tm_isdst = -1;
+		(void)mktime(&day);
+
+		if(poll_scheduler_is_trading_day(&day)) {
+			return poll_scheduler_local_time(&day, PRE_MARKET_OPEN_MIN);
+		}
+	}
+
+	return 0;
+}
+
+/*******************************************************************************
+ * Function Name: poll_scheduler_days_from_civil
+ *******************************************************************************
+ * Summary:
+ *  Days since 1970-01-01 for a proleptic Gregorian date, the UTC counterpart
+ *  to mktime that newlib does not provide.
+ *
+ *******************************************************************************/
+static long poll_scheduler_days_from_civil(long y, unsigned m, unsigned d) {
+	long era;
+	unsigned yoe, doy, doe;
+
+	y -= (m <= 2);
+	era = (y >= 0 ? y : y - 399) / 400;
+	yoe = (unsigned)(y - era * 400);
+	doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+	doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+
+	return era * 146097 + (long)doe - 719468;
+}
@@ -0,0 +1,47 @@
+/******************************************************************************
+* File Name:   poll_scheduler.h
+*
+* Description: This file contains declarations for the market-hours-aware
+* poll scheduler. It only works on wall clock time (no RTOS calls), so it
+* can be driven by a simulated clock on a host.
+*
+*******************************************************************************/
+
+#ifndef POLL_SCHEDULER_H_
+#define POLL_SCHEDULER_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <time.h>
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Poll period for each session, in seconds. Most of the budget goes to the
+ * regular session, when prices actually move.
+ */
+#define POLL_PERIOD_REGULAR_S (60)
+#define POLL_PERIOD_EXTENDED_S (300)     // Pre-market and after-hours
+#define POLL_PERIOD_CLOSED_S   (3600)    // Nights, weekends and holidays
+#define POLL_PERIOD_UNSYNCED_S (120)     // Until the wall clock is known
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+typedef enum {
+	MARKET_CLOSED = 0,
+	MARKET_PRE,
+	MARKET_REGULAR,
+	MARKET_AFTER
+} market_session_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+market_session_t poll_scheduler_session(time_t now);
+time_t poll_scheduler_next_fetch(time_t now, market_session_t *session);
+const char *poll_scheduler_session_name(market_session_t session);
+time_t poll_scheduler_day_start(time_t now);
+time_t poll_scheduler_parse_http_date(const char *value, size_t value_len);
+
+#endif /* POLL_SCHEDULER_H_ */
@@ -0,0 +1,86 @@
+/******************************************************************************
+* File Name:   quote.c
+*
+* Description: This file contains the batched quote request builder and the
+* parser that fills the quote table from the JSON array returned by
+* /api/v3/quote/A,B,C.
+*
+*******************************************************************************/
+
+/* Standard C header file. */
+#include <stdio.h>
+#include <string.h>
+
+#include "quote.h"
+#include "quote_stream.h"
+
+/*******************************************************************************
+ * Function Name: quote_build_resource
+ *******************************************************************************
+ * Summary:
+ *  Builds the resource path that fetches every symbol in one request,
+ *  e.g. "/api/v3/quote/AMD,NVDA?apikey=<key>".
+ *
+ * Parameters:
+ *  char *buffer : destination for the path
+ *  size_t buffer_len : size of buffer
+ *  const char *const *symbols : tickers to request
+ *  uint32_t num_symbols : number of tickers
+ *  const char *api_key : key to bill the request to
+ *
+ * Return:
+ *  size_t : length of the path, 0 if it did not fit
+ *
+ *******************************************************************************/
+size_t quote_build_resource(char *buffer, size_t buffer_len, const char *const *symbols, uint32_t num_symbols, const char *api_key) {
+	size_t len;
+	int written;
+
+	written = snprintf(buffer, buffer_len, "/api/v3/quote/");
+	if(written < 0 || (size_t)written >= buffer_len) {
+		return 0;
+	}
+	len = (size_t)written;
+
+	for(uint32_t i = 0; i < num_symbols; i++) {
+		written = snprintf(buffer + len, buffer_len - len, "%s%s", (i == 0) ? "" : ",", symbols[i]);
+		if(written < 0 || (size_t)written >= buffer_len - len) {
+			return 0;
+		}
+		len += (size_t)written;
+	}
+
+	written = snprintf(buffer + len, buffer_len - len, "?apikey=%s", api_key);
+	if(written < 0 || (size_t)written >= buffer_len - len) {
+		return 0;
+	}
+
+	return len + (size_t)written;
+}
+
+/*******************************************************************************
+ * Function Name: quote_table_parse
+ *******************************************************************************
+ * Summary:
+ *  Parses the JSON array of quote objects into the table in one go with the
+ *  streaming extractor. Entries without a symbol or price are skipped,
+ *  entries past the table capacity are dropped. An error reply (e.g. an
+ *  exhausted key) is an object, not an array, and yields no quotes.
+ *
+ * Parameters:
+ *  quote_table_t *table : table to fill, previous contents are replaced
+ *  const char *json : response body
+ *  size_t json_len : length of the response body
+ *
+ * Return:
+ *  uint32_t : number of quotes in the table
+ *
+ *******************************************************************************/
+uint32_t quote_table_parse(quote_table_t *table, const char *json, size_t json_len) {
+	quote_stream_t stream;
+
+	quote_stream_init(&stream, table);
+	quote_stream_feed(&stream, json, json_len);
+
+	return quote_stream_finish(&stream);
+}
@@ -0,0 +1,60 @@
+/******************************************************************************
+* File Name:   quote.h
+*
+* Description: This file contains the quote model and the fixed-capacity quote
+* table filled from one batched /api/v3/quote response.
+*
+*******************************************************************************/
+
+#ifndef QUOTE_H_
+#define QUOTE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "fixed_point.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define QUOTE_SYMBOL_LEN     (12)    // Longest ticker plus terminator
+#define QUOTE_TABLE_CAPACITY (8)
+
+/* Most bytes one quote object takes in FMP's pretty-printed response, about
+ * 550 B with a 200 B margin for long company names; sizes the receive buffer */
+#define QUOTE_JSON_BYTES (768)
+
+/* Extra numeric fields kept per quote, as FMP names them, at most QUOTE_EXTRA_MAX */
+#ifndef QUOTE_EXTRA_FIELDS
+#define QUOTE_EXTRA_FIELDS "volume"
+#endif
+#define QUOTE_EXTRA_MAX (4)
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+typedef struct {
+	char symbol[QUOTE_SYMBOL_LEN];    // Ticker
+	fixed_t price;                    // Current Price
+	fixed_t change_percent;           // % change over the day
+	fixed_t day_low;                  // Todays low
+	fixed_t day_high;                 // Todays high
+	fixed_t open;                     // Todays open price
+	fixed_t previous_close;           // Previous closing price
+	time_t timestamp;                 // Unix time stamp
+	fixed_t extra[QUOTE_EXTRA_MAX];   // QUOTE_EXTRA_FIELDS, in the order listed
+} quote_t;
+
+typedef struct {
+	quote_t quotes[QUOTE_TABLE_CAPACITY];
+	uint32_t count;
+} quote_table_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+size_t quote_build_resource(char *buffer, size_t buffer_len, const char *const *symbols, uint32_t num_symbols, const char *api_key);
+uint32_t quote_table_parse(quote_table_t *table, const char *json, size_t json_len);
+
+#endif /* QUOTE_H_ */
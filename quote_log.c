@@ -0,0 +1,458 @@
+/******************************************************************************
+* File Name:   quote_log.c
+*
+* Description: This file contains the quote log. Rows are appended in order
+* around a ring of flash rows, so erases are spread evenly over all of them,
+* and every row carries a sequence number and a CRC so a row torn by a reset
+* is simply skipped. Two kinds of row are written: tick rows, batches of
+* compact (time, price) ticks for all symbols, and snapshot rows with the
+* full card values of every symbol. The only index is the sequence number of
+* each row, built by one scan of the headers at boot.
+*
+*******************************************************************************/
+
+/* Header file includes. */
+#include "cyhal.h"
+
+/* Standard C header file. */
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "quote_log.h"
+#include "nv_store.h"
+#include "log_ring.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define QUOTE_LOG_MAGIC      (0x514C4F31u)    // "QLO1"
+#define QUOTE_LOG_ROW_SIZE   (NV_STORE_ROW_SIZE)
+#define QUOTE_LOG_PRICE_UNIT (TICK_RING_PRICE_UNIT)    // Prices are logged in cents
+
+#define QUOTE_LOG_PAYLOAD_SIZE   (QUOTE_LOG_ROW_SIZE - sizeof(quote_log_header_t))
+#define QUOTE_LOG_QUOTES_PER_ROW (QUOTE_LOG_PAYLOAD_SIZE / sizeof(quote_log_quote_t))
+#define QUOTE_LOG_TICKS_PER_ROW  (QUOTE_LOG_PAYLOAD_SIZE / sizeof(quote_log_tick_t))
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+typedef enum {
+	QUOTE_LOG_KIND_SNAPSHOT = 1,
+	QUOTE_LOG_KIND_TICKS
+} quote_log_kind_t;
+
+typedef struct {
+	uint32_t magic;
+	uint32_t crc;            // CRC-32 of the rest of the header and len bytes of payload
+	uint32_t seq;            // Append order, 0 is never written
+	uint32_t symbols_crc;    // Watchlist the slots in the row refer to
+	uint32_t base_time;      // Tick rows: the tick times are relative to it
+	uint16_t len;            // Payload bytes
+	uint8_t kind;
+	uint8_t first;           // Snapshot rows: slot of the first quote
+	uint8_t total;           // Snapshot rows: quotes in the whole snapshot
+	uint8_t reserved[3];
+} quote_log_header_t;
+
+// Card values of one symbol, prices in QUOTE_LOG_PRICE_UNIT
+typedef struct {
+	char symbol[QUOTE_SYMBOL_LEN];
+	uint32_t time;
+	int32_t price;
+	int32_t change_percent;    // fixed_t units
+	int32_t day_low;
+	int32_t day_high;
+	int32_t open;
+	int32_t previous_close;
+} quote_log_quote_t;
+
+typedef struct {
+	int16_t dt;      // Seconds from the row's base time
+	uint8_t slot;
+	uint8_t reserved;
+	int32_t price;
+} quote_log_tick_t;
+
+typedef struct {
+	quote_log_header_t header;
+	union {
+		quote_log_quote_t quotes[QUOTE_LOG_QUOTES_PER_ROW];
+		quote_log_tick_t ticks[QUOTE_LOG_TICKS_PER_ROW];
+		uint8_t bytes[QUOTE_LOG_PAYLOAD_SIZE];
+	} payload;
+} quote_log_row_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+static const quote_log_row_t *quote_log_row(uint32_t index);
+static bool quote_log_row_valid(const quote_log_row_t *row);
+static const quote_log_row_t *quote_log_newest_snapshot(void);
+static void quote_log_write(quote_log_row_t *row);
+static void quote_log_flush_ticks(void);
+static int32_t quote_log_units(fixed_t value);
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+// Volatile: the flash driver writes it, reads must not be folded to the zero initializer
+CY_SECTION(QUOTE_LOG_SECTION) CY_ALIGN(QUOTE_LOG_ROW_SIZE) static const volatile uint8_t logStorage[QUOTE_LOG_ROWS][QUOTE_LOG_ROW_SIZE] = {{0}};
+
+static uint32_t rowSeq[QUOTE_LOG_ROWS];    // 0 for a row holding no valid record
+static uint32_t head = QUOTE_LOG_ROWS - 1;    // Newest row, the next append goes after it
+static uint32_t nextSeq = 1;
+static bool logReady = false;
+
+// Append side, owned by the decode task
+static quote_log_row_t pendingTicks;
+static quote_log_row_t snapshotRow;
+static uint32_t symbolsCrc = 0;
+static time_t lastTickTime[QUOTE_TABLE_CAPACITY];
+static time_t lastSnapshotTime = 0;
+
+/*******************************************************************************
+ * Function Name: quote_log_init
+ *******************************************************************************
+ * Summary:
+ *  Scans the row headers to find the valid rows and the newest one. Must
+ *  run before the other functions.
+ *
+ *******************************************************************************/
+void quote_log_init(void) {
+	uint32_t newest = 0;
+	uint32_t used = 0;
+
+	if(nv_store_init() != CY_RSLT_SUCCESS) {
+		return;
+	}
+
+	for(uint32_t i = 0; i < QUOTE_LOG_ROWS; i++) {
+		const quote_log_row_t *row = quote_log_row(i);
+
+		rowSeq[i] = quote_log_row_valid(row) ? row->header.seq : 0;
+		if(rowSeq[i] != 0) {
+			used++;
+		}
+		if(rowSeq[i] > newest) {
+			newest = rowSeq[i];
+			head = i;
+		}
+	}
+	nextSeq = newest + 1;
+	logReady = true;
+
+	LOG_INFO("Quote log: %lu of %d rows in use", (unsigned long)used, QUOTE_LOG_ROWS);
+}
+
+/*******************************************************************************
+ * Function Name: quote_log_append
+ *******************************************************************************
+ * Summary:
+ *  Logs the new ticks in a decoded batch. Ticks collect in RAM and go to
+ *  flash a row at a time; a snapshot of the whole batch follows them every
+ *  QUOTE_LOG_SNAPSHOT_PERIOD_S. A batch with nothing new writes nothing.
+ *
+ *******************************************************************************/
+void quote_log_append(const quote_table_t *table) {
+	uint32_t crc = 0;
+	time_t newest = 0;
+
+	if(!logReady) {
+		return;
+	}
+
+	for(uint32_t i = 0; i < table->count; i++) {
+		crc = nv_store_crc32(crc, table->quotes[i].symbol, strlen(table->quotes[i].symbol) + 1);
+	}
+
+	// A different watchlist starts over, the slots of older rows mean other symbols
+	if(crc != symbolsCrc) {
+		quote_log_flush_ticks();
+		symbolsCrc = crc;
+		(void)memset(lastTickTime, 0, sizeof(lastTickTime));
+		lastSnapshotTime = 0;
+	}
+
+	for(uint32_t i = 0; i < table->count; i++) {
+		const quote_t *quote = &table->quotes[i];
+		uint32_t n = pendingTicks.header.len / sizeof(quote_log_tick_t);
+		time_t dt = quote->timestamp - (time_t)pendingTicks.header.base_time;
+
+		if(quote->timestamp <= lastTickTime[i]) {
+			continue;
+		}
+		lastTickTime[i] = quote->timestamp;
+		newest = (quote->timestamp > newest) ? quote->timestamp : newest;
+
+		if(n == QUOTE_LOG_TICKS_PER_ROW || (n > 0 && (dt < INT16_MIN || dt > INT16_MAX))) {
+			quote_log_flush_ticks();
+			n = 0;
+		}
+		if(n == 0) {
+			pendingTicks.header.base_time = (uint32_t)quote->timestamp;
+			dt = 0;
+		}
+
+		pendingTicks.payload.ticks[n].dt = (int16_t)dt;
+		pendingTicks.payload.ticks[n].slot = (uint8_t)i;
+		pendingTicks.payload.ticks[n].reserved = 0;
+		pendingTicks.payload.ticks[n].price = quote_log_units(quote->price);
+		pendingTicks.header.len += sizeof(quote_log_tick_t);
+	}
+
+	if(newest == 0 || newest - lastSnapshotTime < QUOTE_LOG_SNAPSHOT_PERIOD_S) {
+		return;
+	}
+
+	// Ticks first, so flash never holds a snapshot newer than the ticks before it
+	quote_log_flush_ticks();
+
+	for(uint32_t first = 0; first < table->count; first += QUOTE_LOG_QUOTES_PER_ROW) {
+		uint32_t n = table->count - first;
+
+		n = (n > QUOTE_LOG_QUOTES_PER_ROW) ? QUOTE_LOG_QUOTES_PER_ROW : n;
+		(void)memset(&snapshotRow, 0, sizeof(snapshotRow));
+		snapshotRow.header.kind = QUOTE_LOG_KIND_SNAPSHOT;
+		snapshotRow.header.first = (uint8_t)first;
+		snapshotRow.header.total = (uint8_t)table->count;
+		snapshotRow.header.len = (uint16_t)(n * sizeof(quote_log_quote_t));
+
+		for(uint32_t j = 0; j < n; j++) {
+			const quote_t *quote = &table->quotes[first + j];
+			quote_log_quote_t *logged = &snapshotRow.payload.quotes[j];
+
+			(void)memcpy(logged->symbol, quote->symbol, sizeof(logged->symbol));
+			logged->time = (uint32_t)quote->timestamp;
+			logged->price = quote_log_units(quote->price);
+			logged->change_percent = (int32_t)quote->change_percent;
+			logged->day_low = quote_log_units(quote->day_low);
+			logged->day_high = quote_log_units(quote->day_high);
+			logged->open = quote_log_units(quote->open);
+			logged->previous_close = quote_log_units(quote->previous_close);
+		}
+		quote_log_write(&snapshotRow);
+	}
+	lastSnapshotTime = newest;
+}
+
+/*******************************************************************************
+ * Function Name: quote_log_load
+ *******************************************************************************
+ * Summary:
+ *  Rebuilds the last known quotes from the newest snapshot, with the price
+ *  and time brought forward by any tick logged after it. Only the fields a
+ *  card shows are restored. Meant for boot, before anything is appended.
+ *
+ * Return:
+ *  uint32_t : quotes restored, in watchlist order
+ *
+ *******************************************************************************/
+uint32_t quote_log_load(quote_t *quotes, uint32_t max_quotes) {
+	const quote_log_row_t *snapshot = quote_log_newest_snapshot();
+	uint32_t total;
+
+	if(snapshot == NULL) {
+		return 0;
+	}
+	total = (snapshot->header.total < max_quotes) ? snapshot->header.total : max_quotes;
+	(void)memset(quotes, 0, total * sizeof(quote_t));
+
+	// Newest row first, so the first quote found for a slot is its latest
+	for(uint32_t i = 0; i < QUOTE_LOG_ROWS; i++) {
+		uint32_t index = (head + QUOTE_LOG_ROWS - i) % QUOTE_LOG_ROWS;
+		const quote_log_row_t *row = quote_log_row(index);
+
+		if(rowSeq[index] == 0 || row->header.kind != QUOTE_LOG_KIND_SNAPSHOT || row->header.symbols_crc != snapshot->header.symbols_crc) {
+			continue;
+		}
+		for(uint32_t j = 0; j < row->header.len / sizeof(quote_log_quote_t); j++) {
+			const quote_log_quote_t *logged = &row->payload.quotes[j];
+			quote_t *quote;
+
+			if(row->header.first + j >= total || quotes[row->header.first + j].symbol[0] != '\0') {
+				continue;
+			}
+			quote = &quotes[row->header.first + j];
+			(void)memcpy(quote->symbol, logged->symbol, sizeof(quote->symbol));
+			quote->symbol[sizeof(quote->symbol) - 1] = '\0';
+			quote->timestamp = (time_t)logged->time;
+			quote->price = (fixed_t)logged->price * QUOTE_LOG_PRICE_UNIT;
+			quote->change_percent = (fixed_t)logged->change_percent;
+			quote->day_low = (fixed_t)logged->day_low * QUOTE_LOG_PRICE_UNIT;
+			quote->day_high = (fixed_t)logged->day_high * QUOTE_LOG_PRICE_UNIT;
+			quote->open = (fixed_t)logged->open * QUOTE_LOG_PRICE_UNIT;
+			quote->previous_close = (fixed_t)logged->previous_close * QUOTE_LOG_PRICE_UNIT;
+		}
+	}
+
+	// Ticks that made it to flash after the snapshot carry a newer price
+	for(uint32_t i = 1; i <= QUOTE_LOG_ROWS; i++) {
+		uint32_t index = (head + i) % QUOTE_LOG_ROWS;
+		const quote_log_row_t *row = quote_log_row(index);
+
+		if(rowSeq[index] == 0 || row->header.kind != QUOTE_LOG_KIND_TICKS || row->header.symbols_crc != snapshot->header.symbols_crc) {
+			continue;
+		}
+		for(uint32_t j = 0; j < row->header.len / sizeof(quote_log_tick_t); j++) {
+			const quote_log_tick_t *tick = &row->payload.ticks[j];
+			time_t time = (time_t)row->header.base_time + tick->dt;
+			quote_t *quote;
+
+			if(tick->slot >= total || quotes[tick->slot].symbol[0] == '\0' || time <= quotes[tick->slot].timestamp) {
+				continue;
+			}
+			quote = &quotes[tick->slot];
+			quote->timestamp = time;
+			quote->price = (fixed_t)tick->price * QUOTE_LOG_PRICE_UNIT;
+			quote->day_low = (quote->price < quote->day_low) ? quote->price : quote->day_low;
+			quote->day_high = (quote->price > quote->day_high) ? quote->price : quote->day_high;
+			quote->change_percent =
+				(quote->previous_close > 0) ? (quote->price - quote->previous_close) * 100 * FIXED_SCALE / quote->previous_close : 0;
+		}
+	}
+
+	return total;
+}
+
+/*******************************************************************************
+ * Function Name: quote_log_replay_ticks
+ *******************************************************************************
+ * Summary:
+ *  Pushes a slot's logged ticks from since onwards into a tick ring, oldest
+ *  first. Meant for boot, before anything is appended.
+ *
+ * Return:
+ *  uint32_t : ticks pushed
+ *
+ *******************************************************************************/
+uint32_t quote_log_replay_ticks(uint32_t slot, time_t since, tick_ring_t *ring) {
+	const quote_log_row_t *snapshot = quote_log_newest_snapshot();
+	uint32_t pushed = 0;
+
+	if(snapshot == NULL) {
+		return 0;
+	}
+
+	for(uint32_t i = 1; i <= QUOTE_LOG_ROWS; i++) {
+		uint32_t index = (head + i) % QUOTE_LOG_ROWS;
+		const quote_log_row_t *row = quote_log_row(index);
+
+		if(rowSeq[index] == 0 || row->header.kind != QUOTE_LOG_KIND_TICKS || row->header.symbols_crc != snapshot->header.symbols_crc) {
+			continue;
+		}
+		for(uint32_t j = 0; j < row->header.len / sizeof(quote_log_tick_t); j++) {
+			const quote_log_tick_t *tick = &row->payload.ticks[j];
+			time_t time = (time_t)row->header.base_time + tick->dt;
+
+			if(tick->slot == slot && time >= since && tick_ring_push(ring, time, (fixed_t)tick->price * QUOTE_LOG_PRICE_UNIT)) {
+				pushed++;
+			}
+		}
+	}
+
+	return pushed;
+}
+
+/*******************************************************************************
+ * Function Name: quote_log_row
+ *******************************************************************************
+ * Summary:
+ *  Row in the memory mapped flash.
+ *
+ *******************************************************************************/
+static const quote_log_row_t *quote_log_row(uint32_t index) {
+	return (const quote_log_row_t *)(uintptr_t)logStorage[index];
+}
+
+/*******************************************************************************
+ * Function Name: quote_log_row_valid
+ *******************************************************************************
+ * Summary:
+ *  Checks a row is a complete record: erased and torn rows fail the magic or
+ *  the CRC.
+ *
+ *******************************************************************************/
+static bool quote_log_row_valid(const quote_log_row_t *row) {
+	const quote_log_header_t *header = &row->header;
+
+	if(header->magic != QUOTE_LOG_MAGIC || header->seq == 0 || header->len > QUOTE_LOG_PAYLOAD_SIZE) {
+		return false;
+	}
+
+	return nv_store_crc32(0, &header->seq, sizeof(*header) - offsetof(quote_log_header_t, seq) + header->len) == header->crc;
+}
+
+/*******************************************************************************
+ * Function Name: quote_log_newest_snapshot
+ *******************************************************************************
+ * Summary:
+ *  Newest snapshot row, whose watchlist the restored data must belong to.
+ *
+ *******************************************************************************/
+static const quote_log_row_t *quote_log_newest_snapshot(void) {
+	for(uint32_t i = 0; i < QUOTE_LOG_ROWS; i++) {
+		uint32_t index = (head + QUOTE_LOG_ROWS - i) % QUOTE_LOG_ROWS;
+
+		if(rowSeq[index] != 0 && quote_log_row(index)->header.kind == QUOTE_LOG_KIND_SNAPSHOT) {
+			return quote_log_row(index);
+		}
+	}
+
+	return NULL;
+}
+
+/*******************************************************************************
+ * Function Name: quote_log_write
+ *******************************************************************************
+ * Summary:
+ *  Seals a row and writes it over the oldest one in the ring. A row that
+ *  fails to write is left out of the index and skipped at the next boot.
+ *
+ *******************************************************************************/
+static void quote_log_write(quote_log_row_t *row) {
+	uint32_t index = (head + 1) % QUOTE_LOG_ROWS;
+	quote_log_header_t *header = &row->header;
+
+	header->magic = QUOTE_LOG_MAGIC;
+	header->seq = nextSeq;
+	header->symbols_crc = symbolsCrc;
+	header->crc = nv_store_crc32(0, &header->seq, sizeof(*header) - offsetof(quote_log_header_t, seq) + header->len);
+
+	head = index;
+	if(nv_store_write_row((const void *)(uintptr_t)logStorage[index], row) != CY_RSLT_SUCCESS) {
+		LOG_ERROR("Quote log write failed!");
+		rowSeq[index] = 0;
+		return;
+	}
+	rowSeq[index] = nextSeq++;
+}
+
+/*******************************************************************************
+ * Function Name: quote_log_flush_ticks
+ *******************************************************************************
+ * Summary:
+ *  Writes the ticks collected so far, if any, and starts a new tick row.
+ *
+ *******************************************************************************/
+static void quote_log_flush_ticks(void) {
+	if(pendingTicks.header.len == 0) {
+		return;
+	}
+
+	pendingTicks.header.kind = QUOTE_LOG_KIND_TICKS;
+	(void)memset(pendingTicks.payload.bytes + pendingTicks.header.len, 0, QUOTE_LOG_PAYLOAD_SIZE - pendingTicks.header.len);
+	quote_log_write(&pendingTicks);
+	pendingTicks.header.len = 0;
+}
+
+/*******************************************************************************
+ * Function Name: quote_log_units
+ *******************************************************************************
+ * Summary:
+ *  Rounds a price to QUOTE_LOG_PRICE_UNIT.
+ *
+ *******************************************************************************/
+static int32_t quote_log_units(fixed_t value) {
+	return (int32_t)((value + ((value >= 0) ? 1 : -1) * (QUOTE_LOG_PRICE_UNIT / 2)) / QUOTE_LOG_PRICE_UNIT);
+}
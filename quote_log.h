@@ -0,0 +1,48 @@
+/******************************************************************************
+* File Name:   quote_log.h
+*
+* Description: This file contains declarations for the quote log, an append
+* only ring of CRC-checked flash rows holding the latest quote of every
+* watchlist symbol and the intraday ticks. It is read back at boot so the
+* cards show the last known values before the network is up.
+*
+*******************************************************************************/
+
+#ifndef QUOTE_LOG_H_
+#define QUOTE_LOG_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "quote.h"
+#include "tick_ring.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Flash rows in the ring, and where they live. Override both to move the log to a bigger region */
+#ifndef QUOTE_LOG_ROWS
+#define QUOTE_LOG_ROWS (48)
+#endif
+#ifndef QUOTE_LOG_SECTION
+#define QUOTE_LOG_SECTION ".cy_em_eeprom"
+#endif
+
+/* Longest gap between two snapshots of the latest quotes, in quote time */
+#ifndef QUOTE_LOG_SNAPSHOT_PERIOD_S
+#define QUOTE_LOG_SNAPSHOT_PERIOD_S (15 * 60)
+#endif
+
+/* How far before the last known quote replayed ticks may go, one extended session */
+#define QUOTE_LOG_HISTORY_S (16 * 60 * 60)
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+void quote_log_init(void);
+void quote_log_append(const quote_table_t *table);
+uint32_t quote_log_load(quote_t *quotes, uint32_t max_quotes);
+uint32_t quote_log_replay_ticks(uint32_t slot, time_t since, tick_ring_t *ring);
+
+#endif /* QUOTE_LOG_H_ */
@@ -0,0 +1,366 @@
+/******************************************************************************
+* File Name:   quote_stream.c
+*
+* Description: This file contains the streaming quote extractor. A small lexer
+* tracks string/scalar state and container depth; keys of objects directly
+* inside the top level array are matched against the quote fields and their
+* values written straight into the quote being built. Nothing else is kept.
+*
+*******************************************************************************/
+
+/* Standard C header file. */
+#include <string.h>
+
+#include "quote_stream.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+// Depth of a quote object: inside the top level array
+#define QUOTE_OBJECT_DEPTH (2)
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+typedef enum {
+	FIELD_SYMBOL,
+	FIELD_PRICE,
+	FIELD_CHANGE_PERCENT,
+	FIELD_DAY_LOW,
+	FIELD_DAY_HIGH,
+	FIELD_OPEN,
+	FIELD_PREVIOUS_CLOSE,
+	FIELD_TIMESTAMP,
+	FIELD_EXTRA    // First of the QUOTE_EXTRA_FIELDS
+} quote_field_t;
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+// Indexed by quote_field_t
+static const char *const fieldNames[] = {"symbol", "price", "changesPercentage", "dayLow", "dayHigh", "open", "previousClose", "timestamp"};
+
+static const char *const extraNames[] = {QUOTE_EXTRA_FIELDS};
+#define EXTRA_COUNT (sizeof(extraNames) / sizeof(extraNames[0]))
+_Static_assert(EXTRA_COUNT <= QUOTE_EXTRA_MAX, "QUOTE_EXTRA_FIELDS lists more than QUOTE_EXTRA_MAX fields");
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+static void quote_stream_byte(quote_stream_t *stream, char c);
+static void quote_stream_structural(quote_stream_t *stream, char c);
+static void quote_stream_append(quote_stream_t *stream, char c);
+static void quote_stream_string_done(quote_stream_t *stream);
+static void quote_stream_scalar_done(quote_stream_t *stream);
+static int quote_stream_lookup(const char *token, size_t len);
+static bool quote_stream_in_quote(const quote_stream_t *stream);
+
+/*******************************************************************************
+ * Function Name: quote_stream_init
+ *******************************************************************************
+ * Summary:
+ *  Prepares an extractor that fills the given table, which is emptied.
+ *
+ *******************************************************************************/
+void quote_stream_init(quote_stream_t *stream, quote_table_t *table) {
+	(void)memset(stream, 0, sizeof(*stream));
+	stream->table = table;
+	stream->lex = QUOTE_LEX_IDLE;
+	stream->field = -1;
+	table->count = 0;
+}
+
+/*******************************************************************************
+ * Function Name: quote_stream_feed
+ *******************************************************************************
+ * Summary:
+ *  Consumes the next piece of the body. Pieces may split tokens anywhere.
+ *
+ *******************************************************************************/
+void quote_stream_feed(quote_stream_t *stream, const char *data, size_t len) {
+	for(size_t i = 0; i < len && stream->lex != QUOTE_LEX_ERROR; i++) {
+		quote_stream_byte(stream, data[i]);
+	}
+}
+
+/*******************************************************************************
+ * Function Name: quote_stream_finish
+ *******************************************************************************
+ * Summary:
+ *  Ends the body. Quotes completed before any malformed input are kept.
+ *
+ * Return:
+ *  uint32_t : number of quotes in the table
+ *
+ *******************************************************************************/
+uint32_t quote_stream_finish(quote_stream_t *stream) {
+	// A bare number as the whole body ends without a delimiter
+	if(stream->lex == QUOTE_LEX_SCALAR) {
+		quote_stream_scalar_done(stream);
+	}
+
+	return stream->table->count;
+}
+
+/*******************************************************************************
+ * Function Name: quote_stream_extra_index
+ *******************************************************************************
+ * Summary:
+ *  Where a QUOTE_EXTRA_FIELDS field lands in quote_t.extra.
+ *
+ * Return:
+ *  int : index into extra, -1 if the field is not configured
+ *
+ *******************************************************************************/
+int quote_stream_extra_index(const char *name) {
+	for(size_t i = 0; i < EXTRA_COUNT; i++) {
+		if(strcmp(extraNames[i], name) == 0) {
+			return (int)i;
+		}
+	}
+
+	return -1;
+}
+
+/*******************************************************************************
+ * Function Name: quote_stream_byte
+ *******************************************************************************
+ * Summary:
+ *  Advances the lexer by one byte.
+ *
+ *******************************************************************************/
+static void quote_stream_byte(quote_stream_t *stream, char c) {
+	switch(stream->lex) {
+		case QUOTE_LEX_STRING:
+			if(c == '\\') {
+				stream->lex = QUOTE_LEX_ESCAPE;
+			} else if(c == '"') {
+				stream->lex = QUOTE_LEX_IDLE;
+				quote_stream_string_done(stream);
+			} else {
+				quote_stream_append(stream, c);
+			}
+			break;
+
+		case QUOTE_LEX_ESCAPE:
+			// Escapes never occur in the fields we keep, the raw character is good enough
+			quote_stream_append(stream, c);
+			stream->lex = QUOTE_LEX_STRING;
+			break;
+
+		case QUOTE_LEX_SCALAR:
+			if((c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '.' || c == '-' || c == '+') {
+				quote_stream_append(stream, c);
+				break;
+			}
+			stream->lex = QUOTE_LEX_IDLE;
+			quote_stream_scalar_done(stream);
+			quote_stream_structural(stream, c);
+			break;
+
+		case QUOTE_LEX_IDLE:
+			quote_stream_structural(stream, c);
+			break;
+
+		default:
+			break;
+	}
+}
+
+/*******************************************************************************
+ * Function Name: quote_stream_structural
+ *******************************************************************************
+ * Summary:
+ *  Handles a byte outside of any token: brackets, separators, whitespace and
+ *  the start of the next token.
+ *
+ *******************************************************************************/
+static void quote_stream_structural(quote_stream_t *stream, char c) {
+	switch(c) {
+		case ' ':
+		case '\t':
+		case '\r':
+		case '\n':
+			break;
+
+		case '"':
+			stream->lex = QUOTE_LEX_STRING;
+			stream->token_len = 0;
+			stream->token_overflow = false;
+			break;
+
+		case '{':
+		case '[':
+			if(stream->depth >= QUOTE_STREAM_MAX_DEPTH) {
+				stream->lex = QUOTE_LEX_ERROR;
+				break;
+			}
+			stream->stack[stream->depth++] = c;
+			stream->expect_key = (c == '{');
+			stream->field = -1;    // A container is never a value we keep
+
+			if(quote_stream_in_quote(stream)) {
+				(void)memset(&stream->current, 0, sizeof(stream->current));
+				stream->seen = 0;
+			}
+			break;
+
+		case '}':
+		case ']':
+			if(stream->depth == 0 || stream->stack[stream->depth - 1] != (char)((c == '}') ? '{' : '[')) {
+				stream->lex = QUOTE_LEX_ERROR;
+				break;
+			}
+
+			// Closing a quote object, keep it if it has what the display needs
+			if(quote_stream_in_quote(stream) && (stream->seen & ((1u << FIELD_SYMBOL) | (1u << FIELD_PRICE))) == ((1u << FIELD_SYMBOL) | (1u << FIELD_PRICE))) {
+				quote_table_t *table = stream->table;
+				if(table->count < QUOTE_TABLE_CAPACITY) {
+					table->quotes[table->count++] = stream->current;
+				}
+			}
+
+			stream->depth--;
+			stream->expect_key = false;
+			stream->field = -1;
+			break;
+
+		case ':':
+			stream->expect_key = false;
+			break;
+
+		case ',':
+			stream->expect_key = (stream->depth > 0 && stream->stack[stream->depth - 1] == '{');
+			stream->field = -1;
+			break;
+
+		default:
+			stream->lex = QUOTE_LEX_SCALAR;
+			stream->token_len = 0;
+			stream->token_overflow = false;
+			quote_stream_append(stream, c);
+			break;
+	}
+}
+
+/*******************************************************************************
+ * Function Name: quote_stream_append
+ *******************************************************************************
+ * Summary:
+ *  Adds a byte to the current token, marking it overflowed once full.
+ *
+ *******************************************************************************/
+static void quote_stream_append(quote_stream_t *stream, char c) {
+	if(stream->token_len < sizeof(stream->token)) {
+		stream->token[stream->token_len++] = c;
+	} else {
+		stream->token_overflow = true;
+	}
+}
+
+/*******************************************************************************
+ * Function Name: quote_stream_string_done
+ *******************************************************************************
+ * Summary:
+ *  A string ended: either a key, which selects the field for the value that
+ *  follows, or a value (only the symbol is a string field).
+ *
+ *******************************************************************************/
+static void quote_stream_string_done(quote_stream_t *stream) {
+	if(stream->expect_key) {
+		stream->field = (quote_stream_in_quote(stream) && !stream->token_overflow) ? quote_stream_lookup(stream->token, stream->token_len) : -1;
+		return;
+	}
+
+	if(stream->field == FIELD_SYMBOL) {
+		size_t len = (stream->token_len < QUOTE_SYMBOL_LEN - 1) ? stream->token_len : QUOTE_SYMBOL_LEN - 1;
+		(void)memcpy(stream->current.symbol, stream->token, len);
+		stream->current.symbol[len] = '\0';
+		stream->seen |= 1u << FIELD_SYMBOL;
+	}
+	stream->field = -1;
+}
+
+/*******************************************************************************
+ * Function Name: quote_stream_scalar_done
+ *******************************************************************************
+ * Summary:
+ *  A number or literal ended, stores it if it belongs to a numeric field.
+ *  FMP sends null for fields it has no value for, those stay 0.
+ *
+ *******************************************************************************/
+static void quote_stream_scalar_done(quote_stream_t *stream) {
+	int field = stream->field;
+	fixed_t value;
+
+	stream->field = -1;
+	if(field < 0 || field == FIELD_SYMBOL || stream->token_overflow) {
+		return;
+	}
+	if(stream->token_len == 4 && memcmp(stream->token, "null", 4) == 0) {
+		return;
+	}
+
+	// Straight from the text to fixed point, no double on the way
+	value = fixed_parse(stream->token, stream->token_len);
+	switch(field) {
+		case FIELD_PRICE:
+			stream->current.price = value;
+			break;
+		case FIELD_CHANGE_PERCENT:
+			stream->current.change_percent = value;
+			break;
+		case FIELD_DAY_LOW:
+			stream->current.day_low = value;
+			break;
+		case FIELD_DAY_HIGH:
+			stream->current.day_high = value;
+			break;
+		case FIELD_OPEN:
+			stream->current.open = value;
+			break;
+		case FIELD_PREVIOUS_CLOSE:
+			stream->current.previous_close = value;
+			break;
+		case FIELD_TIMESTAMP:
+			stream->current.timestamp = (time_t)(value / FIXED_SCALE);
+			break;
+		default:
+			stream->current.extra[field - FIELD_EXTRA] = value;
+			break;
+	}
+	stream->seen |= 1u << field;
+}
+
+/*******************************************************************************
+ * Function Name: quote_stream_lookup
+ *******************************************************************************
+ * Summary:
+ *  Maps a key to its field, -1 for keys that are not kept.
+ *
+ *******************************************************************************/
+static int quote_stream_lookup(const char *token, size_t len) {
+	for(size_t i = 0; i < sizeof(fieldNames) / sizeof(fieldNames[0]); i++) {
+		if(strlen(fieldNames[i]) == len && memcmp(fieldNames[i], token, len) == 0) {
+			return (int)i;
+		}
+	}
+	for(size_t i = 0; i < EXTRA_COUNT; i++) {
+		if(strlen(extraNames[i]) == len && memcmp(extraNames[i], token, len) == 0) {
+			return FIELD_EXTRA + (int)i;
+		}
+	}
+
+	return -1;
+}
+
+/*******************************************************************************
+ * Function Name: quote_stream_in_quote
+ *******************************************************************************
+ * Summary:
+ *  True while directly inside an object of the top level array.
+ *
+ *******************************************************************************/
+static bool quote_stream_in_quote(const quote_stream_t *stream) {
+	return stream->depth == QUOTE_OBJECT_DEPTH && stream->stack[0] == '[' && stream->stack[1] == '{';
+}
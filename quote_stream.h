@@ -0,0 +1,62 @@
+/******************************************************************************
+* File Name:   quote_stream.h
+*
+* Description: This file contains declarations for the streaming quote
+* extractor. It walks the /api/v3/quote JSON one byte at a time, keeps only
+* the fields a quote_t holds and never allocates, so a body can be fed in
+* whatever pieces it arrives in.
+*
+*******************************************************************************/
+
+#ifndef QUOTE_STREAM_H_
+#define QUOTE_STREAM_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "quote.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Deepest nesting tracked, FMP quotes are an array of flat objects */
+#define QUOTE_STREAM_MAX_DEPTH (8)
+
+/* Longest key or scalar kept, longer tokens are never a field we want */
+#define QUOTE_STREAM_TOKEN_LEN (32)
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+typedef enum {
+	QUOTE_LEX_IDLE,
+	QUOTE_LEX_STRING,
+	QUOTE_LEX_ESCAPE,
+	QUOTE_LEX_SCALAR,
+	QUOTE_LEX_ERROR
+} quote_lex_state_t;
+
+typedef struct {
+	quote_table_t *table;
+	quote_lex_state_t lex;
+	uint8_t depth;
+	char stack[QUOTE_STREAM_MAX_DEPTH];    // '[' or '{' per open container
+	bool expect_key;                       // Next string in the current object is a key
+	int field;                             // Field the value being read belongs to, -1 if none
+	char token[QUOTE_STREAM_TOKEN_LEN];
+	uint8_t token_len;
+	bool token_overflow;
+	quote_t current;
+	uint32_t seen;                         // Fields found in the current object, bit per field
+} quote_stream_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+void quote_stream_init(quote_stream_t *stream, quote_table_t *table);
+void quote_stream_feed(quote_stream_t *stream, const char *data, size_t len);
+uint32_t quote_stream_finish(quote_stream_t *stream);
+int quote_stream_extra_index(const char *name);
+
+#endif /* QUOTE_STREAM_H_ */
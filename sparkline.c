@@ -0,0 +1,159 @@
+/******************************************************************************
+* File Name:   sparkline.c
+*
+* Description: This file contains the sparkline widget. A full redraw leaves a
+* quarter of the width free so the following ticks can be appended one
+* column at a time.
+*
+*******************************************************************************/
+
+#include "sparkline.h"
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+static int sparkline_map(const sparkline_t *spark, fixed_t price);
+static uint32_t sparkline_line_pixels(int x0, int y0, int x1, int y1);
+
+/*******************************************************************************
+ * Function Name: sparkline_init
+ *******************************************************************************
+ * Summary:
+ *  Places a sparkline on screen. Nothing is drawn until the first tick.
+ *
+ *******************************************************************************/
+void sparkline_init(sparkline_t *spark, int x, int y, int width, int height, GUI_COLOR color) {
+	spark->x = x;
+	spark->y = y;
+	spark->width = width;
+	spark->height = height;
+	spark->color = color;
+	spark->low = 0;
+	spark->high = 0;
+	spark->column = -1;
+	spark->last_y = y + height - 1;
+}
+
+/*******************************************************************************
+ * Function Name: sparkline_append
+ *******************************************************************************
+ * Summary:
+ *  Draws the newest tick of the ring as the next column, joined to the one
+ *  before it. Falls back to a full redraw when needed.
+ *
+ * Return:
+ *  uint32_t : pixels pushed to the panel
+ *
+ *******************************************************************************/
+uint32_t sparkline_append(sparkline_t *spark, const tick_ring_t *ring) {
+	int y;
+	uint32_t pixels;
+
+	if(ring->count < 2 || spark->column < 1 || spark->column >= spark->width || ring->last_price < spark->low || ring->last_price > spark->high) {
+		return sparkline_redraw(spark, ring);
+	}
+
+	y = sparkline_map(spark, ring->last_price);
+	GUI_SetColor(spark->color);
+	GUI_DrawLine(spark->x + spark->column - 1, spark->last_y, spark->x + spark->column, y);
+	GUI_SetColor(GUI_WHITE);    // Text Color
+
+	pixels = sparkline_line_pixels(spark->column - 1, spark->last_y, spark->column, y);
+	spark->column++;
+	spark->last_y = y;
+
+	return pixels;
+}
+
+/*******************************************************************************
+ * Function Name: sparkline_redraw
+ *******************************************************************************
+ * Summary:
+ *  Clears the chart and draws the newest ticks that fit in three quarters of
+ *  its width, rescaled to their price range.
+ *
+ * Return:
+ *  uint32_t : pixels pushed to the panel
+ *
+ *******************************************************************************/
+uint32_t sparkline_redraw(sparkline_t *spark, const tick_ring_t *ring) {
+	uint32_t visible = ring->count;
+	uint32_t skip = 0;
+	tick_iter_t iter;
+	fixed_t margin;
+	int column = 0;
+	uint32_t pixels = (uint32_t)(spark->width * spark->height);
+
+	GUI_ClearRect(spark->x, spark->y, spark->x + spark->width - 1, spark->y + spark->height - 1);
+	spark->column = 0;
+	if(ring->count == 0) {
+		return pixels;
+	}
+
+	if(visible > (uint32_t)spark->width) {
+		visible = (uint32_t)(spark->width * 3 / 4);
+		skip = ring->count - visible;
+	}
+
+	// Scale to the visible range with a little headroom, so small moves do not rescale at once
+	tick_iter_init(&iter, ring, skip);
+	spark->low = spark->high = ring->last_price;
+	while(tick_iter_next(&iter)) {
+		spark->low = (iter.price < spark->low) ? iter.price : spark->low;
+		spark->high = (iter.price > spark->high) ? iter.price : spark->high;
+	}
+	margin = (spark->high - spark->low) / 8 + TICK_RING_PRICE_UNIT;
+	spark->low -= margin;
+	spark->high += margin;
+
+	GUI_SetColor(spark->color);
+	tick_iter_init(&iter, ring, skip);
+	while(tick_iter_next(&iter)) {
+		int y = sparkline_map(spark, iter.price);
+
+		if(column == 0) {
+			GUI_DrawPixel(spark->x, y);
+			pixels++;
+		} else {
+			GUI_DrawLine(spark->x + column - 1, spark->last_y, spark->x + column, y);
+			pixels += sparkline_line_pixels(column - 1, spark->last_y, column, y);
+		}
+		spark->last_y = y;
+		column++;
+	}
+	GUI_SetColor(GUI_WHITE);    // Text Color
+	spark->column = column;
+
+	return pixels;
+}
+
+/*******************************************************************************
+ * Function Name: sparkline_map
+ *******************************************************************************
+ * Summary:
+ *  Screen line of a price, the top line is the high of the scale.
+ *
+ *******************************************************************************/
+static int sparkline_map(const sparkline_t *spark, fixed_t price) {
+	fixed_t range = spark->high - spark->low;
+
+	if(range <= 0) {
+		return spark->y + spark->height / 2;
+	}
+
+	return spark->y + spark->height - 1 - (int)((price - spark->low) * (spark->height - 1) / range);
+}
+
+/*******************************************************************************
+ * Function Name: sparkline_line_pixels
+ *******************************************************************************
+ * Summary:
+ *  Pixels emWin plots for a line, one per step along its longer axis.
+ *
+ *******************************************************************************/
+static uint32_t sparkline_line_pixels(int x0, int y0, int x1, int y1) {
+	int dx = (x1 > x0) ? x1 - x0 : x0 - x1;
+	int dy = (y1 > y0) ? y1 - y0 : y0 - y1;
+
+	return (uint32_t)(((dx > dy) ? dx : dy) + 1);
+}
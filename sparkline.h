@@ -0,0 +1,41 @@
+/******************************************************************************
+* File Name:   sparkline.h
+*
+* Description: This file contains declarations for the intraday sparkline
+* widget. New ticks add one column to the right of what is already drawn;
+* the chart is only redrawn in full when it runs out of columns or a price
+* leaves the current scale.
+*
+*******************************************************************************/
+
+#ifndef SPARKLINE_H_
+#define SPARKLINE_H_
+
+#include <stdint.h>
+
+#include "GUI.h"
+#include "tick_ring.h"
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+typedef struct {
+	int x;
+	int y;
+	int width;
+	int height;
+	GUI_COLOR color;
+	fixed_t low;       // Price at the bottom line
+	fixed_t high;      // Price at the top line
+	int column;        // Next column to draw, -1 if a full redraw is due
+	int last_y;
+} sparkline_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+void sparkline_init(sparkline_t *spark, int x, int y, int width, int height, GUI_COLOR color);
+uint32_t sparkline_append(sparkline_t *spark, const tick_ring_t *ring);
+uint32_t sparkline_redraw(sparkline_t *spark, const tick_ring_t *ring);
+
+#endif /* SPARKLINE_H_ */
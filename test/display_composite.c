@@ -0,0 +1,13 @@
+/******************************************************************************
+* File Name:   display_composite.c
+*
+* Description: The display task built with DISPLAY_COMPOSITE, linked into
+* test_display next to the one that draws directly, so both can be run over
+* the same updates and compared on the same framebuffer.
+*
+*******************************************************************************/
+
+#define DISPLAY_COMPOSITE (1)
+#define display_task      display_composite_task
+
+#include "../display.c"
@@ -0,0 +1,46 @@
+/******************************************************************************
+* File Name:   FreeRTOS.h
+*
+* Description: Host stand-in for the FreeRTOS kernel header: the types and
+* configuration the modules under test use. host_rtos.c implements the
+* calls.
+*
+*******************************************************************************/
+
+#ifndef FREERTOS_H_
+#define FREERTOS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define configTOTAL_HEAP_SIZE (128 * 1024)
+#define configTICK_RATE_HZ    (1000u)
+
+#define pdFALSE (0)
+#define pdTRUE  (1)
+#define pdPASS  (pdTRUE)
+#define pdFAIL  (pdFALSE)
+
+#define pdMS_TO_TICKS(ms)      ((TickType_t)(ms))
+#define pdTICKS_TO_MS(ticks)   ((uint32_t)(ticks))
+#define portMAX_DELAY          ((TickType_t)UINT32_MAX)
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+typedef uint32_t TickType_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+void *pvPortMalloc(size_t size);
+void vPortFree(void *ptr);
+size_t xPortGetFreeHeapSize(void);
+size_t xPortGetMinimumEverFreeHeapSize(void);
+
+#endif /* FREERTOS_H_ */
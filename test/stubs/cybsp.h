@@ -0,0 +1,14 @@
+/******************************************************************************
+* File Name:   cybsp.h
+*
+* Description: Host stand-in for the board support header. The modules under
+* test only include it.
+*
+*******************************************************************************/
+
+#ifndef CYBSP_H_
+#define CYBSP_H_
+
+#include "cyhal.h"
+
+#endif /* CYBSP_H_ */
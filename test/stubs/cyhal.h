@@ -0,0 +1,54 @@
+/******************************************************************************
+* File Name:   cyhal.h
+*
+* Description: Host stand-in for the parts of the PSoC6 HAL the modules under
+* test use: result codes, attributes, asserts and the flash driver, which
+* host_flash.c emulates.
+*
+*******************************************************************************/
+
+#ifndef CYHAL_H_
+#define CYHAL_H_
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define CY_RSLT_SUCCESS ((cy_rslt_t)0u)
+
+#define CY_RSLT_TYPE_ERROR             (2u)
+#define CY_RSLT_MODULE_MIDDLEWARE_BASE (0x0200u)
+#define CY_RSLT_CREATE(type, module, code) \
+	((cy_rslt_t)((((module) & 0x3FFFu) << 18) | (((type) & 0x3u) << 16) | ((code) & 0xFFFFu)))
+
+/* Every flash region lands in one section, which the emulator finds by the
+ * linker's __start_/__stop_ symbols whatever section the target uses
+ */
+#define CY_SECTION(name) __attribute__((section("host_flash")))
+#define CY_ALIGN(align)  __attribute__((aligned(align)))
+
+#define CY_ASSERT(cond) assert(cond)
+
+#define CY_FLASH_SIZEOF_ROW (512u)
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+typedef uint32_t cy_rslt_t;
+
+typedef struct {
+	int unused;
+} cyhal_flash_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+cy_rslt_t cyhal_flash_init(cyhal_flash_t *obj);
+cy_rslt_t cyhal_flash_erase(cyhal_flash_t *obj, uint32_t address);
+cy_rslt_t cyhal_flash_write(cyhal_flash_t *obj, uint32_t address, const uint32_t *data);
+
+#endif /* CYHAL_H_ */
@@ -0,0 +1,233 @@
+/******************************************************************************
+* File Name:   host_flash.c
+*
+* Description: This file contains the host flash emulator. Rows are written
+* straight into the host_flash section, made writable on first use, and,
+* with a backing file attached, through to the file at the same offset. A
+* write can be torn on purpose: only half the row is programmed and the
+* call fails, as if the board reset in the middle of it.
+*
+*******************************************************************************/
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "cyhal.h"
+#include "host_flash.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define HOST_FLASH_RSLT_ERR (CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CY_RSLT_MODULE_MIDDLEWARE_BASE, 0x48))
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+// Bounds of the section, from the linker
+extern uint8_t __start_host_flash[];
+extern uint8_t __stop_host_flash[];
+
+static bool mapped = false;
+static int backing = -1;
+static uint32_t tearIn = 0;    // Good writes left before the torn one, 0 for none
+static host_flash_stats_t stats;
+
+/*******************************************************************************
+ * Function Name: host_flash_map
+ *******************************************************************************
+ * Summary:
+ *  Makes the section writable, it is linked read-only like flash.
+ *
+ *******************************************************************************/
+static bool host_flash_map(void) {
+	uintptr_t page = (uintptr_t)sysconf(_SC_PAGESIZE);
+	uintptr_t from = (uintptr_t)__start_host_flash & ~(page - 1);
+	uintptr_t to = ((uintptr_t)__stop_host_flash + page - 1) & ~(page - 1);
+
+	if(!mapped) {
+		mapped = (mprotect((void *)from, to - from, PROT_READ | PROT_WRITE) == 0);
+	}
+	return mapped;
+}
+
+/*******************************************************************************
+ * Function Name: host_flash_row
+ *******************************************************************************
+ * Summary:
+ *  Host pointer of a row given by its 32 bit flash address, NULL if the
+ *  address is not a row of the section. Only the low 32 bits are compared,
+ *  so the section may sit anywhere in a 64 bit address space.
+ *
+ *******************************************************************************/
+static uint8_t *host_flash_row(uint32_t address) {
+	uint32_t offset = address - (uint32_t)(uintptr_t)__start_host_flash;
+
+	if(offset >= host_flash_size() || offset % CY_FLASH_SIZEOF_ROW != 0 || !host_flash_map()) {
+		return NULL;
+	}
+	return __start_host_flash + offset;
+}
+
+/*******************************************************************************
+ * Function Name: host_flash_persist
+ *******************************************************************************
+ * Summary:
+ *  Writes a row through to the backing file, if any.
+ *
+ *******************************************************************************/
+static void host_flash_persist(const uint8_t *row) {
+	if(backing >= 0) {
+		(void)pwrite(backing, row, CY_FLASH_SIZEOF_ROW, row - __start_host_flash);
+	}
+}
+
+/*******************************************************************************
+ * Function Name: host_flash_size
+ *******************************************************************************
+ * Summary:
+ *  Bytes of emulated flash.
+ *
+ *******************************************************************************/
+uint32_t host_flash_size(void) {
+	return (uint32_t)(__stop_host_flash - __start_host_flash);
+}
+
+/*******************************************************************************
+ * Function Name: host_flash_attach
+ *******************************************************************************
+ * Summary:
+ *  Backs the flash with a file. A file of the right size is loaded, as the
+ *  flash a reboot would find; any other file starts blank.
+ *
+ * Return:
+ *  bool : false if the file cannot be used
+ *
+ *******************************************************************************/
+bool host_flash_attach(const char *path) {
+	struct stat info;
+
+	if(!host_flash_map()) {
+		return false;
+	}
+	if(backing >= 0) {
+		(void)close(backing);
+	}
+
+	backing = open(path, O_RDWR | O_CREAT, 0644);
+	if(backing < 0 || fstat(backing, &info) != 0) {
+		return false;
+	}
+
+	if(info.st_size == (off_t)host_flash_size() && pread(backing, __start_host_flash, host_flash_size(), 0) == (ssize_t)host_flash_size()) {
+		return true;
+	}
+
+	host_flash_blank();
+	return true;
+}
+
+/*******************************************************************************
+ * Function Name: host_flash_blank
+ *******************************************************************************
+ * Summary:
+ *  Erases the whole flash, and the backing file.
+ *
+ *******************************************************************************/
+void host_flash_blank(void) {
+	if(!host_flash_map()) {
+		return;
+	}
+
+	(void)memset(__start_host_flash, 0, host_flash_size());
+	if(backing >= 0) {
+		(void)ftruncate(backing, 0);
+		(void)pwrite(backing, __start_host_flash, host_flash_size(), 0);
+	}
+}
+
+/*******************************************************************************
+ * Function Name: host_flash_tear_after
+ *******************************************************************************
+ * Summary:
+ *  Lets the given number of writes through and tears the one after. 0 turns
+ *  tearing off.
+ *
+ *******************************************************************************/
+void host_flash_tear_after(uint32_t writes) {
+	tearIn = (writes > 0) ? writes + 1 : 0;
+}
+
+/*******************************************************************************
+ * Function Name: host_flash_stats
+ *******************************************************************************
+ * Summary:
+ *  Row operations so far.
+ *
+ *******************************************************************************/
+host_flash_stats_t host_flash_stats(void) {
+	return stats;
+}
+
+/*******************************************************************************
+ * Function Name: cyhal_flash_init
+ *******************************************************************************
+ * Summary:
+ *  Nothing to set up beyond making the section writable.
+ *
+ *******************************************************************************/
+cy_rslt_t cyhal_flash_init(cyhal_flash_t *obj) {
+	return host_flash_map() ? CY_RSLT_SUCCESS : HOST_FLASH_RSLT_ERR;
+}
+
+/*******************************************************************************
+ * Function Name: cyhal_flash_erase
+ *******************************************************************************
+ * Summary:
+ *  Erases a row to zeros, the PSoC6 erased state.
+ *
+ *******************************************************************************/
+cy_rslt_t cyhal_flash_erase(cyhal_flash_t *obj, uint32_t address) {
+	uint8_t *row = host_flash_row(address);
+
+	if(row == NULL) {
+		stats.failed++;
+		return HOST_FLASH_RSLT_ERR;
+	}
+
+	(void)memset(row, 0, CY_FLASH_SIZEOF_ROW);
+	host_flash_persist(row);
+	stats.row_erases++;
+	return CY_RSLT_SUCCESS;
+}
+
+/*******************************************************************************
+ * Function Name: cyhal_flash_write
+ *******************************************************************************
+ * Summary:
+ *  Erases and programs a row, or tears it when a tear is due.
+ *
+ *******************************************************************************/
+cy_rslt_t cyhal_flash_write(cyhal_flash_t *obj, uint32_t address, const uint32_t *data) {
+	uint8_t *row = host_flash_row(address);
+
+	if(row == NULL) {
+		stats.failed++;
+		return HOST_FLASH_RSLT_ERR;
+	}
+
+	if(tearIn > 0 && --tearIn == 0) {
+		(void)memset(row, 0, CY_FLASH_SIZEOF_ROW);
+		(void)memcpy(row, data, CY_FLASH_SIZEOF_ROW / 2);
+		host_flash_persist(row);
+		stats.failed++;
+		return HOST_FLASH_RSLT_ERR;
+	}
+
+	(void)memcpy(row, data, CY_FLASH_SIZEOF_ROW);
+	host_flash_persist(row);
+	stats.row_writes++;
+	return CY_RSLT_SUCCESS;
+}
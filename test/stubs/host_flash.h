@@ -0,0 +1,35 @@
+/******************************************************************************
+* File Name:   host_flash.h
+*
+* Description: This file contains declarations for the host flash emulator.
+* It implements the cyhal_flash calls over the host_flash section, where the
+* cyhal.h stand-in puts every flash region, and can back that section with
+* a file, so what one process writes survives into the next like a reboot.
+*
+*******************************************************************************/
+
+#ifndef HOST_FLASH_H_
+#define HOST_FLASH_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+typedef struct {
+	uint32_t row_writes;
+	uint32_t row_erases;
+	uint32_t failed;    // Writes torn or refused
+} host_flash_stats_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+bool host_flash_attach(const char *path);
+void host_flash_blank(void);
+void host_flash_tear_after(uint32_t writes);
+host_flash_stats_t host_flash_stats(void);
+uint32_t host_flash_size(void);
+
+#endif /* HOST_FLASH_H_ */
@@ -0,0 +1,230 @@
+/******************************************************************************
+* File Name:   host_rtos.c
+*
+* Description: This file contains the host stand-in of the FreeRTOS kernel
+* calls the modules under test make. Tasks are only handles the test
+* switches between. The heap works like heap_4: first fit over the ucHeap
+* region the application defines, free blocks kept in address order and
+* merged with their neighbours, and the malloc failed hook called when a
+* request cannot be served.
+*
+*******************************************************************************/
+
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "host_rtos.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define HOST_RTOS_TASKS (8)
+#define HEAP_ALIGN      (8)
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+struct host_task {
+	unsigned index;
+};
+
+typedef struct heap_block {
+	struct heap_block *next;    // Next free block by address, while free
+	size_t size;                // Including this header
+} heap_block_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+void vApplicationMallocFailedHook(void);
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+extern uint8_t ucHeap[configTOTAL_HEAP_SIZE];
+
+static struct host_task tasks[HOST_RTOS_TASKS];
+static TaskHandle_t current = NULL;
+static bool started = false;
+static unsigned suspended = 0;
+
+static heap_block_t freeHead = {NULL, 0};
+static bool heapReady = false;
+static size_t freeBytes = 0;
+static size_t minimumFree = 0;
+
+/*******************************************************************************
+ * Function Name: host_rtos_task, host_rtos_start, host_rtos_switch
+ *******************************************************************************
+ * Summary:
+ *  Task handles, starting the scheduler as one of them, and switching to
+ *  another.
+ *
+ *******************************************************************************/
+TaskHandle_t host_rtos_task(unsigned index) {
+	tasks[index % HOST_RTOS_TASKS].index = index % HOST_RTOS_TASKS;
+	return &tasks[index % HOST_RTOS_TASKS];
+}
+
+void host_rtos_start(TaskHandle_t task) {
+	started = true;
+	current = task;
+}
+
+void host_rtos_switch(TaskHandle_t task) {
+	current = task;
+}
+
+bool host_rtos_suspended(void) {
+	return suspended > 0;
+}
+
+/*******************************************************************************
+ * Function Name: vTaskSuspendAll, xTaskResumeAll, xTaskGetCurrentTaskHandle,
+ *                xTaskGetSchedulerState, xTaskGetTickCount
+ *******************************************************************************
+ * Summary:
+ *  The kernel calls, over the state above. Ticks are host milliseconds.
+ *
+ *******************************************************************************/
+void vTaskSuspendAll(void) {
+	suspended++;
+}
+
+BaseType_t xTaskResumeAll(void) {
+	suspended--;
+	return pdFALSE;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+	return current;
+}
+
+BaseType_t xTaskGetSchedulerState(void) {
+	if(!started) {
+		return taskSCHEDULER_NOT_STARTED;
+	}
+	return (suspended > 0) ? taskSCHEDULER_SUSPENDED : taskSCHEDULER_RUNNING;
+}
+
+TickType_t xTaskGetTickCount(void) {
+	struct timespec now;
+
+	(void)clock_gettime(CLOCK_MONOTONIC, &now);
+	return (TickType_t)(now.tv_sec * 1000 + now.tv_nsec / 1000000);
+}
+
+/*******************************************************************************
+ * Function Name: heap_init
+ *******************************************************************************
+ * Summary:
+ *  Makes the whole aligned region one free block.
+ *
+ *******************************************************************************/
+static void heap_init(void) {
+	uintptr_t start = ((uintptr_t)ucHeap + HEAP_ALIGN - 1) & ~(uintptr_t)(HEAP_ALIGN - 1);
+	heap_block_t *block = (heap_block_t *)start;
+
+	block->size = ((uintptr_t)ucHeap + configTOTAL_HEAP_SIZE - start) & ~(size_t)(HEAP_ALIGN - 1);
+	block->next = NULL;
+	freeHead.next = block;
+	freeBytes = minimumFree = block->size;
+	heapReady = true;
+}
+
+/*******************************************************************************
+ * Function Name: pvPortMalloc
+ *******************************************************************************
+ * Summary:
+ *  First fit, splitting off the rest of a block big enough to be useful.
+ *
+ *******************************************************************************/
+void *pvPortMalloc(size_t size) {
+	heap_block_t *previous = &freeHead;
+	heap_block_t *block;
+	size_t needed = (sizeof(heap_block_t) + size + HEAP_ALIGN - 1) & ~(size_t)(HEAP_ALIGN - 1);
+
+	if(!heapReady) {
+		heap_init();
+	}
+
+	for(block = freeHead.next; block != NULL && block->size < needed; block = block->next) {
+		previous = block;
+	}
+	if(block == NULL || size == 0) {
+		vApplicationMallocFailedHook();
+		return NULL;
+	}
+
+	if(block->size - needed > 2 * sizeof(heap_block_t)) {
+		heap_block_t *rest = (heap_block_t *)((uint8_t *)block + needed);
+
+		rest->size = block->size - needed;
+		rest->next = block->next;
+		block->size = needed;
+		previous->next = rest;
+	} else {
+		previous->next = block->next;
+	}
+
+	freeBytes -= block->size;
+	minimumFree = (freeBytes < minimumFree) ? freeBytes : minimumFree;
+	block->next = NULL;
+	return block + 1;
+}
+
+/*******************************************************************************
+ * Function Name: vPortFree
+ *******************************************************************************
+ * Summary:
+ *  Puts a block back in address order and merges it with free neighbours.
+ *
+ *******************************************************************************/
+void vPortFree(void *ptr) {
+	heap_block_t *block;
+	heap_block_t *previous = &freeHead;
+
+	if(ptr == NULL) {
+		return;
+	}
+	block = (heap_block_t *)ptr - 1;
+	freeBytes += block->size;
+
+	while(previous->next != NULL && previous->next < block) {
+		previous = previous->next;
+	}
+
+	block->next = previous->next;
+	if(block->next != NULL && (uint8_t *)block + block->size == (uint8_t *)block->next) {
+		block->size += block->next->size;
+		block->next = block->next->next;
+	}
+	if(previous != &freeHead && (uint8_t *)previous + previous->size == (uint8_t *)block) {
+		previous->size += block->size;
+		previous->next = block->next;
+	} else {
+		previous->next = block;
+	}
+}
+
+/*******************************************************************************
+ * Function Name: xPortGetFreeHeapSize, xPortGetMinimumEverFreeHeapSize
+ *******************************************************************************
+ * Summary:
+ *  Free bytes now and at the lowest, headers included like heap_4.
+ *
+ *******************************************************************************/
+size_t xPortGetFreeHeapSize(void) {
+	if(!heapReady) {
+		heap_init();
+	}
+	return freeBytes;
+}
+
+size_t xPortGetMinimumEverFreeHeapSize(void) {
+	if(!heapReady) {
+		heap_init();
+	}
+	return minimumFree;
+}
@@ -0,0 +1,25 @@
+/******************************************************************************
+* File Name:   host_rtos.h
+*
+* Description: This file contains declarations for the host stand-in of the
+* FreeRTOS kernel: which task is running, and the heap_4 region.
+*
+*******************************************************************************/
+
+#ifndef HOST_RTOS_H_
+#define HOST_RTOS_H_
+
+#include <stdbool.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+void host_rtos_start(TaskHandle_t task);
+void host_rtos_switch(TaskHandle_t task);
+TaskHandle_t host_rtos_task(unsigned index);
+bool host_rtos_suspended(void);
+
+#endif /* HOST_RTOS_H_ */
@@ -0,0 +1,36 @@
+/******************************************************************************
+* File Name:   task.h
+*
+* Description: Host stand-in for the FreeRTOS task API. There is one thread;
+* the test says which task it is pretending to be with host_rtos.h.
+*
+*******************************************************************************/
+
+#ifndef TASK_H_
+#define TASK_H_
+
+#include "FreeRTOS.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define taskSCHEDULER_SUSPENDED   ((BaseType_t)0)
+#define taskSCHEDULER_NOT_STARTED ((BaseType_t)1)
+#define taskSCHEDULER_RUNNING     ((BaseType_t)2)
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+typedef struct host_task *TaskHandle_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+void vTaskSuspendAll(void);
+BaseType_t xTaskResumeAll(void);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+BaseType_t xTaskGetSchedulerState(void);
+TickType_t xTaskGetTickCount(void);
+void vTaskDelay(TickType_t ticks);
+
+#endif /* TASK_H_ */
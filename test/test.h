@@ -0,0 +1,133 @@
+/******************************************************************************
+* File Name:   test.h
+*
+* Description: This file contains the checks and timers shared by the host
+* tests. Each test program runs its checks and exits non-zero if any failed;
+* given the argument "bench" it also prints its benchmarks as CSV:
+*
+*   bench,<test>,<case>,<value>,<unit>
+*
+*******************************************************************************/
+
+#ifndef TEST_H_
+#define TEST_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define CHECK(cond)                                                                  \
+	do {                                                                             \
+		testChecks++;                                                                \
+		if(!(cond)) {                                                                \
+			testFailures++;                                                          \
+			fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+		}                                                                            \
+	} while(0)
+
+#define CHECK_EQ(a, b)                                                                                                       \
+	do {                                                                                                                     \
+		long long checkA = (long long)(a);                                                                                   \
+		long long checkB = (long long)(b);                                                                                   \
+		testChecks++;                                                                                                        \
+		if(checkA != checkB) {                                                                                               \
+			testFailures++;                                                                                                  \
+			fprintf(stderr, "%s:%d: CHECK_EQ(%s, %s) failed: %lld != %lld\n", __FILE__, __LINE__, #a, #b, checkA, checkB); \
+		}                                                                                                                    \
+	} while(0)
+
+#define CHECK_STR(a, b)                                                                                               \
+	do {                                                                                                              \
+		testChecks++;                                                                                                 \
+		if(strcmp((a), (b)) != 0) {                                                                                   \
+			testFailures++;                                                                                           \
+			fprintf(stderr, "%s:%d: CHECK_STR(%s, %s) failed: \"%s\" != \"%s\"\n", __FILE__, __LINE__, #a, #b, (a), (b)); \
+		}                                                                                                             \
+	} while(0)
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+static unsigned testChecks = 0;
+static unsigned testFailures = 0;
+
+/*******************************************************************************
+ * Function Name: test_bench_requested
+ *******************************************************************************
+ * Summary:
+ *  Whether the program was asked to run its benchmarks too.
+ *
+ *******************************************************************************/
+static inline bool test_bench_requested(int argc, char **argv) {
+	return argc > 1 && strcmp(argv[1], "bench") == 0;
+}
+
+/*******************************************************************************
+ * Function Name: test_now_ns
+ *******************************************************************************
+ * Summary:
+ *  Monotonic time in ns, for the benchmarks.
+ *
+ *******************************************************************************/
+static inline uint64_t test_now_ns(void) {
+	struct timespec now;
+
+	(void)clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+/*******************************************************************************
+ * Function Name: test_read_file
+ *******************************************************************************
+ * Summary:
+ *  Reads a file under test/data, relative to the test directory. Aborts the
+ *  test if it is missing.
+ *
+ *******************************************************************************/
+static inline char *test_read_file(const char *name, size_t *len) {
+	char path[256];
+	FILE *file;
+	char *data;
+	long size;
+
+	(void)snprintf(path, sizeof(path), "data/%s", name);
+	file = fopen(path, "rb");
+	if(file == NULL || fseek(file, 0, SEEK_END) != 0 || (size = ftell(file)) < 0 || fseek(file, 0, SEEK_SET) != 0) {
+		fprintf(stderr, "cannot read %s\n", path);
+		exit(2);
+	}
+
+	data = malloc((size_t)size + 1);
+	if(data == NULL || fread(data, 1, (size_t)size, file) != (size_t)size) {
+		fprintf(stderr, "cannot read %s\n", path);
+		exit(2);
+	}
+	data[size] = '\0';
+	fclose(file);
+
+	*len = (size_t)size;
+	return data;
+}
+
+/*******************************************************************************
+ * Function Name: test_summary
+ *******************************************************************************
+ * Summary:
+ *  Prints the result line of a test program.
+ *
+ * Return:
+ *  int : exit status, 0 if every check passed
+ *
+ *******************************************************************************/
+static inline int test_summary(const char *name) {
+	printf("%s: %u checks, %u failed\n", name, testChecks, testFailures);
+	return (testFailures == 0) ? 0 : 1;
+}
+
+#endif /* TEST_H_ */
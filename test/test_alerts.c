@@ -0,0 +1,215 @@
+/******************************************************************************
+* File Name:   test_alerts.c
+*
+* Description: This file contains the host tests and benchmark of the price
+* alert engine: edges, tracked rules following the day high and low, and
+* the cost of evaluating a quote against a full rule table:
+*
+*   bench,alerts,evaluate_<rules per symbol>,<ns per quote>,ns
+*   bench,alerts,rule,<ns per rule>,ns
+*
+*******************************************************************************/
+
+#include "alerts.h"
+#include "log_ring.h"
+#include "test.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define BENCH_RUNS (1000000)
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+static const char *const benchSymbols[] = {"AMD", "NVDA", "INTC", "AAPL", "MSFT", "TSM", "QCOM", "ARM"};
+#define BENCH_SYMBOLS (sizeof(benchSymbols) / sizeof(benchSymbols[0]))
+
+static alert_engine_t engine;
+static unsigned long logged = 0;
+
+/*******************************************************************************
+ * Function Name: log_ring_write
+ *******************************************************************************
+ * Summary:
+ *  Counts the messages instead of queueing them.
+ *
+ *******************************************************************************/
+void log_ring_write(uint32_t level, const char *format, uint32_t count, ...) {
+	logged++;
+}
+
+/*******************************************************************************
+ * Function Name: quote_at
+ *******************************************************************************
+ * Summary:
+ *  A quote for the rules to look at.
+ *
+ *******************************************************************************/
+static quote_t quote_at(const char *symbol, fixed_t price, fixed_t day_low, fixed_t day_high) {
+	quote_t quote = {0};
+
+	(void)snprintf(quote.symbol, sizeof(quote.symbol), "%s", symbol);
+	quote.price = price;
+	quote.previous_close = 1000000;
+	quote.day_low = day_low;
+	quote.day_high = day_high;
+	return quote;
+}
+
+/*******************************************************************************
+ * Function Name: evaluate
+ *******************************************************************************
+ * Summary:
+ *  Runs one quote through the engine.
+ *
+ *******************************************************************************/
+static uint32_t evaluate(const char *symbol, fixed_t price, fixed_t day_low, fixed_t day_high) {
+	quote_t quote = quote_at(symbol, price, day_low, day_high);
+
+	return alerts_evaluate(&engine, &quote);
+}
+
+/*******************************************************************************
+ * Function Name: test_edges
+ *******************************************************************************
+ * Summary:
+ *  A crossing fires both ways, a move fires once while it lasts, and the
+ *  first quote only primes.
+ *
+ *******************************************************************************/
+static void test_edges(void) {
+	static const alert_rule_t rules[] = {ALERT_CROSSES("AMD", 105), ALERT_MOVE_PERCENT("NVDA", 3)};
+
+	CHECK_EQ(alerts_compile(&engine, rules, 2), 2);
+
+	CHECK_EQ(evaluate("AMD", 1100000, 0, 0), 0);    // Above from the start, no edge yet
+	CHECK_EQ(evaluate("AMD", 1000000, 0, 0), 1);
+	CHECK_EQ(evaluate("AMD", 1000000, 0, 0), 0);
+	CHECK_EQ(evaluate("AMD", 1060000, 0, 0), 1);
+	CHECK_EQ(evaluate("AMD", 1070000, 0, 0), 0);
+
+	CHECK_EQ(evaluate("NVDA", 1010000, 0, 0), 0);
+	CHECK_EQ(evaluate("NVDA", 960000, 0, 0), 1);    // 4% down
+	CHECK_EQ(evaluate("NVDA", 950000, 0, 0), 0);
+	CHECK_EQ(evaluate("NVDA", 1000000, 0, 0), 0);
+	CHECK_EQ(evaluate("NVDA", 1040000, 0, 0), 1);
+
+	CHECK_EQ(evaluate("INTC", 1, 0, 0), 0);
+	CHECK_EQ(engine.fired, 4);
+	CHECK_EQ(engine.evaluated, 10);
+}
+
+/*******************************************************************************
+ * Function Name: test_tracked
+ *******************************************************************************
+ * Summary:
+ *  A new day high fires on every quote that extends it, including a
+ *  breakout late in the day after a flat spell, and not while it holds. A
+ *  day high lower than the tracked one (the next day) is taken over without
+ *  firing. The same for a new day low, mirrored.
+ *
+ *******************************************************************************/
+static void test_tracked(void) {
+	static const alert_rule_t rules[] = {ALERT_NEW_DAY_HIGH("AMD"), ALERT_NEW_DAY_LOW("AMD")};
+	uint32_t fired = 0;
+
+	CHECK_EQ(alerts_compile(&engine, rules, 2), 2);
+
+	CHECK_EQ(evaluate("AMD", 1000000, 990000, 1010000), 0);
+	CHECK_EQ(evaluate("AMD", 1020000, 990000, 1020000), 1);
+
+	// A rising morning fires on every new high
+	for(fixed_t high = 1030000; high < 1100000; high += 10000) {
+		fired += evaluate("AMD", high, 990000, high);
+	}
+	CHECK_EQ(fired, 7);
+
+	// Flat afternoon below the high, then a breakout
+	for(int i = 0; i < 20; i++) {
+		CHECK_EQ(evaluate("AMD", 1080000, 990000, 1090000), 0);
+	}
+	CHECK_EQ(evaluate("AMD", 1095000, 990000, 1095000), 1);
+
+	// Next day: day high starts over lower, taken over without firing
+	CHECK_EQ(evaluate("AMD", 1050000, 1040000, 1060000), 0);
+	CHECK_EQ(evaluate("AMD", 1050000, 1040000, 1060000), 0);
+	CHECK_EQ(evaluate("AMD", 1070000, 1040000, 1070000), 1);
+
+	// New lows the same way
+	CHECK_EQ(evaluate("AMD", 1030000, 1030000, 1070000), 1);
+	CHECK_EQ(evaluate("AMD", 1020000, 1020000, 1070000), 1);
+	CHECK_EQ(evaluate("AMD", 1025000, 1020000, 1070000), 0);
+	CHECK_EQ(engine.fired, 12);
+}
+
+/*******************************************************************************
+ * Function Name: bench_evaluate
+ *******************************************************************************
+ * Summary:
+ *  Times a quote against ALERT_MAX_RULES rules spread over eight symbols,
+ *  with prices that cross back and forth so rules keep firing. Only the
+ *  quote's own symbol's rules are visited.
+ *
+ *******************************************************************************/
+static void bench_evaluate(void) {
+	static alert_rule_t rules[ALERT_MAX_RULES];
+	static const char *const percents[] = {"1", "2", "3", "5"};
+	static const char *const prices[] = {"98", "99", "100", "101"};
+	quote_t quotes[BENCH_SYMBOLS * 2];
+	volatile uint32_t sink = 0;
+	uint64_t start;
+	uint64_t elapsed;
+	uint32_t perSymbol = ALERT_MAX_RULES / BENCH_SYMBOLS;
+
+	for(uint32_t i = 0; i < ALERT_MAX_RULES; i++) {
+		const char *symbol = benchSymbols[i % BENCH_SYMBOLS];
+		uint32_t r = i / BENCH_SYMBOLS;
+
+		switch(r % 4) {
+			case 0:
+				rules[i] = (alert_rule_t)ALERT_CROSSES(symbol, 0);
+				rules[i].threshold = prices[(r / 4) % 4];
+				break;
+			case 1:
+				rules[i] = (alert_rule_t)ALERT_MOVE_PERCENT(symbol, 0);
+				rules[i].threshold = percents[(r / 4) % 4];
+				break;
+			case 2:
+				rules[i] = (alert_rule_t)ALERT_NEW_DAY_HIGH(symbol);
+				break;
+			default:
+				rules[i] = (alert_rule_t)ALERT_NEW_DAY_LOW(symbol);
+				break;
+		}
+	}
+	(void)alerts_compile(&engine, rules, ALERT_MAX_RULES);
+
+	for(uint32_t i = 0; i < BENCH_SYMBOLS * 2; i++) {
+		fixed_t price = (i < BENCH_SYMBOLS) ? 970000 : 1030000;
+
+		quotes[i] = quote_at(benchSymbols[i % BENCH_SYMBOLS], price, price - 10000, price + 10000);
+	}
+
+	logged = 0;
+	start = test_now_ns();
+	for(uint32_t run = 0; run < BENCH_RUNS; run++) {
+		sink += alerts_evaluate(&engine, &quotes[run % (BENCH_SYMBOLS * 2)]);
+	}
+	elapsed = test_now_ns() - start;
+	printf("bench,alerts,evaluate_%lu,%llu,ns\n", (unsigned long)perSymbol, (unsigned long long)(elapsed / BENCH_RUNS));
+	printf("bench,alerts,rule,%llu,ns\n", (unsigned long long)(elapsed / ((uint64_t)BENCH_RUNS * perSymbol)));
+	(void)sink;
+}
+
+int main(int argc, char **argv) {
+	test_edges();
+	test_tracked();
+	CHECK(logged == 16 || LOG_LEVEL < LOG_LEVEL_WARN);
+
+	if(test_bench_requested(argc, argv)) {
+		bench_evaluate();
+	}
+
+	return test_summary("alerts");
+}
@@ -0,0 +1,262 @@
+/******************************************************************************
+* File Name:   test_capture.c
+*
+* Description: This file contains the host tests and benchmark of the
+* response capture log, built in record mode over a few rows of the flash
+* emulator. Responses are recorded, rewound and read back from flash; a
+* full log and a row torn by a reset must end the recording cleanly. The
+* benchmark times recording a response and reading it back:
+*
+*   bench,capture,<write|next>,<ns>,ns
+*
+*******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include "capture.h"
+#include "host_flash.h"
+#include "nv_store.h"
+#include "test.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define BENCH_RUNS (2000)
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+// A response as the network task receives it, with its arrival tick
+typedef struct {
+	uint16_t status;
+	const char *header;
+	uint32_t body_len;
+	time_t server_time;
+	TickType_t tick;
+} response_t;
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+static TickType_t now = 0;
+static uint8_t bodies[2048];
+
+/*******************************************************************************
+ * Function Name: xTaskGetTickCount, log_ring_write
+ *******************************************************************************
+ * Summary:
+ *  Arrival times come from the test's clock; logging is not under test.
+ *
+ *******************************************************************************/
+TickType_t xTaskGetTickCount(void) {
+	return now;
+}
+
+void log_ring_write(uint32_t level, const char *format, uint32_t count, ...) {
+}
+
+/*******************************************************************************
+ * Function Name: body_of
+ *******************************************************************************
+ * Summary:
+ *  Body bytes of a response, a different pattern for each length.
+ *
+ *******************************************************************************/
+static uint8_t *body_of(const response_t *response) {
+	for(uint32_t i = 0; i < response->body_len; i++) {
+		bodies[i] = (uint8_t)(i * 7 + response->body_len);
+	}
+	return bodies;
+}
+
+/*******************************************************************************
+ * Function Name: record
+ *******************************************************************************
+ * Summary:
+ *  Hands a response to capture_write at its arrival tick.
+ *
+ *******************************************************************************/
+static void record(const response_t *response) {
+	cy_http_client_response_t received = {0};
+
+	received.status_code = response->status;
+	received.header = (uint8_t *)(uintptr_t)response->header;
+	received.headers_len = (response->header != NULL) ? (uint32_t)strlen(response->header) : 0;
+	received.body = (response->body_len > 0) ? body_of(response) : NULL;
+	received.body_len = response->body_len;
+
+	now = response->tick;
+	capture_write(&received, response->server_time);
+}
+
+/*******************************************************************************
+ * Function Name: check_replay
+ *******************************************************************************
+ * Summary:
+ *  Rewinds and checks the recording holds exactly the given responses, in
+ *  order, with their status, headers, body, server time and arrival time.
+ *
+ *******************************************************************************/
+static void check_replay(const response_t *responses, uint32_t count) {
+	capture_entry_t entry;
+
+	capture_rewind();
+	for(uint32_t i = 0; i < count; i++) {
+		const response_t *response = &responses[i];
+		uint32_t headerLen = (response->header != NULL) ? (uint32_t)strlen(response->header) : 0;
+
+		CHECK(capture_next(&entry));
+		CHECK_EQ(entry.seq, i);
+		CHECK_EQ(entry.status, response->status);
+		CHECK_EQ(entry.arrival_ms, pdTICKS_TO_MS(response->tick));
+		CHECK_EQ(entry.server_time, response->server_time);
+		CHECK_EQ(entry.header_len, headerLen);
+		CHECK(memcmp(entry.header, response->header, headerLen) == 0);
+		CHECK_EQ(entry.body_len, response->body_len);
+		CHECK(memcmp(entry.body, body_of(response), response->body_len) == 0);
+	}
+	CHECK(!capture_next(&entry));
+}
+
+/*******************************************************************************
+ * Function Name: test_round_trip
+ *******************************************************************************
+ * Summary:
+ *  Responses with and without headers or a body, one spanning rows, read
+ *  back as recorded, and again after a second rewind. A new recording
+ *  replays only itself, not the longer one it was written over.
+ *
+ *******************************************************************************/
+static void test_round_trip(void) {
+	static const response_t responses[] = {
+		{200, "Content-Type: application/json\r\nDate: Thu, 13 Jun 2024 13:30:00 GMT\r\n", 180, 1718285400, 1000},
+		{200, "Content-Type: application/json\r\n", 700, 0, 61000},
+		{429, "Retry-After: 60\r\n", 0, 1718285520, 121500},
+		{503, NULL, 17, 1718285580, 181500},
+	};
+	static const response_t next = {200, "Content-Length: 3\r\n", 3, 1718290000, 5};
+
+	host_flash_blank();
+	capture_init();
+	for(uint32_t i = 0; i < sizeof(responses) / sizeof(responses[0]); i++) {
+		record(&responses[i]);
+	}
+	check_replay(responses, sizeof(responses) / sizeof(responses[0]));
+	check_replay(responses, sizeof(responses) / sizeof(responses[0]));
+	CHECK_EQ(host_flash_stats().failed, 0);
+
+	capture_init();
+	record(&next);
+	check_replay(&next, 1);
+}
+
+/*******************************************************************************
+ * Function Name: test_full
+ *******************************************************************************
+ * Summary:
+ *  Once a response does not fit, recording stops: later responses, even
+ *  ones small enough to fit, are dropped and the log replays what it took.
+ *
+ *******************************************************************************/
+static void test_full(void) {
+	response_t responses[8];
+	uint32_t fit = CAPTURE_ROWS * NV_STORE_ROW_SIZE / 1100;    // Records of 1100 B, 64 of them record header and response headers
+	const response_t small = {200, NULL, 4, 0, 0};
+
+	host_flash_blank();
+	capture_init();
+	for(uint32_t i = 0; i < 8; i++) {
+		responses[i] = (response_t){200, "Content-Type: application/json\r\n", 1100 - 64, 1718285400 + i * 60, i * 60000};
+		record(&responses[i]);
+	}
+	record(&small);
+
+	CHECK(fit < 8);
+	check_replay(responses, fit);
+	CHECK_EQ(host_flash_stats().failed, 0);
+}
+
+/*******************************************************************************
+ * Function Name: test_torn_row
+ *******************************************************************************
+ * Summary:
+ *  A reset in the middle of a row write leaves half a row. The response in
+ *  it fails its CRC, so replay ends before it, and recording stops rather
+ *  than write past the torn row.
+ *
+ *******************************************************************************/
+static void test_torn_row(void) {
+	static const response_t responses[] = {
+		{200, "Content-Type: application/json\r\n", 100, 1718285400, 1000},
+		{200, "Content-Type: application/json\r\n", 600, 1718285460, 61000},
+		{200, "Content-Type: application/json\r\n", 10, 1718285520, 121000},
+	};
+	host_flash_stats_t before;
+
+	host_flash_blank();
+	capture_init();
+	record(&responses[0]);
+
+	// The second response fills the first row, which goes through, and tears the next
+	host_flash_tear_after(1);
+	before = host_flash_stats();
+	record(&responses[1]);
+	host_flash_tear_after(0);
+	CHECK_EQ(host_flash_stats().failed, before.failed + 1);
+
+	record(&responses[2]);
+	CHECK_EQ(host_flash_stats().row_writes, before.row_writes + 1);
+	check_replay(responses, 1);
+}
+
+/*******************************************************************************
+ * Function Name: bench_capture
+ *******************************************************************************
+ * Summary:
+ *  Times recording a typical response, a row written per response, and
+ *  reading it back out of flash with its CRC checked.
+ *
+ *******************************************************************************/
+static void bench_capture(void) {
+	const response_t response = {200, "Content-Type: application/json\r\n", 400, 1718285400, 1000};
+	uint32_t perLog = CAPTURE_ROWS * NV_STORE_ROW_SIZE / 464;
+	capture_entry_t entry;
+	uint64_t writeNs = 0;
+	uint64_t nextNs = 0;
+
+	for(int run = 0; run < BENCH_RUNS; run++) {
+		uint64_t start;
+
+		capture_init();
+		(void)body_of(&response);
+		start = test_now_ns();
+		for(uint32_t i = 0; i < perLog; i++) {
+			record(&response);
+		}
+		writeNs += test_now_ns() - start;
+
+		capture_rewind();
+		start = test_now_ns();
+		while(capture_next(&entry)) {
+		}
+		nextNs += test_now_ns() - start;
+	}
+	printf("bench,capture,write,%llu,ns\n", (unsigned long long)(writeNs / ((uint64_t)BENCH_RUNS * perLog)));
+	printf("bench,capture,next,%llu,ns\n", (unsigned long long)(nextNs / ((uint64_t)BENCH_RUNS * perLog)));
+}
+
+int main(int argc, char **argv) {
+	test_round_trip();
+	test_full();
+	test_torn_row();
+
+	if(test_bench_requested(argc, argv)) {
+		bench_capture();
+	}
+
+	return test_summary("capture");
+}
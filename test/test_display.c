@@ -0,0 +1,397 @@
+/******************************************************************************
+* File Name:   test_display.c
+*
+* Description: This file contains the host tests and benchmark of the display
+* task, drawing directly and composited, on the framebuffer of the emWin
+* stand-in. Both run the same scripted trading session of two cards, with a
+* warm start from flash, repeated quotes and an alert, through the real task
+* loop. The test checks what each update costs on the panel bus, that the
+* pixel counts the task reports are what reached the panel, and that both
+* modes leave the same picture. The benchmark prints the cost of an update
+* in each mode:
+*
+*   bench,display,<direct|composite>_<pixels|bus_bytes|windows>,<n>,<unit>
+*   bench,display,<direct|composite>_frame_time,<ns>,ns
+*
+*******************************************************************************/
+
+#include <setjmp.h>
+#include <stdarg.h>
+
+#include "GUI.h"
+#include "bench.h"
+#include "display.h"
+#include "freshness.h"
+#include "log_ring.h"
+#include "metrics.h"
+#include "pipeline.h"
+#include "quote_log.h"
+#include "test.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define CARDS        (2)
+#define ROUNDS       (240)    // One quote per card and minute, four hours
+#define REPEAT_EVERY (10)     // Rounds between repeated, unchanged quotes
+#define ALERT_ROUND  (100)    // Round whose quote fires an alert on card 1
+#define UPDATES_MAX  (CARDS * ROUNDS + CARDS * (ROUNDS / REPEAT_EVERY))
+
+// Thu 2024-06-13 09:30 EDT
+#define SESSION_OPEN (1718285400)
+
+// As laid out by display.c: 120 line cards, the sparkline in rows 70 to 87
+#define CARD_HEIGHT     (120)
+#define SPARK_TOP       (70)
+#define SPARK_BOTTOM    (87)
+#define LABEL_CHAR_AREA (12 * 24)    // A character of the 24 point labels
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+typedef struct {
+	quote_record_t record;
+	bool repeat;    // Same quote as the card's last update
+} script_step_t;
+
+// What one update cost on the panel, and what the task reported for it
+typedef struct {
+	GUI_HOST_LCD_STATS lcd;
+	uint64_t ns;
+	uint32_t reported_pixels;
+	bool repeat;
+} update_cost_t;
+
+typedef struct {
+	GUI_HOST_LCD_STATS boot;
+	update_cost_t updates[UPDATES_MAX];
+	uint32_t count;
+	GUI_COLOR frame[GUI_HOST_YSIZE][GUI_HOST_XSIZE];
+} run_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+void display_composite_task(void *arg);
+void display_panel_init(void);
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+static script_step_t script[UPDATES_MAX];
+static uint32_t scriptLen;
+static uint32_t scriptNext;
+static quote_t warmQuotes[CARDS];
+
+static TickType_t now;
+static run_t *running;
+static uint64_t updateStart;
+static jmp_buf scriptEnd;
+
+static run_t direct;
+static run_t composite;
+
+/*******************************************************************************
+ * Function Name: pipeline_receive_quote, xTaskGetTickCount, quote_log_load,
+ *                quote_log_replay_ticks, log_ring_write and the other stubs
+ *******************************************************************************
+ * Summary:
+ *  The display task's side of the pipeline plays the script, one record per
+ *  call, and notes what the update before it cost. A second passes between
+ *  records. The end of the script leaves the task's loop. The log keeps the
+ *  pixel count of the task's per-card line, the rest is not needed here.
+ *
+ *******************************************************************************/
+bool pipeline_receive_quote(quote_record_t *record, TickType_t wait) {
+	GUI_HOST_LCD_STATS stats;
+
+	GUI_HOST_GetLCDStats(&stats);
+	if(scriptNext == 0) {
+		running->boot = stats;
+	} else {
+		running->updates[scriptNext - 1].lcd = stats;
+		running->updates[scriptNext - 1].ns = test_now_ns() - updateStart;
+		running->updates[scriptNext - 1].repeat = script[scriptNext - 1].repeat;
+		running->count = scriptNext;
+	}
+	if(scriptNext == scriptLen) {
+		longjmp(scriptEnd, 1);
+	}
+
+	now += pdMS_TO_TICKS(1000);
+	*record = script[scriptNext++].record;
+	GUI_HOST_ResetLCDStats();
+	updateStart = test_now_ns();
+	return true;
+}
+
+TickType_t xTaskGetTickCount(void) {
+	return now;
+}
+
+uint32_t quote_log_load(quote_t *quotes, uint32_t max_quotes) {
+	(void)memcpy(quotes, warmQuotes, sizeof(warmQuotes));
+	return CARDS;
+}
+
+uint32_t quote_log_replay_ticks(uint32_t slot, time_t since, tick_ring_t *ring) {
+	(void)tick_ring_push(ring, warmQuotes[slot].timestamp, warmQuotes[slot].price);
+	return 1;
+}
+
+void log_ring_write(uint32_t level, const char *format, uint32_t count, ...) {
+	va_list args;
+
+	if(scriptNext == 0 || strncmp(format, "Card ", 5) != 0) {
+		return;
+	}
+	va_start(args, count);
+	(void)va_arg(args, unsigned long);
+	running->updates[scriptNext - 1].reported_pixels = (uint32_t)va_arg(args, unsigned long);
+	va_end(args);
+}
+
+void display_panel_init(void) {
+}
+
+uint32_t metrics_now(void) {
+	return 0;
+}
+
+uint32_t metrics_record(metrics_phase_t phase, uint32_t start) {
+	return 0;
+}
+
+void freshness_record(time_t server_time, const freshness_stamps_t *stamps, TickType_t flushed) {
+}
+
+void bench_run_parse(quote_table_t *table) {
+}
+
+void bench_measure(bench_stage_t stage, bench_op_t op, void *arg) {
+}
+
+void bench_report(void) {
+}
+
+/*******************************************************************************
+ * Function Name: build_script
+ *******************************************************************************
+ * Summary:
+ *  A session of two cards: yesterday's close restored from flash, then a
+ *  quote per card and minute walking the price. Every REPEAT_EVERY rounds
+ *  the round is sent twice, as when a fetch returns before the feed moved.
+ *  Card 1 fires an alert at ALERT_ROUND, whose frame expires a minute later.
+ *
+ *******************************************************************************/
+static void build_script(void) {
+	static const char *const symbols[CARDS] = {"AAPL", "MSFT"};
+	static const fixed_t closes[CARDS] = {1567900, 4251500};
+	uint32_t seed = 12345;
+
+	scriptLen = 0;
+	for(int card = 0; card < CARDS; card++) {
+		quote_t *quote = &warmQuotes[card];
+
+		(void)memset(quote, 0, sizeof(*quote));
+		(void)snprintf(quote->symbol, sizeof(quote->symbol), "%s", symbols[card]);
+		quote->price = quote->previous_close = quote->open = quote->day_low = quote->day_high = closes[card];
+		quote->timestamp = SESSION_OPEN - 17 * 60 * 60;
+	}
+
+	for(int round = 0; round < ROUNDS; round++) {
+		for(int copy = 0; copy < ((round % REPEAT_EVERY == REPEAT_EVERY - 1) ? 2 : 1); copy++) {
+			for(int card = 0; card < CARDS; card++) {
+				script_step_t *step = &script[scriptLen++];
+				quote_record_t *record = &step->record;
+				const quote_t *last = (round == 0) ? &warmQuotes[card] : &script[scriptLen - 1 - CARDS].record.quote;
+
+				(void)memset(step, 0, sizeof(*step));
+				record->slot = (uint32_t)card;
+				record->count = CARDS;
+				record->quote = *last;
+				step->repeat = copy > 0;
+				if(copy == 0) {
+					// A walk of up to 25 cents a minute either way
+					seed = seed * 1103515245u + 12345u;
+					record->quote.price += (fixed_t)((int)((seed >> 16) % 51) - 25) * 100;
+					record->quote.timestamp = SESSION_OPEN + round * 60;
+					if(round == 0) {
+						record->quote.open = record->quote.day_low = record->quote.day_high = record->quote.price;
+					}
+				}
+				if(record->quote.price < record->quote.day_low) {
+					record->quote.day_low = record->quote.price;
+				}
+				if(record->quote.price > record->quote.day_high) {
+					record->quote.day_high = record->quote.price;
+				}
+				record->quote.change_percent = (record->quote.price - record->quote.previous_close) * 100 * FIXED_SCALE / record->quote.previous_close;
+				record->indicators.from_open_percent = (record->quote.price - record->quote.open) * 100 * FIXED_SCALE / record->quote.open;
+				record->alert = (card == 1 && round == ALERT_ROUND && copy == 0);
+			}
+		}
+	}
+}
+
+/*******************************************************************************
+ * Function Name: run_display
+ *******************************************************************************
+ * Summary:
+ *  Runs a display task over the script and keeps the picture it leaves.
+ *
+ *******************************************************************************/
+static void run_display(run_t *run, void (*task)(void *arg)) {
+	running = run;
+	scriptNext = 0;
+	now = 0;
+	if(setjmp(scriptEnd) == 0) {
+		task(NULL);
+	}
+
+	for(int y = 0; y < GUI_HOST_YSIZE; y++) {
+		for(int x = 0; x < GUI_HOST_XSIZE; x++) {
+			run->frame[y][x] = GUI_HOST_GetPixel(x, y);
+		}
+	}
+}
+
+/*******************************************************************************
+ * Function Name: test_direct
+ *******************************************************************************
+ * Summary:
+ *  Drawing directly, the labels are drawn once at boot and an update only
+ *  touches the fields that changed: a repeated quote costs nothing, and no
+ *  update comes near a whole card. The pixels the task reports are the
+ *  pixels the panel was sent.
+ *
+ *******************************************************************************/
+static void test_direct(void) {
+	uint64_t total = 0;
+	uint32_t largest = 0;
+	int labelInk = 0;
+
+	CHECK_EQ(direct.count, scriptLen);
+	for(uint32_t i = 0; i < direct.count; i++) {
+		const update_cost_t *update = &direct.updates[i];
+
+		if(update->repeat && i < (uint32_t)(ALERT_ROUND * CARDS)) {
+			CHECK_EQ(update->lcd.pixels, 0);
+			CHECK_EQ(update->lcd.windows, 0);
+		}
+		CHECK_EQ(update->reported_pixels, update->lcd.pixels);
+		total += update->lcd.pixels;
+		if(update->lcd.pixels > largest) {
+			largest = update->lcd.pixels;
+		}
+	}
+	CHECK(largest < GUI_HOST_XSIZE * CARD_HEIGHT);
+	CHECK(total / direct.count < GUI_HOST_XSIZE * CARD_HEIGHT / 4);
+
+	// "PC/O" of the last card is still there, nothing after boot drew it
+	for(int y = CARD_HEIGHT + 30; y < CARD_HEIGHT + 30 + 24; y++) {
+		for(int x = 0; x < 4 * 12; x++) {
+			labelInk += direct.frame[y][x] != GUI_BLACK;
+		}
+	}
+	CHECK(labelInk > 4 * LABEL_CHAR_AREA / 2);
+}
+
+/*******************************************************************************
+ * Function Name: test_composite
+ *******************************************************************************
+ * Summary:
+ *  Composited, a card that changed reaches the panel in one window write of
+ *  the whole card, and a repeated quote does not reach it at all.
+ *
+ *******************************************************************************/
+static void test_composite(void) {
+	const uint32_t card = GUI_HOST_XSIZE * CARD_HEIGHT;
+
+	CHECK_EQ(composite.count, scriptLen);
+	for(uint32_t i = 0; i < composite.count; i++) {
+		const update_cost_t *update = &composite.updates[i];
+
+		if(update->repeat) {
+			if(i < (uint32_t)(ALERT_ROUND * CARDS)) {
+				CHECK_EQ(update->lcd.windows, 0);
+			}
+		} else {
+			CHECK_EQ(update->lcd.windows, 1);
+			CHECK_EQ(update->lcd.pixels, card);
+			CHECK_EQ(update->lcd.bus_bytes, GUI_HOST_WINDOW_BYTES + 2 * card);
+		}
+		CHECK_EQ(update->reported_pixels, update->lcd.pixels);
+	}
+}
+
+/*******************************************************************************
+ * Function Name: test_same_picture
+ *******************************************************************************
+ * Summary:
+ *  Both modes end on the same picture. The sparklines are left out: drawn
+ *  directly they grow a column at a time on the scale of their last full
+ *  redraw, composited they are redrawn, and rescaled, with every update.
+ *
+ *******************************************************************************/
+static void test_same_picture(void) {
+	uint32_t differing = 0;
+
+	for(int y = 0; y < GUI_HOST_YSIZE; y++) {
+		int row = y % CARD_HEIGHT;
+
+		if(row >= SPARK_TOP && row <= SPARK_BOTTOM) {
+			continue;
+		}
+		for(int x = 0; x < GUI_HOST_XSIZE; x++) {
+			differing += direct.frame[y][x] != composite.frame[y][x];
+		}
+	}
+	CHECK_EQ(differing, 0);
+}
+
+/*******************************************************************************
+ * Function Name: bench_print
+ *******************************************************************************
+ * Summary:
+ *  Prints the average cost of an update that changed something.
+ *
+ *******************************************************************************/
+static void bench_print(const char *mode, const run_t *run) {
+	uint64_t pixels = 0, bytes = 0, windows = 0, ns = 0;
+	uint32_t count = 0;
+
+	for(uint32_t i = 0; i < run->count; i++) {
+		if(!run->updates[i].repeat) {
+			pixels += run->updates[i].lcd.pixels;
+			bytes += run->updates[i].lcd.bus_bytes;
+			windows += run->updates[i].lcd.windows;
+			ns += run->updates[i].ns;
+			count++;
+		}
+	}
+	printf("bench,display,%s_pixels,%llu,px\n", mode, (unsigned long long)(pixels / count));
+	printf("bench,display,%s_bus_bytes,%llu,B\n", mode, (unsigned long long)(bytes / count));
+	printf("bench,display,%s_windows,%llu,windows\n", mode, (unsigned long long)(windows / count));
+	printf("bench,display,%s_frame_time,%llu,ns\n", mode, (unsigned long long)(ns / count));
+}
+
+int main(int argc, char **argv) {
+	setenv("TZ", "EST5EDT", 1);
+	tzset();
+
+	build_script();
+	run_display(&direct, display_task);
+	run_display(&composite, display_composite_task);
+
+	test_direct();
+	test_composite();
+	test_same_picture();
+
+	if(test_bench_requested(argc, argv)) {
+		bench_print("direct", &direct);
+		bench_print("composite", &composite);
+	}
+
+	return test_summary("display");
+}
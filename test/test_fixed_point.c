@@ -0,0 +1,198 @@
+/******************************************************************************
+* File Name:   test_fixed_point.c
+*
+* Description: This file contains the host tests and microbenchmark of the
+* fixed point parser and formatter. The benchmark runs the per-tick work of
+* one quote, the seven numeric fields parsed and the six card fields
+* formatted, once with fixed_parse/fixed_format and once the way the code
+* did it before, strtod and "%.2f". A host FPU does doubles in hardware, so
+* the gap here is a floor; on the Cortex-M4, where double is soft-float,
+* BENCH_FORMAT of the on-device bench gives the real cycles.
+*
+*   bench,fixed_point,<fixed|double>_tick,<ns per tick>,ns
+*
+*******************************************************************************/
+
+#include <stdlib.h>
+
+#include "fixed_point.h"
+#include "test.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define BENCH_RUNS (200000)
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+// Numeric fields of one recorded quote, as FMP sends them
+static const char *const tickFields[] = {"156.79", "-1.2346", "153.65", "158.36", "156.01", "157.26", "1718308800"};
+#define TICK_FIELDS (sizeof(tickFields) / sizeof(tickFields[0]))
+
+/*******************************************************************************
+ * Function Name: parse
+ *******************************************************************************
+ * Summary:
+ *  fixed_parse of a C string.
+ *
+ *******************************************************************************/
+static fixed_t parse(const char *text) {
+	return fixed_parse(text, strlen(text));
+}
+
+/*******************************************************************************
+ * Function Name: format
+ *******************************************************************************
+ * Summary:
+ *  fixed_format into a static buffer.
+ *
+ *******************************************************************************/
+static const char *format(fixed_t value, uint32_t decimals, bool plus_sign) {
+	static char buffer[32];
+
+	(void)fixed_format(buffer, sizeof(buffer), value, decimals, plus_sign);
+	return buffer;
+}
+
+/*******************************************************************************
+ * Function Name: test_parse
+ *******************************************************************************
+ * Summary:
+ *  Decimal text to 1e-4 units: rounding, exponents, saturation and junk.
+ *
+ *******************************************************************************/
+static void test_parse(void) {
+	CHECK_EQ(parse("0"), 0);
+	CHECK_EQ(parse("156.79"), 1567900);
+	CHECK_EQ(parse("-1.2346"), -12346);
+	CHECK_EQ(parse("+3"), 30000);
+	CHECK_EQ(parse("0.00005"), 1);      // Half away from zero
+	CHECK_EQ(parse("-0.00005"), -1);
+	CHECK_EQ(parse("0.000049"), 0);
+	CHECK_EQ(parse("1.23456"), 12346);
+	CHECK_EQ(parse("2.52131E11"), 2521310000000000LL);
+	CHECK_EQ(parse("1.5e-3"), 15);
+	CHECK_EQ(parse("1718308800"), 17183088000000LL);
+	CHECK_EQ(parse("00012.50"), 125000);
+	CHECK_EQ(parse("123456789012345678901234"), INT64_MAX);
+	CHECK_EQ(parse("-1e30"), -INT64_MAX);
+	CHECK_EQ(parse("1e-30"), 0);
+	CHECK_EQ(parse("null"), 0);
+	CHECK_EQ(parse("1.2.3"), 0);
+	CHECK_EQ(fixed_parse("156.79", 3), 1560000);    // Only len bytes are read
+}
+
+/*******************************************************************************
+ * Function Name: test_format
+ *******************************************************************************
+ * Summary:
+ *  1e-4 units to text: decimals, rounding, signs and short buffers.
+ *
+ *******************************************************************************/
+static void test_format(void) {
+	char small[6];
+
+	CHECK_STR(format(1567900, 2, false), "156.79");
+	CHECK_STR(format(1567890, 2, false), "156.79");
+	CHECK_STR(format(1567850, 2, false), "156.79");
+	CHECK_STR(format(1567849, 2, false), "156.78");
+	CHECK_STR(format(-12346, 2, true), "-1.23");
+	CHECK_STR(format(12346, 2, true), "+1.23");
+	CHECK_STR(format(-40, 2, false), "0.00");    // No "-0.00"
+	CHECK_STR(format(0, 2, true), "+0.00");
+	CHECK_STR(format(5, 0, false), "0");
+	CHECK_STR(format(5000, 0, false), "1");
+	CHECK_STR(format(12345, 4, false), "1.2345");
+	CHECK_STR(format(12345, 9, false), "1.2345");    // At most FIXED_DECIMALS
+	CHECK_STR(format(INT64_MAX, 4, false), "922337203685477.5807");
+
+	CHECK_EQ(fixed_format(small, sizeof(small), 1567900, 2, false), 0);
+	CHECK_STR(small, "");
+	CHECK_EQ(fixed_format(small, sizeof(small), 12300, 2, false), 4);
+	CHECK_STR(small, "1.23");
+}
+
+/*******************************************************************************
+ * Function Name: test_round_trip
+ *******************************************************************************
+ * Summary:
+ *  Random values printed with four decimals parse back to themselves, and
+ *  format like printf does for values with no rounding tie.
+ *
+ *******************************************************************************/
+static void test_round_trip(void) {
+	char text[40];
+	bool parsed = true;
+	bool formatted = true;
+
+	srand(1);
+	for(int i = 0; i < 100000; i++) {
+		long long value = ((long long)rand() << 16 ^ rand()) % 100000000000LL - 50000000000LL;
+
+		(void)snprintf(text, sizeof(text), "%s%lld.%04lld", (value < 0) ? "-" : "", llabs(value) / FIXED_SCALE, llabs(value) % FIXED_SCALE);
+		parsed = parsed && (parse(text) == value);
+
+		if(llabs(value) % 100 != 50) {
+			char expected[40];
+			long long cents = (llabs(value) + 50) / 100;
+
+			(void)snprintf(expected, sizeof(expected), "%s%lld.%02lld", (value < 0 && cents != 0) ? "-" : "", (long long)(cents / 100),
+						   (long long)(cents % 100));
+			formatted = formatted && (strcmp(format(value, 2, false), expected) == 0);
+		}
+	}
+	CHECK(parsed);
+	CHECK(formatted);
+}
+
+/*******************************************************************************
+ * Function Name: bench_tick
+ *******************************************************************************
+ * Summary:
+ *  Times one quote's parse and format, fixed point against double.
+ *
+ *******************************************************************************/
+static void bench_tick(void) {
+	volatile int64_t sink = 0;
+	char buffer[32];
+	uint64_t start = test_now_ns();
+
+	for(int run = 0; run < BENCH_RUNS; run++) {
+		fixed_t values[TICK_FIELDS];
+
+		for(size_t i = 0; i < TICK_FIELDS; i++) {
+			values[i] = fixed_parse(tickFields[i], strlen(tickFields[i]));
+		}
+		for(size_t i = 0; i < TICK_FIELDS - 1; i++) {
+			sink += (int64_t)fixed_format(buffer, sizeof(buffer), values[i], 2, i == 1);
+		}
+	}
+	printf("bench,fixed_point,fixed_tick,%llu,ns\n", (unsigned long long)((test_now_ns() - start) / BENCH_RUNS));
+
+	start = test_now_ns();
+	for(int run = 0; run < BENCH_RUNS; run++) {
+		double values[TICK_FIELDS];
+
+		for(size_t i = 0; i < TICK_FIELDS; i++) {
+			values[i] = strtod(tickFields[i], NULL);
+		}
+		for(size_t i = 0; i < TICK_FIELDS - 1; i++) {
+			sink += snprintf(buffer, sizeof(buffer), (i == 1) ? "%+.2f" : "%.2f", values[i]);
+		}
+	}
+	printf("bench,fixed_point,double_tick,%llu,ns\n", (unsigned long long)((test_now_ns() - start) / BENCH_RUNS));
+	(void)sink;
+}
+
+int main(int argc, char **argv) {
+	test_parse();
+	test_format();
+	test_round_trip();
+
+	if(test_bench_requested(argc, argv)) {
+		bench_tick();
+	}
+
+	return test_summary("fixed_point");
+}
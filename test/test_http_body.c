@@ -0,0 +1,394 @@
+/******************************************************************************
+* File Name:   test_http_body.c
+*
+* Description: This file contains the host tests and benchmark of the HTTP
+* response framer. Responses built around the recorded /api/v3/quote body,
+* chunked and with Content-Length, are fed whole, split at every byte and a
+* TCP segment at a time, and the sink must always get exactly the body. The
+* benchmark measures what the streamed path buys: the receive buffer a
+* response needs against the one the network task reserves, and the work
+* left once the last byte is in, streamed against parsing a buffered body:
+*
+*   bench,http_body,response_<symbols>,<bytes>,B
+*   bench,http_body,buffer_<symbols>,<bytes>,B
+*   bench,http_body,frame_response,<ns per response>,ns
+*   bench,http_body,after_last_byte_<streamed|buffered>,<ns>,ns
+*
+*******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "http_body.h"
+#include "quote_stream.h"
+#include "test.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define BENCH_RUNS   (20000)
+#define SEGMENT_LEN  (1460)         // TCP payload of a full Ethernet frame
+#define COPY_LEN     (16 * 1024)
+#define RESPONSE_LEN (64 * 1024)    // Room for the body in one byte chunks
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+typedef struct {
+	uint8_t data[COPY_LEN];
+	size_t len;
+	bool offsets_ok;    // Every piece arrived at the offset it belongs at
+} body_copy_t;
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+// Headers of a quote response as the API's CDN sends them
+static const char responseHeaders[] = "HTTP/1.1 200 OK\r\n"
+									  "Date: Thu, 13 Jun 2024 20:00:00 GMT\r\n"
+									  "Content-Type: application/json;charset=UTF-8\r\n"
+									  "%s"
+									  "Connection: keep-alive\r\n"
+									  "Vary: Accept-Encoding\r\n"
+									  "Access-Control-Allow-Origin: *\r\n"
+									  "Access-Control-Allow-Methods: GET, POST, PUT, DELETE, OPTIONS\r\n"
+									  "X-Frame-Options: SAMEORIGIN\r\n"
+									  "X-Powered-By: Express\r\n"
+									  "Cache-Control: no-store, no-cache, must-revalidate, proxy-revalidate\r\n"
+									  "ETag: W/\"12f2-7b1mOZf3JyQ0vD8y4uQ0o8c3kYk\"\r\n"
+									  "CF-Cache-Status: DYNAMIC\r\n"
+									  "Report-To: {\"endpoints\":[{\"url\":\"https:\\/\\/a.nel.cloudflare.com\\/report\\/v4?s=Xk2mH1c7EwYB8p\"}],"
+									  "\"group\":\"cf-nel\",\"max_age\":604800}\r\n"
+									  "NEL: {\"success_fraction\":0,\"report_to\":\"cf-nel\",\"max_age\":604800}\r\n"
+									  "Server: cloudflare\r\n"
+									  "CF-RAY: 8936a1b2c3d4e5f6-IAD\r\n"
+									  "\r\n";
+
+static char *json;
+static size_t jsonLen;
+
+/*******************************************************************************
+ * Function Name: copy_sink
+ *******************************************************************************
+ * Summary:
+ *  Collects the body the framer passes on.
+ *
+ *******************************************************************************/
+static void copy_sink(void *arg, const uint8_t *data, size_t len, size_t offset) {
+	body_copy_t *copy = arg;
+
+	copy->offsets_ok = copy->offsets_ok && offset == copy->len;
+	if(copy->len + len <= COPY_LEN) {
+		(void)memcpy(&copy->data[copy->len], data, len);
+	}
+	copy->len += len;
+}
+
+/*******************************************************************************
+ * Function Name: stream_sink
+ *******************************************************************************
+ * Summary:
+ *  Feeds the body to the quote extractor, as the pipeline's sink does.
+ *
+ *******************************************************************************/
+static void stream_sink(void *arg, const uint8_t *data, size_t len, size_t offset) {
+	quote_stream_feed(arg, (const char *)data, len);
+}
+
+/*******************************************************************************
+ * Function Name: build_response
+ *******************************************************************************
+ * Summary:
+ *  A response carrying body, chunked in pieces of chunk bytes when chunk is
+ *  not 0, with Content-Length otherwise, followed by tail.
+ *
+ * Return:
+ *  size_t : length of the response in out
+ *
+ *******************************************************************************/
+static size_t build_response(char *out, size_t size, const char *body, size_t body_len, size_t chunk, const char *tail) {
+	char framing[64];
+	size_t len;
+
+	if(chunk > 0) {
+		(void)snprintf(framing, sizeof(framing), "Transfer-Encoding: chunked\r\n");
+	} else {
+		(void)snprintf(framing, sizeof(framing), "Content-Length: %zu\r\n", body_len);
+	}
+	len = (size_t)snprintf(out, size, responseHeaders, framing);
+
+	if(chunk == 0) {
+		(void)memcpy(&out[len], body, body_len);
+		len += body_len;
+	} else {
+		for(size_t at = 0; at < body_len; at += chunk) {
+			size_t n = (body_len - at < chunk) ? body_len - at : chunk;
+
+			len += (size_t)snprintf(&out[len], size - len, "%zx%s\r\n", n, (at == 0) ? ";ext=1" : "");
+			(void)memcpy(&out[len], &body[at], n);
+			len += n;
+			len += (size_t)snprintf(&out[len], size - len, "\r\n");
+		}
+		len += (size_t)snprintf(&out[len], size - len, "0\r\nX-Trailer: 1\r\n\r\n");
+	}
+
+	len += (size_t)snprintf(&out[len], size - len, "%s", tail);
+	return len;
+}
+
+/*******************************************************************************
+ * Function Name: frame
+ *******************************************************************************
+ * Summary:
+ *  Runs a response through a fresh framer in pieces of step bytes, the last
+ *  piece shorter, and checks that the sink got exactly the expected body.
+ *
+ *******************************************************************************/
+static bool frame(const char *response, size_t len, size_t step, const char *body, size_t body_len, http_body_state_t end) {
+	static body_copy_t copy;
+	http_body_t framer;
+
+	copy.len = 0;
+	copy.offsets_ok = true;
+	http_body_init(&framer, copy_sink, &copy);
+	for(size_t at = 0; at < len; at += step) {
+		http_body_feed(&framer, (const uint8_t *)&response[at], (len - at < step) ? len - at : step);
+	}
+
+	return framer.state == end && copy.offsets_ok && copy.len == body_len && memcmp(copy.data, body, body_len) == 0;
+}
+
+/*******************************************************************************
+ * Function Name: test_framing
+ *******************************************************************************
+ * Summary:
+ *  The quote body comes through exactly, chunked and with Content-Length,
+ *  however the response is split, and the next response pipelined behind it
+ *  never reaches the sink.
+ *
+ *******************************************************************************/
+static void test_framing(void) {
+	static char response[RESPONSE_LEN];
+	static const char next[] = "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\n[]";
+	static const size_t chunks[] = {0, 1, 0x3f2, 4096};
+	bool allSplits = true;
+
+	for(size_t c = 0; c < sizeof(chunks) / sizeof(chunks[0]); c++) {
+		size_t len = build_response(response, sizeof(response), json, jsonLen, chunks[c], next);
+
+		CHECK(frame(response, len, len, json, jsonLen, HTTP_BODY_DONE));
+		CHECK(frame(response, len, SEGMENT_LEN, json, jsonLen, HTTP_BODY_DONE));
+		CHECK(frame(response, len, 1, json, jsonLen, HTTP_BODY_DONE));
+		for(size_t step = 2; step < 300; step += 7) {
+			allSplits = allSplits && frame(response, len, step, json, jsonLen, HTTP_BODY_DONE);
+		}
+	}
+	CHECK(allSplits);
+}
+
+/*******************************************************************************
+ * Function Name: test_headers
+ *******************************************************************************
+ * Summary:
+ *  Header names in any case, an interim 100 response, a body ending with the
+ *  connection, an empty body, and codings the framer leaves to the caller.
+ *
+ *******************************************************************************/
+static void test_headers(void) {
+	static const char lower[] = "HTTP/1.1 200 OK\r\ntransfer-encoding:  Chunked \r\n\r\n2\r\n[]\r\n0\r\n\r\n";
+	static const char interim[] = "HTTP/1.1 100 Continue\r\n\r\nHTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\n[]xx";
+	static const char untilClose[] = "HTTP/1.0 200 OK\r\nServer: test\r\n\r\n[{}]";
+	static const char empty[] = "HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\nHTTP/1.1";
+	static const char notModified[] = "HTTP/1.1 304 Not Modified\r\nETag: x\r\n\r\n";
+	static const char gzip[] = "HTTP/1.1 200 OK\r\nTransfer-Encoding: gzip, chunked\r\n\r\n5\r\n\x1f\x8b\x08\x00\x00\r\n0\r\n\r\n";
+	static const char longCoding[] = "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked                                              \r\n\r\n"
+									 "2\r\n[]\r\n0\r\n\r\n";
+	static const char rateLimited[] = "HTTP/1.1 429 Too Many Requests\r\nRetry-After: 30\r\nContent-Length: 38\r\n\r\n"
+									  "{\"Error Message\": \"Limit Reach . ...\"}";
+
+	CHECK(frame(lower, sizeof(lower) - 1, 1, "[]", 2, HTTP_BODY_DONE));
+	CHECK(frame(interim, sizeof(interim) - 1, 3, "[]", 2, HTTP_BODY_DONE));
+	CHECK(frame(untilClose, sizeof(untilClose) - 1, 5, "[{}]", 4, HTTP_BODY_UNTIL_CLOSE));
+	CHECK(frame(empty, sizeof(empty) - 1, 1, "", 0, HTTP_BODY_DONE));
+	CHECK(frame(notModified, sizeof(notModified) - 1, 1, "", 0, HTTP_BODY_DONE));
+	CHECK(frame(gzip, sizeof(gzip) - 1, 1, "", 0, HTTP_BODY_UNSUPPORTED));
+	CHECK(frame(longCoding, sizeof(longCoding) - 1, 1, "", 0, HTTP_BODY_UNSUPPORTED));
+	CHECK(frame(rateLimited, sizeof(rateLimited) - 1, 4, rateLimited + sizeof(rateLimited) - 39, 38, HTTP_BODY_DONE));
+}
+
+/*******************************************************************************
+ * Function Name: test_errors
+ *******************************************************************************
+ * Summary:
+ *  Malformed framing stops the body short instead of passing on bytes that
+ *  are not body, and the caller can tell it was not done.
+ *
+ *******************************************************************************/
+static void test_errors(void) {
+	static const char notHttp[] = "SSH-2.0-OpenSSH_9.6\r\n\r\n[]";
+	static const char badLength[] = "HTTP/1.1 200 OK\r\nContent-Length: 2x\r\n\r\n[]";
+	static const char twoLengths[] = "HTTP/1.1 200 OK\r\nContent-Length: 2\r\nContent-Length: 3\r\n\r\n[]";
+	static const char badSize[] = "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\nzz\r\n[]\r\n0\r\n\r\n";
+	static const char noCrlf[] = "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n2\r\n[]xx0\r\n\r\n";
+	static const char hugeSize[] = "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\nffffffffffffffffff\r\n[]";
+	static const char cutShort[] = "HTTP/1.1 200 OK\r\nContent-Length: 10\r\n\r\n[{\"a\"";
+	http_body_t framer;
+
+	CHECK(frame(notHttp, sizeof(notHttp) - 1, 1, "", 0, HTTP_BODY_ERROR));
+	CHECK(frame(badLength, sizeof(badLength) - 1, 1, "", 0, HTTP_BODY_ERROR));
+	CHECK(frame(twoLengths, sizeof(twoLengths) - 1, 1, "", 0, HTTP_BODY_ERROR));
+	CHECK(frame(badSize, sizeof(badSize) - 1, 1, "", 0, HTTP_BODY_ERROR));
+	CHECK(frame(noCrlf, sizeof(noCrlf) - 1, 1, "[]", 2, HTTP_BODY_ERROR));
+	CHECK(frame(hugeSize, sizeof(hugeSize) - 1, 1, "", 0, HTTP_BODY_ERROR));
+	CHECK(frame(cutShort, sizeof(cutShort) - 1, 1, "[{\"a\"", 5, HTTP_BODY_LENGTH));
+
+	http_body_init(&framer, NULL, NULL);
+	http_body_feed(&framer, (const uint8_t *)cutShort, sizeof(cutShort) - 1);
+	CHECK(!http_body_done(&framer));
+	http_body_feed(&framer, (const uint8_t *)"]}\"b\"]", 5);
+	CHECK(http_body_done(&framer));
+	CHECK_EQ(framer.offset, 10);
+}
+
+/*******************************************************************************
+ * Function Name: test_quotes
+ *******************************************************************************
+ * Summary:
+ *  The chunked response streamed segment by segment into the extractor gives
+ *  the table a buffered parse of the body gives.
+ *
+ *******************************************************************************/
+static void test_quotes(void) {
+	static char response[COPY_LEN];
+	static quote_table_t streamed;
+	static quote_table_t buffered;
+	quote_stream_t stream;
+	http_body_t framer;
+	size_t len = build_response(response, sizeof(response), json, jsonLen, 0x3f2, "");
+
+	quote_stream_init(&stream, &streamed);
+	http_body_init(&framer, stream_sink, &stream);
+	for(size_t at = 0; at < len; at += SEGMENT_LEN) {
+		http_body_feed(&framer, (const uint8_t *)&response[at], (len - at < SEGMENT_LEN) ? len - at : SEGMENT_LEN);
+	}
+	CHECK_EQ(quote_stream_finish(&stream), 8);
+	CHECK_EQ(quote_table_parse(&buffered, json, jsonLen), 8);
+	CHECK(memcmp(&streamed, &buffered, sizeof(streamed)) == 0);
+}
+
+/*******************************************************************************
+ * Function Name: test_buffer_size
+ *******************************************************************************
+ * Summary:
+ *  The receive buffer the network task reserves for a watchlist holds the
+ *  response for it, chunk framing included, up to a full table. The widest
+ *  recorded quote object stays inside QUOTE_JSON_BYTES.
+ *
+ *******************************************************************************/
+static void test_buffer_size(bool report) {
+	static char response[COPY_LEN];
+	size_t widest = 0;
+	size_t start = 0;
+	int depth = 0;
+
+	for(size_t i = 0; i < jsonLen; i++) {
+		if(json[i] == '{' && depth++ == 0) {
+			start = i;
+		} else if(json[i] == '}' && --depth == 0) {
+			widest = (i + 1 - start > widest) ? i + 1 - start : widest;
+		}
+	}
+	CHECK(widest + 128 <= QUOTE_JSON_BYTES);
+
+	for(uint32_t symbols = 1; symbols <= QUOTE_TABLE_CAPACITY; symbols++) {
+		size_t bodyLen = 0;
+		size_t len;
+
+		// The first n objects and the closing bracket
+		for(int seen = 0, d = 0; bodyLen < jsonLen && seen < (int)symbols; bodyLen++) {
+			if(json[bodyLen] == '{') {
+				d++;
+			} else if(json[bodyLen] == '}' && --d == 0) {
+				seen++;
+			}
+		}
+		(void)memcpy(response, json, bodyLen);
+		(void)memcpy(&response[bodyLen], "\n]", 2);
+		bodyLen += 2;
+		(void)memmove(&response[COPY_LEN / 2], response, bodyLen);
+		len = build_response(response, COPY_LEN / 2, &response[COPY_LEN / 2], bodyLen, 0x3f2, "");
+
+		CHECK(len <= HTTP_BODY_HEADER_BYTES + symbols * QUOTE_JSON_BYTES);
+		if(report && (symbols == 3 || symbols == QUOTE_TABLE_CAPACITY)) {
+			printf("bench,http_body,response_%lu,%zu,B\n", (unsigned long)symbols, len);
+			printf("bench,http_body,buffer_%lu,%lu,B\n", (unsigned long)symbols, (unsigned long)(HTTP_BODY_HEADER_BYTES + symbols * QUOTE_JSON_BYTES));
+		}
+	}
+}
+
+/*******************************************************************************
+ * Function Name: bench_last_byte
+ *******************************************************************************
+ * Summary:
+ *  Times framing a whole response, then the work left after its last segment
+ *  arrives: streamed, framing and extracting that segment and finishing the
+ *  table; buffered, parsing the whole body as before the streamed path.
+ *
+ *******************************************************************************/
+static void bench_last_byte(void) {
+	static char response[COPY_LEN];
+	static quote_table_t table;
+	size_t len = build_response(response, sizeof(response), json, jsonLen, 0x3f2, "");
+	size_t last = (len - 1) / SEGMENT_LEN * SEGMENT_LEN;
+	volatile uint32_t sink = 0;
+	uint64_t streamed = 0;
+	uint64_t start;
+
+	start = test_now_ns();
+	for(int run = 0; run < BENCH_RUNS; run++) {
+		http_body_t framer;
+
+		http_body_init(&framer, NULL, NULL);
+		http_body_feed(&framer, (const uint8_t *)response, len);
+		sink += framer.state;
+	}
+	printf("bench,http_body,frame_response,%llu,ns\n", (unsigned long long)((test_now_ns() - start) / BENCH_RUNS));
+
+	for(int run = 0; run < BENCH_RUNS; run++) {
+		quote_stream_t stream;
+		http_body_t framer;
+
+		quote_stream_init(&stream, &table);
+		http_body_init(&framer, stream_sink, &stream);
+		http_body_feed(&framer, (const uint8_t *)response, last);
+		start = test_now_ns();
+		http_body_feed(&framer, (const uint8_t *)&response[last], len - last);
+		sink += quote_stream_finish(&stream);
+		streamed += test_now_ns() - start;
+	}
+	printf("bench,http_body,after_last_byte_streamed,%llu,ns\n", (unsigned long long)(streamed / BENCH_RUNS));
+
+	start = test_now_ns();
+	for(int run = 0; run < BENCH_RUNS; run++) {
+		sink += quote_table_parse(&table, json, jsonLen);
+	}
+	printf("bench,http_body,after_last_byte_buffered,%llu,ns\n", (unsigned long long)((test_now_ns() - start) / BENCH_RUNS));
+	(void)sink;
+}
+
+int main(int argc, char **argv) {
+	json = test_read_file("fmp_quote_many.json", &jsonLen);
+
+	test_framing();
+	test_headers();
+	test_errors();
+	test_quotes();
+	test_buffer_size(test_bench_requested(argc, argv));
+
+	if(test_bench_requested(argc, argv)) {
+		bench_last_byte();
+	}
+
+	free(json);
+	return test_summary("http_body");
+}
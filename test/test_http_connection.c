@@ -0,0 +1,991 @@
+/******************************************************************************
+* File Name:   test_http_connection.c
+*
+* Description: This file contains the host fault-injection test of the
+* connection manager and its reconnect state machine. The manager runs over
+* the host's HTTP client, host/http_client_host.c, linked with the same
+* socket wrappers as the firmware; the socket below it is a scripted server
+* in this file that takes the faults of the stand-in server
+* (host/standin_server.py) one request at a time, and hands its responses
+* over in pieces of random size. The clock is virtual, so backoff and the
+* circuit breaker are checked to the millisecond without waiting.
+*
+* The test checks session reuse, TLS session resumption and when it is
+* dropped, the class given to each failure, the bounds of the jittered
+* backoff, that nothing is sent while backing off or with the circuit open,
+* that bodies the caller rejects open it too, and that every body reaches
+* the body sink intact.
+* A soak run of the stand-in's chaos mix checks the same over a long run;
+* the benchmark prints what it cost:
+*
+*   bench,http_connection,soak_<handshakes|failures>_per_100_requests,<n>,n
+*   bench,http_connection,soak_mean_retry_delay,<ms>,ms
+*
+*******************************************************************************/
+
+#define _GNU_SOURCE    // memmem
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "freshness.h"
+#include "host_socket.h"
+#include "http_connection.h"
+#include "log_ring.h"
+#include "metrics.h"
+#include "test.h"
+#include "tls_session_cache.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define RESPONSE_MAX  (4096)
+#define PIECE_MAX     (700)      // Largest piece the server hands over at once
+#define CHUNK_LEN     (100)      // Chunk size of chunked bodies
+#define POLL_MS       (60000)    // Wait between polls after a success
+#define SEEDS         (64)
+#define SOAK_POLLS    (5000)
+
+#define RESOURCE_PATH "/api/v3/quote/AAPL,MSFT"
+#define HOST_NAME     "financialmodelingprep.com"
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+// As named by the stand-in server, connect faults first
+typedef enum {
+	FAULT_DNS,            // Host name does not resolve
+	FAULT_RESET,          // Connect refused
+	FAULT_TLS,            // Handshake fails
+	FAULT_NONE,           // Clean keep-alive response, the default
+	FAULT_CHUNKED,        // Body sent chunked
+	FAULT_UNTIL_CLOSE,    // Body ends with the connection
+	FAULT_CLOSE,          // Connection: close after the response
+	FAULT_429,
+	FAULT_503,
+	FAULT_DISCONNECT,     // Closed half way through the response
+	FAULT_STALL,          // Stops sending half way through the response
+	FAULT_DROP_IDLE,      // Idle session closed before the request
+	FAULT_COUNT
+} fault_t;
+
+struct host_socket {
+	char response[RESPONSE_MAX];
+	size_t len;
+	size_t sent;       // Bytes of the response handed over so far
+	size_t cut;        // Where the server stops sending
+	bool closes;       // The server closes at the cut, else it goes quiet
+};
+
+// The scripted server and what was asked of it
+typedef struct {
+	fault_t faults[16];    // Played one per network event they apply to
+	uint32_t fault_count;
+	uint32_t fault_next;
+
+	uint32_t lookups;
+	uint32_t opens;
+	uint32_t closes;
+	uint32_t requests;
+	uint32_t tls_failures;
+	bool session_cached;    // A TLS session the next handshake resumes
+	bool last_resumed;
+	uint32_t rng;
+} server_t;
+
+// What the body sink was given
+typedef struct {
+	char data[RESPONSE_MAX];
+	size_t len;
+	bool offsets_ok;    // Every piece arrived at the offset it belongs at
+} sunk_t;
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+static const char quoteBody[] = "[{\"symbol\":\"AAPL\",\"name\":\"Apple Inc.\",\"price\":189.25,\"changesPercentage\":0.4513,"
+								"\"change\":0.85,\"dayLow\":187.8,\"dayHigh\":190.12,\"open\":188.02,\"previousClose\":188.4,"
+								"\"volume\":41203311,\"timestamp\":1718308800},{\"symbol\":\"MSFT\",\"name\":\"Microsoft Corporation\","
+								"\"price\":425.15,\"changesPercentage\":-0.2112,\"change\":-0.9,\"dayLow\":423.5,\"dayHigh\":427.9,"
+								"\"open\":426.6,\"previousClose\":426.05,\"volume\":17530108,\"timestamp\":1718308800}]";
+
+static const char limitBody[] = "{\"Error Message\":\"Limit Reach . Please upgrade your plan or visit our documentation for more details\"}";
+
+static server_t server;
+static sunk_t sunk;
+static TickType_t now;
+static uint8_t requestBuffer[RESPONSE_MAX];
+
+/*******************************************************************************
+ * Function Name: server_take
+ *******************************************************************************
+ * Summary:
+ *  The next scripted fault if it is one of first to last, which it then
+ *  uses up, FAULT_NONE otherwise. A connect fault waits for a connect, a
+ *  response fault for a request.
+ *
+ *******************************************************************************/
+static fault_t server_take(fault_t first, fault_t last) {
+	fault_t fault;
+
+	if(server.fault_next == server.fault_count) {
+		return FAULT_NONE;
+	}
+	fault = server.faults[server.fault_next];
+	if(fault < first || fault > last) {
+		return FAULT_NONE;
+	}
+	server.fault_next++;
+	return fault;
+}
+
+/*******************************************************************************
+ * Function Name: server_script
+ *******************************************************************************
+ * Summary:
+ *  Queues faults for the server to play, after those still queued.
+ *
+ *******************************************************************************/
+static void server_script(uint32_t count, ...) {
+	va_list args;
+
+	va_start(args, count);
+	for(uint32_t i = 0; i < count && server.fault_count < sizeof(server.faults) / sizeof(server.faults[0]); i++) {
+		server.faults[server.fault_count++] = (fault_t)va_arg(args, int);
+	}
+	va_end(args);
+}
+
+/*******************************************************************************
+ * Function Name: server_calls
+ *******************************************************************************
+ * Summary:
+ *  Every network call made so far, to tell whether a poll made any.
+ *
+ *******************************************************************************/
+static uint32_t server_calls(void) {
+	return server.lookups + server.opens + server.requests;
+}
+
+/*******************************************************************************
+ * Function Name: server_random
+ *******************************************************************************
+ * Summary:
+ *  xorshift32 for piece sizes and the soak's fault mix.
+ *
+ *******************************************************************************/
+static uint32_t server_random(void) {
+	server.rng ^= server.rng << 13;
+	server.rng ^= server.rng >> 17;
+	server.rng ^= server.rng << 5;
+	return server.rng;
+}
+
+/*******************************************************************************
+ * Function Name: server_respond
+ *******************************************************************************
+ * Summary:
+ *  Writes the response to a request, as the fault has the server send it.
+ *
+ *******************************************************************************/
+static void server_respond(struct host_socket *socket, fault_t fault) {
+	int len = 0;
+
+	socket->sent = 0;
+	socket->closes = false;
+	switch(fault) {
+		case FAULT_CHUNKED:
+			len = snprintf(socket->response, RESPONSE_MAX, "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n"
+														   "Transfer-Encoding: chunked\r\nConnection: keep-alive\r\n\r\n");
+			for(size_t at = 0; at < sizeof(quoteBody) - 1; at += CHUNK_LEN) {
+				int chunk = (int)((sizeof(quoteBody) - 1 - at < CHUNK_LEN) ? sizeof(quoteBody) - 1 - at : CHUNK_LEN);
+				len += snprintf(&socket->response[len], RESPONSE_MAX - len, "%x\r\n%.*s\r\n", chunk, chunk, &quoteBody[at]);
+			}
+			len += snprintf(&socket->response[len], RESPONSE_MAX - len, "0\r\n\r\n");
+			break;
+		case FAULT_UNTIL_CLOSE:
+			len = snprintf(socket->response, RESPONSE_MAX, "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nConnection: close\r\n\r\n%s",
+						   quoteBody);
+			socket->closes = true;
+			break;
+		case FAULT_CLOSE:
+			len = snprintf(socket->response, RESPONSE_MAX, "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: %zu\r\n"
+														   "Connection: close\r\n\r\n%s",
+						   sizeof(quoteBody) - 1, quoteBody);
+			socket->closes = true;
+			break;
+		case FAULT_429:
+			len = snprintf(socket->response, RESPONSE_MAX, "HTTP/1.1 429 Too Many Requests\r\nContent-Type: application/json\r\n"
+														   "Content-Length: %zu\r\nRetry-After: 60\r\n\r\n%s",
+						   sizeof(limitBody) - 1, limitBody);
+			break;
+		case FAULT_503:
+			len = snprintf(socket->response, RESPONSE_MAX, "HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\n\r\n");
+			break;
+		case FAULT_DROP_IDLE:
+			socket->closes = true;
+			break;
+		default:
+			len = snprintf(socket->response, RESPONSE_MAX, "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: %zu\r\n"
+														   "Connection: keep-alive\r\n\r\n%s",
+						   sizeof(quoteBody) - 1, quoteBody);
+			break;
+	}
+	socket->len = (size_t)len;
+	socket->cut = socket->len;
+	if(fault == FAULT_DISCONNECT || fault == FAULT_STALL) {
+		socket->cut = socket->len / 2;
+		socket->closes = (fault == FAULT_DISCONNECT);
+	}
+}
+
+/*******************************************************************************
+ * Function Name: cy_socket_gethostbyname, host_socket_open, host_socket_close,
+ *                cy_socket_send and cy_socket_recv
+ *******************************************************************************
+ * Summary:
+ *  The server's side of the socket. A request is checked and answered as
+ *  the next response fault has it; the answer is handed over a random
+ *  piece at a time, up to where the fault cuts it off. A closed session
+ *  stays closed.
+ *
+ *******************************************************************************/
+cy_rslt_t cy_socket_gethostbyname(const char *hostname, cy_socket_ip_version_t ip_ver, cy_socket_ip_address_t *addr) {
+	server.lookups++;
+	CHECK_STR(hostname, HOST_NAME);
+	if(server_take(FAULT_DNS, FAULT_DNS) == FAULT_DNS) {
+		return CY_RSLT_MODULE_SECURE_SOCKETS_HOST_NOT_FOUND;
+	}
+	addr->version = CY_SOCKET_IP_VER_V4;
+	addr->ip.v4 = 0x0100007fu;
+	return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t host_socket_open(cy_socket_t *handle, const cy_awsport_server_info_t *server_info, const cy_awsport_ssl_credentials_t *credentials,
+						   uint32_t send_timeout_ms, uint32_t receive_timeout_ms) {
+	server.opens++;
+	switch(server_take(FAULT_RESET, FAULT_TLS)) {
+		case FAULT_RESET:
+			server.closes++;
+			return CY_RSLT_MODULE_SECURE_SOCKETS_CLOSED;
+		case FAULT_TLS:
+			server.closes++;
+			server.tls_failures++;
+			return CY_RSLT_MODULE_SECURE_SOCKETS_TLS_ERROR;
+		default:
+			break;
+	}
+	*handle = calloc(1, sizeof(**handle));
+	server.last_resumed = server.session_cached;
+	server.session_cached = true;
+	return CY_RSLT_SUCCESS;
+}
+
+void host_socket_close(cy_socket_t handle) {
+	if(handle != NULL) {
+		server.closes++;
+		free(handle);
+	}
+}
+
+cy_rslt_t cy_socket_send(cy_socket_t handle, const void *data, uint32_t size, int flags, uint32_t *bytes_sent) {
+	static const char requestLine[] = "GET " RESOURCE_PATH " HTTP/1.1\r\n";
+
+	if(handle->closes && handle->sent == handle->cut) {
+		return CY_RSLT_MODULE_SECURE_SOCKETS_CLOSED;
+	}
+	server.requests++;
+	CHECK(size > sizeof(requestLine) - 1 && memcmp(data, requestLine, sizeof(requestLine) - 1) == 0);
+	CHECK(memmem(data, size, "\r\nConnection: keep-alive\r\n", strlen("\r\nConnection: keep-alive\r\n")) != NULL);
+	CHECK(memmem(data, size, "\r\nHost: " HOST_NAME "\r\n", strlen("\r\nHost: " HOST_NAME "\r\n")) != NULL);
+	server_respond(handle, server_take(FAULT_NONE, FAULT_DROP_IDLE));
+	*bytes_sent = size;
+	return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_socket_recv(cy_socket_t handle, void *buffer, uint32_t size, int flags, uint32_t *bytes_received) {
+	size_t piece = 1 + server_random() % PIECE_MAX;
+
+	*bytes_received = 0;
+	if(handle->sent == handle->cut) {
+		return handle->closes ? CY_RSLT_MODULE_SECURE_SOCKETS_CLOSED : CY_RSLT_MODULE_SECURE_SOCKETS_TIMEOUT;
+	}
+	if(piece > handle->cut - handle->sent) {
+		piece = handle->cut - handle->sent;
+	}
+	if(piece > size) {
+		piece = size;
+	}
+	(void)memcpy(buffer, &handle->response[handle->sent], piece);
+	handle->sent += piece;
+	*bytes_received = (uint32_t)piece;
+	return CY_RSLT_SUCCESS;
+}
+
+/*******************************************************************************
+ * Function Name: tls_session_cache_failed_handshakes, xTaskGetTickCount,
+ *                log_ring_write and the other stubs
+ *******************************************************************************
+ * Summary:
+ *  Handshakes fail only where the server says so, and resume once a session
+ *  was negotiated, until it is invalidated. The clock is the test's. Timing
+ *  and logs are not needed here.
+ *
+ *******************************************************************************/
+uint32_t tls_session_cache_failed_handshakes(void) {
+	return server.tls_failures;
+}
+
+void tls_session_cache_invalidate(void) {
+	server.session_cached = false;
+}
+
+bool tls_session_cache_last_resumed(void) {
+	return server.last_resumed;
+}
+
+TickType_t xTaskGetTickCount(void) {
+	return now;
+}
+
+void log_ring_write(uint32_t level, const char *format, uint32_t count, ...) {
+}
+
+uint32_t metrics_now(void) {
+	return 0;
+}
+
+uint32_t metrics_record(metrics_phase_t phase, uint32_t start) {
+	return 0;
+}
+
+void metrics_record_cycles(metrics_phase_t phase, uint32_t cycles) {
+}
+
+uint32_t metrics_last(metrics_phase_t phase) {
+	return 0;
+}
+
+void freshness_first_byte(void) {
+}
+
+/*******************************************************************************
+ * Function Name: sink
+ *******************************************************************************
+ * Summary:
+ *  Body sink copying the body out. A retried request streams its body again
+ *  from the start, so the copy ends where the last piece did.
+ *
+ *******************************************************************************/
+static void sink(void *arg, const uint8_t *data, size_t len, size_t offset) {
+	sunk_t *copy = (sunk_t *)arg;
+
+	copy->offsets_ok = copy->offsets_ok && offset <= copy->len && offset + len <= sizeof(copy->data);
+	if(offset + len <= sizeof(copy->data)) {
+		(void)memcpy(&copy->data[offset], data, len);
+		copy->len = offset + len;
+	}
+}
+
+/*******************************************************************************
+ * Function Name: start
+ *******************************************************************************
+ * Summary:
+ *  A fresh server and connection, the clock at at.
+ *
+ *******************************************************************************/
+static void start(http_connection_t *conn, TickType_t at) {
+	static cy_awsport_ssl_credentials_t credentials;
+	static cy_awsport_server_info_t serverInfo = {.host_name = HOST_NAME, .port = 443};
+
+	(void)memset(&server, 0, sizeof(server));
+	server.rng = 2463534242u;
+	now = at;
+	CHECK_EQ(http_connection_init(conn, &credentials, &serverInfo), CY_RSLT_SUCCESS);
+	http_connection_set_body_sink(conn, sink, &sunk);
+}
+
+/*******************************************************************************
+ * Function Name: finish
+ *******************************************************************************
+ * Summary:
+ *  Tears the connection down again; every session the server saw opened
+ *  must have been closed.
+ *
+ *******************************************************************************/
+static void finish(http_connection_t *conn) {
+	http_connection_deinit(conn);
+	CHECK(conn->handle == NULL);
+	CHECK_EQ(server.opens, server.closes);
+}
+
+/*******************************************************************************
+ * Function Name: poll
+ *******************************************************************************
+ * Summary:
+ *  One fetch, as the HTTP client task makes it.
+ *
+ *******************************************************************************/
+static cy_rslt_t poll(http_connection_t *conn, cy_http_client_response_t *response) {
+	cy_http_client_request_header_t request = {
+		.method = CY_HTTP_CLIENT_METHOD_GET,
+		.resource_path = RESOURCE_PATH,
+		.buffer = requestBuffer,
+		.buffer_len = sizeof(requestBuffer),
+		.range_start = -1,
+		.range_end = -1,
+	};
+	cy_http_client_header_t header = {
+		.field = "Host",
+		.field_len = strlen("Host"),
+		.value = HOST_NAME,
+		.value_len = strlen(HOST_NAME),
+	};
+
+	(void)memset(response, 0, sizeof(*response));
+	sunk.len = 0;
+	sunk.offsets_ok = true;
+	return http_connection_get(conn, &request, &header, 1, response);
+}
+
+/*******************************************************************************
+ * Function Name: check_quote
+ *******************************************************************************
+ * Summary:
+ *  The response and the sink both hold the quote body.
+ *
+ *******************************************************************************/
+static bool check_quote(const cy_http_client_response_t *response) {
+	bool ok = response->status_code == 200 && response->body_len == sizeof(quoteBody) - 1 &&
+			  memcmp(response->body, quoteBody, sizeof(quoteBody) - 1) == 0 && sunk.offsets_ok && sunk.len == sizeof(quoteBody) - 1 &&
+			  memcmp(sunk.data, quoteBody, sizeof(quoteBody) - 1) == 0;
+
+	CHECK(ok);
+	return ok;
+}
+
+/*******************************************************************************
+ * Function Name: check_backing_off
+ *******************************************************************************
+ * Summary:
+ *  Polls while a retry is not allowed yet, which must be refused without a
+ *  network call, and leaves the clock at the end of the delay.
+ *
+ *******************************************************************************/
+static void check_backing_off(http_connection_t *conn) {
+	cy_http_client_response_t response;
+	uint32_t delay = http_connection_retry_delay_ms(conn);
+	uint32_t calls = server_calls();
+
+	CHECK(delay > 0);
+	CHECK_EQ(poll(conn, &response), HTTP_CONNECTION_RSLT_BACKOFF);
+	now += pdMS_TO_TICKS(delay - 1);
+	CHECK_EQ(poll(conn, &response), HTTP_CONNECTION_RSLT_BACKOFF);
+	CHECK_EQ(server_calls(), calls);
+	now += pdMS_TO_TICKS(1);
+	CHECK_EQ(http_connection_retry_delay_ms(conn), 0);
+}
+
+/*******************************************************************************
+ * Function Name: test_keep_alive
+ *******************************************************************************
+ * Summary:
+ *  One lookup and one handshake serve every poll, whether the body comes
+ *  with a length or chunked.
+ *
+ *******************************************************************************/
+static void test_keep_alive(void) {
+	http_connection_t conn;
+	cy_http_client_response_t response;
+
+	start(&conn, 1000);
+	for(int i = 0; i < 10; i++) {
+		server_script(1, (i % 2 == 0) ? FAULT_NONE : FAULT_CHUNKED);
+		CHECK_EQ(poll(&conn, &response), CY_RSLT_SUCCESS);
+		check_quote(&response);
+		now += pdMS_TO_TICKS(POLL_MS);
+	}
+	CHECK_EQ(conn.state, HTTP_CONNECTION_CONNECTED);
+	CHECK_EQ(conn.requests, 10);
+	CHECK_EQ(conn.handshakes, 1);
+	CHECK_EQ(conn.server_closes, 0);
+	CHECK_EQ(server.lookups, 1);
+	CHECK_EQ(server.opens, 1);
+	CHECK_EQ(server.closes, 0);
+	CHECK_EQ(http_connection_retry_delay_ms(&conn), 0);
+	finish(&conn);
+}
+
+/*******************************************************************************
+ * Function Name: test_connect_failures
+ *******************************************************************************
+ * Summary:
+ *  A lookup, connect or handshake that fails is told apart, backs off for
+ *  the first delay and is retried, on a fresh connection, once it is over.
+ *
+ *******************************************************************************/
+static void test_connect_failures(void) {
+	static const struct {
+		fault_t fault;
+		http_failure_t failure;
+		cy_rslt_t result;
+	} cases[] = {
+		{FAULT_DNS, HTTP_FAILURE_DNS, CY_RSLT_MODULE_SECURE_SOCKETS_HOST_NOT_FOUND},
+		{FAULT_RESET, HTTP_FAILURE_TCP, CY_RSLT_MODULE_SECURE_SOCKETS_CLOSED},
+		{FAULT_TLS, HTTP_FAILURE_TLS, CY_RSLT_MODULE_SECURE_SOCKETS_TLS_ERROR},
+	};
+
+	for(size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+		http_connection_t conn;
+		cy_http_client_response_t response;
+		uint32_t delay;
+
+		start(&conn, 1000);
+		server_script(1, cases[i].fault);
+		CHECK_EQ(poll(&conn, &response), cases[i].result);
+		CHECK_EQ(conn.state, HTTP_CONNECTION_BACKOFF);
+		CHECK_EQ(conn.last_failure, cases[i].failure);
+		CHECK_EQ(conn.failures[cases[i].failure], 1);
+		CHECK_EQ(conn.consecutive_failures, 1);
+		CHECK_EQ(conn.handshakes, 0);
+		CHECK_EQ(conn.requests, 0);
+		CHECK_EQ(server.opens, (cases[i].fault == FAULT_DNS) ? 0 : 1);
+
+		delay = http_connection_retry_delay_ms(&conn);
+		CHECK(delay >= HTTP_CONNECTION_BACKOFF_BASE_MS / 2 && delay <= HTTP_CONNECTION_BACKOFF_BASE_MS);
+		check_backing_off(&conn);
+
+		CHECK_EQ(poll(&conn, &response), CY_RSLT_SUCCESS);
+		check_quote(&response);
+		CHECK_EQ(conn.state, HTTP_CONNECTION_CONNECTED);
+		CHECK_EQ(conn.consecutive_failures, 0);
+		CHECK_EQ(conn.last_failure, HTTP_FAILURE_NONE);
+		CHECK_EQ(conn.handshakes, 1);
+		CHECK_EQ(conn.resumed_handshakes, 0);
+		CHECK_EQ(server.opens - server.closes, 1);
+		finish(&conn);
+	}
+}
+
+/*******************************************************************************
+ * Function Name: test_backoff
+ *******************************************************************************
+ * Summary:
+ *  Connects failing in a row back off for a delay drawn from [d/2, d], d
+ *  doubling from the base up to the cap, until the circuit opens for its
+ *  full period. Devices started at different times draw different delays.
+ *
+ *******************************************************************************/
+static void test_backoff(void) {
+	uint32_t firstDelays[SEEDS];
+	uint32_t distinct = 0;
+
+	for(uint32_t seed = 0; seed < SEEDS; seed++) {
+		http_connection_t conn;
+		cy_http_client_response_t response;
+
+		start(&conn, 1000 + seed * 7919);
+		for(uint32_t n = 1; n < HTTP_CONNECTION_CIRCUIT_THRESHOLD; n++) {
+			uint32_t cap = HTTP_CONNECTION_BACKOFF_BASE_MS << (n - 1);
+			uint32_t delay;
+
+			cap = (cap > HTTP_CONNECTION_BACKOFF_MAX_MS) ? HTTP_CONNECTION_BACKOFF_MAX_MS : cap;
+			server_script(1, FAULT_RESET);
+			CHECK_EQ(poll(&conn, &response), CY_RSLT_MODULE_SECURE_SOCKETS_CLOSED);
+			CHECK_EQ(conn.state, HTTP_CONNECTION_BACKOFF);
+			CHECK_EQ(conn.consecutive_failures, n);
+			delay = http_connection_retry_delay_ms(&conn);
+			CHECK(delay >= cap / 2 && delay <= cap);
+			if(n == 1) {
+				firstDelays[seed] = delay;
+			}
+			check_backing_off(&conn);
+		}
+
+		server_script(1, FAULT_RESET);
+		CHECK_EQ(poll(&conn, &response), CY_RSLT_MODULE_SECURE_SOCKETS_CLOSED);
+		CHECK_EQ(conn.state, HTTP_CONNECTION_CIRCUIT_OPEN);
+		CHECK_EQ(http_connection_retry_delay_ms(&conn), HTTP_CONNECTION_CIRCUIT_OPEN_MS);
+		CHECK_EQ(conn.failures[HTTP_FAILURE_TCP], HTTP_CONNECTION_CIRCUIT_THRESHOLD);
+		CHECK_EQ(server.opens, HTTP_CONNECTION_CIRCUIT_THRESHOLD);
+		finish(&conn);
+	}
+
+	for(uint32_t seed = 0; seed < SEEDS; seed++) {
+		uint32_t earlier = 0;
+
+		while(earlier < seed && firstDelays[earlier] != firstDelays[seed]) {
+			earlier++;
+		}
+		distinct += (earlier == seed);
+	}
+	CHECK(distinct > SEEDS / 2);
+}
+
+/*******************************************************************************
+ * Function Name: test_circuit_breaker
+ *******************************************************************************
+ * Summary:
+ *  With the circuit open nothing is sent for the whole period. A trial that
+ *  fails opens it again for a full period, one that succeeds closes it and
+ *  resets the backoff.
+ *
+ *******************************************************************************/
+static void test_circuit_breaker(void) {
+	http_connection_t conn;
+	cy_http_client_response_t response;
+	uint32_t opens;
+
+	start(&conn, 1000);
+	for(uint32_t n = 0; n < HTTP_CONNECTION_CIRCUIT_THRESHOLD; n++) {
+		server_script(1, FAULT_TLS);
+		CHECK(poll(&conn, &response) != CY_RSLT_SUCCESS);
+		if(n + 1 < HTTP_CONNECTION_CIRCUIT_THRESHOLD) {
+			now += pdMS_TO_TICKS(http_connection_retry_delay_ms(&conn));
+		}
+	}
+	CHECK_EQ(conn.state, HTTP_CONNECTION_CIRCUIT_OPEN);
+	CHECK_EQ(conn.failures[HTTP_FAILURE_TLS], HTTP_CONNECTION_CIRCUIT_THRESHOLD);
+	check_backing_off(&conn);
+
+	// The trial fails, the circuit opens again
+	opens = server.opens;
+	server_script(1, FAULT_DNS);
+	CHECK_EQ(poll(&conn, &response), CY_RSLT_MODULE_SECURE_SOCKETS_HOST_NOT_FOUND);
+	CHECK_EQ(server.opens, opens);
+	CHECK_EQ(conn.state, HTTP_CONNECTION_CIRCUIT_OPEN);
+	CHECK_EQ(http_connection_retry_delay_ms(&conn), HTTP_CONNECTION_CIRCUIT_OPEN_MS);
+	check_backing_off(&conn);
+
+	// The upstream is back
+	CHECK_EQ(poll(&conn, &response), CY_RSLT_SUCCESS);
+	check_quote(&response);
+	CHECK_EQ(conn.state, HTTP_CONNECTION_CONNECTED);
+	CHECK_EQ(conn.consecutive_failures, 0);
+	CHECK_EQ(http_connection_retry_delay_ms(&conn), 0);
+
+	// And a new failure starts from the first delay
+	server_script(1, FAULT_503);
+	CHECK_EQ(poll(&conn, &response), HTTP_CONNECTION_RSLT_BACKOFF);
+	CHECK(http_connection_retry_delay_ms(&conn) <= HTTP_CONNECTION_BACKOFF_BASE_MS);
+	CHECK_EQ(server.opens - server.closes, 1);
+	finish(&conn);
+}
+
+/*******************************************************************************
+ * Function Name: test_status
+ *******************************************************************************
+ * Summary:
+ *  A server error is a failure that keeps the session for the retry, a
+ *  client error is the caller's to handle and no failure at all.
+ *
+ *******************************************************************************/
+static void test_status(void) {
+	http_connection_t conn;
+	cy_http_client_response_t response;
+
+	start(&conn, 1000);
+	server_script(1, FAULT_503);
+	CHECK_EQ(poll(&conn, &response), HTTP_CONNECTION_RSLT_BACKOFF);
+	CHECK_EQ(response.status_code, 503);
+	CHECK_EQ(conn.failures[HTTP_FAILURE_HTTP_STATUS], 1);
+	CHECK_EQ(conn.state, HTTP_CONNECTION_CONNECTED);
+	check_backing_off(&conn);
+
+	server_script(1, FAULT_429);
+	CHECK_EQ(poll(&conn, &response), CY_RSLT_SUCCESS);
+	CHECK_EQ(response.status_code, 429);
+	CHECK(response.body_len == sizeof(limitBody) - 1 && memcmp(response.body, limitBody, sizeof(limitBody) - 1) == 0);
+	CHECK(sunk.len == sizeof(limitBody) - 1 && memcmp(sunk.data, limitBody, sizeof(limitBody) - 1) == 0);
+	CHECK_EQ(conn.consecutive_failures, 0);
+	CHECK_EQ(http_connection_retry_delay_ms(&conn), 0);
+	CHECK_EQ(conn.handshakes, 1);
+	CHECK_EQ(server.opens, 1);
+	finish(&conn);
+}
+
+/*******************************************************************************
+ * Function Name: test_server_closes
+ *******************************************************************************
+ * Summary:
+ *  A session the server closed, after saying so, with the end of a body or
+ *  while idle, is replaced on the next request without a failure, and the
+ *  close is counted once.
+ *
+ *******************************************************************************/
+static void test_server_closes(void) {
+	http_connection_t conn;
+	cy_http_client_response_t response;
+
+	start(&conn, 1000);
+	server_script(1, FAULT_CLOSE);
+	CHECK_EQ(poll(&conn, &response), CY_RSLT_SUCCESS);
+	check_quote(&response);
+	CHECK_EQ(conn.state, HTTP_CONNECTION_IDLE);
+	CHECK_EQ(conn.server_closes, 1);
+	CHECK_EQ(server.closes, 1);
+
+	// Not framed on the way in, the body goes to the sink whole
+	server_script(1, FAULT_UNTIL_CLOSE);
+	CHECK_EQ(poll(&conn, &response), CY_RSLT_SUCCESS);
+	check_quote(&response);
+	CHECK_EQ(conn.handshakes, 2);
+	CHECK_EQ(conn.server_closes, 2);
+	CHECK_EQ(server.opens - server.closes, 0);
+
+	CHECK_EQ(poll(&conn, &response), CY_RSLT_SUCCESS);
+	check_quote(&response);
+	CHECK_EQ(conn.handshakes, 3);
+
+	// The idle session was dropped, the request is sent again on a new one
+	server_script(1, FAULT_DROP_IDLE);
+	CHECK_EQ(poll(&conn, &response), CY_RSLT_SUCCESS);
+	check_quote(&response);
+	CHECK_EQ(conn.handshakes, 4);
+	CHECK_EQ(conn.resumed_handshakes, 3);
+	CHECK_EQ(conn.server_closes, 3);
+	CHECK_EQ(conn.requests, 5);
+	CHECK_EQ(server.opens - server.closes, 1);
+
+	CHECK_EQ(conn.consecutive_failures, 0);
+	for(int failure = HTTP_FAILURE_DNS; failure < HTTP_FAILURE_COUNT; failure++) {
+		CHECK_EQ(conn.failures[failure], 0);
+	}
+	finish(&conn);
+}
+
+/*******************************************************************************
+ * Function Name: test_tls_session
+ *******************************************************************************
+ * Summary:
+ *  Reconnects resume the cached TLS session until a handshake fails, which
+ *  drops it: the handshake after the failure is a full one.
+ *
+ *******************************************************************************/
+static void test_tls_session(void) {
+	http_connection_t conn;
+	cy_http_client_response_t response;
+
+	start(&conn, 1000);
+	server_script(2, FAULT_CLOSE, FAULT_CLOSE);
+	CHECK_EQ(poll(&conn, &response), CY_RSLT_SUCCESS);
+	CHECK_EQ(poll(&conn, &response), CY_RSLT_SUCCESS);
+	CHECK_EQ(conn.handshakes, 2);
+	CHECK_EQ(conn.resumed_handshakes, 1);
+
+	server_script(1, FAULT_TLS);
+	CHECK_EQ(poll(&conn, &response), CY_RSLT_MODULE_SECURE_SOCKETS_TLS_ERROR);
+	CHECK(!server.session_cached);
+	check_backing_off(&conn);
+	CHECK_EQ(poll(&conn, &response), CY_RSLT_SUCCESS);
+	CHECK_EQ(conn.handshakes, 3);
+	CHECK_EQ(conn.resumed_handshakes, 1);
+
+	// A connect that fails before the handshake leaves the session cached
+	server_script(2, FAULT_CLOSE, FAULT_RESET);
+	CHECK_EQ(poll(&conn, &response), CY_RSLT_SUCCESS);
+	CHECK_EQ(poll(&conn, &response), CY_RSLT_MODULE_SECURE_SOCKETS_CLOSED);
+	CHECK(server.session_cached);
+	check_backing_off(&conn);
+	CHECK_EQ(poll(&conn, &response), CY_RSLT_SUCCESS);
+	CHECK_EQ(conn.handshakes, 4);
+	CHECK_EQ(conn.resumed_handshakes, 2);
+	finish(&conn);
+}
+
+/*******************************************************************************
+ * Function Name: test_broken_responses
+ *******************************************************************************
+ * Summary:
+ *  A response cut off, by a close or a stall, fails the request as TCP and
+ *  drops the session; on a reused session the request is retried once on a
+ *  new one first. A body only the caller finds wrong is a payload failure
+ *  that backs off but keeps the session.
+ *
+ *******************************************************************************/
+static void test_broken_responses(void) {
+	http_connection_t conn;
+	cy_http_client_response_t response;
+
+	start(&conn, 1000);
+	server_script(1, FAULT_STALL);
+	CHECK_EQ(poll(&conn, &response), CY_RSLT_MODULE_SECURE_SOCKETS_TIMEOUT);
+	CHECK_EQ(conn.state, HTTP_CONNECTION_BACKOFF);
+	CHECK_EQ(conn.failures[HTTP_FAILURE_TCP], 1);
+	CHECK_EQ(server.opens - server.closes, 0);
+	check_backing_off(&conn);
+
+	server_script(1, FAULT_DISCONNECT);
+	CHECK_EQ(poll(&conn, &response), CY_RSLT_MODULE_SECURE_SOCKETS_CLOSED);
+	CHECK_EQ(conn.failures[HTTP_FAILURE_TCP], 2);
+	CHECK_EQ(conn.server_closes, 1);
+	CHECK_EQ(server.opens - server.closes, 0);
+	check_backing_off(&conn);
+
+	CHECK_EQ(poll(&conn, &response), CY_RSLT_SUCCESS);
+	check_quote(&response);
+	CHECK_EQ(conn.consecutive_failures, 0);
+
+	// Retried on a new session, then failing there too
+	server_script(2, FAULT_DISCONNECT, FAULT_DISCONNECT);
+	CHECK_EQ(poll(&conn, &response), CY_RSLT_MODULE_SECURE_SOCKETS_CLOSED);
+	CHECK_EQ(server.requests, 5);
+	CHECK_EQ(conn.failures[HTTP_FAILURE_TCP], 3);
+	CHECK_EQ(conn.consecutive_failures, 1);
+	CHECK_EQ(server.opens - server.closes, 0);
+	check_backing_off(&conn);
+
+	// Retried on a new session, and working there
+	CHECK_EQ(poll(&conn, &response), CY_RSLT_SUCCESS);
+	server_script(2, FAULT_STALL, FAULT_CHUNKED);
+	CHECK_EQ(poll(&conn, &response), CY_RSLT_SUCCESS);
+	check_quote(&response);
+	CHECK_EQ(conn.failures[HTTP_FAILURE_TCP], 3);
+
+	http_connection_report_failure(&conn, HTTP_FAILURE_PAYLOAD);
+	CHECK_EQ(conn.failures[HTTP_FAILURE_PAYLOAD], 1);
+	CHECK_EQ(conn.state, HTTP_CONNECTION_CONNECTED);
+	check_backing_off(&conn);
+	CHECK_EQ(poll(&conn, &response), CY_RSLT_SUCCESS);
+	CHECK_EQ(server.opens - server.closes, 1);
+	finish(&conn);
+}
+
+/*******************************************************************************
+ * Function Name: test_payload_failures
+ *******************************************************************************
+ * Summary:
+ *  A server that keeps answering with bodies the caller cannot use is
+ *  treated like one that does not answer: each payload failure goes on
+ *  from the streak before it, the delays grow and the circuit opens. A
+ *  body taken after the circuit closes ends the streak.
+ *
+ *******************************************************************************/
+static void test_payload_failures(void) {
+	http_connection_t conn;
+	cy_http_client_response_t response;
+
+	start(&conn, 1000);
+	for(uint32_t n = 1; n < HTTP_CONNECTION_CIRCUIT_THRESHOLD; n++) {
+		uint32_t cap = HTTP_CONNECTION_BACKOFF_BASE_MS << (n - 1);
+		uint32_t delay;
+
+		cap = (cap > HTTP_CONNECTION_BACKOFF_MAX_MS) ? HTTP_CONNECTION_BACKOFF_MAX_MS : cap;
+		CHECK_EQ(poll(&conn, &response), CY_RSLT_SUCCESS);
+		check_quote(&response);
+		http_connection_report_failure(&conn, HTTP_FAILURE_PAYLOAD);
+		CHECK_EQ(conn.consecutive_failures, n);
+		CHECK_EQ(conn.state, HTTP_CONNECTION_CONNECTED);
+		delay = http_connection_retry_delay_ms(&conn);
+		CHECK(delay >= cap / 2 && delay <= cap);
+		check_backing_off(&conn);
+	}
+
+	CHECK_EQ(poll(&conn, &response), CY_RSLT_SUCCESS);
+	http_connection_report_failure(&conn, HTTP_FAILURE_PAYLOAD);
+	CHECK_EQ(conn.state, HTTP_CONNECTION_CIRCUIT_OPEN);
+	CHECK_EQ(conn.failures[HTTP_FAILURE_PAYLOAD], HTTP_CONNECTION_CIRCUIT_THRESHOLD);
+	CHECK_EQ(http_connection_retry_delay_ms(&conn), HTTP_CONNECTION_CIRCUIT_OPEN_MS);
+	CHECK_EQ(server.opens - server.closes, 0);
+	check_backing_off(&conn);
+
+	// The trial's body is taken, a later bad one starts a new streak
+	CHECK_EQ(poll(&conn, &response), CY_RSLT_SUCCESS);
+	CHECK_EQ(conn.consecutive_failures, 0);
+	CHECK_EQ(poll(&conn, &response), CY_RSLT_SUCCESS);
+	http_connection_report_failure(&conn, HTTP_FAILURE_PAYLOAD);
+	CHECK_EQ(conn.consecutive_failures, 1);
+	CHECK(http_connection_retry_delay_ms(&conn) <= HTTP_CONNECTION_BACKOFF_BASE_MS);
+	CHECK_EQ(server.requests, HTTP_CONNECTION_CIRCUIT_THRESHOLD + 2);
+	finish(&conn);
+}
+
+/*******************************************************************************
+ * Function Name: test_soak
+ *******************************************************************************
+ * Summary:
+ *  Polls through the stand-in server's chaos mix, waiting after each poll
+ *  as the HTTP client task does. No poll during a delay may touch the
+ *  network, every success must deliver the body, and no session may leak.
+ *
+ *******************************************************************************/
+static void test_soak(bool bench) {
+	// Per mille of each fault as in the stand-in's chaos profile, its client
+	// errors all 429, plus the lookup and handshake failures it cannot make
+	static const uint16_t mix[FAULT_COUNT] = {
+		[FAULT_DNS] = 20, [FAULT_RESET] = 30, [FAULT_TLS] = 20, [FAULT_CHUNKED] = 100, [FAULT_UNTIL_CLOSE] = 50, [FAULT_CLOSE] = 50,
+		[FAULT_429] = 90, [FAULT_503] = 50, [FAULT_DISCONNECT] = 50, [FAULT_STALL] = 100, [FAULT_DROP_IDLE] = 50,
+	};
+	http_connection_t conn;
+	cy_http_client_response_t response;
+	uint64_t delays = 0;
+	uint32_t retries = 0;
+	uint32_t quotes = 0;
+	bool ok = true;
+
+	start(&conn, 1000);
+	for(uint32_t i = 0; i < SOAK_POLLS; i++) {
+		uint32_t pick = server_random() % 1000;
+		uint32_t calls;
+		uint32_t delay;
+		fault_t fault = FAULT_NONE;
+		cy_rslt_t result;
+
+		for(int f = 0; f < FAULT_COUNT; f++) {
+			if(pick < mix[f]) {
+				fault = (fault_t)f;
+				break;
+			}
+			pick -= mix[f];
+		}
+		server.fault_count = server.fault_next = 0;
+		server_script(1, fault);
+
+		result = poll(&conn, &response);
+		if(result == CY_RSLT_SUCCESS && response.status_code == 200) {
+			ok = check_quote(&response) && ok;
+			quotes++;
+		}
+		ok = ok && server.opens - server.closes <= 1;
+
+		delay = http_connection_retry_delay_ms(&conn);
+		if(delay > 0) {
+			calls = server_calls();
+			ok = ok && poll(&conn, &response) == HTTP_CONNECTION_RSLT_BACKOFF && server_calls() == calls;
+			delays += delay;
+			retries++;
+		}
+		now += pdMS_TO_TICKS((delay > 0) ? delay : POLL_MS);
+	}
+	CHECK(ok);
+	CHECK(quotes > SOAK_POLLS / 2);
+	CHECK(conn.failures[HTTP_FAILURE_DNS] > 0 && conn.failures[HTTP_FAILURE_TCP] > 0 && conn.failures[HTTP_FAILURE_TLS] > 0 &&
+		  conn.failures[HTTP_FAILURE_HTTP_STATUS] > 0);
+
+	if(bench) {
+		uint32_t failures = 0;
+
+		for(int failure = HTTP_FAILURE_DNS; failure < HTTP_FAILURE_COUNT; failure++) {
+			failures += conn.failures[failure];
+		}
+		printf("bench,http_connection,soak_handshakes_per_100_requests,%lu,n\n", (unsigned long)(100 * conn.handshakes / conn.requests));
+		printf("bench,http_connection,soak_failures_per_100_requests,%lu,n\n", (unsigned long)(100 * failures / conn.requests));
+		printf("bench,http_connection,soak_mean_retry_delay,%lu,ms\n", (unsigned long)(delays / (retries ? retries : 1)));
+	}
+	finish(&conn);
+}
+
+int main(int argc, char **argv) {
+	test_keep_alive();
+	test_connect_failures();
+	test_backoff();
+	test_circuit_breaker();
+	test_status();
+	test_server_closes();
+	test_tls_session();
+	test_broken_responses();
+	test_payload_failures();
+	test_soak(test_bench_requested(argc, argv));
+
+	return test_summary("http_connection");
+}
@@ -0,0 +1,200 @@
+/******************************************************************************
+* File Name:   test_indicators.c
+*
+* Description: This file contains the host tests and benchmark of the
+* indicator engine. Each statistic is checked after every tick of a random
+* walk against a brute-force recomputation over the whole history. The
+* benchmark times a tick once the engine has already seen more and more
+* history; the cost per tick has to stay flat:
+*
+*   bench,indicators,tick_after_<ticks>,<ns per tick>,ns
+*   bench,indicators,state_bytes,<bytes>,B
+*
+*******************************************************************************/
+
+#include <stdlib.h>
+
+#include "indicators.h"
+#include "test.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define CHECK_TICKS (5000)
+#define BENCH_TICKS (100000)
+#define VOLUME_EXTRA (0)
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+static fixed_t prices[CHECK_TICKS];
+static int64_t volumes[CHECK_TICKS];    // Cumulative day volume, in shares
+
+/*******************************************************************************
+ * Function Name: make_quote
+ *******************************************************************************
+ * Summary:
+ *  A quote of tick i of the walk.
+ *
+ *******************************************************************************/
+static quote_t make_quote(uint32_t i, fixed_t price, int64_t volume) {
+	quote_t quote = {0};
+
+	(void)snprintf(quote.symbol, sizeof(quote.symbol), "AMD");
+	quote.timestamp = 1718285400 + 60 * (time_t)i;
+	quote.price = price;
+	quote.open = 1560100;
+	quote.extra[VOLUME_EXTRA] = volume * FIXED_SCALE;
+	return quote;
+}
+
+/*******************************************************************************
+ * Function Name: test_brute_force
+ *******************************************************************************
+ * Summary:
+ *  EMA, SMA, rolling min/max, VWAP and the move from the open after every
+ *  tick of a random walk equal the same statistics recomputed from scratch.
+ *  Halfway through the volume drops, a new day for VWAP.
+ *
+ *******************************************************************************/
+static void test_brute_force(void) {
+	static indicator_state_t state;
+	fixed_t ema = 0;
+	fixed_t price = 1567900;
+	int64_t volume = 0;
+	uint32_t dayStart = 0;
+	bool tickOk = true, emaOk = true, smaOk = true, minMaxOk = true, vwapOk = true, openOk = true;
+
+	srand(7);
+	indicators_reset(&state, "AMD");
+	for(uint32_t i = 0; i < CHECK_TICKS; i++) {
+		quote_t quote;
+		uint32_t from = (i + 1 > INDICATOR_WINDOW) ? i + 1 - INDICATOR_WINDOW : 0;
+		int64_t sum = 0;
+		int64_t priceVolume = 0;
+		int64_t traded = 0;
+		fixed_t min = INT64_MAX;
+		fixed_t max = INT64_MIN;
+
+		price += (fixed_t)(rand() % 2001 - 1000);
+		if(i == CHECK_TICKS / 2) {
+			volume = 0;
+			dayStart = i;
+		}
+		volume += rand() % 5000;
+		prices[i] = price;
+		volumes[i] = volume;
+
+		quote = make_quote(i, price, volume);
+		tickOk = indicators_update(&state, &quote, VOLUME_EXTRA) && tickOk;
+
+		ema = (i == 0) ? price : ema + (price - ema) * 2 / (INDICATOR_EMA_PERIOD + 1);
+		for(uint32_t j = from; j <= i; j++) {
+			sum += prices[j];
+			min = (prices[j] < min) ? prices[j] : min;
+			max = (prices[j] > max) ? prices[j] : max;
+		}
+		for(uint32_t j = dayStart; j <= i; j++) {
+			int64_t shares = volumes[j] - ((j > dayStart) ? volumes[j - 1] : 0);
+
+			priceVolume += prices[j] * shares;
+			traded += shares;
+		}
+
+		emaOk = emaOk && state.values.ema == ema;
+		smaOk = smaOk && state.values.sma == (fixed_t)(sum / (int64_t)(i + 1 - from));
+		minMaxOk = minMaxOk && state.values.min == min && state.values.max == max;
+		vwapOk = vwapOk && state.values.has_vwap == (traded > 0) && (traded == 0 || state.values.vwap == (fixed_t)(priceVolume / traded));
+		openOk = openOk && state.values.from_open_percent == (price - 1560100) * 100 * FIXED_SCALE / 1560100;
+	}
+
+	CHECK(tickOk);
+	CHECK(emaOk);
+	CHECK(smaOk);
+	CHECK(minMaxOk);
+	CHECK(vwapOk);
+	CHECK(openOk);
+	CHECK_EQ(state.seq, CHECK_TICKS);
+}
+
+/*******************************************************************************
+ * Function Name: test_not_a_tick
+ *******************************************************************************
+ * Summary:
+ *  A quote that is not newer than the last one changes nothing, and a quote
+ *  without volume leaves VWAP out.
+ *
+ *******************************************************************************/
+static void test_not_a_tick(void) {
+	static indicator_state_t state;
+	static indicator_state_t before;
+	quote_t quote = make_quote(0, 1567900, 1000);
+
+	indicators_reset(&state, "AMD");
+	CHECK(indicators_update(&state, &quote, -1));
+	CHECK(!state.values.has_vwap);
+	CHECK_EQ(state.values.ema, 1567900);
+
+	before = state;
+	quote.price = 1600000;
+	CHECK(!indicators_update(&state, &quote, -1));
+	quote.timestamp -= 60;
+	CHECK(!indicators_update(&state, &quote, -1));
+	CHECK(memcmp(&before, &state, sizeof(state)) == 0);
+	CHECK_STR(state.symbol, "AMD");
+}
+
+/*******************************************************************************
+ * Function Name: bench_history
+ *******************************************************************************
+ * Summary:
+ *  Times BENCH_TICKS ticks after the engine has already seen none, 10^5,
+ *  10^6 and 4 * 10^6 ticks of history.
+ *
+ *******************************************************************************/
+static void bench_history(void) {
+	static const uint32_t histories[] = {0, 100000, 1000000, 4000000};
+	static indicator_state_t state;
+	fixed_t price = 1567900;
+	int64_t volume = 0;
+	uint32_t tick = 0;
+
+	srand(11);
+	indicators_reset(&state, "AMD");
+	for(size_t h = 0; h < sizeof(histories) / sizeof(histories[0]); h++) {
+		uint32_t seen;
+		uint64_t start;
+		quote_t quote;
+
+		for(; tick < histories[h]; tick++) {
+			price += (fixed_t)(rand() % 2001 - 1000);
+			volume += rand() % 5000;
+			quote = make_quote(tick, price, volume);
+			(void)indicators_update(&state, &quote, VOLUME_EXTRA);
+		}
+
+		seen = tick;
+		start = test_now_ns();
+		for(uint32_t i = 0; i < BENCH_TICKS; i++) {
+			price += (fixed_t)((i * 7919) % 2001) - 1000;
+			volume += (i * 104729) % 5000;
+			quote = make_quote(tick + i, price, volume);
+			(void)indicators_update(&state, &quote, VOLUME_EXTRA);
+		}
+		tick += BENCH_TICKS;
+		printf("bench,indicators,tick_after_%lu,%llu,ns\n", (unsigned long)seen,
+			   (unsigned long long)((test_now_ns() - start) / BENCH_TICKS));
+	}
+	printf("bench,indicators,state_bytes,%zu,B\n", sizeof(indicator_state_t));
+}
+
+int main(int argc, char **argv) {
+	test_brute_force();
+	test_not_a_tick();
+
+	if(test_bench_requested(argc, argv)) {
+		bench_history();
+	}
+
+	return test_summary("indicators");
+}
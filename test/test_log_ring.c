@@ -0,0 +1,155 @@
+/******************************************************************************
+* File Name:   test_log_ring.c
+*
+* Description: This file contains the host tests and benchmark of the log
+* ring. Records are read back and formatted the way the drain task does,
+* with the host's 64 bit pointers, so a string argument that lost its upper
+* half would show here rather than crash the log task. The benchmark times
+* a write and its read:
+*
+*   bench,log_ring,write_read,<ns>,ns
+*
+*******************************************************************************/
+
+#include <stdlib.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include "log_ring.h"
+#include "test.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define BENCH_RUNS (100000)
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+static TickType_t now = 0;
+
+/*******************************************************************************
+ * Function Name: xTaskGetTickCount, vTaskDelay
+ *******************************************************************************
+ * Summary:
+ *  The tick a message is logged at is what the test set; the drain task is
+ *  not run.
+ *
+ *******************************************************************************/
+TickType_t xTaskGetTickCount(void) {
+	return now;
+}
+
+void vTaskDelay(TickType_t ticks) {
+	now += ticks;
+}
+
+/*******************************************************************************
+ * Function Name: format
+ *******************************************************************************
+ * Summary:
+ *  Formats a record as log_ring_task prints it, without the level and tick.
+ *
+ *******************************************************************************/
+static const char *format(const log_record_t *record) {
+	static char line[128];
+	const uintptr_t *a = record->args;
+
+	(void)snprintf(line, sizeof(line), record->format, a[0], a[1], a[2], a[3], a[4], a[5], a[6], a[7]);
+	return line;
+}
+
+/*******************************************************************************
+ * Function Name: test_arguments
+ *******************************************************************************
+ * Summary:
+ *  Strings, unsigned and signed integers come back as they were logged, with
+ *  the level, tick and argument count; arguments past LOG_ARGS_MAX are
+ *  dropped.
+ *
+ *******************************************************************************/
+static void test_arguments(void) {
+	static const char *const names[] = {"AMD", "NVDA"};
+	log_record_t record;
+
+	now = 1234;
+	LOG_WARN("Alert: %s rule %u (%s) fired", names[1], 3u, "above 120.00");
+	LOG_INFO("Market %s, next fetch in %ld s", "closed", (long)-42);
+	LOG_ERROR("No arguments");
+	log_ring_write(LOG_LEVEL_DEBUG, "%s %s %s %s %s %s %s %s", 9, "a", "b", "c", "d", "e", "f", "g", "h", "i");
+
+	CHECK(log_ring_read(&record));
+	CHECK_EQ(record.level, LOG_LEVEL_WARN);
+	CHECK_EQ(record.tick, 1234);
+	CHECK_EQ(record.count, 3);
+	CHECK_STR(format(&record), "Alert: NVDA rule 3 (above 120.00) fired");
+
+	CHECK(log_ring_read(&record));
+	CHECK_STR(format(&record), "Market closed, next fetch in -42 s");
+
+	CHECK(log_ring_read(&record));
+	CHECK_EQ(record.count, 0);
+	CHECK_STR(format(&record), "No arguments");
+
+	CHECK(log_ring_read(&record));
+	CHECK_EQ(record.count, LOG_ARGS_MAX);
+	CHECK_STR(format(&record), "a b c d e f g h");
+
+	CHECK(!log_ring_read(&record));
+}
+
+/*******************************************************************************
+ * Function Name: test_full
+ *******************************************************************************
+ * Summary:
+ *  A full ring drops new messages and keeps the ones queued, in order; once
+ *  drained it takes messages again.
+ *
+ *******************************************************************************/
+static void test_full(void) {
+	log_record_t record;
+
+	for(unsigned long i = 0; i < LOG_RING_RECORDS + 5; i++) {
+		LOG_INFO("Message %lu", i);
+	}
+	for(unsigned long i = 0; i < LOG_RING_RECORDS; i++) {
+		CHECK(log_ring_read(&record));
+		CHECK_EQ(record.args[0], i);
+	}
+	CHECK(!log_ring_read(&record));
+
+	LOG_INFO("After %s", "drain");
+	CHECK(log_ring_read(&record));
+	CHECK_STR(format(&record), "After drain");
+}
+
+/*******************************************************************************
+ * Function Name: bench_ring
+ *******************************************************************************
+ * Summary:
+ *  Prints the cost of queueing a message with a string and two integers and
+ *  taking it off the ring.
+ *
+ *******************************************************************************/
+static void bench_ring(void) {
+	log_record_t record;
+	uint64_t start = test_now_ns();
+
+	for(unsigned long i = 0; i < BENCH_RUNS; i++) {
+		LOG_INFO("%s: %lu px, %lu ms", "AMD", i, (unsigned long)BENCH_RUNS);
+		(void)log_ring_read(&record);
+	}
+	printf("bench,log_ring,write_read,%.1f,ns\n", (double)(test_now_ns() - start) / BENCH_RUNS);
+}
+
+int main(int argc, char **argv) {
+	test_arguments();
+	test_full();
+
+	if(test_bench_requested(argc, argv)) {
+		bench_ring();
+	}
+
+	return test_summary("log_ring");
+}
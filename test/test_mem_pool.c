@@ -0,0 +1,336 @@
+/******************************************************************************
+* File Name:   test_mem_pool.c
+*
+* Description: This file contains the host tests, soak run and benchmark of
+* the memory subsystem, linked with malloc wrapped as on the target and run
+* over the heap_4 stand-in in stubs/host_rtos.c. The soak runs the quote
+* pipeline of a fetch (extract, indicators, alerts) on a recorded body next
+* to an allocation churn standing in for a connection's TLS and HTTP
+* buffers, and requires every cycle after the first to end with the same
+* live blocks, bytes and free heap per tag:
+*
+*   bench,mem_pool,<pool|heap|libc>_pair,<ns per malloc and free>,ns
+*   bench,mem_pool,soak_cycles,<cycles>,cycles
+*   bench,mem_pool,soak_net_allocs,<blocks>,blocks
+*
+*******************************************************************************/
+
+#include <stdlib.h>
+
+#include "alerts.h"
+#include "host_rtos.h"
+#include "indicators.h"
+#include "mem_pool.h"
+#include "quote_stream.h"
+#include "test.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define SOAK_CYCLES (20000)
+#define BENCH_RUNS  (1000000)
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+void *__real_malloc(size_t size);
+void __real_free(void *ptr);
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+// Sizes of the churn, small ones for the pools and buffers for heap_4
+static const size_t churnSizes[] = {24, 60, 100, 200, 300, 500, 700, 1500, 4096, 16 * 1024 + 325, 40, 96};
+#define CHURN_BLOCKS (sizeof(churnSizes) / sizeof(churnSizes[0]))
+
+static TaskHandle_t networkTask;
+static TaskHandle_t decodeTask;
+
+/*******************************************************************************
+ * Function Name: log_ring_write
+ *******************************************************************************
+ * Summary:
+ *  Logging is not under test.
+ *
+ *******************************************************************************/
+void log_ring_write(uint32_t level, const char *format, uint32_t count, ...) {
+}
+
+/*******************************************************************************
+ * Function Name: live_blocks
+ *******************************************************************************
+ * Summary:
+ *  Blocks held now over every tag.
+ *
+ *******************************************************************************/
+static long live_blocks(uint32_t *bytes) {
+	long live = 0;
+
+	*bytes = 0;
+	for(uint32_t i = 0; i < MEM_TAG_COUNT; i++) {
+		mem_tag_stats_t stats;
+
+		mem_pool_get_stats((mem_tag_t)i, &stats);
+		live += (long)stats.allocs - (long)stats.frees;
+		*bytes += stats.current;
+	}
+	return live;
+}
+
+/*******************************************************************************
+ * Function Name: test_pools
+ *******************************************************************************
+ * Summary:
+ *  Small requests come from the pools, leaving the heap alone, until their
+ *  pool runs dry; big ones and the overflow go to heap_4. Freeing all of it
+ *  gives everything back.
+ *
+ *******************************************************************************/
+static void test_pools(void) {
+	static void *blocks[80];
+	size_t heapFree = xPortGetFreeHeapSize();
+	uint32_t bytes;
+	void *big;
+
+	for(int i = 0; i < 64; i++) {
+		blocks[i] = malloc(32);
+	}
+	CHECK_EQ(xPortGetFreeHeapSize(), heapFree);
+	CHECK(((uintptr_t)blocks[0] % 8) == 0);
+
+	blocks[64] = malloc(20);    // The 32 B pool is empty now
+	CHECK(blocks[64] != NULL);
+	CHECK(xPortGetFreeHeapSize() < heapFree);
+
+	big = malloc(2000);
+	CHECK(big != NULL);
+	CHECK_EQ(live_blocks(&bytes), 66);
+	CHECK_EQ(bytes, 64 * 32 + 20 + 2000);
+
+	free(big);
+	for(int i = 0; i <= 64; i++) {
+		free(blocks[i]);
+	}
+	CHECK_EQ(live_blocks(&bytes), 0);
+	CHECK_EQ(bytes, 0);
+	CHECK_EQ(xPortGetFreeHeapSize(), heapFree);
+}
+
+/*******************************************************************************
+ * Function Name: test_calls
+ *******************************************************************************
+ * Summary:
+ *  calloc zeroes and refuses an overflowing product, realloc keeps the
+ *  contents across pools and the heap, and blocks the C library allocated
+ *  itself go back to it.
+ *
+ *******************************************************************************/
+static void test_calls(void) {
+	volatile size_t huge = SIZE_MAX / 2;
+	uint32_t bytes;
+	uint8_t *zeroed = calloc(50, 2);
+	char *text = malloc(16);
+	char *foreign = __real_malloc(64);
+	bool allZero = true;
+
+	for(int i = 0; i < 100; i++) {
+		allZero = allZero && zeroed[i] == 0;
+	}
+	CHECK(allZero);
+	CHECK(calloc(huge, 4) == NULL);
+
+	(void)snprintf(text, 16, "quote");
+	text = realloc(text, 300);
+	CHECK_STR(text, "quote");
+	text = realloc(text, 3000);
+	CHECK_STR(text, "quote");
+	text = realloc(text, 8);
+	CHECK(memcmp(text, "quote", 6) == 0);
+
+	free(foreign);    // Must reach __real_free, not a pool
+	free(text);
+	free(zeroed);
+	free(NULL);
+	CHECK_EQ(live_blocks(&bytes), 0);
+	CHECK(!host_rtos_suspended());
+}
+
+/*******************************************************************************
+ * Function Name: test_tags
+ *******************************************************************************
+ * Summary:
+ *  A registered task is charged for what it allocates, a re-tagged piece of
+ *  work to its own tag, and heap exhaustion to the tag that hit it.
+ *
+ *******************************************************************************/
+static void test_tags(void) {
+	mem_tag_stats_t network, tls, decode;
+	void *a, *b, *c;
+
+	host_rtos_start(networkTask);
+	a = malloc(100);
+	CHECK_EQ(mem_pool_set_tag(MEM_TAG_TLS), MEM_TAG_NETWORK);
+	b = malloc(5000);
+	CHECK(malloc(configTOTAL_HEAP_SIZE) == NULL);
+	CHECK_EQ(mem_pool_set_tag(MEM_TAG_NETWORK), MEM_TAG_TLS);
+	host_rtos_switch(decodeTask);
+	c = malloc(40);
+
+	mem_pool_get_stats(MEM_TAG_NETWORK, &network);
+	mem_pool_get_stats(MEM_TAG_TLS, &tls);
+	mem_pool_get_stats(MEM_TAG_DECODE, &decode);
+	CHECK_EQ(network.current, 100);
+	CHECK_EQ(tls.current, 5000);
+	CHECK_EQ(tls.failed, 1);
+	CHECK_EQ(network.failed, 0);
+	CHECK_EQ(decode.current, 40);
+
+	// Freed by another task, still credited to the tag that allocated
+	free(a);
+	free(b);
+	free(c);
+	mem_pool_get_stats(MEM_TAG_NETWORK, &network);
+	mem_pool_get_stats(MEM_TAG_TLS, &tls);
+	CHECK_EQ(network.current, 0);
+	CHECK_EQ(tls.current, 0);
+	CHECK_EQ(tls.peak, 5000);
+}
+
+/*******************************************************************************
+ * Function Name: fetch_cycle
+ *******************************************************************************
+ * Summary:
+ *  One fetch: the network task churns its buffers, freed in another order
+ *  than allocated and with one grown by realloc, while the body is parsed,
+ *  then the decode task runs indicators and alerts over the table.
+ *
+ *******************************************************************************/
+static void fetch_cycle(const char *json, size_t len, quote_table_t *table, indicator_state_t *indicators, alert_engine_t *alerts) {
+	void *blocks[CHURN_BLOCKS];
+	mem_tag_t previous;
+
+	host_rtos_switch(networkTask);
+	previous = mem_pool_set_tag(MEM_TAG_TLS);
+	for(size_t i = 0; i < CHURN_BLOCKS; i++) {
+		blocks[i] = malloc(churnSizes[i]);
+	}
+	(void)mem_pool_set_tag(previous);
+	blocks[2] = realloc(blocks[2], 900);
+	for(size_t i = 0; i < CHURN_BLOCKS; i += 2) {
+		free(blocks[i]);
+	}
+
+	(void)quote_table_parse(table, json, len);
+
+	for(size_t i = 1; i < CHURN_BLOCKS; i += 2) {
+		free(blocks[i]);
+	}
+
+	host_rtos_switch(decodeTask);
+	for(uint32_t i = 0; i < table->count; i++) {
+		(void)indicators_update(&indicators[i], &table->quotes[i], 0);
+		(void)alerts_evaluate(alerts, &table->quotes[i]);
+	}
+}
+
+/*******************************************************************************
+ * Function Name: soak
+ *******************************************************************************
+ * Summary:
+ *  SOAK_CYCLES fetch cycles. After the first one every cycle has to end
+ *  where the one before ended: same live blocks and bytes, same free heap,
+ *  and no new heap low-water mark, so nothing leaks or fragments.
+ *
+ *******************************************************************************/
+static void soak(bool report) {
+	static quote_table_t table;
+	static indicator_state_t indicators[QUOTE_TABLE_CAPACITY];
+	static alert_engine_t alerts;
+	static const alert_rule_t rules[] = {ALERT_MOVE_PERCENT("AMD", 1), ALERT_NEW_DAY_HIGH("NVDA"), ALERT_CROSSES("INTC", 30)};
+	size_t len;
+	char *json = test_read_file("fmp_quote_many.json", &len);
+	long live;
+	uint32_t bytes;
+	uint32_t lastBytes;
+	size_t heapFree;
+	size_t heapLowest;
+	long worstDrift = 0;
+	bool steady = true;
+
+	(void)alerts_compile(&alerts, rules, sizeof(rules) / sizeof(rules[0]));
+	fetch_cycle(json, len, &table, indicators, &alerts);
+	live = live_blocks(&lastBytes);
+	heapFree = xPortGetFreeHeapSize();
+	heapLowest = xPortGetMinimumEverFreeHeapSize();
+
+	for(int cycle = 1; cycle < SOAK_CYCLES; cycle++) {
+		long now;
+
+		fetch_cycle(json, len, &table, indicators, &alerts);
+		now = live_blocks(&bytes);
+		worstDrift = (labs(now - live) > worstDrift) ? labs(now - live) : worstDrift;
+		steady = steady && now == live && bytes == lastBytes && xPortGetFreeHeapSize() == heapFree &&
+				 xPortGetMinimumEverFreeHeapSize() == heapLowest;
+	}
+	CHECK(steady);
+	CHECK_EQ(worstDrift, 0);
+	CHECK_EQ(table.count, 8);
+
+	if(report) {
+		printf("bench,mem_pool,soak_cycles,%d,cycles\n", SOAK_CYCLES);
+		printf("bench,mem_pool,soak_net_allocs,%ld,blocks\n", worstDrift);
+	}
+	free(json);
+}
+
+/*******************************************************************************
+ * Function Name: bench_pairs
+ *******************************************************************************
+ * Summary:
+ *  Times a malloc and free pair served by a pool, by heap_4 and by the host
+ *  C library.
+ *
+ *******************************************************************************/
+static void bench_pairs(void) {
+	static const size_t sizes[] = {48, 2048};
+	static const char *const names[] = {"pool", "heap"};
+	volatile uintptr_t sink = 0;
+	uint64_t start;
+
+	for(size_t s = 0; s < 2; s++) {
+		start = test_now_ns();
+		for(int i = 0; i < BENCH_RUNS; i++) {
+			void *ptr = malloc(sizes[s]);
+			sink += (uintptr_t)ptr;
+			free(ptr);
+		}
+		printf("bench,mem_pool,%s_pair,%llu,ns\n", names[s], (unsigned long long)((test_now_ns() - start) / BENCH_RUNS));
+	}
+
+	start = test_now_ns();
+	for(int i = 0; i < BENCH_RUNS; i++) {
+		void *ptr = __real_malloc(48);
+		sink += (uintptr_t)ptr;
+		__real_free(ptr);
+	}
+	printf("bench,mem_pool,libc_pair,%llu,ns\n", (unsigned long long)((test_now_ns() - start) / BENCH_RUNS));
+	(void)sink;
+}
+
+int main(int argc, char **argv) {
+	networkTask = host_rtos_task(1);
+	decodeTask = host_rtos_task(2);
+	mem_pool_register_task(networkTask, MEM_TAG_NETWORK);
+	mem_pool_register_task(decodeTask, MEM_TAG_DECODE);
+
+	test_pools();
+	test_calls();
+	test_tags();
+	soak(test_bench_requested(argc, argv));
+
+	if(test_bench_requested(argc, argv)) {
+		bench_pairs();
+	}
+
+	return test_summary("mem_pool");
+}
@@ -0,0 +1,367 @@
+/******************************************************************************
+* File Name:   test_poll_scheduler.c
+*
+* Description: This file contains the host tests and benchmark of the poll
+* scheduler, in New York time. A simulated clock jumps from one fetch
+* deadline to the next, so a week of polling runs in a moment; every
+* deadline is checked to fall after the clock and before any session
+* change. The benchmark times a deadline and counts the fetches of a week
+* with a holiday and an early close:
+*
+*   bench,poll_scheduler,next_fetch,<ns>,ns
+*   bench,poll_scheduler,fetches_per_week,<n>,n
+*
+*******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "poll_scheduler.h"
+#include "test.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define BENCH_RUNS (20)
+
+#define HOUR (60 * 60)
+#define DAY  (24 * HOUR)
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+// Fetches a walk of the simulated clock made, by the session each fell in
+typedef struct {
+	unsigned fetches[MARKET_AFTER + 1];
+	unsigned total;
+} walk_t;
+
+/*******************************************************************************
+ * Function Name: local
+ *******************************************************************************
+ * Summary:
+ *  Wall clock time of a New York date and time.
+ *
+ *******************************************************************************/
+static time_t local(int year, int month, int day, int hour, int minute) {
+	struct tm tm = {.tm_year = year - 1900, .tm_mon = month - 1, .tm_mday = day, .tm_hour = hour, .tm_min = minute, .tm_isdst = -1};
+
+	return mktime(&tm);
+}
+
+/*******************************************************************************
+ * Function Name: utc
+ *******************************************************************************
+ * Summary:
+ *  Wall clock time of a UTC date and time.
+ *
+ *******************************************************************************/
+static time_t utc(int year, int month, int day, int hour, int minute) {
+	struct tm tm = {.tm_year = year - 1900, .tm_mon = month - 1, .tm_mday = day, .tm_hour = hour, .tm_min = minute};
+
+	return timegm(&tm);
+}
+
+/*******************************************************************************
+ * Function Name: walk
+ *******************************************************************************
+ * Summary:
+ *  Runs the simulated clock from one time to another, fetching at every
+ *  deadline. A deadline must be after the clock, and the session must not
+ *  change before it, or a boundary print would be missed.
+ *
+ *******************************************************************************/
+static walk_t walk(time_t from, time_t to) {
+	walk_t result = {0};
+	time_t now = from;
+
+	while(now < to) {
+		market_session_t session;
+		time_t next = poll_scheduler_next_fetch(now, &session);
+
+		CHECK(next > now);
+		CHECK_EQ(poll_scheduler_session(next - 1), session);
+		if(next <= now) {
+			break;
+		}
+
+		now = next;
+		result.fetches[poll_scheduler_session(now)]++;
+		result.total++;
+	}
+
+	return result;
+}
+
+/*******************************************************************************
+ * Function Name: test_sessions
+ *******************************************************************************
+ * Summary:
+ *  The sessions of an ordinary trading day, to the second, with their names.
+ *
+ *******************************************************************************/
+static void test_sessions(void) {
+	// Thu 2024-06-13
+	CHECK_EQ(poll_scheduler_session(local(2024, 6, 13, 0, 0)), MARKET_CLOSED);
+	CHECK_EQ(poll_scheduler_session(local(2024, 6, 13, 4, 0) - 1), MARKET_CLOSED);
+	CHECK_EQ(poll_scheduler_session(local(2024, 6, 13, 4, 0)), MARKET_PRE);
+	CHECK_EQ(poll_scheduler_session(local(2024, 6, 13, 9, 30) - 1), MARKET_PRE);
+	CHECK_EQ(poll_scheduler_session(local(2024, 6, 13, 9, 30)), MARKET_REGULAR);
+	CHECK_EQ(poll_scheduler_session(local(2024, 6, 13, 16, 0) - 1), MARKET_REGULAR);
+	CHECK_EQ(poll_scheduler_session(local(2024, 6, 13, 16, 0)), MARKET_AFTER);
+	CHECK_EQ(poll_scheduler_session(local(2024, 6, 13, 20, 0) - 1), MARKET_AFTER);
+	CHECK_EQ(poll_scheduler_session(local(2024, 6, 13, 20, 0)), MARKET_CLOSED);
+	CHECK_EQ(poll_scheduler_session(local(2024, 6, 13, 23, 59)), MARKET_CLOSED);
+
+	// Weekends are closed at every hour
+	CHECK_EQ(poll_scheduler_session(local(2024, 6, 15, 10, 0)), MARKET_CLOSED);
+	CHECK_EQ(poll_scheduler_session(local(2024, 6, 16, 5, 0)), MARKET_CLOSED);
+	CHECK_EQ(poll_scheduler_session(local(2024, 6, 16, 17, 0)), MARKET_CLOSED);
+
+	CHECK_STR(poll_scheduler_session_name(MARKET_CLOSED), "closed");
+	CHECK_STR(poll_scheduler_session_name(MARKET_PRE), "pre-market");
+	CHECK_STR(poll_scheduler_session_name(MARKET_REGULAR), "regular");
+	CHECK_STR(poll_scheduler_session_name(MARKET_AFTER), "after-hours");
+}
+
+/*******************************************************************************
+ * Function Name: test_holiday_and_early_close
+ *******************************************************************************
+ * Summary:
+ *  Independence Day is closed all day. The day before closes the regular
+ *  session at 13:00 and after-hours at 17:00, and the first deadline after
+ *  it runs straight on to the hourly polls of a closed market.
+ *
+ *******************************************************************************/
+static void test_holiday_and_early_close(void) {
+	market_session_t session;
+
+	// Wed 2024-07-03, early close
+	CHECK_EQ(poll_scheduler_session(local(2024, 7, 3, 9, 30)), MARKET_REGULAR);
+	CHECK_EQ(poll_scheduler_session(local(2024, 7, 3, 13, 0) - 1), MARKET_REGULAR);
+	CHECK_EQ(poll_scheduler_session(local(2024, 7, 3, 13, 0)), MARKET_AFTER);
+	CHECK_EQ(poll_scheduler_session(local(2024, 7, 3, 17, 0) - 1), MARKET_AFTER);
+	CHECK_EQ(poll_scheduler_session(local(2024, 7, 3, 17, 0)), MARKET_CLOSED);
+	CHECK_EQ(poll_scheduler_next_fetch(local(2024, 7, 3, 12, 59) + 30, &session), local(2024, 7, 3, 13, 0));
+	CHECK_EQ(session, MARKET_REGULAR);
+	CHECK_EQ(poll_scheduler_next_fetch(local(2024, 7, 3, 16, 57), &session), local(2024, 7, 3, 17, 0));
+	CHECK_EQ(session, MARKET_AFTER);
+	CHECK_EQ(poll_scheduler_next_fetch(local(2024, 7, 3, 17, 0), &session), local(2024, 7, 3, 18, 0));
+	CHECK_EQ(session, MARKET_CLOSED);
+
+	// Thu 2024-07-04, closed; Fri 2024-07-05 trades as usual
+	CHECK_EQ(poll_scheduler_session(local(2024, 7, 4, 4, 0)), MARKET_CLOSED);
+	CHECK_EQ(poll_scheduler_session(local(2024, 7, 4, 10, 0)), MARKET_CLOSED);
+	CHECK_EQ(poll_scheduler_session(local(2024, 7, 4, 17, 0)), MARKET_CLOSED);
+	CHECK_EQ(poll_scheduler_next_fetch(local(2024, 7, 4, 9, 30), NULL), local(2024, 7, 4, 10, 0));
+	CHECK_EQ(poll_scheduler_next_fetch(local(2024, 7, 5, 3, 10), NULL), local(2024, 7, 5, 4, 0));
+	CHECK_EQ(poll_scheduler_session(local(2024, 7, 5, 4, 0)), MARKET_PRE);
+	CHECK_EQ(poll_scheduler_session(local(2024, 7, 5, 15, 0)), MARKET_REGULAR);
+}
+
+/*******************************************************************************
+ * Function Name: test_dst
+ *******************************************************************************
+ * Summary:
+ *  Sessions follow New York time across both DST changes: the open is 13:30
+ *  UTC in summer and 14:30 UTC in winter, and the pre-market open the
+ *  weekend of a change ends on lands on the right UTC hour.
+ *
+ *******************************************************************************/
+static void test_dst(void) {
+	// Spring forward, Sun 2024-03-10 02:00 EST
+	CHECK_EQ(poll_scheduler_next_fetch(local(2024, 3, 9, 23, 30), NULL), local(2024, 3, 10, 0, 0));
+	CHECK_EQ(poll_scheduler_next_fetch(local(2024, 3, 10, 1, 30), NULL), utc(2024, 3, 10, 7, 0));    // 03:00 EDT
+	CHECK_EQ(poll_scheduler_session(utc(2024, 3, 8, 14, 30)), MARKET_REGULAR);                     // Fri 09:30 EST
+	CHECK_EQ(poll_scheduler_session(utc(2024, 3, 8, 14, 29)), MARKET_PRE);
+	CHECK_EQ(poll_scheduler_next_fetch(utc(2024, 3, 11, 7, 30), NULL), utc(2024, 3, 11, 8, 0));    // Mon 04:00 EDT
+	CHECK_EQ(poll_scheduler_session(utc(2024, 3, 11, 13, 30)), MARKET_REGULAR);                    // Mon 09:30 EDT
+	CHECK_EQ(poll_scheduler_session(utc(2024, 3, 11, 13, 29)), MARKET_PRE);
+
+	// Fall back, Sun 2024-11-03 02:00 EDT, 01:00 to 02:00 comes twice
+	CHECK_EQ(poll_scheduler_next_fetch(utc(2024, 11, 3, 5, 0), NULL), utc(2024, 11, 3, 6, 0));    // 01:00 EDT, then 01:00 EST
+	CHECK_EQ(poll_scheduler_next_fetch(utc(2024, 11, 3, 6, 0), NULL), utc(2024, 11, 3, 7, 0));
+	CHECK_EQ(poll_scheduler_session(utc(2024, 11, 1, 13, 30)), MARKET_REGULAR);                   // Fri 09:30 EDT
+	CHECK_EQ(poll_scheduler_next_fetch(utc(2024, 11, 4, 8, 30), NULL), utc(2024, 11, 4, 9, 0));    // Mon 04:00 EST
+	CHECK_EQ(poll_scheduler_session(utc(2024, 11, 4, 14, 30)), MARKET_REGULAR);                   // Mon 09:30 EST
+	CHECK_EQ(poll_scheduler_session(utc(2024, 11, 4, 14, 29)), MARKET_PRE);
+	CHECK_EQ(poll_scheduler_session(utc(2024, 11, 4, 13, 30)), MARKET_PRE);
+}
+
+/*******************************************************************************
+ * Function Name: test_weekends
+ *******************************************************************************
+ * Summary:
+ *  From the close of after-hours on Friday the clock is polled hourly until
+ *  Monday's pre-market open, one fetch per real hour whether the weekend is
+ *  an ordinary one or loses or gains an hour to DST.
+ *
+ *******************************************************************************/
+static void test_weekends(void) {
+	walk_t weekend;
+
+	// Friday's last after-hours deadline is the close itself
+	CHECK_EQ(poll_scheduler_next_fetch(local(2024, 6, 14, 19, 58), NULL), local(2024, 6, 14, 20, 0));
+	CHECK_EQ(poll_scheduler_next_fetch(local(2024, 6, 14, 20, 0), NULL), local(2024, 6, 14, 21, 0));
+	CHECK_EQ(poll_scheduler_next_fetch(local(2024, 6, 17, 3, 59) + 30, NULL), local(2024, 6, 17, 4, 0));
+
+	weekend = walk(local(2024, 6, 14, 20, 0), local(2024, 6, 17, 4, 0));
+	CHECK_EQ(weekend.total, 56);
+	CHECK_EQ(weekend.fetches[MARKET_CLOSED], 55);
+	CHECK_EQ(weekend.fetches[MARKET_PRE], 1);
+
+	weekend = walk(local(2024, 3, 8, 20, 0), local(2024, 3, 11, 4, 0));
+	CHECK_EQ(weekend.total, 55);
+
+	weekend = walk(local(2024, 11, 1, 20, 0), local(2024, 11, 4, 4, 0));
+	CHECK_EQ(weekend.total, 57);
+}
+
+/*******************************************************************************
+ * Function Name: test_week
+ *******************************************************************************
+ * Summary:
+ *  A week of polling with the Independence Day holiday and the early close
+ *  before it: every regular minute is fetched, every fifth extended-hours
+ *  minute, and closed hours once an hour.
+ *
+ *******************************************************************************/
+static void test_week(void) {
+	walk_t week = walk(local(2024, 7, 1, 0, 0), local(2024, 7, 8, 0, 0));
+
+	// Three full days and the 9:30 to 13:00 of the early close
+	CHECK_EQ(week.fetches[MARKET_REGULAR], 3 * 390 + 210);
+	CHECK_EQ(week.fetches[MARKET_PRE], 4 * 66);
+	CHECK_EQ(week.fetches[MARKET_AFTER], 4 * 48);
+	CHECK_EQ(week.fetches[MARKET_CLOSED], 107);
+}
+
+/*******************************************************************************
+ * Function Name: test_tables
+ *******************************************************************************
+ * Summary:
+ *  Scans every weekday the tables cover. Each listed holiday falls on a
+ *  weekday and closes it, each early close falls on a trading day, and no
+ *  other weekday is short; the known dates are spot checked.
+ *
+ *******************************************************************************/
+static void test_tables(void) {
+	static const unsigned expectedHolidays[] = {10, 11, 10, 10};
+	static const unsigned expectedEarlyCloses[] = {3, 3, 2, 1};
+	unsigned holidays[4] = {0};
+	unsigned earlyCloses[4] = {0};
+
+	for(time_t noon = local(2024, 1, 1, 12, 0); noon < local(2028, 1, 1, 0, 0); noon += DAY) {
+		struct tm day;
+		time_t morning;
+		time_t afternoon;
+
+		(void)localtime_r(&noon, &day);
+		if(day.tm_wday == 0 || day.tm_wday == 6) {
+			continue;
+		}
+
+		// Noon plus a whole number of days drifts an hour with DST, go by the date
+		morning = local(day.tm_year + 1900, day.tm_mon + 1, day.tm_mday, 10, 0);
+		afternoon = local(day.tm_year + 1900, day.tm_mon + 1, day.tm_mday, 14, 0);
+		if(poll_scheduler_session(morning) == MARKET_CLOSED) {
+			holidays[day.tm_year - 124]++;
+			CHECK_EQ(poll_scheduler_session(afternoon), MARKET_CLOSED);
+		} else if(poll_scheduler_session(afternoon) == MARKET_AFTER) {
+			earlyCloses[day.tm_year - 124]++;
+		} else {
+			CHECK_EQ(poll_scheduler_session(afternoon), MARKET_REGULAR);
+		}
+	}
+
+	for(int year = 0; year < 4; year++) {
+		CHECK_EQ(holidays[year], expectedHolidays[year]);
+		CHECK_EQ(earlyCloses[year], expectedEarlyCloses[year]);
+	}
+
+	CHECK_EQ(poll_scheduler_session(local(2024, 3, 29, 10, 0)), MARKET_CLOSED);    // Good Friday
+	CHECK_EQ(poll_scheduler_session(local(2025, 1, 9, 10, 0)), MARKET_CLOSED);     // National day of mourning
+	CHECK_EQ(poll_scheduler_session(local(2026, 7, 3, 10, 0)), MARKET_CLOSED);     // Independence Day observed
+	CHECK_EQ(poll_scheduler_session(local(2027, 12, 24, 10, 0)), MARKET_CLOSED);   // Christmas observed
+	CHECK_EQ(poll_scheduler_session(local(2025, 11, 28, 14, 0)), MARKET_AFTER);    // Day after Thanksgiving
+	CHECK_EQ(poll_scheduler_session(local(2026, 12, 24, 12, 0)), MARKET_REGULAR);
+	CHECK_EQ(poll_scheduler_session(local(2026, 12, 24, 13, 0)), MARKET_AFTER);
+}
+
+/*******************************************************************************
+ * Function Name: test_parse_http_date
+ *******************************************************************************
+ * Summary:
+ *  Dates in the IMF-fixdate form of RFC 9110 parse to their UTC time; the
+ *  day name is not checked. Anything else, or a value too long to copy,
+ *  parses to 0.
+ *
+ *******************************************************************************/
+static void test_parse_http_date(void) {
+	static const char *const bad[] = {
+		"",
+		"Sun, 18 Oct 2026",
+		"Sun, 18 Foo 2026 14:03:07 GMT",
+		"Sun, 18 anF 2026 14:03:07 GMT",    // Straddles Jan and Feb in the month table
+		"Sunday, 18-Oct-26 14:03:07 GMT",
+		"Sun, 18 Oct 2026 14:03:07 GMT                    ",
+	};
+	const char *date = "Sun, 18 Oct 2026 14:03:07 GMT";
+
+	CHECK_EQ(poll_scheduler_parse_http_date(date, strlen(date)), utc(2026, 10, 18, 14, 3) + 7);
+
+	date = "Thu, 29 Feb 2024 00:00:00 GMT";
+	CHECK_EQ(poll_scheduler_parse_http_date(date, strlen(date)), utc(2024, 2, 29, 0, 0));
+	date = "Fri, 31 Dec 1999 23:59:59 GMT";
+	CHECK_EQ(poll_scheduler_parse_http_date(date, strlen(date)), utc(2000, 1, 1, 0, 0) - 1);
+	date = "Mon, 01 Jan 1970 00:00:00 GMT";
+	CHECK_EQ(poll_scheduler_parse_http_date(date, strlen(date)), 0);
+
+	// Header values are not terminated, only value_len is read
+	date = "Wed, 12 Jun 2024 08:00:00 GMT\r\nServer: x";
+	CHECK_EQ(poll_scheduler_parse_http_date(date, 29), utc(2024, 6, 12, 8, 0));
+
+	for(size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+		CHECK_EQ(poll_scheduler_parse_http_date(bad[i], strlen(bad[i])), 0);
+	}
+}
+
+/*******************************************************************************
+ * Function Name: bench_scheduler
+ *******************************************************************************
+ * Summary:
+ *  Times a deadline over the week of test_week, the scheduler's work on
+ *  each poll, and prints the fetches that week costs.
+ *
+ *******************************************************************************/
+static void bench_scheduler(void) {
+	walk_t week = {0};
+	uint64_t start = test_now_ns();
+	unsigned calls = 0;
+
+	for(int run = 0; run < BENCH_RUNS; run++) {
+		week = walk(local(2024, 7, 1, 0, 0), local(2024, 7, 8, 0, 0));
+		calls += week.total;
+	}
+	printf("bench,poll_scheduler,next_fetch,%llu,ns\n", (unsigned long long)((test_now_ns() - start) / calls));
+	printf("bench,poll_scheduler,fetches_per_week,%u,n\n", week.total);
+}
+
+int main(int argc, char **argv) {
+	setenv("TZ", "EST5EDT", 1);
+	tzset();
+
+	test_sessions();
+	test_holiday_and_early_close();
+	test_dst();
+	test_weekends();
+	test_week();
+	test_tables();
+	test_parse_http_date();
+
+	if(test_bench_requested(argc, argv)) {
+		bench_scheduler();
+	}
+
+	return test_summary("poll_scheduler");
+}
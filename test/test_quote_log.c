@@ -0,0 +1,309 @@
+/******************************************************************************
+* File Name:   test_quote_log.c
+*
+* Description: This file contains the host tests and benchmark of the quote
+* log, run on the file-backed flash emulator. A reboot is a child process
+* that appends and exits, after which this process, which never appended,
+* reads the same flash back from the file. The benchmark times an append
+* and the boot-time reads, and counts the rows a trading day writes:
+*
+*   bench,quote_log,<append_batch|boot_load>,<ns>,ns
+*   bench,quote_log,rows_per_day,<rows>,rows
+*   bench,quote_log,erases_per_row_per_day,<erases>,erases
+*
+*******************************************************************************/
+
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "host_flash.h"
+#include "quote_log.h"
+#include "test.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define FLASH_FILE "build/quote_log.flash"
+
+// Thu 2024-06-13 04:00 EDT, start of pre-market
+#define DAY_START (1718265600)
+
+// One batch a minute, 4:00 to 20:00
+#define DAY_MINUTES (16 * 60)
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+static const char *const watchlist[] = {"AMD", "NVDA", "INTC", "AAPL", "MSFT", "TSM", "QCOM", "ARM"};
+#define WATCHLIST_LEN (sizeof(watchlist) / sizeof(watchlist[0]))
+
+static quote_table_t table;
+static uint32_t writerSymbols = 3;
+static uint32_t writerMinutes = 0;
+static bool writerStopsOnFailure = false;
+
+/*******************************************************************************
+ * Function Name: log_ring_write
+ *******************************************************************************
+ * Summary:
+ *  Logging is not under test.
+ *
+ *******************************************************************************/
+void log_ring_write(uint32_t level, const char *format, uint32_t count, ...) {
+}
+
+/*******************************************************************************
+ * Function Name: price_at
+ *******************************************************************************
+ * Summary:
+ *  Whole-cent price of a slot at a minute of the day.
+ *
+ *******************************************************************************/
+static fixed_t price_at(uint32_t slot, uint32_t minute) {
+	return (fixed_t)(1000000 + slot * 500000 + (minute * 37 + slot * 11) % 2000 * 100);
+}
+
+/*******************************************************************************
+ * Function Name: fill_batch
+ *******************************************************************************
+ * Summary:
+ *  The decoded table of one poll.
+ *
+ *******************************************************************************/
+static void fill_batch(uint32_t symbols, uint32_t minute) {
+	table.count = symbols;
+	for(uint32_t i = 0; i < symbols; i++) {
+		quote_t *quote = &table.quotes[i];
+
+		(void)memset(quote, 0, sizeof(*quote));
+		(void)snprintf(quote->symbol, sizeof(quote->symbol), "%s", watchlist[i]);
+		quote->timestamp = DAY_START + 60 * (time_t)minute;
+		quote->price = price_at(i, minute);
+		quote->change_percent = 12300;
+		quote->day_low = 900000;
+		quote->day_high = 3000000;
+		quote->open = 1000000;
+		quote->previous_close = 990000;
+	}
+}
+
+/*******************************************************************************
+ * Function Name: writer
+ *******************************************************************************
+ * Summary:
+ *  Body of the child process: boots on the flash file and appends a batch
+ *  a minute, stopping dead at the first failed write when asked to, like a
+ *  reset in the middle of it.
+ *
+ *******************************************************************************/
+static void writer(void) {
+	if(!host_flash_attach(FLASH_FILE)) {
+		_exit(2);
+	}
+	quote_log_init();
+
+	for(uint32_t minute = 0; minute < writerMinutes; minute++) {
+		fill_batch(writerSymbols, minute);
+		quote_log_append(&table);
+		if(writerStopsOnFailure && host_flash_stats().failed > 0) {
+			break;
+		}
+	}
+	_exit(0);
+}
+
+/*******************************************************************************
+ * Function Name: reboot
+ *******************************************************************************
+ * Summary:
+ *  Runs the writer in a child and boots this process on what it left.
+ *
+ *******************************************************************************/
+static void reboot(void) {
+	int status = -1;
+	pid_t child = fork();
+
+	if(child == 0) {
+		writer();
+	}
+	CHECK(child > 0 && waitpid(child, &status, 0) == child && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+	CHECK(host_flash_attach(FLASH_FILE));
+	quote_log_init();
+}
+
+/*******************************************************************************
+ * Function Name: blank_flash
+ *******************************************************************************
+ * Summary:
+ *  Starts a test with erased flash.
+ *
+ *******************************************************************************/
+static void blank_flash(void) {
+	CHECK(host_flash_attach(FLASH_FILE));
+	host_flash_blank();
+}
+
+/*******************************************************************************
+ * Function Name: check_replay
+ *******************************************************************************
+ * Summary:
+ *  The ticks replayed for a slot are the minutes first to last, exact.
+ *
+ *******************************************************************************/
+static void check_replay(uint32_t slot, uint32_t first, uint32_t last) {
+	static tick_ring_t ring;
+	tick_iter_t iter;
+	uint32_t minute = first;
+	bool allMatch = true;
+
+	tick_ring_reset(&ring);
+	CHECK_EQ(quote_log_replay_ticks(slot, 0, &ring), last - first + 1);
+
+	tick_iter_init(&iter, &ring, 0);
+	while(tick_iter_next(&iter)) {
+		allMatch = allMatch && iter.time == DAY_START + 60 * (time_t)minute && iter.price == price_at(slot, minute);
+		minute++;
+	}
+	CHECK(allMatch);
+}
+
+/*******************************************************************************
+ * Function Name: test_round_trip
+ *******************************************************************************
+ * Summary:
+ *  Two hours of three symbols survive a reboot. Snapshots go out every
+ *  15 minutes of quote time with the ticks before them; the ticks after
+ *  the last one (minutes 106 to 119) were still in RAM and are lost.
+ *
+ *******************************************************************************/
+static void test_round_trip(void) {
+	static quote_t quotes[WATCHLIST_LEN];
+
+	blank_flash();
+	CHECK_EQ(quote_log_load(quotes, WATCHLIST_LEN), 0);
+
+	writerSymbols = 3;
+	writerMinutes = 120;
+	writerStopsOnFailure = false;
+	reboot();
+
+	CHECK_EQ(quote_log_load(quotes, WATCHLIST_LEN), 3);
+	CHECK_STR(quotes[0].symbol, "AMD");
+	CHECK_STR(quotes[2].symbol, "INTC");
+	CHECK_EQ(quotes[1].timestamp, DAY_START + 60 * 105);
+	CHECK_EQ(quotes[1].price, price_at(1, 105));
+	CHECK_EQ(quotes[1].open, 1000000);
+	CHECK_EQ(quotes[1].previous_close, 990000);
+	CHECK_EQ(quotes[1].change_percent, 12300);
+
+	check_replay(0, 0, 105);
+	check_replay(2, 0, 105);
+}
+
+/*******************************************************************************
+ * Function Name: test_torn_write
+ *******************************************************************************
+ * Summary:
+ *  A reset in the middle of the fourth row write (the ticks of minutes 16
+ *  to 30) leaves a torn row that is skipped; the boot restores the last
+ *  snapshot, minute 15, and its ticks.
+ *
+ *******************************************************************************/
+static void test_torn_write(void) {
+	static quote_t quotes[WATCHLIST_LEN];
+
+	blank_flash();
+	host_flash_tear_after(3);
+	writerMinutes = 120;
+	writerStopsOnFailure = true;
+	reboot();
+	host_flash_tear_after(0);
+
+	CHECK_EQ(quote_log_load(quotes, WATCHLIST_LEN), 3);
+	CHECK_EQ(quotes[0].timestamp, DAY_START + 60 * 15);
+	CHECK_EQ(quotes[0].price, price_at(0, 15));
+	check_replay(1, 0, 15);
+}
+
+/*******************************************************************************
+ * Function Name: test_wrap
+ *******************************************************************************
+ * Summary:
+ *  A whole day of all eight symbols goes round the ring more than once and
+ *  still reads back the latest snapshot, minute 945, brought forward by the
+ *  tick rows that filled after it: 60 ticks a row, so the first one after
+ *  the snapshot ends with ARM at minute 952.
+ *
+ *******************************************************************************/
+static void test_wrap(void) {
+	static quote_t quotes[WATCHLIST_LEN];
+
+	blank_flash();
+	writerSymbols = WATCHLIST_LEN;
+	writerMinutes = DAY_MINUTES;
+	writerStopsOnFailure = false;
+	reboot();
+
+	CHECK_EQ(quote_log_load(quotes, WATCHLIST_LEN), WATCHLIST_LEN);
+	CHECK_STR(quotes[7].symbol, "ARM");
+	CHECK_EQ(quotes[7].timestamp, DAY_START + 60 * 952);
+	CHECK_EQ(quotes[7].price, price_at(7, 952));
+	CHECK_EQ(quotes[0].timestamp, DAY_START + 60 * 953);
+}
+
+/*******************************************************************************
+ * Function Name: bench_log
+ *******************************************************************************
+ * Summary:
+ *  Times appends of an eight symbol batch and the boot reads (scan, load,
+ *  replay of every slot), and counts the rows a day of one batch a minute
+ *  writes and how often that erases each row.
+ *
+ *******************************************************************************/
+static void bench_log(void) {
+	static quote_t quotes[WATCHLIST_LEN];
+	static tick_ring_t ring;
+	host_flash_stats_t before;
+	host_flash_stats_t after;
+	uint64_t start;
+	const uint32_t days = 20;
+
+	blank_flash();
+	quote_log_init();
+	before = host_flash_stats();
+	start = test_now_ns();
+	for(uint32_t minute = 0; minute < days * DAY_MINUTES; minute++) {
+		fill_batch(WATCHLIST_LEN, minute);
+		quote_log_append(&table);
+	}
+	after = host_flash_stats();
+	printf("bench,quote_log,append_batch,%llu,ns\n", (unsigned long long)((test_now_ns() - start) / (days * DAY_MINUTES)));
+	printf("bench,quote_log,rows_per_day,%lu,rows\n", (unsigned long)((after.row_writes - before.row_writes) / days));
+	printf("bench,quote_log,erases_per_row_per_day,%lu,erases\n", (unsigned long)((after.row_writes - before.row_writes) / days / QUOTE_LOG_ROWS));
+
+	start = test_now_ns();
+	for(int run = 0; run < 100; run++) {
+		quote_log_init();
+		(void)quote_log_load(quotes, WATCHLIST_LEN);
+		for(uint32_t slot = 0; slot < WATCHLIST_LEN; slot++) {
+			tick_ring_reset(&ring);
+			(void)quote_log_replay_ticks(slot, quotes[slot].timestamp - QUOTE_LOG_HISTORY_S, &ring);
+		}
+	}
+	printf("bench,quote_log,boot_load,%llu,ns\n", (unsigned long long)((test_now_ns() - start) / 100));
+}
+
+int main(int argc, char **argv) {
+	test_round_trip();
+	test_torn_write();
+	test_wrap();
+
+	if(test_bench_requested(argc, argv)) {
+		bench_log();
+	}
+
+	(void)unlink(FLASH_FILE);
+	return test_summary("quote_log");
+}
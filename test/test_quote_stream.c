@@ -0,0 +1,310 @@
+/******************************************************************************
+* File Name:   test_quote_stream.c
+*
+* Description: This file contains the host tests and benchmark of the
+* streaming quote extractor, run over recorded /api/v3/quote responses.
+* The bodies are fed whole, split at every byte and one byte at a time, and
+* must always give the same table. The program is linked with malloc
+* wrapped, so a parse that allocates fails the test. Built with cJSON
+* (make CJSON_DIR=...), the benchmark also times the cJSON DOM parse the
+* extractor replaced:
+*
+*   bench,quote_stream,<parser>_<corpus>,<ns per body>,ns
+*   bench,quote_stream,<parser>_<corpus>_peak,<bytes>,B
+*
+*******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "quote.h"
+#include "quote_stream.h"
+#include "test.h"
+
+#ifdef HAVE_CJSON
+#include "cJSON.h"
+#endif
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define BENCH_RUNS (20000)
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void __real_free(void *ptr);
+void *__wrap_malloc(size_t size);
+void *__wrap_calloc(size_t count, size_t size);
+void *__wrap_realloc(void *ptr, size_t size);
+void __wrap_free(void *ptr);
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+// Heap use through malloc, for the allocation check and the cJSON peak
+static unsigned long allocations = 0;
+static size_t heapNow = 0;
+static size_t heapPeak = 0;
+
+/*******************************************************************************
+ * Function Name: __wrap_malloc, __wrap_calloc, __wrap_realloc, __wrap_free
+ *******************************************************************************
+ * Summary:
+ *  Count allocations and track the bytes in use. A size header in front of
+ *  each block lets free know how much is returned.
+ *
+ *******************************************************************************/
+void *__wrap_malloc(size_t size) {
+	size_t *block = __real_malloc(size + sizeof(max_align_t));
+
+	if(block == NULL) {
+		return NULL;
+	}
+	allocations++;
+	heapNow += size;
+	heapPeak = (heapNow > heapPeak) ? heapNow : heapPeak;
+	*block = size;
+	return (char *)block + sizeof(max_align_t);
+}
+
+void *__wrap_calloc(size_t count, size_t size) {
+	void *ptr = __wrap_malloc(count * size);
+
+	if(ptr != NULL) {
+		(void)memset(ptr, 0, count * size);
+	}
+	return ptr;
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+	void *moved = __wrap_malloc(size);
+	size_t old;
+
+	if(ptr == NULL || moved == NULL) {
+		return moved;
+	}
+	old = *(size_t *)((char *)ptr - sizeof(max_align_t));
+	(void)memcpy(moved, ptr, (old < size) ? old : size);
+	__wrap_free(ptr);
+	return moved;
+}
+
+void __wrap_free(void *ptr) {
+	size_t *block;
+
+	if(ptr == NULL) {
+		return;
+	}
+	block = (size_t *)((char *)ptr - sizeof(max_align_t));
+	heapNow -= *block;
+	__real_free(block);
+}
+
+/*******************************************************************************
+ * Function Name: same_table
+ *******************************************************************************
+ * Summary:
+ *  Compares two parsed tables field by field.
+ *
+ *******************************************************************************/
+static bool same_table(const quote_table_t *a, const quote_table_t *b) {
+	if(a->count != b->count) {
+		return false;
+	}
+	for(uint32_t i = 0; i < a->count; i++) {
+		const quote_t *x = &a->quotes[i];
+		const quote_t *y = &b->quotes[i];
+
+		if(strcmp(x->symbol, y->symbol) != 0 || x->price != y->price || x->change_percent != y->change_percent || x->day_low != y->day_low ||
+		   x->day_high != y->day_high || x->open != y->open || x->previous_close != y->previous_close || x->timestamp != y->timestamp ||
+		   memcmp(x->extra, y->extra, sizeof(x->extra)) != 0) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/*******************************************************************************
+ * Function Name: test_one
+ *******************************************************************************
+ * Summary:
+ *  Every kept field of a single-symbol response.
+ *
+ *******************************************************************************/
+static void test_one(void) {
+	static quote_table_t table;
+	size_t len;
+	char *json = test_read_file("fmp_quote_one.json", &len);
+	const quote_t *q = &table.quotes[0];
+
+	CHECK_EQ(quote_table_parse(&table, json, len), 1);
+	CHECK_STR(q->symbol, "AMD");
+	CHECK_EQ(q->price, 1567900);
+	CHECK_EQ(q->change_percent, -12346);
+	CHECK_EQ(q->day_low, 1536500);
+	CHECK_EQ(q->day_high, 1583600);
+	CHECK_EQ(q->open, 1560100);
+	CHECK_EQ(q->previous_close, 1572600);
+	CHECK_EQ(q->timestamp, 1718308800);
+	CHECK_EQ(q->extra[quote_stream_extra_index("volume")], 412345670000LL);
+	free(json);
+}
+
+/*******************************************************************************
+ * Function Name: test_splits
+ *******************************************************************************
+ * Summary:
+ *  The multi-symbol response fed in two pieces split at every byte, and one
+ *  byte at a time, gives the same table as fed whole.
+ *
+ *******************************************************************************/
+static void test_splits(void) {
+	static quote_table_t whole;
+	static quote_table_t split;
+	quote_stream_t stream;
+	size_t len;
+	char *json = test_read_file("fmp_quote_many.json", &len);
+	unsigned long before = allocations;
+	bool allSame = true;
+
+	CHECK_EQ(quote_table_parse(&whole, json, len), 8);
+	CHECK_STR(whole.quotes[0].symbol, "AMD");
+	CHECK_STR(whole.quotes[7].symbol, "ARM");
+	CHECK_EQ(whole.quotes[3].price, 2124900);
+
+	for(size_t at = 0; at <= len; at++) {
+		quote_stream_init(&stream, &split);
+		quote_stream_feed(&stream, json, at);
+		quote_stream_feed(&stream, json + at, len - at);
+		(void)quote_stream_finish(&stream);
+		allSame = allSame && same_table(&whole, &split);
+	}
+	CHECK(allSame);
+
+	quote_stream_init(&stream, &split);
+	for(size_t i = 0; i < len; i++) {
+		quote_stream_feed(&stream, &json[i], 1);
+	}
+	(void)quote_stream_finish(&stream);
+	CHECK(same_table(&whole, &split));
+
+	// Zero heap, whatever the pieces
+	CHECK_EQ(allocations - before, 0);
+	free(json);
+}
+
+/*******************************************************************************
+ * Function Name: test_errors
+ *******************************************************************************
+ * Summary:
+ *  An error reply gives no quotes; a body cut short or broken keeps the
+ *  quotes completed before the damage.
+ *
+ *******************************************************************************/
+static void test_errors(void) {
+	static quote_table_t table;
+	size_t len;
+	char *error = test_read_file("fmp_error.json", &len);
+	char *json;
+	char *second;
+
+	CHECK_EQ(quote_table_parse(&table, error, len), 0);
+	free(error);
+
+	json = test_read_file("fmp_quote_many.json", &len);
+	second = strstr(json + 1, "\"symbol\": \"NVDA\"");
+	CHECK(second != NULL);
+	CHECK_EQ(quote_table_parse(&table, json, (size_t)(second - json)), 1);
+
+	// A stray closing bracket inside the second object
+	*second = ']';
+	CHECK_EQ(quote_table_parse(&table, json, len), 1);
+	CHECK_STR(table.quotes[0].symbol, "AMD");
+	free(json);
+
+	CHECK_EQ(quote_table_parse(&table, "[]", 2), 0);
+	CHECK_EQ(quote_table_parse(&table, "[{\"symbol\":\"X\"}]", 16), 0);    // No price, not a quote
+	CHECK_EQ(quote_table_parse(&table, "[{\"symbol\":\"X\",\"price\":null,\"open\":1}]", 38), 0);
+}
+
+#ifdef HAVE_CJSON
+/*******************************************************************************
+ * Function Name: cjson_parse
+ *******************************************************************************
+ * Summary:
+ *  The DOM parse the extractor replaced: build the tree, look up the kept
+ *  fields, delete the tree.
+ *
+ *******************************************************************************/
+static uint32_t cjson_parse(quote_table_t *table, const char *json, size_t len) {
+	static const char *const names[] = {"price", "changesPercentage", "dayLow", "dayHigh", "open", "previousClose", "timestamp", "volume"};
+	cJSON *root = cJSON_ParseWithLength(json, len);
+	cJSON *item;
+
+	table->count = 0;
+	cJSON_ArrayForEach(item, root) {
+		cJSON *symbol = cJSON_GetObjectItem(item, "symbol");
+		double sum = 0;
+
+		if(!cJSON_IsString(symbol) || table->count >= QUOTE_TABLE_CAPACITY) {
+			continue;
+		}
+		for(size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+			sum += cJSON_GetNumberValue(cJSON_GetObjectItem(item, names[i]));
+		}
+		table->quotes[table->count++].price = (fixed_t)sum;
+	}
+	cJSON_Delete(root);
+
+	return table->count;
+}
+#endif
+
+/*******************************************************************************
+ * Function Name: bench_corpus
+ *******************************************************************************
+ * Summary:
+ *  Times the extractor, and cJSON when built in, over one recorded body.
+ *
+ *******************************************************************************/
+static void bench_corpus(const char *corpus, const char *file) {
+	static quote_table_t table;
+	size_t len;
+	char *json = test_read_file(file, &len);
+	uint64_t start = test_now_ns();
+
+	for(int i = 0; i < BENCH_RUNS; i++) {
+		(void)quote_table_parse(&table, json, len);
+	}
+	printf("bench,quote_stream,stream_%s,%llu,ns\n", corpus, (unsigned long long)((test_now_ns() - start) / BENCH_RUNS));
+	printf("bench,quote_stream,stream_%s_peak,%zu,B\n", corpus, sizeof(quote_stream_t));
+
+#ifdef HAVE_CJSON
+	heapPeak = heapNow;
+	start = test_now_ns();
+	for(int i = 0; i < BENCH_RUNS; i++) {
+		(void)cjson_parse(&table, json, len);
+	}
+	printf("bench,quote_stream,cjson_%s,%llu,ns\n", corpus, (unsigned long long)((test_now_ns() - start) / BENCH_RUNS));
+	printf("bench,quote_stream,cjson_%s_peak,%zu,B\n", corpus, heapPeak - heapNow);
+#endif
+
+	free(json);
+}
+
+int main(int argc, char **argv) {
+	test_one();
+	test_splits();
+	test_errors();
+
+	if(test_bench_requested(argc, argv)) {
+		bench_corpus("one", "fmp_quote_one.json");
+		bench_corpus("many", "fmp_quote_many.json");
+	}
+
+	return test_summary("quote_stream");
+}
@@ -0,0 +1,209 @@
+/******************************************************************************
+* File Name:   test_tick_ring.c
+*
+* Description: This file contains the host tests and benchmark of the
+* delta-encoded tick ring, and of the trading date the display starts a new
+* chart on. The benchmark times a push and a full decode of a session, and
+* prints the bytes each stored tick costs:
+*
+*   bench,tick_ring,<push|decode_session>,<ns>,ns
+*   bench,tick_ring,bytes_per_tick,<bytes>,B
+*
+*******************************************************************************/
+
+#include <stdlib.h>
+
+#include "poll_scheduler.h"
+#include "tick_ring.h"
+#include "test.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define BENCH_RUNS (2000)
+
+// Thu 2024-06-13 09:30 EDT
+#define SESSION_OPEN (1718285400)
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+static tick_ring_t ring;
+
+/*******************************************************************************
+ * Function Name: newest
+ *******************************************************************************
+ * Summary:
+ *  Decodes the ring to its newest tick.
+ *
+ *******************************************************************************/
+static tick_iter_t newest(void) {
+	tick_iter_t iter;
+
+	tick_iter_init(&iter, &ring, ring.count - 1);
+	(void)tick_iter_next(&iter);
+	return iter;
+}
+
+/*******************************************************************************
+ * Function Name: test_push
+ *******************************************************************************
+ * Summary:
+ *  Ticks decode to what was pushed, to the cent; a repeated quote is dropped
+ *  and a clamped jump is caught up by the next tick.
+ *
+ *******************************************************************************/
+static void test_push(void) {
+	tick_iter_t iter;
+
+	tick_ring_reset(&ring);
+	CHECK(tick_ring_push(&ring, SESSION_OPEN, 1567900));
+	CHECK(tick_ring_push(&ring, SESSION_OPEN + 60, 1568149));
+	CHECK(!tick_ring_push(&ring, SESSION_OPEN + 60, 1569000));
+	CHECK(!tick_ring_push(&ring, SESSION_OPEN + 30, 1569000));
+	CHECK_EQ(ring.count, 2);
+
+	tick_iter_init(&iter, &ring, 0);
+	CHECK(tick_iter_next(&iter));
+	CHECK_EQ(iter.time, SESSION_OPEN);
+	CHECK_EQ(iter.price, 1567900);
+	CHECK(tick_iter_next(&iter));
+	CHECK_EQ(iter.time, SESSION_OPEN + 60);
+	CHECK_EQ(iter.price, 1568100);
+	CHECK(!tick_iter_next(&iter));
+
+	// 400.00 up is more than a delta holds, the next tick catches up
+	CHECK(tick_ring_push(&ring, SESSION_OPEN + 120, 1568100 + 4000000));
+	CHECK_EQ(newest().price, 1568100 + (fixed_t)INT16_MAX * TICK_RING_PRICE_UNIT);
+	CHECK(tick_ring_push(&ring, SESSION_OPEN + 180, 1568100 + 4000000));
+	CHECK_EQ(newest().price, 1568100 + 4000000);
+	CHECK_EQ(ring.last_price, 1568100 + 4000000);
+}
+
+/*******************************************************************************
+ * Function Name: test_wrap
+ *******************************************************************************
+ * Summary:
+ *  Past capacity the oldest ticks are dropped and the base moves with them.
+ *
+ *******************************************************************************/
+static void test_wrap(void) {
+	const uint32_t pushed = TICK_RING_CAPACITY + 500;
+	tick_iter_t iter;
+	bool allMatch = true;
+	uint32_t seen = 0;
+
+	tick_ring_reset(&ring);
+	for(uint32_t i = 0; i < pushed; i++) {
+		(void)tick_ring_push(&ring, SESSION_OPEN + 60 * i, 1000000 + (fixed_t)(i % 37) * 300);
+	}
+	CHECK_EQ(ring.count, TICK_RING_CAPACITY);
+	CHECK_EQ(ring.first_time, SESSION_OPEN + 60 * (pushed - TICK_RING_CAPACITY));
+
+	tick_iter_init(&iter, &ring, 0);
+	while(tick_iter_next(&iter)) {
+		uint32_t i = pushed - TICK_RING_CAPACITY + seen++;
+
+		allMatch = allMatch && iter.time == SESSION_OPEN + 60 * (time_t)i && iter.price == 1000000 + (fixed_t)(i % 37) * 300;
+	}
+	CHECK_EQ(seen, TICK_RING_CAPACITY);
+	CHECK(allMatch);
+}
+
+/*******************************************************************************
+ * Function Name: test_gap
+ *******************************************************************************
+ * Summary:
+ *  A gap too long for a delta starts the ring over at the new tick instead
+ *  of leaving last_time behind the real time.
+ *
+ *******************************************************************************/
+static void test_gap(void) {
+	const time_t monday = SESSION_OPEN + 4 * 24 * 60 * 60;
+
+	tick_ring_reset(&ring);
+	(void)tick_ring_push(&ring, SESSION_OPEN, 1567900);
+	(void)tick_ring_push(&ring, SESSION_OPEN + UINT16_MAX, 1568000);
+	CHECK_EQ(ring.count, 2);
+	CHECK_EQ(ring.last_time, SESSION_OPEN + UINT16_MAX);
+
+	CHECK(tick_ring_push(&ring, monday, 1600000));
+	CHECK_EQ(ring.count, 1);
+	CHECK_EQ(ring.first_time, monday);
+	CHECK_EQ(ring.last_time, monday);
+	CHECK_EQ(newest().time, monday);
+	CHECK_EQ(newest().price, 1600000);
+
+	CHECK(tick_ring_push(&ring, monday + 60, 1600100));
+	CHECK_EQ(newest().time, monday + 60);
+}
+
+/*******************************************************************************
+ * Function Name: test_day_start
+ *******************************************************************************
+ * Summary:
+ *  Times share a day start when they share a New York trading date, so a
+ *  chart spans 4:00 to 20:00 and restarts after midnight Eastern, not UTC.
+ *
+ *******************************************************************************/
+static void test_day_start(void) {
+	const time_t day = poll_scheduler_day_start(SESSION_OPEN);
+
+	CHECK_EQ(day, SESSION_OPEN - (9 * 60 + 30) * 60);
+	CHECK_EQ(poll_scheduler_day_start(day + 4 * 60 * 60), day);
+	CHECK_EQ(poll_scheduler_day_start(day + 23 * 60 * 60 + 59 * 60), day);    // 03:59 UTC the next day
+	CHECK_EQ(poll_scheduler_day_start(day + 24 * 60 * 60), day + 24 * 60 * 60);
+	CHECK_EQ(poll_scheduler_day_start(day - 1), day - 24 * 60 * 60);
+}
+
+/*******************************************************************************
+ * Function Name: bench_ring
+ *******************************************************************************
+ * Summary:
+ *  Times pushes into a full ring and the decode of a whole session, the
+ *  work of a sparkline redraw before any pixel is drawn.
+ *
+ *******************************************************************************/
+static void bench_ring(void) {
+	volatile fixed_t sink = 0;
+	uint64_t start;
+	time_t time = SESSION_OPEN;
+	tick_iter_t iter;
+
+	tick_ring_reset(&ring);
+	start = test_now_ns();
+	for(int i = 0; i < BENCH_RUNS * TICK_RING_CAPACITY; i++) {
+		(void)tick_ring_push(&ring, time, 1000000 + (fixed_t)(i % 101) * 100);
+		time += 60;
+	}
+	printf("bench,tick_ring,push,%llu,ns\n", (unsigned long long)((test_now_ns() - start) / ((uint64_t)BENCH_RUNS * TICK_RING_CAPACITY)));
+
+	start = test_now_ns();
+	for(int run = 0; run < BENCH_RUNS; run++) {
+		tick_iter_init(&iter, &ring, 0);
+		while(tick_iter_next(&iter)) {
+			sink += iter.price;
+		}
+	}
+	printf("bench,tick_ring,decode_session,%llu,ns\n", (unsigned long long)((test_now_ns() - start) / BENCH_RUNS));
+	printf("bench,tick_ring,bytes_per_tick,%zu,B\n", sizeof(tick_delta_t));
+	(void)sink;
+}
+
+int main(int argc, char **argv) {
+	setenv("TZ", "EST5EDT", 1);
+	tzset();
+
+	CHECK_EQ(sizeof(tick_delta_t), 4);
+
+	test_push();
+	test_wrap();
+	test_gap();
+	test_day_start();
+
+	if(test_bench_requested(argc, argv)) {
+		bench_ring();
+	}
+
+	return test_summary("tick_ring");
+}
@@ -0,0 +1,147 @@
+/******************************************************************************
+* File Name:   tick_ring.c
+*
+* Description: This file contains the delta-encoded tick ring. Deltas are taken
+* against the last decoded tick rather than the raw previous price, so a delta
+* that had to be clamped is caught up by the following ones instead of
+* leaving a permanent offset.
+*
+*******************************************************************************/
+
+/* Standard C header file. */
+#include <string.h>
+
+#include "tick_ring.h"
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+static int16_t tick_ring_clamp16(int64_t value);
+
+/*******************************************************************************
+ * Function Name: tick_ring_reset
+ *******************************************************************************
+ * Summary:
+ *  Empties the ring.
+ *
+ *******************************************************************************/
+void tick_ring_reset(tick_ring_t *ring) {
+	(void)memset(ring, 0, sizeof(*ring));
+}
+
+/*******************************************************************************
+ * Function Name: tick_ring_push
+ *******************************************************************************
+ * Summary:
+ *  Appends a tick, dropping the oldest one when the ring is full. Ticks that
+ *  are not newer than the last one (a repeated quote) are ignored. A gap
+ *  longer than a delta can hold (about 18 h, a night or a weekend) starts
+ *  the ring over at the new tick, so the decoded times never fall behind.
+ *
+ * Return:
+ *  bool : true if the tick was added
+ *
+ *******************************************************************************/
+bool tick_ring_push(tick_ring_t *ring, time_t time, fixed_t price) {
+	tick_delta_t delta;
+	uint32_t tail;
+
+	if(ring->count == 0 || time - ring->last_time > UINT16_MAX) {
+		ring->head = 0;
+		ring->first_time = ring->last_time = time;
+		ring->first_price = ring->last_price = price;
+		ring->count = 1;
+		return true;
+	}
+
+	if(time <= ring->last_time) {
+		return false;
+	}
+
+	delta.dt = (uint16_t)(time - ring->last_time);
+	delta.dp = tick_ring_clamp16((price - ring->last_price + ((price >= ring->last_price) ? 1 : -1) * (TICK_RING_PRICE_UNIT / 2)) /
+								 TICK_RING_PRICE_UNIT);
+
+	// Full, the second oldest tick becomes the base
+	if(ring->count == TICK_RING_CAPACITY) {
+		ring->head = (ring->head + 1) % TICK_RING_CAPACITY;
+		ring->first_time += ring->deltas[ring->head].dt;
+		ring->first_price += (fixed_t)ring->deltas[ring->head].dp * TICK_RING_PRICE_UNIT;
+		ring->count--;
+	}
+
+	tail = (ring->head + ring->count) % TICK_RING_CAPACITY;
+	ring->deltas[tail] = delta;
+	ring->count++;
+	ring->last_time += delta.dt;
+	ring->last_price += (fixed_t)delta.dp * TICK_RING_PRICE_UNIT;
+
+	return true;
+}
+
+/*******************************************************************************
+ * Function Name: tick_iter_init
+ *******************************************************************************
+ * Summary:
+ *  Starts a walk from the oldest tick, skipping the first skip ticks. The
+ *  first tick_iter_next then yields the tick after the skipped ones.
+ *
+ *******************************************************************************/
+void tick_iter_init(tick_iter_t *iter, const tick_ring_t *ring, uint32_t skip) {
+	iter->ring = ring;
+	iter->index = 0;
+	iter->time = ring->first_time;
+	iter->price = ring->first_price;
+
+	// The deltas have to be summed anyway, skipping is just not reporting them
+	while(skip > 0 && tick_iter_next(iter)) {
+		skip--;
+	}
+}
+
+/*******************************************************************************
+ * Function Name: tick_iter_next
+ *******************************************************************************
+ * Summary:
+ *  Moves to the next tick and decodes its time and price. The oldest tick
+ *  is the base itself, its stored delta is already folded into the base.
+ *
+ * Return:
+ *  bool : false once past the newest tick
+ *
+ *******************************************************************************/
+bool tick_iter_next(tick_iter_t *iter) {
+	const tick_ring_t *ring = iter->ring;
+	const tick_delta_t *delta;
+
+	if(iter->index >= ring->count) {
+		return false;
+	}
+
+	if(iter->index > 0) {
+		delta = &ring->deltas[(ring->head + iter->index) % TICK_RING_CAPACITY];
+		iter->time += delta->dt;
+		iter->price += (fixed_t)delta->dp * TICK_RING_PRICE_UNIT;
+	}
+	iter->index++;
+
+	return true;
+}
+
+/*******************************************************************************
+ * Function Name: tick_ring_clamp16
+ *******************************************************************************
+ * Summary:
+ *  Saturates a delta to what a tick_delta_t can hold.
+ *
+ *******************************************************************************/
+static int16_t tick_ring_clamp16(int64_t value) {
+	if(value > INT16_MAX) {
+		return INT16_MAX;
+	}
+	if(value < INT16_MIN) {
+		return INT16_MIN;
+	}
+
+	return (int16_t)value;
+}
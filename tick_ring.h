@@ -0,0 +1,63 @@
+/******************************************************************************
+* File Name:   tick_ring.h
+*
+* Description: This file contains declarations for the intraday tick ring. Each
+* tick is stored as a time and price delta from the one before it, 4 bytes a
+* tick, so a whole session of minute ticks fits in a few KB per symbol.
+*
+*******************************************************************************/
+
+#ifndef TICK_RING_H_
+#define TICK_RING_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "fixed_point.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Ticks kept per symbol, 960 covers 4:00 to 20:00 at one a minute */
+#ifndef TICK_RING_CAPACITY
+#define TICK_RING_CAPACITY (1024)
+#endif
+
+/* Price resolution of a stored delta, in fixed_t units (100 = one cent) */
+#define TICK_RING_PRICE_UNIT (100)
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+typedef struct {
+	uint16_t dt;    // Seconds since the previous tick
+	int16_t dp;     // Price change since the previous tick, in TICK_RING_PRICE_UNIT
+} tick_delta_t;
+
+typedef struct {
+	tick_delta_t deltas[TICK_RING_CAPACITY];
+	uint32_t head;          // Oldest tick
+	uint32_t count;
+	time_t first_time;      // Oldest tick, the deltas are relative to it
+	fixed_t first_price;
+	time_t last_time;       // Newest tick, as decoded from the deltas
+	fixed_t last_price;
+} tick_ring_t;
+
+typedef struct {
+	const tick_ring_t *ring;
+	uint32_t index;
+	time_t time;
+	fixed_t price;
+} tick_iter_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+void tick_ring_reset(tick_ring_t *ring);
+bool tick_ring_push(tick_ring_t *ring, time_t time, fixed_t price);
+void tick_iter_init(tick_iter_t *iter, const tick_ring_t *ring, uint32_t skip);
+bool tick_iter_next(tick_iter_t *iter);
+
+#endif /* TICK_RING_H_ */
@@ -0,0 +1,345 @@
+/******************************************************************************
+* File Name:   tls_session_cache.c
+*
+* Description: This file contains the TLS session resumption cache.
+*
+* The secure sockets TLS port owns the mbedtls_ssl_context and does not
+* expose it, so the cache sits underneath it instead: the link step wraps
+* mbedtls_ssl_set_hostname and mbedtls_ssl_handshake (-Wl,--wrap in the
+* Makefile). The first wrapper notes which context is for our server, the
+* second offers the cached session before the first flight and stores the
+* negotiated one after the handshake completes. Both session-ID and RFC 5077
+* ticket resumption go through mbedtls_ssl_set_session.
+*
+* Only public functions are called, but telling a resumed handshake from a
+* full one needs the master secret of the session, a field of
+* mbedtls_ssl_session: a resumed handshake keeps the secret of the session
+* offered, a full one derives a new one from fresh randoms. The field is
+* private from mbed TLS 3, hence the version check below.
+*
+*******************************************************************************/
+
+/* Header file includes. */
+#include "cyhal.h"
+#include "cybsp.h"
+
+/* FreeRTOS header file. */
+#include <FreeRTOS.h>
+#include <task.h>
+
+/* Standard C header file. */
+#include <stdio.h>
+#include <string.h>
+
+#include "mbedtls/platform_util.h"
+#include "mbedtls/ssl.h"
+#include "mbedtls/version.h"
+
+#include "nv_store.h"
+#include "mem_pool.h"
+#include "metrics.h"
+#include "log_ring.h"
+#include "tls_session_cache.h"
+
+#if MBEDTLS_VERSION_NUMBER >= 0x03000000
+#error "tls_session_cache reads mbedtls_ssl_session.master, private from mbed TLS 3"
+#endif
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+int __real_mbedtls_ssl_set_hostname(mbedtls_ssl_context *ssl, const char *hostname);
+int __wrap_mbedtls_ssl_set_hostname(mbedtls_ssl_context *ssl, const char *hostname);
+int __real_mbedtls_ssl_handshake(mbedtls_ssl_context *ssl);
+int __wrap_mbedtls_ssl_handshake(mbedtls_ssl_context *ssl);
+
+static void tls_session_cache_offer(mbedtls_ssl_context *ssl);
+static bool tls_session_cache_store(const mbedtls_ssl_context *ssl);
+static void tls_session_cache_record(tls_handshake_histogram_t *histogram, uint32_t elapsed_ms);
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+static const char *cacheHostName = NULL;
+
+// Serialized session from the last completed handshake
+static uint8_t sessionBlob[TLS_SESSION_CACHE_MAX_SIZE];
+static size_t sessionBlobLen = 0;
+static unsigned char sessionMaster[48];    // Master secret of the cached session, kept by a resumed handshake
+
+// Context given our host name, and whether its handshake is under way
+static const mbedtls_ssl_context *cacheSsl = NULL;
+static bool handshaking = false;
+static bool offered = false;
+
+static TickType_t handshakeStart;
+static uint32_t handshakeStartCycles;
+static bool lastResumed = false;
+static uint32_t failedHandshakes = 0;
+
+static tls_handshake_histogram_t fullHandshakes;
+static tls_handshake_histogram_t resumedHandshakes;
+
+/*******************************************************************************
+ * Function Name: tls_session_cache_init
+ *******************************************************************************
+ * Summary:
+ *  Sets the server the cache is kept for and reloads its last session from
+ *  flash when that is enabled.
+ *
+ * Parameters:
+ *  const char *host_name : server name, handshakes to other hosts are left alone
+ *
+ *******************************************************************************/
+void tls_session_cache_init(const char *host_name) {
+	cacheHostName = host_name;
+	sessionBlobLen = 0;
+
+#if TLS_SESSION_CACHE_USE_FLASH
+	if(nv_store_init() == CY_RSLT_SUCCESS) {
+		sessionBlobLen = nv_store_read(NV_STORE_SLOT_TLS_SESSION, sessionBlob, sizeof(sessionBlob));
+	}
+#endif
+
+	if(sessionBlobLen > 0) {
+		mbedtls_ssl_session session;
+
+		// Only the master secret is needed to spot resumption later
+		mbedtls_ssl_session_init(&session);
+		if(mbedtls_ssl_session_load(&session, sessionBlob, sessionBlobLen) == 0) {
+			(void)memcpy(sessionMaster, session.master, sizeof(sessionMaster));
+			LOG_INFO("Loaded TLS session for %s from flash", host_name);
+		} else {
+			sessionBlobLen = 0;
+		}
+		mbedtls_ssl_session_free(&session);
+	}
+}
+
+/*******************************************************************************
+ * Function Name: tls_session_cache_invalidate
+ *******************************************************************************
+ * Summary:
+ *  Drops the cached session, the next handshake is a full one. Called when a
+ *  handshake with the server fails, so a session the server may have
+ *  dropped is not offered again.
+ *
+ *******************************************************************************/
+void tls_session_cache_invalidate(void) {
+	sessionBlobLen = 0;
+	mbedtls_platform_zeroize(sessionBlob, sizeof(sessionBlob));
+	mbedtls_platform_zeroize(sessionMaster, sizeof(sessionMaster));
+#if TLS_SESSION_CACHE_USE_FLASH
+	(void)nv_store_erase(NV_STORE_SLOT_TLS_SESSION);
+#endif
+}
+
+/*******************************************************************************
+ * Function Name: tls_session_cache_last_resumed
+ *******************************************************************************
+ * Summary:
+ *  Reports whether the most recent handshake with the server was resumed.
+ *
+ *******************************************************************************/
+bool tls_session_cache_last_resumed(void) {
+	return lastResumed;
+}
+
+/*******************************************************************************
+ * Function Name: tls_session_cache_failed_handshakes
+ *******************************************************************************
+ * Summary:
+ *  Number of handshakes with the server that ended in an error. Lets the
+ *  connection manager tell TLS failures from TCP ones.
+ *
+ *******************************************************************************/
+uint32_t tls_session_cache_failed_handshakes(void) {
+	return failedHandshakes;
+}
+
+/*******************************************************************************
+ * Function Name: tls_session_cache_print_histogram
+ *******************************************************************************
+ * Summary:
+ *  Prints the full and resumed handshake time histograms side by side.
+ *
+ *******************************************************************************/
+void tls_session_cache_print_histogram(void) {
+	LOG_DEBUG("TLS handshakes: full %lu (avg %lu ms), resumed %lu (avg %lu ms)", (unsigned long)fullHandshakes.count,
+			  (unsigned long)(fullHandshakes.count ? fullHandshakes.total_ms / fullHandshakes.count : 0), (unsigned long)resumedHandshakes.count,
+			  (unsigned long)(resumedHandshakes.count ? resumedHandshakes.total_ms / resumedHandshakes.count : 0));
+
+	// One message per row, the drain task prints each on its own line
+	for(int i = 0; i < TLS_HANDSHAKE_BUCKET_COUNT; i++) {
+		if(i == TLS_HANDSHAKE_BUCKET_COUNT - 1) {
+			LOG_DEBUG("  >=%5u ms full %4lu resumed %4lu", TLS_HANDSHAKE_BUCKET_MS << (i - 1), (unsigned long)fullHandshakes.buckets[i],
+					  (unsigned long)resumedHandshakes.buckets[i]);
+		} else {
+			LOG_DEBUG("  < %5u ms full %4lu resumed %4lu", TLS_HANDSHAKE_BUCKET_MS << i, (unsigned long)fullHandshakes.buckets[i],
+					  (unsigned long)resumedHandshakes.buckets[i]);
+		}
+	}
+}
+
+/*******************************************************************************
+ * Function Name: __wrap_mbedtls_ssl_set_hostname
+ *******************************************************************************
+ * Summary:
+ *  Link time wrapper around mbedtls_ssl_set_hostname, which the TLS port
+ *  calls with the SNI name before each handshake. Notes the context if the
+ *  name is our server's.
+ *
+ *******************************************************************************/
+int __wrap_mbedtls_ssl_set_hostname(mbedtls_ssl_context *ssl, const char *hostname) {
+	int ret = __real_mbedtls_ssl_set_hostname(ssl, hostname);
+
+	if(ret == 0 && cacheHostName != NULL && hostname != NULL && strcmp(hostname, cacheHostName) == 0) {
+		cacheSsl = ssl;
+		handshaking = false;
+	} else if(ssl == cacheSsl) {
+		cacheSsl = NULL;
+	}
+
+	return ret;
+}
+
+/*******************************************************************************
+ * Function Name: __wrap_mbedtls_ssl_handshake
+ *******************************************************************************
+ * Summary:
+ *  Link time wrapper around mbedtls_ssl_handshake. The TLS port may call it
+ *  several times per handshake when the socket would block, so the session is
+ *  only offered on the first call; the handshake is over once a call returns
+ *  anything but WANT_READ or WANT_WRITE.
+ *
+ *******************************************************************************/
+int __wrap_mbedtls_ssl_handshake(mbedtls_ssl_context *ssl) {
+	int ret;
+	bool ours = (ssl == cacheSsl);
+	mem_tag_t previousTag;
+
+	if(ours && !handshaking) {
+		handshaking = true;
+		handshakeStart = xTaskGetTickCount();
+		handshakeStartCycles = metrics_now();
+		tls_session_cache_offer(ssl);
+	}
+
+	// Handshake allocations are charged separately from the rest of the network task
+	previousTag = mem_pool_set_tag(MEM_TAG_TLS);
+	ret = __real_mbedtls_ssl_handshake(ssl);
+	(void)mem_pool_set_tag(previousTag);
+
+	if(!ours || ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
+		return ret;
+	}
+	handshaking = false;
+
+	if(ret != 0) {
+		failedHandshakes++;
+	} else {
+		uint32_t elapsed_ms = pdTICKS_TO_MS(xTaskGetTickCount() - handshakeStart);
+		unsigned char offeredMaster[sizeof(sessionMaster)];
+
+		(void)memcpy(offeredMaster, sessionMaster, sizeof(offeredMaster));
+
+		(void)metrics_record(METRICS_PHASE_TLS, handshakeStartCycles);
+
+		if(!tls_session_cache_store(ssl)) {
+			sessionBlobLen = 0;
+		}
+
+		// A full handshake derives a new master secret, a resumed one keeps the one offered
+		lastResumed = offered && (sessionBlobLen > 0) && (memcmp(sessionMaster, offeredMaster, sizeof(offeredMaster)) == 0);
+		mbedtls_platform_zeroize(offeredMaster, sizeof(offeredMaster));
+		tls_session_cache_record(lastResumed ? &resumedHandshakes : &fullHandshakes, elapsed_ms);
+	}
+
+	return ret;
+}
+
+/*******************************************************************************
+ * Function Name: tls_session_cache_offer
+ *******************************************************************************
+ * Summary:
+ *  Loads the cached session into the context so the ClientHello carries its
+ *  session ID and ticket.
+ *
+ *******************************************************************************/
+static void tls_session_cache_offer(mbedtls_ssl_context *ssl) {
+	mbedtls_ssl_session session;
+
+	offered = false;
+	if(sessionBlobLen == 0) {
+		return;
+	}
+
+	mbedtls_ssl_session_init(&session);
+	if(mbedtls_ssl_session_load(&session, sessionBlob, sessionBlobLen) != 0 || mbedtls_ssl_set_session(ssl, &session) != 0) {
+		LOG_WARN("Cached TLS session rejected, doing a full handshake");
+		sessionBlobLen = 0;
+	} else {
+		offered = true;
+	}
+	mbedtls_ssl_session_free(&session);
+}
+
+/*******************************************************************************
+ * Function Name: tls_session_cache_store
+ *******************************************************************************
+ * Summary:
+ *  Serializes the session negotiated by the completed handshake.
+ *
+ * Return:
+ *  bool : false if the session could not be saved
+ *
+ *******************************************************************************/
+static bool tls_session_cache_store(const mbedtls_ssl_context *ssl) {
+	mbedtls_ssl_session session;
+	size_t len = 0;
+	int ret;
+
+	mbedtls_ssl_session_init(&session);
+	ret = mbedtls_ssl_get_session(ssl, &session);
+	if(ret == 0) {
+		ret = mbedtls_ssl_session_save(&session, sessionBlob, sizeof(sessionBlob), &len);
+	}
+	if(ret == 0) {
+		(void)memcpy(sessionMaster, session.master, sizeof(sessionMaster));
+	}
+	mbedtls_ssl_session_free(&session);
+
+	if(ret != 0) {
+		return false;
+	}
+	sessionBlobLen = len;
+
+#if TLS_SESSION_CACHE_USE_FLASH
+	// Master secret in the clear, see TLS_SESSION_CACHE_USE_FLASH
+	// Resumed sessions keep their blob unless a new ticket came in, nv_store skips identical rows
+	if(nv_store_write(NV_STORE_SLOT_TLS_SESSION, sessionBlob, sessionBlobLen) != CY_RSLT_SUCCESS) {
+		LOG_WARN("TLS session not saved to flash");
+	}
+#endif
+
+	return true;
+}
+
+/*******************************************************************************
+ * Function Name: tls_session_cache_record
+ *******************************************************************************
+ * Summary:
+ *  Adds one handshake duration to a histogram.
+ *
+ *******************************************************************************/
+static void tls_session_cache_record(tls_handshake_histogram_t *histogram, uint32_t elapsed_ms) {
+	int bucket = 0;
+
+	while(bucket < TLS_HANDSHAKE_BUCKET_COUNT - 1 && elapsed_ms >= ((uint32_t)TLS_HANDSHAKE_BUCKET_MS << bucket)) {
+		bucket++;
+	}
+
+	histogram->count++;
+	histogram->total_ms += elapsed_ms;
+	histogram->buckets[bucket]++;
+}
@@ -0,0 +1,53 @@
+/******************************************************************************
+* File Name:   tls_session_cache.h
+*
+* Description: This file contains declarations for the TLS session resumption
+* cache. The last session negotiated with the server is kept in RAM (and
+* optionally in flash) and offered again on the next handshake, so reconnects
+* take the abbreviated session-ID or session-ticket handshake.
+*
+*******************************************************************************/
+
+#ifndef TLS_SESSION_CACHE_H_
+#define TLS_SESSION_CACHE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Keep a copy of the session in flash so resumption survives a reboot. Off by
+ * default: the serialized session holds the master secret in the clear, so
+ * anyone who can read the flash can decrypt recorded traffic of the session
+ * and of every connection resumed from it until the server drops it. */
+#ifndef TLS_SESSION_CACHE_USE_FLASH
+#define TLS_SESSION_CACHE_USE_FLASH (0)
+#endif
+
+/* Largest serialized session (including the ticket) that is cached */
+#define TLS_SESSION_CACHE_MAX_SIZE (496)
+
+/* Handshake time histogram, bucket i counts handshakes below (TLS_HANDSHAKE_BUCKET_MS << i) */
+#define TLS_HANDSHAKE_BUCKET_MS    (100)
+#define TLS_HANDSHAKE_BUCKET_COUNT (8)
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+typedef struct {
+	uint32_t count;
+	uint32_t total_ms;
+	uint32_t buckets[TLS_HANDSHAKE_BUCKET_COUNT];    // Last bucket also takes everything slower
+} tls_handshake_histogram_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+void tls_session_cache_init(const char *host_name);
+void tls_session_cache_invalidate(void);
+bool tls_session_cache_last_resumed(void);
+uint32_t tls_session_cache_failed_handshakes(void);
+void tls_session_cache_print_histogram(void);
+
+#endif /* TLS_SESSION_CACHE_H_ */
@@ -0,0 +1,86 @@
+/******************************************************************************
+* File Name:   wifi.c
+*
+* Description: This file contains the Wi-Fi station bring-up, the only code
+* that talks to the Wi-Fi connection manager. Everything above it sees a
+* plain IP network through secure sockets.
+*
+*******************************************************************************/
+
+/* Header file includes. */
+#include "cyhal.h"
+#include "cybsp.h"
+
+/* FreeRTOS header file. */
+#include <FreeRTOS.h>
+#include <task.h>
+
+/* Standard C header file. */
+#include <stdio.h>
+#include <string.h>
+
+/* Wi-Fi connection manager header files. */
+#include "cy_wcm.h"
+#include "cy_wcm_error.h"
+
+/* Credentials and retry settings. */
+#include "http_client.h"
+
+#include "wifi.h"
+
+/*******************************************************************************
+ * Function Name: wifi_connect
+ *******************************************************************************
+ * Summary:
+ *  Connects to Wi-Fi AP using the user-configured credentials, retries up to a
+ *  configured number of times until the connection succeeds.
+ *
+ *******************************************************************************/
+cy_rslt_t wifi_connect(void) {
+	cy_rslt_t result;
+
+	/* Variables used by Wi-Fi connection manager.*/
+	cy_wcm_connect_params_t wifi_conn_param;
+
+	cy_wcm_config_t wifi_config = {.interface = CY_WCM_INTERFACE_TYPE_STA};
+
+	cy_wcm_ip_address_t ip_address;
+
+	/* Initialize Wi-Fi connection manager. */
+	result = cy_wcm_init(&wifi_config);
+
+	if(result != CY_RSLT_SUCCESS) {
+		printf("Wi-Fi Connection Manager initialization failed!\n");
+		return result;
+	}
+	printf("Wi-Fi Connection Manager initialized.\r\n");
+
+	/* Set the Wi-Fi SSID, password and security type. */
+	memset(&wifi_conn_param, 0, sizeof(cy_wcm_connect_params_t));
+	memcpy(wifi_conn_param.ap_credentials.SSID, WIFI_SSID, sizeof(WIFI_SSID));
+	memcpy(wifi_conn_param.ap_credentials.password, WIFI_PASSWORD, sizeof(WIFI_PASSWORD));
+	wifi_conn_param.ap_credentials.security = WIFI_SECURITY_TYPE;
+
+	/* Join the Wi-Fi AP. */
+	for(uint32_t conn_retries = 0; conn_retries < MAX_WIFI_CONN_RETRIES; conn_retries++) {
+		result = cy_wcm_connect_ap(&wifi_conn_param, &ip_address);
+
+		if(result == CY_RSLT_SUCCESS) {
+			printf("Successfully connected to Wi-Fi network '%s'.\n", wifi_conn_param.ap_credentials.SSID);
+			printf("IP Address Assigned: %d.%d.%d.%d\n", (uint8)ip_address.ip.v4, (uint8)(ip_address.ip.v4 >> 8), (uint8)(ip_address.ip.v4 >> 16),
+				   (uint8)(ip_address.ip.v4 >> 24));
+			return result;
+		}
+
+		printf("Connection to Wi-Fi network failed with error code %d."
+			   "Retrying in %d ms...\n",
+			   (int)result, WIFI_CONN_RETRY_INTERVAL_MSEC);
+
+		vTaskDelay(pdMS_TO_TICKS(WIFI_CONN_RETRY_INTERVAL_MSEC));
+	}
+
+	/* Stop retrying after maximum retry attempts. */
+	printf("Exceeded maximum Wi-Fi connection attempts\n");
+
+	return result;
+}
@@ -0,0 +1,19 @@
+/******************************************************************************
+* File Name:   wifi.h
+*
+* Description: This file contains declarations for the Wi-Fi station
+* bring-up. Credentials and retry settings are in http_client.h.
+*
+*******************************************************************************/
+
+#ifndef WIFI_H_
+#define WIFI_H_
+
+#include "cy_result.h"
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+cy_rslt_t wifi_connect(void);
+
+#endif /* WIFI_H_ */